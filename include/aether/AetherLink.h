@@ -6,7 +6,11 @@
 #include <thread>
 #include <mutex>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <functional>
+#include <map>
 
 namespace aether {
 
@@ -19,18 +23,31 @@ enum class JobStatus {
     Pending,
     Processing,
     Completed,
-    Failed
+    Failed,
+    Cancelled
+};
+
+/** A piece of a job that one worker renders into one encoded file. */
+struct RenderRange {
+    int64_t firstFrame = 0;
+    int64_t frameCount = 0;
+    std::string resultPath; // where the master stores the worker's file
+    bool done = false;      // the file is there; set on submit to skip ranges an earlier run finished
 };
 
 struct RenderJob {
     std::string jobId;
-    std::string filePath;
-    uint32_t startFrame = 0;
-    uint32_t endFrame = 0;
-    uint32_t width = 1920;
-    uint32_t height = 1080;
+    std::vector<uint8_t> payload;    // what the workers render; opaque to the link, read by their RangeRenderer
+    int64_t startFrame = 0;          // frames [startFrame, endFrame) are split into ranges when ranges is empty
+    int64_t endFrame = 0;
+    int64_t chunkFrames = 0;         // length of those ranges
+    std::string resultDir;           // and their files: resultDir/chunk_00000<resultExtension>, ...
+    std::string resultExtension;     // e.g. ".mp4"; workers write the same kind of file
+    std::vector<RenderRange> ranges;
     JobStatus status = JobStatus::Pending;
-    std::string resultPath;
+    int64_t framesDone = 0;          // in finished ranges plus those the workers report as rendered
+    double fps = 0.0;                // over all workers since the job was submitted
+    std::string error;
 };
 
 struct NetworkNode {
@@ -40,74 +57,142 @@ struct NetworkNode {
     bool isOnline = false;
     uint32_t availableCores = 0;
     std::string gpuName;
+    uint32_t renderSlots = 0;    // ranges the worker renders at once
+    uint32_t activeRanges = 0;
+    int64_t framesRendered = 0;  // in ranges it has sent back
+    double fps = 0.0;            // framesRendered over the time it has been connected
 };
 
+/**
+ * Distributed rendering over TCP. Workers connect to the master and say how
+ * many ranges they render at once; the master splits each job into frame
+ * ranges, hands them to the least loaded workers and stores the encoded files
+ * they stream back. Every message is a little-endian length, a type byte and
+ * the body.
+ *
+ * Both sides send heartbeats. A worker that disconnects or misses them has its
+ * ranges queued again for the others; a range that fails on a worker, or is
+ * lost with it, is retried elsewhere a few times before the job fails. Workers reconnect to a
+ * master that went away and drop what they were rendering for it.
+ */
 class AetherLink {
 public:
     using JobCompletedCallback = std::function<void(const RenderJob& job)>;
-    
-    // Singleton access
+    /**
+     * Renders frames [firstFrame, firstFrame + frameCount) of payload to
+     * outputPath on a worker's render thread. Calls progress with the frames
+     * done so far and returns early once cancelled is set.
+     */
+    using RangeRenderer = std::function<bool(const std::vector<uint8_t>& payload, int64_t firstFrame, int64_t frameCount,
+                                             const std::string& outputPath, const std::function<void(int64_t)>& progress,
+                                             const std::atomic<bool>& cancelled, std::string& error)>;
+
+    // Singleton access: the application's own node
     static AetherLink& getInstance();
-    
+
+    AetherLink();
+    ~AetherLink();
+
     // Delete copy constructor and assignment operator
     AetherLink(const AetherLink&) = delete;
     AetherLink& operator=(const AetherLink&) = delete;
 
-    // Initialization
+    // Initialization; a master listens on port (0 = any free port, see getPort()), a worker finds masters on it
     bool initialize(NodeRole role, uint16_t port = 8888);
     void shutdown();
 
     // Node management
+    /** Master: listens for workers. Worker: starts its render threads and keeps connected to the master. */
     bool startServer();
     void stopServer();
+    /** Worker: the master to connect to. */
     bool connectToNode(const std::string& ipAddress, uint16_t port);
+    /** Master: drops a worker; its ranges go to the others. */
     void disconnectFromNode(const std::string& nodeId);
     std::vector<NetworkNode> getConnectedNodes() const;
-    
+
     // Job management (Master role)
     std::string submitJob(const RenderJob& job);
     bool cancelJob(const std::string& jobId);
+    /** Without the payload. */
     RenderJob getJobStatus(const std::string& jobId) const;
     std::vector<RenderJob> getAllJobs() const;
-    
-    // Discovery
-    void discoverNodes();
+    /** Even ranges of chunkFrames covering [startFrame, endFrame), their files named after their index. */
+    static std::vector<RenderRange> splitRange(int64_t startFrame, int64_t endFrame, int64_t chunkFrames,
+                                               const std::string& resultDir, const std::string& extension);
+
+    // Discovery: a master with auto discovery answers broadcasts on its port; a worker asks for a second
+    std::vector<NetworkNode> discoverNodes();
     void setAutoDiscovery(bool enable) { m_autoDiscovery = enable; }
-    
-    // Callbacks
+
+    // Worker settings
+    void setRangeRenderer(RangeRenderer renderer) { m_rangeRenderer = std::move(renderer); }
+    /** Ranges rendered at once; 0 picks from the core count. */
+    void setWorkerSlots(uint32_t count) { m_workerSlots = count; }
+    /** A peer is given up on after five intervals without a message. */
+    void setHeartbeatInterval(std::chrono::milliseconds interval) { m_heartbeatInterval = interval; }
+
+    // Callbacks; runs on the master's scheduler thread
     void setJobCompletedCallback(JobCompletedCallback callback) { m_jobCompletedCallback = callback; }
-    
+
     // Getters
     NodeRole getRole() const { return m_role; }
     bool isServerRunning() const { return m_serverRunning; }
     std::string getNodeId() const { return m_nodeId; }
+    uint16_t getPort() const { return m_port; }
 
 private:
-    AetherLink() = default;
-    ~AetherLink() = default;
+    struct Peer;
+    struct Job;
+    struct WorkItem;
 
     void serverThread();
+    void schedulerThread();
+    void peerThread(std::shared_ptr<Peer> peer);
     void workerThread();
+    void renderThread();
     void discoveryThread();
     std::string generateNodeId();
 
+    void updateJobProgress(Job& job) const;
+    void cancelWorkItems(const std::string& jobId);
+
     NodeRole m_role = NodeRole::Master;
     uint16_t m_port = 8888;
     std::string m_nodeId;
-    
+
     std::atomic<bool> m_serverRunning{false};
     std::atomic<bool> m_shouldStop{false};
     std::thread m_serverThread;
+    std::thread m_schedulerThread;
     std::thread m_workerThread;
+    std::vector<std::thread> m_renderThreads;
     std::thread m_discoveryThread;
-    
-    std::vector<NetworkNode> m_connectedNodes;
-    std::vector<RenderJob> m_jobQueue;
-    
+    intptr_t m_listenSocket = -1;
+
+    // Master
+    std::vector<std::shared_ptr<Peer>> m_peers;
+    std::vector<std::unique_ptr<Job>> m_jobs;
+    uint64_t m_nextJobNumber = 1;
+    bool m_scheduleRequested = false;
+
+    // Worker
+    std::string m_masterAddress;
+    uint16_t m_masterPort = 0;
+    std::shared_ptr<Peer> m_master;
+    uint64_t m_connection = 0; // bumped on every connect, so results meant for an earlier one are dropped
+    std::vector<std::shared_ptr<WorkItem>> m_workQueue;
+    std::vector<std::shared_ptr<WorkItem>> m_rendering;
+    std::map<std::string, std::shared_ptr<const std::vector<uint8_t>>> m_payloads; // by job id
+    RangeRenderer m_rangeRenderer;
+    uint32_t m_workerSlots = 0;
+
+    std::chrono::milliseconds m_heartbeatInterval{1000};
     JobCompletedCallback m_jobCompletedCallback;
     bool m_autoDiscovery = false;
-    
+
     mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
     bool m_initialized = false;
 };
 
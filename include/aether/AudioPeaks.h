@@ -0,0 +1,127 @@
+#pragma once
+
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace aether {
+
+/** One waveform column; full scale is 32767. */
+struct PeakBin {
+    int16_t min = 0;
+    int16_t max = 0;
+    int16_t rms = 0;
+};
+
+/**
+ * Waveform pyramid of one media file, read from a peak file. Level 0 holds
+ * one bin per kBaseSamplesPerBin sample frames, with all channels folded
+ * together; each further level merges kLevelFactor bins of the level below.
+ * The file is memory-mapped, so only the bins that are drawn are paged in.
+ * Immutable once opened; safe to read from any thread.
+ */
+class AudioPeaks {
+public:
+    static constexpr int kBaseSamplesPerBin = 64;
+    static constexpr int kLevelFactor = 4;
+
+    /** Null if the file is missing or not a valid peak file. */
+    static std::shared_ptr<const AudioPeaks> open(const QString& peakFile);
+
+    int getSampleRate() const { return m_sampleRate; }
+    int getChannelCount() const { return m_channels; }
+    qint64 getDurationMs() const { return m_sampleRate > 0 ? m_totalSamples * 1000 / m_sampleRate : 0; }
+    int getLevelCount() const { return static_cast<int>(m_levels.size()); }
+    /** Size of the mapped peak file. */
+    qint64 getMappedBytes() const { return m_mappedBytes; }
+
+    /**
+     * Fills out[0..pixels) with the waveform from startMs on, msPerPixel per
+     * pixel. Reads the coarsest level with at least one bin per pixel, so the
+     * cost is a few bins per pixel whatever the zoom or clip length.
+     */
+    void render(double startMs, double msPerPixel, int pixels, PeakBin* out) const;
+
+    /**
+     * Decodes mediaPath's audio and writes its peak file. Runs for as long as
+     * decoding the whole file takes; returns false early when cancel is set.
+     */
+    static bool generate(const QString& mediaPath, const QString& peakFile, const std::atomic<bool>* cancel = nullptr);
+
+private:
+    AudioPeaks() = default;
+
+    struct Level {
+        const PeakBin* bins = nullptr;
+        qint64 count = 0;
+        qint64 samplesPerBin = 0;
+    };
+
+    QFile m_file;
+    int m_sampleRate = 0;
+    int m_channels = 0;
+    qint64 m_totalSamples = 0;
+    qint64 m_mappedBytes = 0;
+    std::vector<Level> m_levels;
+};
+
+/**
+ * Peak files for the timeline, generated on a background thread the first
+ * time a file is drawn and kept on disk, keyed by the file's path, size and
+ * modification time. The least recently drawn files are unmapped once the
+ * open ones exceed the memory budget, and deleted from disk at startup once
+ * the directory exceeds its own.
+ */
+class AudioPeakCache {
+public:
+    /** Runs on the worker thread whenever a file's peaks become available. */
+    using ReadyCallback = std::function<void()>;
+
+    AudioPeakCache(ReadyCallback onReady, const QString& diskDir, size_t memoryBudgetBytes = 256u * 1024u * 1024u);
+    ~AudioPeakCache();
+
+    AudioPeakCache(const AudioPeakCache&) = delete;
+    AudioPeakCache& operator=(const AudioPeakCache&) = delete;
+
+    /** Peaks of mediaPath, or null while they are being generated (or it has no audio). GUI thread. */
+    std::shared_ptr<const AudioPeaks> peaks(const QString& mediaPath);
+
+    size_t getMemoryBytes() const;
+
+private:
+    struct Entry {
+        std::shared_ptr<const AudioPeaks> peaks; // null while queued, or when it failed
+        std::list<QString>::iterator lru;
+    };
+
+    QString peakPath(const QString& mediaPath) const;
+    static size_t entryBytes(const Entry& entry);
+    void store(const QString& mediaPath, std::shared_ptr<const AudioPeaks> peaks); // locked by caller
+    void workerLoop();
+    void trimDisk(qint64 maxBytes) const;
+
+    ReadyCallback m_onReady;
+    QString m_diskDir;
+    size_t m_memoryBudget;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    QHash<QString, Entry> m_entries;
+    std::list<QString> m_lru; // most recent first
+    size_t m_memoryBytes = 0;
+    std::deque<QString> m_queue;
+    std::atomic<bool> m_stopping{false};
+    std::thread m_thread;
+};
+
+} // namespace aether
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "aether/ExportEngine.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace aether {
+
+/** One independently encoded piece of a chunked export. */
+struct ExportChunk {
+    int64_t firstFrame = 0; // within the export
+    int64_t frameCount = 0;
+    std::string path;       // finished chunk file in the work directory
+    bool done = false;
+};
+
+/**
+ * Export split into chunks that are encoded in parallel, each by its own
+ * ExportEngine and encoder, then joined into the output by copying their
+ * packets. Every chunk starts a fresh encoder, so each is a run of closed
+ * GOPs and the join is lossless; chunk lengths are whole GOPs so the
+ * keyframe cadence carries on across the joins. All chunks share one
+ * bitrate target with the same rate ceiling, so quality does not step at the
+ * joins.
+ *
+ * Chunks are written to a work directory as partial files and renamed once
+ * complete; starting again with the same request and directory reuses the
+ * chunks that were finished, so an interrupted export resumes where it was.
+ * A manifest in the directory records which job its chunks belong to and
+ * their length; chunks left there for anything else are deleted.
+ */
+class ChunkedExport {
+public:
+    using FinishedCallback = ExportEngine::FinishedCallback;
+    using BackendFactory = std::function<std::unique_ptr<IEncoderBackend>()>;
+
+    ChunkedExport();
+    /** Cancels a running export and waits for it; finished chunks are kept. */
+    ~ChunkedExport();
+
+    ChunkedExport(const ChunkedExport&) = delete;
+    ChunkedExport& operator=(const ChunkedExport&) = delete;
+
+    /** Defaults to createEncoderBackend. */
+    void setBackendFactory(BackendFactory factory) { m_backendFactory = std::move(factory); }
+    /** Upper bound on a chunk's length; shorter exports use shorter chunks to keep every worker busy. */
+    void setMaxChunkSeconds(double seconds) { m_maxChunkSeconds = seconds; }
+    /**
+     * Fixes the chunk length (frames; 0 = derive it from the worker count, or
+     * take it from the work directory's manifest when resuming). Finished
+     * chunks are only reused when they have this length.
+     */
+    void setChunkFrames(int64_t frames) { m_chunkFrames = frames; }
+
+    /**
+     * parallelChunks 0 picks from the core count. onFinished runs on the
+     * controller thread once the output is written or the export has failed.
+     */
+    bool start(const ExportRequest& request, const std::string& workDir, uint32_t parallelChunks = 0,
+               FinishedCallback onFinished = {});
+    void cancel();
+    void wait();
+    bool isRunning() const { return m_running.load(); }
+
+    /** Progress over all chunks, with stage statistics summed across the chunk engines. */
+    ExportStats getStats() const;
+    std::vector<ExportChunk> getChunks() const;
+    const std::string& getLastError() const { return m_lastError; }
+
+    /** GOP-aligned chunks covering totalFrames, named after their index in workDir; chunkFrames as for setChunkFrames(). */
+    static std::vector<ExportChunk> planChunks(int64_t totalFrames, const EncodeParams& params, uint32_t parallelChunks,
+                                               double maxChunkSeconds, const std::string& workDir, int64_t chunkFrames = 0);
+    /** Joins finished chunk files into params.outputPath without re-encoding. */
+    static bool concatenate(const std::vector<ExportChunk>& chunks, const EncodeParams& params,
+                            const BackendFactory& backendFactory, std::string& error);
+
+    /** What a work directory's chunks are for: the encoded request (DistributedExport::encodePayload) and its frame count. */
+    static std::string jobHash(const std::vector<uint8_t>& payload, int64_t totalFrames);
+    /** The length of the chunks in workDir if its manifest says they belong to jobHash, otherwise 0. */
+    static int64_t reusableChunkFrames(const std::string& workDir, const std::string& jobHash);
+    /** Deletes the chunks in workDir and records that the ones to come belong to jobHash and are chunkFrames long. */
+    static bool resetWorkDir(const std::string& workDir, const std::string& jobHash, int64_t chunkFrames);
+    /** Deletes the chunks in workDir and its manifest, once they are no longer needed. */
+    static void clearWorkDir(const std::string& workDir);
+
+private:
+    void run();
+
+    BackendFactory m_backendFactory;
+    double m_maxChunkSeconds = 60.0;
+    int64_t m_chunkFrames = 0;
+
+    ExportRequest m_request;
+    std::string m_workDir;
+    uint32_t m_parallel = 1;
+    FinishedCallback m_onFinished;
+    std::chrono::steady_clock::time_point m_startTime;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::vector<ExportChunk> m_chunks;
+    std::vector<std::unique_ptr<ExportEngine>> m_engines; // one per parallel slot
+    std::vector<int> m_engineChunk;                       // chunk each slot renders, -1 = idle
+    std::vector<int> m_finishedSlots;                     // reported finished, not yet collected
+    std::vector<ExportStageStats> m_finishedStages;       // summed over collected chunk engines
+    int64_t m_reusedFrames = 0;                           // frames of chunks finished by an earlier run
+    int64_t m_finishedFrames = 0;                         // frames of chunks finished by this run
+    int64_t m_copiedFrames = 0;                           // of those, stream-copied
+    std::vector<std::string> m_copyRejections;            // from collected chunk engines, without repeats
+    bool m_finished = false;
+    bool m_ok = false;
+    double m_finishedElapsedMs = 0.0;
+    std::string m_error;
+    std::atomic<bool> m_cancelled{false};
+
+    std::atomic<bool> m_running{false};
+    std::thread m_thread;
+    std::string m_lastError;
+};
+
+} // namespace aether
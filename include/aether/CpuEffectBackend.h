@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace aether {
+
+/** Tightly packed RGBA8 image, same layout as the rgba8 storage images used by the compute shaders. */
+struct CpuImage {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint8_t> rgba;
+
+    void resize(uint32_t w, uint32_t h) {
+        width = w;
+        height = h;
+        rgba.assign(static_cast<size_t>(w) * h * 4, 0);
+    }
+    bool isValid() const { return width > 0 && height > 0 && rgba.size() >= static_cast<size_t>(width) * height * 4; }
+};
+
+/** Result of a pixel-diff between two renders (used by headless regression checks). */
+struct ImageDiff {
+    bool sizeMismatch = false;
+    uint32_t maxChannelDelta = 0;
+    uint64_t differingPixels = 0;
+    double psnr = 0.0; // dB, infinity when identical
+};
+
+/**
+ * CPU implementation of the compute shaders in shaders/ (blur, color_correction).
+ * Parameters use the same layout as each shader's push-constant block, so a
+ * RenderView effect can run on either backend without translation:
+ *   blur             { float radius }
+ *   color_correction { vec4 lift; vec4 gamma; vec4 gain }
+ */
+class CpuEffectBackend {
+public:
+    CpuEffectBackend() = default;
+
+    bool supportsEffect(const std::string& shaderName) const;
+    bool apply(const std::string& shaderName, const std::vector<float>& pushConstants,
+               const CpuImage& input, CpuImage& output) const;
+
+    static void boxBlur(const CpuImage& input, CpuImage& output, float radius);
+    static void colorCorrection(const CpuImage& input, CpuImage& output,
+                                const float lift[4], const float gamma[4], const float gain[4]);
+    /** The lift/gamma/gain curve as a per-channel 8-bit table (what colorCorrection applies). */
+    static void buildColorCorrectionTable(const float lift[4], const float gamma[4], const float gain[4],
+                                          uint8_t table[4][256]);
+    /** Unpacks color_correction push constants, filling identity values for missing entries. */
+    static void unpackColorCorrection(const std::vector<float>& pushConstants,
+                                      float lift[4], float gamma[4], float gain[4]);
+
+    /** Per-channel comparison; pixels differing by more than `tolerance` are counted. */
+    static ImageDiff compare(const CpuImage& a, const CpuImage& b, uint8_t tolerance = 0);
+};
+
+} // namespace aether
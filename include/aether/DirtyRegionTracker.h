@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace aether {
+
+/** Axis-aligned pixel rectangle in image space. */
+struct DirtyRect {
+    uint32_t x = 0;
+    uint32_t y = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    bool isEmpty() const { return width == 0 || height == 0; }
+};
+
+/** One stage of the effect chain. footprintRadius is how far (in pixels) an output
+ *  pixel reads around its input position: 0 for per-pixel ops, the kernel radius for blur. */
+struct EffectStage {
+    std::string name;
+    uint32_t footprintRadius = 0;
+};
+
+/**
+ * Maps effect parameter changes to the image region they invalidate.
+ * A change inside stage i spreads through every neighbourhood op from i to the end
+ * of the chain, so the region is dilated by the sum of those footprint radii.
+ */
+class DirtyRegionTracker {
+public:
+    DirtyRegionTracker() = default;
+
+    void setFrameSize(uint32_t width, uint32_t height);
+    uint32_t getFrameWidth() const { return m_frameWidth; }
+    uint32_t getFrameHeight() const { return m_frameHeight; }
+
+    // Effect chain (in evaluation order)
+    void addStage(const std::string& name, uint32_t footprintRadius = 0);
+    void removeStage(const std::string& name);
+    void clearStages();
+    bool setStageFootprint(const std::string& name, uint32_t footprintRadius);
+    const std::vector<EffectStage>& getStages() const { return m_stages; }
+
+    /** Parameter of `stageName` changed inside `region` (empty region = whole frame).
+     *  Returns the resulting dirty rectangle in output space and queues it. */
+    DirtyRect invalidateParameter(const std::string& stageName, const DirtyRect& region);
+    /** Parameter changed for the whole frame (e.g. global grade). */
+    DirtyRect invalidateStage(const std::string& stageName);
+    void invalidateAll();
+
+    bool hasPendingRegions() const { return !m_pending.empty(); }
+    /** Pending dirty rectangles since the last call; clears the queue. */
+    std::vector<DirtyRect> takePendingRegions();
+
+    /** Total downstream expansion for a change inside stage `index`. */
+    uint32_t downstreamExpansion(size_t stageIndex) const;
+
+private:
+    DirtyRect fullFrame() const;
+    DirtyRect dilateAndClamp(const DirtyRect& rect, uint32_t radius) const;
+    int findStage(const std::string& name) const;
+
+    uint32_t m_frameWidth = 0;
+    uint32_t m_frameHeight = 0;
+    std::vector<EffectStage> m_stages;
+    std::vector<DirtyRect> m_pending;
+};
+
+} // namespace aether
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "aether/AetherLink.h"
+#include "aether/ChunkedExport.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace aether {
+
+/**
+ * Chunked export rendered by AetherLink workers instead of local engines. The
+ * chunks are planned as for ChunkedExport, sized for the slots of the workers
+ * connected when it starts; each becomes a range of one AetherLink job whose
+ * payload is the request with its project saved in full. Workers render their
+ * ranges with renderRange() and stream the chunk files back, and the master
+ * joins them into the output once all are in.
+ *
+ * Workers open the media at the paths the project has, so they need the same
+ * files at the same paths (a shared drive). Chunks left in the work directory
+ * by an earlier run are reused as ChunkedExport reuses them, when its
+ * manifest says they were rendered for the same payload.
+ */
+class DistributedExport {
+public:
+    using FinishedCallback = ChunkedExport::FinishedCallback;
+    using BackendFactory = ChunkedExport::BackendFactory;
+
+    /** link must be a running master and outlive the export. */
+    explicit DistributedExport(AetherLink& link);
+    /** Cancels a running export and waits for it; finished chunks are kept. */
+    ~DistributedExport();
+
+    DistributedExport(const DistributedExport&) = delete;
+    DistributedExport& operator=(const DistributedExport&) = delete;
+
+    /** Joins the chunks; defaults to createEncoderBackend. */
+    void setBackendFactory(BackendFactory factory) { m_backendFactory = std::move(factory); }
+    void setMaxChunkSeconds(double seconds) { m_maxChunkSeconds = seconds; }
+
+    /** onFinished runs on the controller thread once the output is written or the export has failed. */
+    bool start(const ExportRequest& request, const std::string& workDir, FinishedCallback onFinished = {});
+    void cancel();
+    void wait();
+    bool isRunning() const { return m_running.load(); }
+
+    /** Frames done over all workers; no per-stage statistics. */
+    ExportStats getStats() const;
+    const std::string& getLastError() const { return m_lastError; }
+
+    /** The request as the workers receive it; false (see error) if its project cannot be saved. */
+    static bool encodePayload(const ExportRequest& request, std::vector<uint8_t>& payload, std::string& error);
+    /** An AetherLink::RangeRenderer: renders frames of an encoded request with a local ExportEngine. */
+    static bool renderRange(const std::vector<uint8_t>& payload, int64_t firstFrame, int64_t frameCount,
+                            const std::string& outputPath, const std::function<void(int64_t)>& progress,
+                            const std::atomic<bool>& cancelled, std::string& error);
+
+private:
+    void run();
+
+    AetherLink& m_link;
+    BackendFactory m_backendFactory;
+    double m_maxChunkSeconds = 60.0;
+
+    EncodeParams m_params;
+    std::vector<ExportChunk> m_chunks;
+    std::string m_workDir;
+    std::string m_jobId;
+    FinishedCallback m_onFinished;
+    std::chrono::steady_clock::time_point m_startTime;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_cancelled = false;
+    ExportStats m_result;      // once finished
+    bool m_finished = false;
+
+    std::atomic<bool> m_running{false};
+    std::thread m_thread;
+    std::string m_lastError;
+};
+
+} // namespace aether
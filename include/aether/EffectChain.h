@@ -0,0 +1,80 @@
+#pragma once
+
+#include "aether/CpuEffectBackend.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace aether {
+
+/** How an effect reads its input: per-pixel effects can be fused, neighbourhood effects cannot. */
+enum class EffectAccess {
+    PerPixel,     // output(x,y) depends only on input(x,y)
+    Neighbourhood // reads a window around (x,y), e.g. blur
+};
+
+/** One effect in evaluation order; params use the shader's push-constant layout. */
+struct EffectOp {
+    std::string name;
+    std::string shaderName;
+    std::vector<float> params;
+};
+
+/**
+ * A run of consecutive per-pixel effects compiled into one kernel.
+ * Channel-separable effects (lift/gamma/gain, gain) collapse into one 256-entry
+ * table per channel; a 3D LUT splits the run into table -> LUT -> table steps,
+ * all applied while the pixel is in registers.
+ */
+struct FusedPixelKernel {
+    enum class StepType { Table, Lut3D };
+    struct Step {
+        StepType type = StepType::Table;
+        uint8_t table[4][256];     // Table: per-channel mapping
+        uint32_t lutSize = 0;      // Lut3D: edge length
+        std::vector<float> lut;    // Lut3D: size^3 RGB triplets, red fastest
+    };
+    std::vector<Step> steps;
+
+    void apply(const CpuImage& input, CpuImage& output) const;
+};
+
+struct CompiledStage {
+    std::string name;                 // "a+b+c" for fused runs
+    EffectAccess access = EffectAccess::PerPixel;
+    std::vector<size_t> effectIndices;
+    FusedPixelKernel kernel;          // PerPixel stages
+    EffectOp op;                      // Neighbourhood stages
+};
+
+/** Chain after fusion: one full-frame memory round trip per stage instead of per effect. */
+struct CompiledEffectChain {
+    std::vector<CompiledStage> stages;
+    size_t effectCount = 0;
+
+    bool isEmpty() const { return stages.empty(); }
+    /** Frame reads+writes relative to running every effect as its own pass. */
+    float bandwidthRatio() const {
+        return effectCount == 0 ? 1.0f : static_cast<float>(stages.size()) / static_cast<float>(effectCount);
+    }
+};
+
+class EffectChainCompiler {
+public:
+    static bool isKnownEffect(const std::string& shaderName);
+    static EffectAccess accessOf(const std::string& shaderName);
+    /** Pixels an output pixel reads around itself: 0 for per-pixel effects, the box radius for blur. */
+    static uint32_t footprintOf(const EffectOp& op);
+
+    /** Fuses consecutive per-pixel effects; neighbourhood effects break the chain. */
+    static CompiledEffectChain compile(const std::vector<EffectOp>& effects);
+
+    /** Runs a compiled chain on the CPU; per-stage timings (ms) are appended when requested. */
+    static bool execute(const CompiledEffectChain& chain, const CpuImage& input, CpuImage& output,
+                        std::vector<double>* stageMilliseconds = nullptr);
+
+    /** Packs the Table steps of a fused stage for shaders/pixel_chain.comp (one uint per entry, RGBA8). */
+    static std::vector<uint32_t> packGpuTables(const FusedPixelKernel& kernel);
+};
+
+} // namespace aether
@@ -3,6 +3,7 @@
 #include <string>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace aether {
 
@@ -12,15 +13,86 @@ struct EncodeParams {
     uint32_t height = 1080;
     double fps = 24.0;
     uint32_t bitrateKbps = 0;
-    std::string codec;
+    uint32_t maxBitrateKbps = 0;  // rate-control ceiling; 0 = none
+    uint32_t bufferSizeKbits = 0; // decoder buffer the ceiling is measured over
+    std::string codec;            // encoder or codec name; empty = the container's default
+    uint32_t encoderThreads = 0;  // 0 = let the encoder decide
+    uint32_t gopSize = 0;         // frames between keyframes; 0 = encoder default
 };
 
+/** A frame in the encoder's own pixel format, made by convertFrame(). */
+struct EncoderFrame {
+    virtual ~EncoderFrame() = default;
+    int64_t index = -1; // output frame number, i.e. its timestamp; -1 = the frame after the previous one
+};
+
+/** One compressed packet made by encode(), to be passed to writePacket(). */
+struct EncoderPacket {
+    virtual ~EncoderPacket() = default;
+};
+
+/** Source times (ms) of the clean keyframes that bound a run of copyable packets. */
+struct CopySpan {
+    int64_t startMs = 0;
+    int64_t endMs = 0; // exclusive; endMs <= startMs means nothing can be copied
+    std::string rejection; // why nothing can be copied, when empty
+    bool headersDiffer = false; // rejected only for stream headers other than the output's
+
+    bool isEmpty() const { return endMs <= startMs; }
+};
+
+/**
+ * Video encoder and muxer. encodeFrame() does everything for one frame; the
+ * staged calls split the same work so that a pipeline can run colour
+ * conversion, encoding and muxing on different threads at once:
+ * convertFrame() may be called from several threads concurrently, while
+ * encode() and writePacket() are each called from one thread, in frame order.
+ */
 class IEncoderBackend {
 public:
     virtual ~IEncoderBackend() = default;
     virtual bool open(const EncodeParams& params) = 0;
+    /** rgbData is tightly packed RGBA8. */
     virtual bool encodeFrame(const void* rgbData, uint32_t width, uint32_t height) = 0;
+    /** Flushes the encoder and finishes the file; safe to call twice. */
     virtual void close() = 0;
+
+    virtual std::unique_ptr<EncoderFrame> convertFrame(const void* rgbaData, uint32_t width, uint32_t height) = 0;
+    /**
+     * Encodes frame, or drains the encoder when frame is null; appends finished
+     * packets to out. A frame after a drain starts a fresh, closed GOP.
+     */
+    virtual bool encode(std::unique_ptr<EncoderFrame> frame, std::vector<std::unique_ptr<EncoderPacket>>& out) = 0;
+    virtual bool writePacket(std::unique_ptr<EncoderPacket> packet) = 0;
+
+    /**
+     * Smart rendering. The longest run of sourcePath's video inside
+     * [fromMs, toMs) that can go into the output without re-encoding: it must
+     * start and end on keyframes no later frame refers back past, and the
+     * stream must match the output's codec, size, pixel format and frame rate,
+     * and its stream headers where the container keeps one set for the file.
+     * An empty span says why in rejection. Call after open() and before the
+     * first packet is written.
+     */
+    virtual CopySpan findCopySpan(const std::string& /*sourcePath*/, int64_t /*fromMs*/, int64_t /*toMs*/) { return {}; }
+    /**
+     * Writes the packets of a span found by findCopySpan() as output frames
+     * firstFrame onward. Called in order with writePacket(), after encode()
+     * has been flushed; encoding frames afterwards starts a new GOP. It may run
+     * on the muxing thread while encode() runs, so frames encoded after a
+     * copied span must carry their index.
+     */
+    virtual bool copyPackets(const std::string& /*sourcePath*/, const CopySpan& /*span*/, int64_t /*firstFrame*/) { return false; }
+    /**
+     * Gives the output sourcePath's stream headers instead of the encoder's, so
+     * findCopySpan() no longer rejects that source for headers that differ.
+     * Encoded frames need the encoder's own headers, so this is only for exports
+     * copied entirely from sourcePath; an empty path restores the encoder's.
+     * Call after open() and before the first packet is written.
+     */
+    virtual bool useStreamHeaders(const std::string& /*sourcePath*/) { return false; }
+
+    virtual std::string getLastError() const = 0;
 };
 
 std::unique_ptr<IEncoderBackend> createEncoderBackend();
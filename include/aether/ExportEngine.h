@@ -0,0 +1,105 @@
+#pragma once
+
+#include "aether/EncoderBackend.h"
+#include "aether/ProjectFile.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace aether {
+
+struct ExportRequest {
+    ProjectDocument project;
+    EncodeParams params;       // outputPath, size and fps of the file to write
+    int64_t startMs = 0;       // timeline range to export
+    int64_t endMs = -1;        // -1 = end of the sequence
+    int64_t frameCount = -1;   // frames from startMs on; overrides endMs when set
+    bool smartRender = true;   // copy untouched stretches of clips instead of re-encoding them
+    // A source copied whole may give the output its own stream headers. Off for
+    // pieces joined later, which must all carry the encoder's headers.
+    bool adoptStreamHeaders = true;
+    uint32_t convertThreads = 2;
+    uint32_t queueDepth = 8;   // frames buffered between two stages
+    size_t nodeCacheBytes = size_t(256) << 20; // node graph results kept for later frames; 0 = none
+};
+
+struct ExportStageStats {
+    std::string name;
+    uint32_t workers = 1;
+    int64_t frames = 0;
+    double busyMs = 0.0;      // time spent working, not waiting on a neighbour
+    double fps = 0.0;         // frames per second of wall-clock time since the start
+    double utilisation = 0.0; // busyMs / (elapsed * workers); the stage near 1.0 is the bottleneck
+};
+
+struct ExportStats {
+    std::vector<ExportStageStats> stages; // decode, effects, convert, encode, mux
+    int64_t framesDone = 0;               // frames written to the file
+    int64_t copiedFrames = 0;             // of those, copied from their source without re-encoding
+    std::vector<std::string> copyRejections; // smart render: "source: reason" for each source re-encoded instead
+    int64_t totalFrames = 0;
+    double elapsedMs = 0.0;
+    double fps = 0.0;
+    bool finished = false;
+    bool ok = false;
+    std::string error;
+};
+
+/**
+ * Renders a timeline range to a file. Each frame passes through five stages,
+ * each on its own thread (conversion on several): decode the clip under the
+ * frame, run the node graph, convert to the encoder's pixel format, encode,
+ * and mux. Stages are joined by bounded queues, so all five run at once and a
+ * slow stage holds back the ones before it instead of letting frames pile up.
+ *
+ * With smartRender, stretches of clips shown unchanged (normal speed, no node
+ * graph) whose source already matches the output are not decoded at all: the
+ * backend copies their packets, and only the GOPs cut by an edit go through
+ * the stages.
+ */
+class ExportEngine {
+public:
+    /** Runs on the mux thread once the export has finished, failed or been cancelled. */
+    using FinishedCallback = std::function<void(const ExportStats&)>;
+
+    ExportEngine();
+    /** Cancels a running export and waits for it. */
+    ~ExportEngine();
+
+    ExportEngine(const ExportEngine&) = delete;
+    ExportEngine& operator=(const ExportEngine&) = delete;
+
+    /**
+     * Opens the backend and starts the stages; returns false (see getLastError())
+     * when the export could not start or one is already running.
+     */
+    bool start(const ExportRequest& request, std::unique_ptr<IEncoderBackend> backend = createEncoderBackend(),
+               FinishedCallback onFinished = {});
+    /** Stops the stages; the partial file is removed. */
+    void cancel();
+    /** Blocks until the export has finished. */
+    void wait();
+    bool isRunning() const { return m_running.load(); }
+
+    /** Frames request covers. */
+    static int64_t frameCount(const ExportRequest& request);
+
+    /** Progress and per-stage throughput; safe to call from any thread. */
+    ExportStats getStats() const;
+    const std::string& getLastError() const { return m_lastError; }
+
+private:
+    struct Pipeline;
+
+    std::unique_ptr<Pipeline> m_pipeline;
+    std::thread m_muxThread;
+    std::atomic<bool> m_running{false};
+    std::string m_lastError;
+};
+
+} // namespace aether
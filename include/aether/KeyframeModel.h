@@ -3,6 +3,8 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <cstddef>
+#include <unordered_map>
 
 namespace aether {
 
@@ -12,10 +14,31 @@ enum class KeyframeInterpolation {
     Bezier
 };
 
+/** Bezier control point relative to its keyframe: x is a fraction of the segment's
+ *  duration (0..1), y is a value offset. The default (1/3, 0) is a flat ease. */
+struct BezierHandle {
+    double x = 1.0 / 3.0;
+    double y = 0.0;
+};
+
+/** interpolation applies to the segment that starts at this keyframe. */
 struct Keyframe {
     int64_t timeMs = 0;
     double value = 0.0;
     KeyframeInterpolation interpolation = KeyframeInterpolation::Linear;
+    BezierHandle inHandle;  // towards the previous keyframe
+    BezierHandle outHandle; // towards the next keyframe
+};
+
+/** Index of a parameter, resolved once with KeyframeModel::findParameter.
+ *  Valid until the next setParameters(). */
+using ParameterHandle = int32_t;
+constexpr ParameterHandle InvalidParameterHandle = -1;
+
+/** Remembers the last segment used so sequential evaluation is O(1) per call.
+ *  One cursor per playback stream or thread; the model itself stays const. */
+struct KeyframeCursor {
+    size_t segment = 0;
 };
 
 struct ParameterKeyframes {
@@ -33,15 +56,42 @@ public:
     uint32_t nodeId() const { return m_nodeId; }
     void setParameters(const std::vector<ParameterKeyframes>& params);
     const std::vector<ParameterKeyframes>& parameters() const { return m_parameters; }
+    /** Inserts in time order; a key already at timeMs gets the new value instead. */
     void addKeyframe(const std::string& parameterId, int64_t timeMs, double value);
     void removeKeyframe(const std::string& parameterId, size_t keyframeIndex);
     void setKeyframeValue(const std::string& parameterId, size_t keyframeIndex, double value);
-    void setKeyframeTime(const std::string& parameterId, size_t keyframeIndex, int64_t timeMs);
+    /** Moves the key in place (O(distance moved)) and returns its new index, for drags. */
+    size_t setKeyframeTime(const std::string& parameterId, size_t keyframeIndex, int64_t timeMs);
+    /** Bulk insert for recorded automation: existing keys inside the batch's time span are
+     *  replaced by the batch in one O(n + m) pass. Later duplicates in the batch win. */
+    void insertKeyframes(const std::string& parameterId, std::vector<Keyframe> keys);
+    /** Ramer-Douglas-Peucker over the linear runs in [fromMs, toMs]: drops keys whose removal
+     *  moves the curve by at most tolerance (in value units). Returns the number removed. */
+    size_t simplifyKeyframes(const std::string& parameterId, double tolerance,
+                             int64_t fromMs = INT64_MIN, int64_t toMs = INT64_MAX);
     double evaluate(const std::string& parameterId, int64_t timeMs) const;
 
+    ParameterHandle findParameter(const std::string& parameterId) const;
+    /** Binary search for the segment; thread-safe. */
+    double evaluate(ParameterHandle handle, double timeMs) const;
+    /** Starts from the cursor's segment and walks, which is O(1) for monotonic playback. */
+    double evaluate(ParameterHandle handle, double timeMs, KeyframeCursor& cursor) const;
+    /** Values at arbitrary times (sorted times are fastest) into out[0..count). */
+    void evaluateBatch(ParameterHandle handle, const double* timesMs, size_t count, double* out) const;
+    /** Values at startMs + i * stepMs for i in [0, count); linear runs are vectorized. */
+    void sampleUniform(ParameterHandle handle, double startMs, double stepMs, size_t count, double* out) const;
+
+    /** Evaluates one segment at timeMs (t0 <= timeMs <= t1) using a's interpolation. */
+    static double interpolate(const Keyframe& a, const Keyframe& b, double timeMs);
+
 private:
+    const std::vector<Keyframe>* keyframesOf(ParameterHandle handle) const;
+    ParameterKeyframes* parameterById(const std::string& parameterId);
+    void rebuildIndex();
+
     uint32_t m_nodeId = 0;
     std::vector<ParameterKeyframes> m_parameters;
+    std::unordered_map<std::string, ParameterHandle> m_handleById;
 };
 
 } // namespace aether
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace aether {
+
+class ThreadPool;
+
+/** What a probe learns about a media file. */
+struct MediaProbeResult {
+    QString path;          // as requested
+    bool ok = false;
+    QString error;
+    qint64 durationMs = 0;
+    bool hasVideo = false; // cover art does not count
+    bool hasAudio = false;
+    bool isStill = false;  // single image
+    int width = 0;
+    int height = 0;
+    int fps = 0;
+    QString videoCodec;
+    QString audioCodec;
+    int audioChannels = 0;
+    int audioSampleRate = 0;
+    QString audioLayout;   // "stereo", "5.1(side)", ...
+    bool fromCache = false;
+};
+
+/**
+ * Probe results keyed by file identity: canonical path, size and modification
+ * time. A file that was changed or replaced misses and is probed again. The
+ * least recently used entries are dropped beyond maxEntries. Thread-safe.
+ */
+class MediaMetadataCache {
+public:
+    explicit MediaMetadataCache(size_t maxEntries = 20000) : m_maxEntries(maxEntries) {}
+
+    bool load(const QString& cacheFile);
+    bool save(const QString& cacheFile);
+
+    bool lookup(const QString& mediaPath, MediaProbeResult& out);
+    void insert(const QString& mediaPath, const MediaProbeResult& result);
+    size_t size() const;
+    bool isDirty() const;
+
+private:
+    struct Entry {
+        qint64 size = 0;
+        qint64 modifiedMs = 0;
+        uint64_t lastUsed = 0;
+        MediaProbeResult result;
+    };
+
+    static bool identify(const QString& mediaPath, QString& key, qint64& size, qint64& modifiedMs);
+    void evict();
+
+    mutable std::mutex m_mutex;
+    QHash<QString, Entry> m_entries;
+    uint64_t m_clock = 0;
+    size_t m_maxEntries;
+    bool m_dirty = false;
+};
+
+/**
+ * Probes media files with libavformat on a small pool of its own, so a slow
+ * card or network share never blocks the UI or the shared compute pool.
+ * Results come from the cache when the file is unchanged since it was last
+ * probed. A path already waiting is not queued twice.
+ */
+class MediaProbeService {
+public:
+    /** Runs on a probe thread for every finished request, cache hits included. */
+    using ResultCallback = std::function<void(const MediaProbeResult& result)>;
+
+    MediaProbeService(ResultCallback onResult, const QString& cacheFile = QString(), size_t threadCount = 4);
+    /** Drops queued requests, waits for running probes and saves the cache. */
+    ~MediaProbeService();
+
+    MediaProbeService(const MediaProbeService&) = delete;
+    MediaProbeService& operator=(const MediaProbeService&) = delete;
+
+    /** Queues path and returns immediately. */
+    void request(const QString& path);
+    /** Cache lookup, then a probe on the calling thread; for when the answer is needed now. */
+    MediaProbeResult probeNow(const QString& path);
+    size_t getPendingCount() const;
+
+    uint64_t getCacheHits() const { return m_cacheHits.load(); }
+    uint64_t getProbeCount() const { return m_probes.load(); }
+    /** Mean time of probes that missed the cache, in milliseconds. */
+    double getAverageProbeMs() const;
+
+    void saveCache();
+
+    /** Opens path with libavformat and reads its stream parameters. */
+    static MediaProbeResult probeFile(const QString& path);
+
+private:
+    MediaProbeResult lookupOrProbe(const QString& path);
+
+    ResultCallback m_onResult;
+    QString m_cacheFile;
+    MediaMetadataCache m_cache;
+
+    mutable std::mutex m_mutex;
+    QSet<QString> m_pending; // queued or running
+    std::atomic<bool> m_cancelled{false};
+    std::atomic<uint64_t> m_cacheHits{0};
+    std::atomic<uint64_t> m_probes{0};
+    std::atomic<uint64_t> m_probeMicros{0};
+    std::unique_ptr<ThreadPool> m_pool;
+};
+
+} // namespace aether
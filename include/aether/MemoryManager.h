@@ -7,6 +7,9 @@
 
 namespace aether {
 
+/** Physical memory of the machine, in bytes; for code that does not run the MemoryManager. */
+bool querySystemMemory(uint64_t& totalBytes, uint64_t& availableBytes);
+
 class MemoryManager {
 public:
     using MemoryWarningCallback = std::function<void(uint64_t usedMB, uint64_t totalMB, float percentage)>;
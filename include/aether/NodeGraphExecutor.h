@@ -0,0 +1,127 @@
+#pragma once
+
+#include "aether/CpuEffectBackend.h"
+#include "aether/NodeGraphModel.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace aether {
+
+class KeyframeModel;
+class NodeResultCache;
+class ThreadPool;
+
+/** Value of a node parameter at timeMs, or nullopt to use the parameter's default. */
+using NodeParameterSource =
+    std::function<std::optional<double>(uint32_t nodeId, const std::string& parameterId, int64_t timeMs)>;
+
+struct NodeParameterSpec {
+    const char* id;
+    double defaultValue;
+};
+
+struct NodeTiming {
+    uint32_t nodeId = 0;
+    std::string title;
+    double milliseconds = 0.0;
+    bool cached = false; // served from the NodeResultCache
+};
+
+/** One scheduled node of a compiled graph. */
+struct CompiledNode {
+    uint32_t nodeId = 0;
+    NodeType type = NodeType::Transform;
+    std::string title;
+    std::vector<int> inputs; // schedule index feeding each input port, -1 = the source image
+    uint32_t level = 0;      // wavefront; nodes sharing a level do not depend on each other
+    uint32_t buffer = 0;     // intermediate buffer this node writes
+};
+
+/**
+ * Compiles a NodeGraphModel into a schedule and evaluates it on CPU images.
+ * compile() keeps only nodes upstream of the output, sorts them topologically
+ * (failing on cycles) and groups them into wavefronts. Intermediate buffers are
+ * assigned by lifetime: a buffer is handed to a later wavefront once its last
+ * reader has run, so a long chain needs only a few frames of memory. Nodes of
+ * one wavefront run in parallel on a ThreadPool.
+ *
+ * Unconnected input ports read the source image passed to execute().
+ *
+ * With a NodeResultCache attached, every node gets a key hashed from its type,
+ * its evaluated parameters and its inputs' keys; a node whose key is cached is
+ * not run, so only the branches downstream of an actual change are recomputed.
+ * A result is only stored once its node has had the same key on two frames in
+ * a row: a node fed by moving footage or animated parameters gets a new key
+ * every frame, and storing those would just evict the static results.
+ */
+class NodeGraphExecutor {
+public:
+    NodeGraphExecutor() = default;
+
+    /** nullptr = ThreadPool::getInstance(). */
+    void setThreadPool(ThreadPool* pool) { m_pool = pool; }
+    /** Unset, or returning nullopt, means every parameter uses its default. */
+    void setParameterSource(NodeParameterSource source) { m_parameterSource = std::move(source); }
+    /** nullptr disables result caching. The cache may be shared between executors. */
+    void setResultCache(NodeResultCache* cache) { m_cache = cache; }
+
+    /** Parameter source reading the keyframed values of model.nodeId(). */
+    static NodeParameterSource keyframeSource(const KeyframeModel& model);
+
+    /** outputNodeId 0 picks the newest node that feeds nothing. */
+    bool compile(const NodeGraphModel& graph, uint32_t outputNodeId = 0);
+    bool isCompiled() const { return !m_schedule.empty(); }
+    /** False once the graph has been structurally edited since compile(). */
+    bool isUpToDate(const NodeGraphModel& graph) const { return isCompiled() && m_compiledRevision == graph.revision(); }
+    const std::string& getLastError() const { return m_lastError; }
+
+    /** sourceKey identifies the source frame (e.g. clip and frame number); 0 hashes its pixels. */
+    bool execute(const CpuImage& source, int64_t timeMs, CpuImage& output, uint64_t sourceKey = 0);
+
+    const std::vector<CompiledNode>& getSchedule() const { return m_schedule; }
+    uint32_t getOutputNodeId() const { return m_schedule.empty() ? 0 : m_schedule.back().nodeId; }
+    size_t getLevelCount() const { return m_levelStarts.empty() ? 0 : m_levelStarts.size() - 1; }
+    /** Distinct intermediate buffers after aliasing (at most one per scheduled node). */
+    size_t getBufferCount() const { return m_bufferCount; }
+
+    /** Per-node cost of the last execute(), in schedule order. */
+    const std::vector<NodeTiming>& getLastTimings() const { return m_lastTimings; }
+    double getLastTotalMs() const { return m_lastTotalMs; }
+    size_t getLastCacheHits() const { return m_lastCacheHits; }
+
+    static const std::vector<NodeParameterSpec>& parameterSpecs(NodeType type);
+
+private:
+    ThreadPool& pool() const;
+    void resolveParameters(const CompiledNode& node, int64_t timeMs, std::vector<double>& values) const;
+    void runNode(const CompiledNode& node, const std::vector<double>& params,
+                 const CpuImage* const* inputs, size_t inputCount, CpuImage& output) const;
+
+    ThreadPool* m_pool = nullptr;
+    NodeParameterSource m_parameterSource;
+    NodeResultCache* m_cache = nullptr;
+    std::string m_lastError;
+
+    uint64_t m_compiledRevision = 0;
+    std::vector<CompiledNode> m_schedule; // topological, grouped by level
+    std::vector<size_t> m_levelStarts;    // schedule index where each level begins, plus the end
+    size_t m_bufferCount = 0;
+    std::vector<CpuImage> m_buffers;      // kept between frames to avoid reallocating
+
+    // Per schedule step, valid during execute()
+    std::vector<uint64_t> m_stepKeys;
+    std::vector<const CpuImage*> m_stepResults;
+    std::vector<std::shared_ptr<const CpuImage>> m_stepCached;
+    std::vector<uint64_t> m_previousKeys; // per schedule step, from the last execute()
+
+    std::vector<NodeTiming> m_lastTimings;
+    double m_lastTotalMs = 0.0;
+    size_t m_lastCacheHits = 0;
+};
+
+} // namespace aether
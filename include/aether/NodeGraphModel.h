@@ -3,6 +3,10 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace aether {
 
@@ -17,11 +21,23 @@ enum class NodeType {
 struct NodePort {
     uint32_t nodeId = 0;
     uint32_t portIndex = 0;
+
+    bool operator==(const NodePort& other) const = default;
 };
 
 struct NodeConnection {
     NodePort source;
     NodePort dest;
+
+    bool operator==(const NodeConnection& other) const = default;
+};
+
+struct NodeConnectionHash {
+    size_t operator()(const NodeConnection& c) const {
+        uint64_t a = (static_cast<uint64_t>(c.source.nodeId) << 32) | c.source.portIndex;
+        uint64_t b = (static_cast<uint64_t>(c.dest.nodeId) << 32) | c.dest.portIndex;
+        return static_cast<size_t>(a * 0x9E3779B97F4A7C15ull ^ (b + 0x632BE59BD9B4E019ull + (a << 6) + (a >> 2)));
+    }
 };
 
 struct Node {
@@ -34,28 +50,82 @@ struct Node {
     std::vector<std::string> outputPortNames;
 };
 
+enum class NodeGraphChange {
+    NodeAdded,
+    NodeRemoved,       // sent after the node's ConnectionRemoved events
+    NodeMoved,
+    ConnectionAdded,
+    ConnectionRemoved
+};
+
+struct NodeGraphEvent {
+    NodeGraphChange change = NodeGraphChange::NodeAdded;
+    uint32_t nodeId = 0;         // node events
+    NodeConnection connection;   // connection events
+};
+
+using NodeGraphListener = std::function<void(const NodeGraphEvent&)>;
+
+/**
+ * Node graph storage. Nodes live in a dense vector with an id -> index map;
+ * removal swaps the last node into the hole, so nodes() and connections() are
+ * not in insertion order once anything was removed. Each node keeps the
+ * indices of its incoming and outgoing connections, and a hash set of all
+ * connections makes duplicate checks constant time.
+ */
 class NodeGraphModel {
 public:
     NodeGraphModel();
+    /** Copies hold the graph only; listeners stay with the original. */
+    NodeGraphModel(const NodeGraphModel& other);
+    NodeGraphModel& operator=(const NodeGraphModel&) = delete; // would bypass the listeners
     uint32_t addNode(NodeType type, float x, float y);
+    /** Adds a node keeping its id (e.g. when loading); false if the id is 0 or taken. */
+    bool insertNode(Node node);
     void removeNode(uint32_t nodeId);
+    void clear();
     bool addConnection(const NodePort& source, const NodePort& dest);
     void removeConnection(size_t connectionIndex);
+    bool removeConnection(const NodeConnection& connection);
     void setNodePosition(uint32_t nodeId, float x, float y);
 
     const std::vector<Node>& nodes() const { return m_nodes; }
     const std::vector<NodeConnection>& connections() const { return m_connections; }
     Node* nodeById(uint32_t id);
     const Node* nodeById(uint32_t id) const;
+    bool hasConnection(const NodeConnection& connection) const { return m_connectionSet.count(connection) != 0; }
+    /** Indices into connections() ending at / starting from nodeId. */
+    const std::vector<size_t>& incomingConnections(uint32_t nodeId) const;
+    const std::vector<size_t>& outgoingConnections(uint32_t nodeId) const;
+    /** Bumped on structural edits (not moves); lets evaluators tell whether a compiled graph is stale. */
+    uint64_t revision() const { return m_revision; }
+
+    /** Listeners run synchronously after each edit. Returns a handle for removeListener. */
+    int addListener(NodeGraphListener listener);
+    void removeListener(int handle);
 
     static const char* nodeTypeName(NodeType t);
     static int inputPortCount(NodeType t);
     static int outputPortCount(NodeType t);
 
 private:
+    struct Adjacency {
+        std::vector<size_t> incoming;
+        std::vector<size_t> outgoing;
+    };
+
     uint32_t nextNodeId();
+    void removeConnectionAt(size_t connectionIndex);
+    void notify(const NodeGraphEvent& event);
+
     std::vector<Node> m_nodes;
+    std::vector<Adjacency> m_adjacency; // parallel to m_nodes
+    std::unordered_map<uint32_t, size_t> m_indexById;
     std::vector<NodeConnection> m_connections;
+    std::unordered_set<NodeConnection, NodeConnectionHash> m_connectionSet;
+    std::vector<std::pair<int, NodeGraphListener>> m_listeners;
+    int m_nextListener = 1;
+    uint64_t m_revision = 0;
     uint32_t m_nextId = 1;
 };
 
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "aether/CpuEffectBackend.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace aether {
+
+struct NodeCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+};
+
+/**
+ * Node outputs keyed by a content hash (node type, evaluated parameters and the
+ * keys of its inputs), evicted least-recently-used once the memory budget is
+ * exceeded. A still background or an unanimated mask keeps the same key from
+ * frame to frame, so after its first frames it is served from here.
+ * Thread-safe: nodes of one wavefront look up and insert concurrently.
+ */
+class NodeResultCache {
+public:
+    explicit NodeResultCache(size_t budgetBytes = size_t(512) << 20);
+
+    void setBudget(size_t budgetBytes);
+    size_t getBudget() const { return m_budget; }
+
+    /** Cached image for key, or nullptr (counts as a miss). */
+    std::shared_ptr<const CpuImage> find(uint64_t key);
+    /** Images larger than the whole budget are not stored. */
+    void insert(uint64_t key, std::shared_ptr<const CpuImage> image);
+    void clear();
+
+    NodeCacheStats getStats() const;
+
+private:
+    struct Entry {
+        uint64_t key;
+        std::shared_ptr<const CpuImage> image;
+        size_t bytes;
+    };
+
+    void evictToBudget();
+
+    mutable std::mutex m_mutex;
+    size_t m_budget;
+    size_t m_bytes = 0;
+    std::list<Entry> m_lru; // most recently used first
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> m_index;
+    NodeCacheStats m_stats;
+};
+
+} // namespace aether
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "aether/CpuEffectBackend.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace aether {
+
+class ThreadPool;
+
+struct ParticleEmitterSettings {
+    float x = 0.0f;                // spawn centre, pixels
+    float y = 0.0f;
+    float spawnRadius = 0.0f;
+    float directionRadians = -1.5707963f; // up
+    float spreadRadians = 0.5f;
+    float speedMin = 50.0f;        // pixels / second
+    float speedMax = 150.0f;
+    float lifetimeMin = 1.0f;      // seconds
+    float lifetimeMax = 2.0f;
+    float ratePerSecond = 0.0f;    // continuous emission; 0 = bursts only
+    uint32_t color = 0xFFFFFFFF;   // RGBA8, R in the low byte
+};
+
+struct ParticleForces {
+    float gravityX = 0.0f;
+    float gravityY = 98.0f;
+    float drag = 0.0f;             // fraction of velocity lost per second
+};
+
+struct ParticleFrameStats {
+    size_t alive = 0;
+    size_t emitted = 0;
+    size_t removed = 0;
+    double emitMs = 0.0;
+    double updateMs = 0.0;
+    double compactMs = 0.0;
+    double totalMs() const { return emitMs + updateMs + compactMs; }
+};
+
+/**
+ * CPU particle simulation with structure-of-arrays storage. Each attribute is a
+ * contiguous float array, so the integrator streams through memory and
+ * vectorizes (SSE2 where available); emission, update and compaction are split
+ * across a ThreadPool.
+ */
+class ParticleSystem {
+public:
+    explicit ParticleSystem(size_t capacity = 1 << 20);
+
+    /** nullptr = ThreadPool::getInstance(). */
+    void setThreadPool(ThreadPool* pool) { m_pool = pool; }
+
+    void setEmitter(const ParticleEmitterSettings& emitter) { m_emitter = emitter; }
+    const ParticleEmitterSettings& getEmitter() const { return m_emitter; }
+    void setForces(const ParticleForces& forces) { m_forces = forces; }
+    void setCapacity(size_t capacity);
+    size_t getCapacity() const { return m_capacity; }
+
+    /** Spawns up to `count` particles now; returns how many fit. */
+    size_t emit(size_t count);
+    /** Continuous emission, integration, ageing and removal of dead particles. */
+    void update(float deltaTime);
+    void clear();
+
+    size_t getAliveCount() const { return m_alive; }
+    const ParticleFrameStats& getLastStats() const { return m_lastStats; }
+
+    /** Additive point splat into an RGBA8 frame (rows are split across the pool).
+     *  Reuses per-system scratch, so one system renders one frame at a time. */
+    void render(CpuImage& target) const;
+
+    // Read-only SoA views, [0, getAliveCount())
+    const float* positionsX() const { return m_front.posX.data(); }
+    const float* positionsY() const { return m_front.posY.data(); }
+    const float* velocitiesX() const { return m_front.velX.data(); }
+    const float* velocitiesY() const { return m_front.velY.data(); }
+    const float* ages() const { return m_front.age.data(); }
+
+private:
+    struct Storage {
+        std::vector<float> posX, posY, velX, velY, age, lifetime;
+        std::vector<uint32_t> color;
+        void resize(size_t n);
+    };
+
+    ThreadPool& pool() const;
+    void spawnRange(size_t begin, size_t end, uint64_t seed);
+    void integrate(size_t begin, size_t end, float deltaTime);
+    size_t compact();
+
+    size_t m_capacity = 0;
+    size_t m_alive = 0;
+    Storage m_front;
+    Storage m_back; // compaction target, swapped with m_front
+    std::vector<size_t> m_chunkAlive;
+    // render() scratch: on-screen particle indices grouped by row band
+    mutable std::vector<size_t> m_bandStart;
+    mutable std::vector<uint32_t> m_bandParticles;
+
+    ParticleEmitterSettings m_emitter;
+    ParticleForces m_forces;
+    float m_emitAccumulator = 0.0f;
+    uint64_t m_frameSeed = 0x9E3779B97F4A7C15ull;
+    ThreadPool* m_pool = nullptr;
+    ParticleFrameStats m_lastStats;
+};
+
+} // namespace aether
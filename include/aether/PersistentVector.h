@@ -0,0 +1,366 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace aether {
+
+/** Summary for vectors that keep none. */
+struct NoSummary {
+    template <typename T>
+    static NoSummary of(const T&) { return {}; }
+    static NoSummary combine(const NoSummary&, const NoSummary&) { return {}; }
+};
+
+/**
+ * Immutable sequence with structural sharing. Every edit returns a new vector
+ * that shares all untouched nodes with the old one, so keeping old versions
+ * around (undo history, a render thread's view of the timeline) costs only the
+ * nodes an edit copied. Storage is a B+ tree of up to kBranch elements per
+ * leaf and kBranch children per inner node; erase merges or evens out nodes
+ * that fall under half full. Index lookup, set, insert and erase are
+ * O(log n), iteration is O(1) amortised.
+ *
+ * Versions are safe to read from any number of threads: nodes are never
+ * modified after they are published.
+ *
+ * Every node can also carry a Summary of the elements below it: a value type
+ * whose default value is the identity for `static Summary combine(a, b)`, with
+ * `static Summary of(const T&)` for one element. Edits keep the summaries of
+ * the nodes they copy up to date, which makes findFirst a single descent.
+ */
+template <typename T, typename Summary = NoSummary>
+class PersistentVector {
+    struct Node;
+    using NodePtr = std::shared_ptr<const Node>;
+
+public:
+    using value_type = T;
+    using size_type = std::ptrdiff_t; // signed, like QVector's qsizetype
+
+    static constexpr size_t kBranch = 32;
+
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() = default;
+
+        reference operator*() const { return m_leaf->items[static_cast<size_t>(m_index - m_leafStart)]; }
+        pointer operator->() const { return &**this; }
+        const_iterator& operator++() {
+            ++m_index;
+            if (m_index < m_owner->size() && m_index - m_leafStart >= static_cast<size_type>(m_leaf->items.size()))
+                m_leafStart = m_owner->findLeaf(m_index, m_leaf);
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+        bool operator==(const const_iterator& other) const { return m_index == other.m_index; }
+        bool operator!=(const const_iterator& other) const { return m_index != other.m_index; }
+
+    private:
+        friend class PersistentVector;
+        const_iterator(const PersistentVector* owner, size_type index) : m_owner(owner), m_index(index) {
+            if (m_index < m_owner->size()) m_leafStart = m_owner->findLeaf(m_index, m_leaf);
+        }
+
+        const PersistentVector* m_owner = nullptr;
+        const Node* m_leaf = nullptr;
+        size_type m_index = 0;
+        size_type m_leafStart = 0;
+    };
+
+    PersistentVector() = default;
+
+    size_type size() const { return m_root ? m_root->count : 0; }
+    bool isEmpty() const { return !m_root; }
+    bool empty() const { return !m_root; }
+
+    const T& operator[](size_type index) const {
+        const Node* leaf = nullptr;
+        size_type start = findLeaf(index, leaf);
+        return leaf->items[static_cast<size_t>(index - start)];
+    }
+    const T& front() const { return (*this)[0]; }
+    const T& back() const { return (*this)[size() - 1]; }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+
+    /** Copies of this vector with one edit applied; this vector is unchanged. */
+    PersistentVector set(size_type index, T value) const {
+        PersistentVector result;
+        result.m_root = setIn(*m_root, index, std::move(value));
+        return result;
+    }
+
+    PersistentVector insert(size_type index, T value) const {
+        PersistentVector result;
+        if (!m_root) {
+            auto leaf = std::make_shared<Node>();
+            leaf->items.push_back(std::move(value));
+            leaf->count = 1;
+            summarize(*leaf);
+            result.m_root = std::move(leaf);
+            return result;
+        }
+        NodePtr first, second;
+        insertIn(*m_root, index, std::move(value), first, second);
+        if (second) {
+            auto root = std::make_shared<Node>();
+            root->count = first->count + second->count;
+            root->children = {std::move(first), std::move(second)};
+            summarize(*root);
+            result.m_root = std::move(root);
+        } else {
+            result.m_root = std::move(first);
+        }
+        return result;
+    }
+
+    PersistentVector pushBack(T value) const { return insert(size(), std::move(value)); }
+
+    PersistentVector erase(size_type index) const {
+        PersistentVector result;
+        result.m_root = eraseIn(*m_root, index);
+        // Drop inner levels that are left with a single child
+        while (result.m_root && !result.m_root->children.empty() && result.m_root->children.size() == 1)
+            result.m_root = result.m_root->children.front();
+        return result;
+    }
+
+    /** Builds a vector from a range in O(n), with full leaves. */
+    template <typename It>
+    static PersistentVector fromRange(It first, It last) {
+        std::vector<NodePtr> level;
+        while (first != last) {
+            auto leaf = std::make_shared<Node>();
+            while (first != last && leaf->items.size() < kBranch)
+                leaf->items.push_back(*first++);
+            leaf->count = static_cast<size_type>(leaf->items.size());
+            summarize(*leaf);
+            level.push_back(std::move(leaf));
+        }
+        while (level.size() > 1) {
+            std::vector<NodePtr> parents;
+            for (size_t i = 0; i < level.size(); i += kBranch) {
+                auto inner = std::make_shared<Node>();
+                for (size_t j = i; j < level.size() && j < i + kBranch; j++) {
+                    inner->count += level[j]->count;
+                    inner->children.push_back(level[j]);
+                }
+                summarize(*inner);
+                parents.push_back(std::move(inner));
+            }
+            level = std::move(parents);
+        }
+        PersistentVector result;
+        if (!level.empty()) result.m_root = std::move(level.front());
+        return result;
+    }
+
+    const_iterator iteratorAt(size_type index) const { return const_iterator(this, index); }
+
+    /** Summary of every element; the default Summary when empty. */
+    Summary summary() const { return m_root ? m_root->summary : Summary(); }
+
+    /**
+     * Index of the first element e for which pred(Summary::of(e)) holds, or
+     * size(). pred must hold for a combined summary exactly when it holds for
+     * one of its parts (e.g. "maximum end > t"), so the search walks down into
+     * the first child that matches and never backtracks: O(log n).
+     */
+    template <typename Pred>
+    size_type findFirst(Pred pred) const {
+        if (!m_root || !pred(m_root->summary)) return size();
+        const Node* node = m_root.get();
+        size_type start = 0;
+        while (!isLeaf(*node)) {
+            size_t c = 0;
+            while (c + 1 < node->children.size() && !pred(node->children[c]->summary)) {
+                start += node->children[c]->count;
+                c++;
+            }
+            node = node->children[c].get();
+        }
+        for (size_t i = 0; i < node->items.size(); i++) {
+            if (pred(Summary::of(node->items[i]))) return start + static_cast<size_type>(i);
+        }
+        return size();
+    }
+
+    /** True when both are the same version (no element can differ). */
+    bool sharesRootWith(const PersistentVector& other) const { return m_root == other.m_root; }
+
+    /**
+     * Bytes of nodes in this version that base does not share at the same
+     * position: roughly what keeping this version costs on top of base. Shape
+     * changes (splits) make it over-count, never under-count.
+     */
+    size_t unsharedBytes(const PersistentVector& base) const { return unsharedIn(m_root.get(), base.m_root.get()); }
+
+private:
+    struct Node {
+        size_type count = 0;                // elements below this node
+        std::vector<T> items;               // leaf only
+        std::vector<NodePtr> children;      // inner only
+        [[no_unique_address]] Summary summary;
+    };
+
+    static bool isLeaf(const Node& node) { return node.children.empty(); }
+
+    static void summarize(Node& node) {
+        Summary s;
+        for (const T& item : node.items) s = Summary::combine(s, Summary::of(item));
+        for (const NodePtr& child : node.children) s = Summary::combine(s, child->summary);
+        node.summary = s;
+    }
+
+    // Child holding index; index is rebased to that child
+    static size_t childFor(const Node& node, size_type& index) {
+        size_t c = 0;
+        while (c + 1 < node.children.size() && index >= node.children[c]->count) {
+            index -= node.children[c]->count;
+            c++;
+        }
+        return c;
+    }
+
+    size_type findLeaf(size_type index, const Node*& leaf) const {
+        const Node* node = m_root.get();
+        size_type start = index;
+        while (!isLeaf(*node)) {
+            size_t c = childFor(*node, index);
+            node = node->children[c].get();
+        }
+        leaf = node;
+        return start - index;
+    }
+
+    static NodePtr setIn(const Node& node, size_type index, T&& value) {
+        auto copy = std::make_shared<Node>(node);
+        if (isLeaf(node)) {
+            copy->items[static_cast<size_t>(index)] = std::move(value);
+        } else {
+            size_t c = childFor(node, index);
+            copy->children[c] = setIn(*node.children[c], index, std::move(value));
+        }
+        summarize(*copy);
+        return copy;
+    }
+
+    // Writes the replacement for node to first, and its new right sibling to second if it split
+    static void insertIn(const Node& node, size_type index, T&& value, NodePtr& first, NodePtr& second) {
+        auto copy = std::make_shared<Node>(node);
+        copy->count++;
+        if (isLeaf(node)) {
+            copy->items.insert(copy->items.begin() + index, std::move(value));
+        } else {
+            size_t c = childFor(node, index); // index == count appends to the last child
+            NodePtr a, b;
+            insertIn(*node.children[c], index, std::move(value), a, b);
+            copy->children[c] = std::move(a);
+            if (b) copy->children.insert(copy->children.begin() + static_cast<std::ptrdiff_t>(c) + 1, std::move(b));
+        }
+        second.reset();
+        if (width(*copy) > kBranch) second = splitOff(*copy);
+        summarize(*copy);
+        first = std::move(copy);
+    }
+
+    // Elements of a leaf, children of an inner node
+    static size_t width(const Node& node) { return isLeaf(node) ? node.items.size() : node.children.size(); }
+
+    // Moves the upper half of node to a new right sibling; node's summary is left to the caller
+    static NodePtr splitOff(Node& node) {
+        auto right = std::make_shared<Node>();
+        if (isLeaf(node)) {
+            const size_t half = node.items.size() / 2;
+            right->items.assign(std::make_move_iterator(node.items.begin() + static_cast<std::ptrdiff_t>(half)),
+                                std::make_move_iterator(node.items.end()));
+            node.items.resize(half);
+            right->count = static_cast<size_type>(right->items.size());
+        } else {
+            const size_t half = node.children.size() / 2;
+            right->children.assign(node.children.begin() + static_cast<std::ptrdiff_t>(half), node.children.end());
+            node.children.resize(half);
+            for (const NodePtr& child : right->children)
+                right->count += child->count;
+        }
+        node.count -= right->count;
+        summarize(*right);
+        return right;
+    }
+
+    // A child of parent left under half full is merged with a neighbour, or evened out with it
+    // when both do not fit in one node, so erasing keeps the tree O(log n) deep
+    static void rebalance(Node& parent, size_t c) {
+        if (parent.children.size() < 2 || width(*parent.children[c]) >= kBranch / 2) return;
+        const size_t left = c > 0 ? c - 1 : c;
+        const Node& a = *parent.children[left];
+        const Node& b = *parent.children[left + 1];
+        auto merged = std::make_shared<Node>();
+        merged->count = a.count + b.count;
+        merged->items.reserve(a.items.size() + b.items.size());
+        merged->items.insert(merged->items.end(), a.items.begin(), a.items.end());
+        merged->items.insert(merged->items.end(), b.items.begin(), b.items.end());
+        merged->children.reserve(a.children.size() + b.children.size());
+        merged->children.insert(merged->children.end(), a.children.begin(), a.children.end());
+        merged->children.insert(merged->children.end(), b.children.begin(), b.children.end());
+        const auto second = parent.children.begin() + static_cast<std::ptrdiff_t>(left) + 1;
+        if (width(*merged) > kBranch) {
+            *second = splitOff(*merged);
+        } else {
+            parent.children.erase(second);
+        }
+        summarize(*merged);
+        parent.children[left] = std::move(merged);
+    }
+
+    // nullptr when the node becomes empty
+    static NodePtr eraseIn(const Node& node, size_type index) {
+        auto copy = std::make_shared<Node>(node);
+        copy->count--;
+        if (isLeaf(node)) {
+            copy->items.erase(copy->items.begin() + index);
+            if (copy->items.empty()) return nullptr;
+        } else {
+            size_t c = childFor(node, index);
+            NodePtr child = eraseIn(*node.children[c], index);
+            if (child) {
+                copy->children[c] = std::move(child);
+                rebalance(*copy, c);
+            } else {
+                copy->children.erase(copy->children.begin() + static_cast<std::ptrdiff_t>(c));
+            }
+            if (copy->children.empty()) return nullptr;
+        }
+        summarize(*copy);
+        return copy;
+    }
+
+    static size_t unsharedIn(const Node* node, const Node* base) {
+        if (!node || node == base) return 0;
+        size_t bytes = sizeof(Node) + node->items.capacity() * sizeof(T) + node->children.capacity() * sizeof(NodePtr);
+        for (size_t c = 0; c < node->children.size(); c++) {
+            const Node* other = base && c < base->children.size() ? base->children[c].get() : nullptr;
+            bytes += unsharedIn(node->children[c].get(), other);
+        }
+        return bytes;
+    }
+
+    NodePtr m_root;
+};
+
+} // namespace aether
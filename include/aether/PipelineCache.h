@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace aether {
+
+/**
+ * Disk-persisted VkPipelineCache. The cache file is keyed by the driver's
+ * pipelineCacheUUID (plus vendor/device ID), so a driver update or a different
+ * GPU starts from an empty cache instead of feeding the driver stale data.
+ * Instances on the same GPU share that file: save() merges what is already
+ * on disk, so one engine's pipelines do not overwrite another's.
+ */
+class PipelineCache {
+public:
+    PipelineCache();
+    ~PipelineCache();
+
+    PipelineCache(const PipelineCache&) = delete;
+    PipelineCache& operator=(const PipelineCache&) = delete;
+
+    /** cacheDirectory empty = per-user cache directory. */
+    bool initialize(VkPhysicalDevice physicalDevice, VkDevice device, const std::string& cacheDirectory = "");
+    /** Waits for background builds, writes the cache to disk and destroys it. */
+    void shutdown();
+    bool save();
+
+    VkPipelineCache getHandle() const { return m_cache; }
+    const std::string& getFilePath() const { return m_filePath; }
+    bool wasLoadedFromDisk() const { return m_loadedFromDisk; }
+
+    VkPipeline createComputePipeline(const uint32_t* code, size_t wordCount, VkPipelineLayout layout);
+    /** Builds on a worker thread so pipeline compilation stays off the startup path. */
+    std::shared_future<VkPipeline> createComputePipelineAsync(std::vector<uint32_t> code, VkPipelineLayout layout);
+
+    static std::string defaultCacheDirectory();
+
+private:
+    bool readCacheFile(const VkPhysicalDeviceProperties& properties, std::vector<uint8_t>& data) const;
+    void waitForPendingBuilds();
+
+    VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+    VkDevice m_device = VK_NULL_HANDLE;
+    VkPipelineCache m_cache = VK_NULL_HANDLE;
+    std::string m_filePath;
+    bool m_loadedFromDisk = false;
+
+    std::mutex m_pendingMutex;
+    std::vector<std::shared_future<VkPipeline>> m_pending;
+};
+
+} // namespace aether
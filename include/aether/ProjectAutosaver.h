@@ -0,0 +1,75 @@
+#pragma once
+
+#include "ProjectFile.h"
+#include <QString>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace aether {
+
+struct AutosaveStats {
+    uint64_t saves = 0;      // autosaves that wrote at least one chunk
+    uint64_t unchanged = 0;  // autosaves that found nothing to write
+    uint64_t failures = 0;
+    uint64_t superseded = 0; // documents replaced by a newer one before they were written
+    uint64_t totalBytes = 0;
+    double totalMs = 0.0;
+    double maxMs = 0.0;
+    ProjectSaveStats last;
+    QString lastError;
+};
+
+/**
+ * Writes autosaves on its own thread. The GUI thread captures a ProjectDocument
+ * (cheap: the timeline is a shared snapshot) and hands it over; the worker
+ * serialises it through a ProjectWriter, which appends only the chunks that
+ * changed since the previous autosave. Only the newest document waits: one
+ * submitted while another is queued replaces it.
+ *
+ * Autosaves go to autosavePathFor(projectPath), never over the project itself.
+ */
+class ProjectAutosaver {
+public:
+    /** Runs on the worker thread after each attempt. */
+    using SavedCallback = std::function<void(bool ok, const ProjectSaveStats& stats)>;
+
+    explicit ProjectAutosaver(SavedCallback onSaved = nullptr);
+    /** Writes a queued document before returning, so edits made just before quitting are kept. */
+    ~ProjectAutosaver();
+
+    ProjectAutosaver(const ProjectAutosaver&) = delete;
+    ProjectAutosaver& operator=(const ProjectAutosaver&) = delete;
+
+    /** Queues document for projectPath's autosave file and returns immediately. */
+    void submit(const QString& projectPath, ProjectDocument document);
+    /** Drops a queued document (e.g. the project was closed); a save in progress still finishes. */
+    void cancelPending();
+    /** True while a document is queued or being written. */
+    bool isBusy() const;
+    AutosaveStats getStats() const;
+
+    static QString autosavePathFor(const QString& projectPath);
+    /** True when projectPath has an autosave that is newer and holds different contents. */
+    static bool hasNewerAutosave(const QString& projectPath);
+
+private:
+    void workerLoop();
+
+    SavedCallback m_onSaved;
+    ProjectWriter m_writer; // worker thread only
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    QString m_pendingPath;
+    ProjectDocument m_pending;
+    bool m_hasPending = false;
+    bool m_saving = false;
+    bool m_stopping = false;
+    AutosaveStats m_stats;
+    std::thread m_thread;
+};
+
+} // namespace aether
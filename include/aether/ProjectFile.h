@@ -1,16 +1,150 @@
 #pragma once
 
 #include "ProjectSettings.h"
+#include <QByteArray>
+#include <QFile>
 #include <QString>
+#include <QVector>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
 
 namespace aether {
 
+struct MediaItem;
+struct TimelineSnapshot;
+class ProjectModel;
+class NodeGraphModel;
+class KeyframeModel;
+
+/** Chunk types of the project container (little-endian FourCCs). */
+namespace ProjectChunk {
+constexpr uint32_t fourcc(char a, char b, char c, char d) {
+    return static_cast<uint32_t>(static_cast<uint8_t>(a)) | (static_cast<uint32_t>(static_cast<uint8_t>(b)) << 8)
+         | (static_cast<uint32_t>(static_cast<uint8_t>(c)) << 16) | (static_cast<uint32_t>(static_cast<uint8_t>(d)) << 24);
+}
+constexpr uint32_t Meta = fourcc('M', 'E', 'T', 'A');      // name, location, settings, track count
+constexpr uint32_t Media = fourcc('M', 'D', 'I', 'A');     // media pool
+constexpr uint32_t Track = fourcc('T', 'R', 'A', 'K');     // one per track, id = track index
+constexpr uint32_t NodeGraph = fourcc('N', 'O', 'D', 'E');
+constexpr uint32_t Keyframes = fourcc('K', 'E', 'Y', 'S');
+} // namespace ProjectChunk
+
+/** Everything a save writes. Immutable once captured, so it can be written from any thread. */
+struct ProjectDocument {
+    QString projectName;
+    QString saveLocation;
+    ProjectSettings settings;
+    std::shared_ptr<const QVector<MediaItem>> media;
+    std::shared_ptr<const TimelineSnapshot> timeline;
+    std::shared_ptr<const NodeGraphModel> nodeGraph; // optional
+    std::shared_ptr<const KeyframeModel> keyframes;  // optional
+};
+
+struct ProjectSaveStats {
+    uint64_t bytesWritten = 0;
+    uint32_t chunksWritten = 0;
+    uint32_t chunksReused = 0; // unchanged since the last save and not rewritten
+    bool compacted = false;    // the whole file was rewritten
+    double milliseconds = 0.0;
+};
+
 class ProjectFile {
 public:
+    /** Takes a snapshot of the project; the timeline is shared, not copied. GUI thread. */
+    static ProjectDocument capture(const ProjectModel& model, const NodeGraphModel* nodeGraph,
+                                   const KeyframeModel* keyframes, const QString& projectName,
+                                   const QString& saveLocation, const ProjectSettings& settings);
+
+    /** Writes a project holding only its name, location and settings (a new, empty project). */
     static bool saveToPath(const QString& path, const QString& projectName,
                            const QString& saveLocation, const ProjectSettings& settings);
+    /** Reads name, location and settings; accepts the binary format and the older INI text files. */
     static bool loadFromPath(const QString& path, QString* outProjectName,
                              QString* outSaveLocation, ProjectSettings* outSettings);
+    /** Loads the whole project into the given models; nodeGraph and keyframes may be null. */
+    static bool loadProject(const QString& path, ProjectModel& model, NodeGraphModel* nodeGraph,
+                            KeyframeModel* keyframes, QString* outProjectName, QString* outSaveLocation,
+                            ProjectSettings* outSettings, QString* outError = nullptr);
+};
+
+/**
+ * Random access to a saved project. open() reads the header and the index at
+ * the end of the file and CRC-checks the chunks the newest save appended; the
+ * rest are loaded on demand and CRC-checked when read. If the file ends in a
+ * torn write, or a chunk of the newest save is damaged, the newest earlier
+ * index that checks out is used.
+ */
+class ProjectReader {
+public:
+    struct ChunkEntry {
+        uint32_t type = 0;
+        uint32_t id = 0;
+        uint32_t version = 0;
+        uint32_t crc = 0;
+        uint64_t offset = 0; // of the payload
+        uint64_t size = 0;
+    };
+
+    bool open(const QString& path);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+
+    const std::vector<ChunkEntry>& chunks() const { return m_chunks; }
+    const ChunkEntry* findChunk(uint32_t type, uint32_t id = 0) const;
+    bool readChunk(const ChunkEntry& entry, QByteArray& payload);
+    uint64_t getGeneration() const { return m_generation; }
+    /** Offset just past the index in use; later bytes are a torn write. */
+    uint64_t getValidEnd() const { return m_validEnd; }
+    const QString& getLastError() const { return m_lastError; }
+
+private:
+    bool readIndex(uint64_t indexOffset, uint32_t indexSize, uint32_t indexCrc);
+    bool recoverIndex();
+    bool appendedChunksIntact(uint64_t indexOffset);
+
+    QFile m_file;
+    std::vector<ChunkEntry> m_chunks;
+    uint64_t m_generation = 0;
+    uint64_t m_validEnd = 0;
+    QString m_lastError;
+};
+
+/**
+ * Saves projects incrementally. The file is an append-only journal: each save
+ * appends only the chunks whose contents changed, then a new index and trailer,
+ * so an interrupted save leaves the previous index intact. When the file is new,
+ * was changed behind the writer's back, or holds mostly superseded chunks, it is
+ * rewritten in full to a temporary file and atomically renamed over the old one.
+ *
+ * One writer per file; not thread-safe, but it may live on any one thread.
+ */
+class ProjectWriter {
+public:
+    ProjectWriter();
+    ~ProjectWriter();
+
+    bool save(const QString& path, const ProjectDocument& document, ProjectSaveStats* stats = nullptr);
+    /** Forget what was written; the next save rewrites the whole file. */
+    void reset();
+    const QString& getLastError() const { return m_lastError; }
+
+private:
+    struct Pending;
+
+    bool writeFull(const QString& path, std::vector<Pending>& pending, ProjectSaveStats& stats);
+    bool writeAppend(const QString& path, std::vector<Pending>& pending, ProjectSaveStats& stats);
+
+    QString m_path;
+    uint64_t m_fileSize = 0;
+    uint64_t m_generation = 0;
+    std::map<std::pair<uint32_t, uint32_t>, ProjectReader::ChunkEntry> m_written;
+    // What the last save wrote, to skip re-encoding parts that are still shared
+    std::shared_ptr<const QVector<MediaItem>> m_lastMedia;
+    std::shared_ptr<const TimelineSnapshot> m_lastTimeline;
+    QString m_lastError;
 };
 
 } // namespace aether
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "aether/ChunkedExport.h"
+#include <QString>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace aether {
+
+enum class RenderJobStatus { Queued, Rendering, Done, Failed, Cancelled };
+
+/** A render queue entry as the queue reports it. */
+struct RenderJobInfo {
+    QString id;                // the job's directory in the queue directory
+    QString name;
+    int priority = 0;          // higher renders first; equal priorities in the order they were added
+    RenderJobStatus status = RenderJobStatus::Queued;
+    EncodeParams params;
+    int64_t framesDone = 0;
+    int64_t totalFrames = 0;
+    double fps = 0.0;          // throughput of the current run
+    double etaSeconds = -1.0;  // -1 = unknown
+    uint32_t workers = 0;      // chunk engines rendering it now
+    std::string error;
+};
+
+/** What the scheduler shares out between jobs. */
+struct RenderBudget {
+    uint32_t cores = 1;
+    uint64_t availableBytes = 0;
+};
+
+/**
+ * Renders exports one after another, or side by side when there is room, on
+ * its own scheduler thread. Each job is a ChunkedExport; the scheduler gives
+ * the highest-priority jobs as many chunk engines as the cores and the free
+ * memory allow, and a job added above a running one takes engines from it
+ * (the lower job stops after its finished chunks and carries on later).
+ *
+ * Jobs live in the queue directory, one subdirectory each holding a snapshot
+ * of the project, the job's settings and its chunks, so the queue survives a
+ * restart and a job that was rendering resumes from its last finished chunk.
+ */
+class RenderQueue {
+public:
+    /** Runs on the scheduler thread when a job changes, and every second while one renders. */
+    using ChangedCallback = std::function<void()>;
+    using BackendFactory = ChunkedExport::BackendFactory;
+
+    /** Loads the jobs in directory (GUI thread: it builds project models) and starts the scheduler. */
+    explicit RenderQueue(const QString& directory, ChangedCallback onChanged = nullptr,
+                         BackendFactory backendFactory = createEncoderBackend);
+    /** Stops rendering; running jobs resume from their finished chunks next time. */
+    ~RenderQueue();
+
+    RenderQueue(const RenderQueue&) = delete;
+    RenderQueue& operator=(const RenderQueue&) = delete;
+
+    /** Saves the job to the queue directory; returns its id, or an empty string (see error). */
+    QString submit(const ExportRequest& request, const QString& name, int priority, std::string* error = nullptr);
+    void setPriority(const QString& id, int priority);
+    /** Stops a job and keeps its finished chunks; requeue() carries on from them. */
+    void cancel(const QString& id);
+    /** Queues a cancelled or failed job again. */
+    void requeue(const QString& id);
+    /** Cancels the job and deletes it with its chunks. */
+    void remove(const QString& id);
+
+    /**
+     * A paused queue starts no jobs; running ones carry on. The queue starts
+     * paused unless it was rendering when the application last stopped.
+     */
+    void setPaused(bool paused);
+    bool isPaused() const;
+
+    /** Jobs in the order they render. Safe to call from any thread. */
+    std::vector<RenderJobInfo> getJobs() const;
+
+    /** Cores and memory the machine has free now. */
+    static RenderBudget currentBudget();
+    /** Estimated memory one chunk engine needs for params: the frames in its queues and the encoder's lookahead. */
+    static uint64_t engineMemory(const EncodeParams& params, uint32_t queueDepth);
+
+private:
+    struct Job;
+
+    void load();
+    bool saveJob(const Job& job) const;
+    void schedulerLoop();
+    void collectFinished(std::unique_lock<std::mutex>& lock);
+    void schedule();
+    bool startJob(Job& job, uint32_t engines, uint32_t encoderThreads);
+    void updateProgress(Job& job) const;
+    std::vector<Job*> renderOrder() const;
+
+    QString m_directory;
+    ChangedCallback m_onChanged;
+    BackendFactory m_backendFactory;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::vector<std::unique_ptr<Job>> m_jobs;
+    uint64_t m_nextSequence = 1;
+    bool m_paused = true;
+    bool m_dirty = false;        // something changed that the callback has not reported yet
+    bool m_stopping = false;
+    std::thread m_thread;
+};
+
+} // namespace aether
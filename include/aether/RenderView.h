@@ -8,6 +8,14 @@
 
 namespace aether {
 class TilingRenderer;
+class DirtyRegionTracker;
+struct DirtyRect;
+class VulkanRenderer;
+struct CompiledEffectChain;
+class PipelineCache;
+class VulkanVFXEngine;
+struct CpuImage;
+struct ImageDiff;
 
 enum class ShaderType {
     Vertex,
@@ -23,6 +31,17 @@ struct Shader {
     std::string entryPoint = "main";
 };
 
+enum class RenderBackend {
+    Vulkan,
+    Cpu
+};
+
+struct PassTiming {
+    std::string name;
+    double milliseconds = 0.0;
+    bool gpu = false; // timestamp query vs. host clock
+};
+
 struct RenderViewSettings {
     uint32_t width = 1920;
     uint32_t height = 1080;
@@ -42,11 +61,21 @@ public:
 
     // Initialization
     bool initialize(VkDevice device, VkPhysicalDevice physicalDevice, VkQueue graphicsQueue, VkCommandPool commandPool);
+    // Offscreen mode for CI / render nodes: owns a headless VulkanRenderer (any ICD,
+    // including lavapipe) and falls back to the CPU effect backend when Vulkan is
+    // unavailable. AETHER_HEADLESS_BACKEND=cpu forces the CPU path.
+    bool initializeHeadless(uint32_t width, uint32_t height);
     void shutdown();
+    bool isHeadless() const { return m_headless; }
+    /** Backend that produced the last offscreen frame. */
+    RenderBackend getBackend() const { return m_backend; }
 
     // Shader management
     bool loadShader(const std::string& name, ShaderType type, const std::string& source);
-    bool loadShaderFromFile(const std::string& name, ShaderType type, const std::string& filePath);
+    bool loadShaderFromFile(const std::string& name, ShaderType type, const std::string& filePath); // .spv or GLSL
+    bool loadShaderSpirv(const std::string& name, ShaderType type, const uint32_t* code, size_t wordCount);
+    /** Loads SPIR-V compiled from shaders/<shaderName>.comp at build time. */
+    bool loadEmbeddedShader(const std::string& name, ShaderType type, const std::string& shaderName);
     void unloadShader(const std::string& name);
     Shader* getShader(const std::string& name);
     
@@ -55,6 +84,7 @@ public:
     void destroyPipeline();
     VkPipeline getPipeline() const { return m_graphicsPipeline; }
     VkPipelineLayout getPipelineLayout() const { return m_pipelineLayout; }
+    PipelineCache* getPipelineCache() const { return m_pipelineCache.get(); }
     
     // Rendering
     void beginRender(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, VkExtent2D extent);
@@ -68,9 +98,31 @@ public:
     void setPan(float x, float y) { m_settings.panX = x; m_settings.panY = y; }
     
     // Effect management
+    // How far an edit spreads through the chain follows from each effect's shader and parameters
     bool addEffect(const std::string& name, const std::string& shaderName);
     void removeEffect(const std::string& name);
     void clearEffects();
+    // Parameters use the effect shader's push-constant layout
+    void setEffectParameters(const std::string& name, const std::vector<float>& pushConstants);
+    
+    /** Renders the effect chain over `input` into host memory (headless mode only). With tiling
+     *  enabled the last result is kept, and only tiles invalidated since then (or all of them,
+     *  when the input pixels change) are re-rendered into it. */
+    bool renderOffscreen(const CpuImage& input, CpuImage& output);
+    /** Renders `input` with the Vulkan compute passes and with the CPU backend and diffs the results;
+     *  false when either backend cannot render it. */
+    bool compareBackends(const CpuImage& input, ImageDiff& diff, uint8_t tolerance = 1);
+    const std::vector<PassTiming>& getLastPassTimings() const { return m_lastPassTimings; }
+    /** Full-frame passes after fusing per-pixel effects, and that count relative to one pass per effect. */
+    size_t getCompiledPassCount();
+    float getChainBandwidthRatio();
+    
+    // Incremental re-render: only tiles touched by a parameter change are recomputed
+    void invalidateEffectParameter(const std::string& effectName, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+    void invalidateEffect(const std::string& effectName);
+    void invalidateAll();
+    /** Fraction of tiles recomputed by the last renderOffscreen() (1.0 when tiling is off). */
+    float getLastRecomputedTileFraction() const;
     
     // Tiling render support
     void enableTiling(bool enable) { m_useTiling = enable; }
@@ -79,9 +131,18 @@ public:
 
 private:
     bool compileShader(const std::string& source, ShaderType type, VkShaderModule& module);
+    void storeShader(const std::string& name, ShaderType type, VkShaderModule module, const std::string& source);
+    bool initializePipelineCache();
     bool createDescriptorSetLayout();
     bool createUniformBuffers();
     void updateUniformBuffer();
+    // Re-render `regions` of `frame`, which holds the previous result, from `input`
+    bool renderOffscreenGpu(const CpuImage& input, const std::vector<DirtyRect>& regions, CpuImage& frame);
+    bool renderOffscreenCpu(const CpuImage& input, const std::vector<DirtyRect>& regions, CpuImage& frame);
+    std::vector<DirtyRect> takeDirtyRegions(const CpuImage& input);
+    const CompiledEffectChain& compiledChain();
+    bool createComputeTargets(uint32_t width, uint32_t height);
+    void destroyComputeTargets();
 
     VkDevice m_device = VK_NULL_HANDLE;
     VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
@@ -92,14 +153,37 @@ private:
     VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
     VkPipeline m_graphicsPipeline = VK_NULL_HANDLE;
     VkDescriptorSetLayout m_descriptorSetLayout = VK_NULL_HANDLE;
+    std::unique_ptr<PipelineCache> m_pipelineCache;
     
     RenderViewSettings m_settings;
     std::vector<std::string> m_activeEffects;
+    std::map<std::string, std::string> m_effectShaders;
+    std::map<std::string, std::vector<float>> m_effectParameters;
     
     // Tiling render
     bool m_useTiling = false;
     uint32_t m_tileSize = 512;
     std::unique_ptr<TilingRenderer> m_tilingRenderer;
+    std::unique_ptr<DirtyRegionTracker> m_dirtyTracker;
+    
+    // Headless rendering
+    bool m_headless = false;
+    RenderBackend m_backend = RenderBackend::Vulkan;
+    std::unique_ptr<VulkanRenderer> m_offscreenRenderer;
+    std::unique_ptr<VulkanVFXEngine> m_vfxEngine;
+    // Ping-pong rgba8 storage images for the compute passes and a host-visible staging buffer
+    VkImage m_computeImages[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
+    VkImageView m_computeViews[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
+    VkDeviceMemory m_computeMemory[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
+    VkBuffer m_stagingBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory m_stagingMemory = VK_NULL_HANDLE;
+    uint32_t m_computeWidth = 0;
+    uint32_t m_computeHeight = 0;
+    std::unique_ptr<CompiledEffectChain> m_compiledChain;
+    std::unique_ptr<CpuImage> m_tileImage; // last offscreen result, updated tile by tile
+    uint64_t m_tileInputHash = 0;
+    bool m_chainDirty = true;
+    std::vector<PassTiming> m_lastPassTimings;
     
     bool m_initialized = false;
 };
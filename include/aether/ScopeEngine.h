@@ -0,0 +1,140 @@
+#pragma once
+
+#include "aether/CpuEffectBackend.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace aether {
+
+class ThreadPool;
+
+/**
+ * One 8-bit frame handed to the scopes. Planar YCbCr is the decoder's native
+ * output and is analysed as-is; packed RGB24 (planes[0] only) is converted with
+ * BT.709 full-range coefficients. The pixel memory is borrowed, not copied.
+ */
+struct ScopeFrame {
+    enum class Format { Yuv420, Yuv422, Yuv444, Rgb24 };
+
+    Format format = Format::Rgb24;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    const uint8_t* planes[3] = {nullptr, nullptr, nullptr};
+    uint32_t strides[3] = {0, 0, 0};
+    bool limitedRange = true; // YCbCr only: 16-235 video levels
+
+    bool isValid() const;
+};
+
+struct ScopeSettings {
+    uint32_t waveformColumns = 512;
+    uint64_t sampleBudget = 1u << 20; // pixels analysed per frame; larger frames are subsampled
+    float intensity = 1.0f;           // brightness of the density images
+};
+
+/** Density images ready to draw (RGBA8, row 0 at the top), plus what they cost. */
+struct ScopeResult {
+    CpuImage waveform;    // waveformColumns x 256, luma
+    CpuImage parade;      // 3 * waveformColumns x 256, R | G | B
+    CpuImage vectorscope; // 256 x 256, Cb to the right, Cr up
+    CpuImage histogram;   // 256 x 128, luma and RGB overlaid
+    uint32_t frameWidth = 0;
+    uint32_t frameHeight = 0;
+    uint32_t sampleStep = 1;
+    uint64_t samples = 0;
+    double accumulateMs = 0.0;
+    double resolveMs = 0.0;
+    double computeMs() const { return accumulateMs + resolveMs; }
+};
+
+/**
+ * Computes waveform, RGB parade, vectorscope and histogram for a frame.
+ * Rows are split across a ThreadPool; every chunk converts its rows with SSE2
+ * (where available) and counts into its own bins, which are summed and tone
+ * mapped once at the end, so there is no sharing between threads while counting.
+ */
+class ScopeEngine {
+public:
+    ScopeEngine();
+
+    /** nullptr = ThreadPool::getInstance(). */
+    void setThreadPool(ThreadPool* pool) { m_pool = pool; }
+    void setSettings(const ScopeSettings& settings) { m_settings = settings; }
+    const ScopeSettings& getSettings() const { return m_settings; }
+
+    bool analyze(const ScopeFrame& frame, ScopeResult& result);
+
+    /** Row/column step that keeps width*height/step^2 within the sample budget. */
+    static uint32_t chooseSampleStep(uint32_t width, uint32_t height, uint64_t sampleBudget);
+
+private:
+    struct Bins {
+        std::vector<uint32_t> waveform;    // [column][level]
+        std::vector<uint32_t> parade;      // [channel][column][level]
+        std::vector<uint32_t> vectorscope; // [cr][cb]
+        std::vector<uint32_t> histogram;   // [Y, R, G, B][level]
+    };
+
+    ThreadPool& pool() const;
+    void accumulateRows(const ScopeFrame& frame, uint32_t step, size_t rowBegin, size_t rowEnd, Bins& bins) const;
+    void reduceBins(size_t chunkCount);
+    void resolveImages(ScopeResult& result);
+
+    ThreadPool* m_pool = nullptr;
+    ScopeSettings m_settings;
+    std::vector<Bins> m_bins;           // one set per parallel chunk, reused between frames
+    std::vector<uint16_t> m_sampleColumn; // waveform column of each sampled x
+    std::vector<uint8_t> m_vectorscopeTint; // RGB hue of each Cb/Cr bin
+};
+
+/**
+ * Runs a ScopeEngine on its own thread. Frames arriving while one is being
+ * analysed replace each other, so a slow frame drops intermediates instead of
+ * queueing latency; the caller never waits for analysis.
+ */
+class ScopeWorker {
+public:
+    using ResultCallback = std::function<void()>;
+
+    /** onResult runs on the worker thread after each new result is published. */
+    explicit ScopeWorker(ResultCallback onResult = nullptr);
+    ~ScopeWorker();
+
+    ScopeWorker(const ScopeWorker&) = delete;
+    ScopeWorker& operator=(const ScopeWorker&) = delete;
+
+    void setSettings(const ScopeSettings& settings);
+    /** owner keeps the frame's pixel memory alive until the worker is done with it. */
+    void submit(const ScopeFrame& frame, std::shared_ptr<const void> owner);
+
+    std::shared_ptr<const ScopeResult> latestResult() const;
+    uint64_t getDroppedFrames() const { return m_droppedFrames.load(); }
+
+private:
+    void workerLoop();
+
+    ScopeEngine m_engine;
+    ResultCallback m_onResult;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    ScopeFrame m_pendingFrame;
+    std::shared_ptr<const void> m_pendingOwner;
+    bool m_hasPending = false;
+    bool m_settingsChanged = false;
+    ScopeSettings m_pendingSettings;
+    bool m_stopping = false;
+    std::shared_ptr<ScopeResult> m_latest;
+    std::shared_ptr<ScopeResult> m_spare; // worker thread only
+    std::atomic<uint64_t> m_droppedFrames{0};
+    std::thread m_thread;
+};
+
+} // namespace aether
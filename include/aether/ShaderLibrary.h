@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace aether {
+
+/** SPIR-V for one shader in shaders/, compiled by the aether_shaders build step. */
+struct EmbeddedShader {
+    const char* name = nullptr; // file stem, e.g. "blur"
+    const uint32_t* code = nullptr;
+    size_t wordCount = 0;
+
+    size_t sizeInBytes() const { return wordCount * sizeof(uint32_t); }
+};
+
+/** Looks up embedded SPIR-V by name; nullptr when the build had no shader compiler. */
+const EmbeddedShader* findEmbeddedShader(const std::string& name);
+std::vector<std::string> listEmbeddedShaders();
+
+/** Reads a .spv file produced by glslc; false if missing or not valid SPIR-V. */
+bool loadSpirvFile(const std::string& filePath, std::vector<uint32_t>& words);
+
+} // namespace aether
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace aether {
+
+/**
+ * Fixed-size worker pool shared by engine subsystems (particles, scopes, node graph, export).
+ * parallelFor lets the calling thread help with its own chunks, so nested calls from inside a
+ * task cannot deadlock the pool.
+ */
+class ThreadPool {
+public:
+    /** threadCount workers; 0 runs everything on the calling thread. */
+    explicit ThreadPool(size_t threadCount = defaultThreadCount());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Process-wide pool
+    static ThreadPool& getInstance();
+    /** One worker per hardware thread, minus the caller. */
+    static size_t defaultThreadCount();
+
+    size_t getThreadCount() const { return m_workers.size(); }
+    /** Workers plus the calling thread, i.e. the parallelism parallelFor can reach. */
+    size_t getConcurrency() const { return m_workers.size() + 1; }
+
+    template <typename F>
+    auto submit(F&& task) -> std::future<decltype(task())> {
+        using Result = decltype(task());
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> future = packaged->get_future();
+        enqueue([packaged]() { (*packaged)(); });
+        return future;
+    }
+
+    /**
+     * Calls body(chunkBegin, chunkEnd) over [begin, end) in chunks of at least grainSize
+     * and returns when all chunks are done.
+     */
+    void parallelFor(size_t begin, size_t end, size_t grainSize,
+                     const std::function<void(size_t, size_t)>& body);
+
+private:
+    void enqueue(std::function<void()> task);
+    bool runPendingTask();
+    void workerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopping = false;
+};
+
+} // namespace aether
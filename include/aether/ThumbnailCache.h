@@ -0,0 +1,128 @@
+#pragma once
+
+#include <QHash>
+#include <QImage>
+#include <QRect>
+#include <QSet>
+#include <QString>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace aether {
+
+/**
+ * Filmstrip thumbnails for the timeline. Thumbnails are taken every
+ * levelIntervalMs(level) of source time, at the keyframe at or before each
+ * time so that each one costs a seek and a single decode. They are grouped
+ * into atlases: strips of kThumbsPerAtlas frames that are extracted, cached
+ * and stored on disk (as JPEG) as a unit.
+ *
+ * Lookups are made from paintEvent and never block: a missing atlas is
+ * queued and a thumbnail from another level is returned meanwhile. Queued
+ * atlases are extracted lowest priority value first; an atlas that the
+ * last two paint passes did not ask for again is dropped from the queue.
+ * An atlas that could not be extracted is remembered for a while, within
+ * the memory budget, rather than retried on every paint.
+ */
+class ThumbnailCache {
+public:
+    static constexpr int kThumbHeight = 72;
+    static constexpr int kThumbsPerAtlas = 16;
+    static constexpr int kLevelCount = 14;
+
+    static qint64 levelIntervalMs(int level) { return 250LL << level; }
+    /** Coarsest level whose thumbnails are at most msPerThumb apart. */
+    static int levelForSpacing(double msPerThumb);
+
+    /** Runs on a worker thread whenever an atlas becomes available. */
+    using ReadyCallback = std::function<void()>;
+
+    explicit ThumbnailCache(ReadyCallback onReady, const QString& diskDir = QString(),
+                            size_t memoryBudgetBytes = 128u * 1024u * 1024u, size_t threadCount = 2);
+    ~ThumbnailCache();
+
+    ThumbnailCache(const ThumbnailCache&) = delete;
+    ThumbnailCache& operator=(const ThumbnailCache&) = delete;
+
+    /** Starts a paint pass; requests not repeated since the previous pass become stale. */
+    void beginFrame();
+
+    /**
+     * Thumbnail nearest to sourceMs: on success atlas and source are the image
+     * and rectangle to draw. Queues the atlas at level if it is not cached.
+     * GUI thread.
+     */
+    bool thumbnail(const QString& mediaPath, int level, qint64 sourceMs, int priority,
+                   QImage& atlas, QRect& source);
+    /** Queues the atlas holding sourceMs without looking anything up (prefetch). */
+    void request(const QString& mediaPath, int level, qint64 sourceMs, int priority);
+
+    size_t getMemoryBytes() const;
+    uint64_t getExtractedCount() const { return m_extracted.load(); }
+    uint64_t getDiskHitCount() const { return m_diskHits.load(); }
+    size_t getQueueLength() const;
+
+private:
+    struct Atlas {
+        QImage image;
+        int thumbWidth = 0;
+        int count = 0; // thumbnails present; the media may end inside the atlas
+    };
+    struct Entry {
+        std::shared_ptr<const Atlas> atlas; // null: extraction failed
+        std::chrono::steady_clock::time_point failedAt;
+        std::list<QString>::iterator lru;
+    };
+    struct Job {
+        QString mediaPath;
+        int level = 0;
+        int index = 0;
+        int priority = 0;
+        uint64_t frame = 0; // paint pass that last asked for it
+        uint64_t order = 0; // FIFO among equal priorities
+    };
+
+    static QString atlasKey(const QString& mediaPath, int level, int index);
+    static size_t entryBytes(const Entry& entry);
+    /** Whether key has an entry; one that failed long enough ago is dropped so it is tried again. Locked by caller. */
+    bool isCached(const QString& key);
+    std::shared_ptr<const Atlas> find(const QString& key); // locked by caller
+    void enqueue(const QString& mediaPath, int level, int index, int priority); // locked by caller
+    void store(const QString& key, std::shared_ptr<const Atlas> atlas); // locked by caller
+    void workerLoop();
+
+    // Worker side
+    QString diskPath(const QString& mediaPath, int level, int index) const;
+    std::shared_ptr<const Atlas> loadFromDisk(const QString& path) const;
+    void saveToDisk(const QString& path, const Atlas& atlas) const;
+    static std::shared_ptr<const Atlas> extract(const QString& mediaPath, int level, int index);
+    void trimDisk(qint64 maxBytes) const;
+
+    ReadyCallback m_onReady;
+    QString m_diskDir;
+    size_t m_memoryBudget;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    QHash<QString, Entry> m_atlases;
+    std::list<QString> m_lru; // most recent first
+    size_t m_memoryBytes = 0;
+    QHash<QString, Job> m_queue;
+    QSet<QString> m_running;
+    uint64_t m_frame = 0;
+    uint64_t m_order = 0;
+    bool m_stopping = false;
+    std::atomic<uint64_t> m_extracted{0};
+    std::atomic<uint64_t> m_diskHits{0};
+    std::vector<std::thread> m_threads;
+};
+
+} // namespace aether
@@ -3,6 +3,7 @@
 #include <vulkan/vulkan.h>
 #include <vector>
 #include <cstdint>
+#include <cstddef>
 
 namespace aether {
 
@@ -12,6 +13,13 @@ struct Tile {
     uint32_t width = 512;
     uint32_t height = 512;
     bool isVisible = false;
+    bool isDirty = true;
+};
+
+struct TileUpdateStats {
+    uint32_t recomputedTiles = 0;
+    uint32_t totalTiles = 0;
+    float recomputedFraction = 0.0f;
 };
 
 class TilingRenderer {
@@ -34,6 +42,15 @@ public:
     // Tile queries
     Tile getTileAt(uint32_t x, uint32_t y) const;
     std::vector<Tile> getTilesInRegion(uint32_t x, uint32_t y, uint32_t width, uint32_t height) const;
+
+    // Dirty tracking (tiles whose content must be recomputed and re-uploaded)
+    void invalidateRegion(uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+    void invalidateAll();
+    /** Visible dirty tiles for this frame; marks them clean and updates the stats.
+     *  Dirty tiles outside the viewport stay dirty until they scroll into view. */
+    std::vector<Tile> takeDirtyVisibleTiles();
+    uint32_t getDirtyTileCount() const;
+    const TileUpdateStats& getLastUpdateStats() const { return m_lastUpdateStats; }
     
     // Statistics
     uint32_t getTotalTileCount() const { return static_cast<uint32_t>(m_allTiles.size()); }
@@ -44,10 +61,13 @@ private:
     void generateTiles();
     void cullTiles();
     bool isTileVisible(const Tile& tile) const;
+    size_t tileIndex(uint32_t tileColumn, uint32_t tileRow) const { return static_cast<size_t>(tileRow) * m_tilesX + tileColumn; }
 
     uint32_t m_imageWidth = 0;
     uint32_t m_imageHeight = 0;
     uint32_t m_tileSize = 512;
+    uint32_t m_tilesX = 0;
+    uint32_t m_tilesY = 0;
     
     uint32_t m_viewportX = 0;
     uint32_t m_viewportY = 0;
@@ -56,6 +76,7 @@ private:
     
     std::vector<Tile> m_allTiles;
     std::vector<Tile> m_visibleTiles;
+    TileUpdateStats m_lastUpdateStats;
     
     bool m_initialized = false;
 };
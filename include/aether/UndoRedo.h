@@ -1,5 +1,7 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
 #include <memory>
 #include <vector>
 #include <functional>
@@ -13,13 +15,29 @@ public:
     virtual void undo() = 0;
     virtual void redo() = 0;
     virtual std::string getDescription() const = 0;
+
+    // Approximate bytes held by the action; the manager bounds its history by the sum
+    virtual size_t getMemoryUsage() const { return sizeof(*this); }
+
+    // Actions sharing a non-empty key that arrive within the coalesce window are merged
+    // into one undo step (e.g. every move of one slider drag)
+    virtual std::string getCoalesceKey() const { return std::string(); }
+
+    // Absorb a newer action so that undo() restores this action's original state and
+    // redo() the newer one's result. Return false to keep them as separate steps.
+    virtual bool mergeWith(const UndoRedoAction& newer) { (void)newer; return false; }
 };
 
+/**
+ * Linear undo history kept in a ring buffer, so dropping the oldest step is O(1).
+ * The history is bounded by both step count and the actions' memory usage; the
+ * oldest steps are dropped first, but the newest step is always kept.
+ */
 class UndoRedoManager {
 public:
     // Singleton access
     static UndoRedoManager& getInstance();
-    
+
     // Delete copy constructor and assignment operator
     UndoRedoManager(const UndoRedoManager&) = delete;
     UndoRedoManager& operator=(const UndoRedoManager&) = delete;
@@ -29,24 +47,48 @@ public:
     bool undo();
     bool redo();
     void clear();
-    
+    // Ends the current gesture: the next action starts a new step even if its key matches
+    void breakCoalescing() {
+        m_lastPushTime = {};
+        m_gestureCanMerge = false;
+    }
+    // An explicit gesture (a drag): while it is open, actions with matching keys fold into
+    // one step however long it pauses, instead of only within the coalesce window
+    void beginGesture();
+    void endGesture();
+
     // State queries
     bool canUndo() const { return m_currentIndex > 0; }
-    bool canRedo() const { return m_currentIndex < m_actions.size(); }
+    bool canRedo() const { return m_currentIndex < m_count; }
     std::string getUndoDescription() const;
     std::string getRedoDescription() const;
-    
+
     // History management
-    void setMaxHistorySize(size_t size) { m_maxHistorySize = size; }
-    size_t getHistorySize() const { return m_actions.size(); }
+    void setMaxHistorySize(size_t size);
+    void setMaxHistoryBytes(size_t bytes);
+    void setCoalesceWindow(std::chrono::milliseconds window) { m_coalesceWindow = window; }
+    size_t getHistorySize() const { return m_count; }
+    size_t getHistoryBytes() const { return m_historyBytes; }
 
 private:
     UndoRedoManager() = default;
     ~UndoRedoManager() = default;
 
-    std::vector<std::unique_ptr<UndoRedoAction>> m_actions;
+    std::unique_ptr<UndoRedoAction>& at(size_t index) { return m_ring[(m_head + index) % m_ring.size()]; }
+    const std::unique_ptr<UndoRedoAction>& at(size_t index) const { return m_ring[(m_head + index) % m_ring.size()]; }
+    void trimHistory();
+
+    std::vector<std::unique_ptr<UndoRedoAction>> m_ring;
+    size_t m_head = 0;  // slot of the oldest step
+    size_t m_count = 0;
     size_t m_currentIndex = 0;
-    size_t m_maxHistorySize = 100;
+    size_t m_historyBytes = 0;
+    size_t m_maxHistorySize = 1000;
+    size_t m_maxHistoryBytes = 256u * 1024u * 1024u;
+    std::chrono::milliseconds m_coalesceWindow{500};
+    std::chrono::steady_clock::time_point m_lastPushTime;
+    bool m_inGesture = false;
+    bool m_gestureCanMerge = false; // the newest step was pushed by the open gesture
 };
 
 } // namespace aether
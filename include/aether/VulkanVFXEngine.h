@@ -7,8 +7,14 @@
 namespace aether {
 
 struct VulkanContext;
+struct FusedPixelKernel;
+class PipelineCache;
+class ParticleSystem;
 
-/** GPU-accelerated VFX: Blur, Color Correction, Particles via Vulkan Compute Shaders. */
+/**
+ * GPU-accelerated VFX: Blur, Color Correction and fused per-pixel chains via Vulkan compute
+ * shaders. Handles are passed as void* so callers need not include the Vulkan headers.
+ */
 class VulkanVFXEngine {
 public:
     VulkanVFXEngine();
@@ -17,25 +23,66 @@ public:
     VulkanVFXEngine(const VulkanVFXEngine&) = delete;
     VulkanVFXEngine& operator=(const VulkanVFXEngine&) = delete;
 
-    bool initialize(void* vulkanInstance, void* physicalDevice, void* device);
+    /** Returns immediately; compute pipelines are built in the background (see arePipelinesReady).
+     *  sharedCache (which must outlive the engine) replaces a pipeline cache of the engine's own. */
+    bool initialize(void* vulkanInstance, void* physicalDevice, void* device, PipelineCache* sharedCache = nullptr);
     void shutdown();
 
-    /** Run blur pass on input texture; output to output texture. */
-    void dispatchBlur(uint32_t width, uint32_t height, float radius);
-    /** Run color correction (3-way or LUT) pass. */
-    void dispatchColorCorrection(uint32_t width, uint32_t height);
-    /** Run particle simulation step. */
+    /** Recycles the descriptor sets and buffers of earlier dispatches; call once the GPU has finished them. */
+    void beginFrame();
+    /**
+     * The dispatches record into commandBuffer and compute the output rectangle (x, y, width,
+     * height); reads still clamp at the image edges. input and output are VkImageViews of
+     * same-sized rgba8 storage images in VK_IMAGE_LAYOUT_GENERAL. Each dispatch ends with a
+     * barrier that makes its output visible to later compute and transfer commands. They
+     * record nothing and return false while the pipeline they need is not built.
+     */
+    bool dispatchBlur(void* commandBuffer, void* input, void* output, uint32_t x, uint32_t y, uint32_t width,
+                      uint32_t height, float radius);
+    /** pushConstants: color_correction { vec4 lift; vec4 gamma; vec4 gain }, identity for missing entries. */
+    bool dispatchColorCorrection(void* commandBuffer, void* input, void* output, uint32_t x, uint32_t y,
+                                 uint32_t width, uint32_t height, const std::vector<float>& pushConstants);
+    /** A fused run of per-pixel effects (EffectChainCompiler output) as one pass; its LUT steps must share one size. */
+    bool dispatchPixelChain(void* commandBuffer, void* input, void* output, uint32_t x, uint32_t y, uint32_t width,
+                            uint32_t height, const FusedPixelKernel& kernel);
+    /** Run particle simulation step (keeps `count` particles alive; simulated on the CPU pool). */
     void dispatchParticles(uint32_t count, float deltaTime);
+    ParticleSystem& getParticleSystem();
 
     bool isInitialized() const { return m_initialized; }
+    /** Non-blocking: true once every background pipeline build has finished. */
+    bool arePipelinesReady();
+    /** Blocks until the background pipeline builds have finished. */
+    void waitForPipelines();
+
+    /** Whether dispatchPixelChain can run `kernel` (LUT steps of different sizes cannot share one pass). */
+    static bool canDispatchPixelChain(const FusedPixelKernel& kernel);
 
 private:
+    struct PendingPipelines;
+    struct FrameResources;
+
     bool createComputePipelines();
+    void collectPipelines(bool wait);
+    void* allocateDescriptorSet(void* setLayout);
+    void* createStorageBuffer(const void* data, size_t size);
     bool m_initialized = false;
+    void* m_physicalDevice = nullptr;
     void* m_device = nullptr;
     void* m_blurPipeline = nullptr;
     void* m_colorCorrectionPipeline = nullptr;
     void* m_particlesPipeline = nullptr;
+    void* m_pixelChainPipeline = nullptr;
+    void* m_descriptorSetLayout = nullptr;
+    void* m_pixelChainSetLayout = nullptr;
+    void* m_blurLayout = nullptr;
+    void* m_colorCorrectionLayout = nullptr;
+    void* m_pixelChainLayout = nullptr;
+    std::unique_ptr<PipelineCache> m_ownedPipelineCache;
+    PipelineCache* m_pipelineCache = nullptr;
+    std::unique_ptr<PendingPipelines> m_pending;
+    std::unique_ptr<FrameResources> m_frame;
+    std::unique_ptr<ParticleSystem> m_particles;
 };
 
 } // namespace aether
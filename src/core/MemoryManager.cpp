@@ -4,9 +4,6 @@
 #ifdef _WIN32
 #include <windows.h>
 #include <psapi.h>
-#else
-#include <sys/sysinfo.h>
-#include <unistd.h>
 #endif
 #include <iostream>
 
@@ -51,29 +48,11 @@ void MemoryManager::update() {
 }
 
 bool MemoryManager::querySystemMemory() {
-#ifdef _WIN32
-    MEMORYSTATUSEX memInfo;
-    memInfo.dwLength = sizeof(MEMORYSTATUSEX);
-    
-    if (GlobalMemoryStatusEx(&memInfo)) {
-        m_totalRAM = memInfo.ullTotalPhys;
-        m_availableRAM = memInfo.ullAvailPhys;
-        m_usedRAM = m_totalRAM - m_availableRAM;
-        return true;
-    }
-    
-    return false;
-#else
-    struct sysinfo si;
-    if (sysinfo(&si) == 0) {
-        m_totalRAM = si.totalram * si.mem_unit;
-        m_availableRAM = si.freeram * si.mem_unit;
-        m_usedRAM = m_totalRAM - m_availableRAM;
-        return true;
+    if (!aether::querySystemMemory(m_totalRAM, m_availableRAM)) {
+        return false;
     }
-    
-    return false;
-#endif
+    m_usedRAM = m_totalRAM - m_availableRAM;
+    return true;
 }
 
 float MemoryManager::getRAMUsagePercentage() const {
@@ -0,0 +1,48 @@
+#include "../../include/aether/MemoryManager.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/sysinfo.h>
+#include <fstream>
+#include <string>
+#endif
+
+namespace aether {
+
+bool querySystemMemory(uint64_t& totalBytes, uint64_t& availableBytes) {
+#ifdef _WIN32
+    MEMORYSTATUSEX memInfo;
+    memInfo.dwLength = sizeof(MEMORYSTATUSEX);
+    
+    if (GlobalMemoryStatusEx(&memInfo)) {
+        totalBytes = memInfo.ullTotalPhys;
+        availableBytes = memInfo.ullAvailPhys;
+        return true;
+    }
+    
+    return false;
+#else
+    struct sysinfo si;
+    if (sysinfo(&si) != 0) {
+        return false;
+    }
+    totalBytes = static_cast<uint64_t>(si.totalram) * si.mem_unit;
+    availableBytes = static_cast<uint64_t>(si.freeram) * si.mem_unit;
+    
+    // Free memory leaves out the page cache, which the kernel gives up on demand;
+    // MemAvailable counts it
+    std::ifstream meminfo("/proc/meminfo");
+    std::string key;
+    uint64_t kilobytes = 0;
+    std::string unit;
+    while (meminfo >> key >> kilobytes >> unit) {
+        if (key == "MemAvailable:") {
+            availableBytes = kilobytes * 1024;
+            break;
+        }
+    }
+    return true;
+#endif
+}
+
+} // namespace aether
@@ -0,0 +1,129 @@
+#include "aether/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+
+namespace aether {
+
+size_t ThreadPool::defaultThreadCount() {
+    unsigned int hardware = std::thread::hardware_concurrency();
+    return hardware > 1 ? hardware - 1 : 1;
+}
+
+ThreadPool::ThreadPool(size_t threadCount) {
+    m_workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        m_workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+    for (auto& worker : m_workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+ThreadPool& ThreadPool::getInstance() {
+    static ThreadPool instance;
+    return instance;
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push(std::move(task));
+    }
+    m_condition.notify_one();
+}
+
+bool ThreadPool::runPendingTask() {
+    std::function<void()> task;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_tasks.empty()) {
+            return false;
+        }
+        task = std::move(m_tasks.front());
+        m_tasks.pop();
+    }
+    task();
+    return true;
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+            if (m_stopping && m_tasks.empty()) {
+                return;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(size_t begin, size_t end, size_t grainSize,
+                             const std::function<void(size_t, size_t)>& body) {
+    if (end <= begin) {
+        return;
+    }
+    const size_t count = end - begin;
+    grainSize = std::max<size_t>(grainSize, 1);
+    // A few chunks per thread keeps the tail short when chunks finish unevenly
+    const size_t maxChunks = getConcurrency() * 4;
+    const size_t chunkCount = std::min(maxChunks, (count + grainSize - 1) / grainSize);
+    if (chunkCount <= 1) {
+        body(begin, end);
+        return;
+    }
+    const size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+    struct Shared {
+        std::atomic<size_t> nextChunk{0};
+        std::atomic<size_t> remaining{0};
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+    auto shared = std::make_shared<Shared>();
+    shared->remaining = chunkCount;
+
+    // Each helper claims chunks until none are left, so the work balances itself
+    auto drain = [shared, begin, end, chunkSize, chunkCount, &body]() {
+        size_t chunk;
+        while ((chunk = shared->nextChunk.fetch_add(1)) < chunkCount) {
+            size_t chunkBegin = begin + chunk * chunkSize;
+            size_t chunkEnd = std::min(end, chunkBegin + chunkSize);
+            body(chunkBegin, chunkEnd);
+            if (shared->remaining.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(shared->mutex);
+                shared->done.notify_all();
+            }
+        }
+    };
+
+    const size_t helpers = std::min(m_workers.size(), chunkCount - 1);
+    for (size_t i = 0; i < helpers; i++) {
+        enqueue(drain);
+    }
+    drain();
+
+    // Chunks may still be running on workers; help with other queued work meanwhile
+    while (shared->remaining.load() != 0) {
+        if (!runPendingTask()) {
+            std::unique_lock<std::mutex> lock(shared->mutex);
+            shared->done.wait(lock, [&shared]() { return shared->remaining.load() == 0; });
+        }
+    }
+}
+
+} // namespace aether
@@ -9,29 +9,94 @@ UndoRedoManager& UndoRedoManager::getInstance() {
 }
 
 void UndoRedoManager::pushAction(std::unique_ptr<UndoRedoAction> action) {
+    if (!action) {
+        return;
+    }
+
     // Remove any actions after current index (when we're in the middle of history)
-    if (m_currentIndex < m_actions.size()) {
-        m_actions.erase(m_actions.begin() + m_currentIndex, m_actions.end());
+    while (m_count > m_currentIndex) {
+        auto& slot = at(m_count - 1);
+        m_historyBytes -= slot->getMemoryUsage();
+        slot.reset();
+        m_count--;
+    }
+
+    // Fold into the previous step while the same gesture is still going
+    const auto now = std::chrono::steady_clock::now();
+    const std::string key = action->getCoalesceKey();
+    const bool sameGesture = m_inGesture ? m_gestureCanMerge : now - m_lastPushTime <= m_coalesceWindow;
+    if (m_count > 0 && !key.empty() && sameGesture) {
+        auto& last = at(m_count - 1);
+        if (last->getCoalesceKey() == key) {
+            const size_t oldBytes = last->getMemoryUsage();
+            if (last->mergeWith(*action)) {
+                m_historyBytes = m_historyBytes - oldBytes + last->getMemoryUsage();
+                m_lastPushTime = now;
+                trimHistory();
+                return;
+            }
+        }
+    }
+
+    // Grow the ring, unrolling it so the oldest step is at slot 0 again
+    if (m_count == m_ring.size()) {
+        std::vector<std::unique_ptr<UndoRedoAction>> grown(std::max<size_t>(16, m_ring.size() * 2));
+        for (size_t i = 0; i < m_count; i++)
+            grown[i] = std::move(at(i));
+        m_ring = std::move(grown);
+        m_head = 0;
     }
-    
-    // Add new action
-    m_actions.push_back(std::move(action));
-    m_currentIndex = m_actions.size();
-    
-    // Limit history size
-    if (m_actions.size() > m_maxHistorySize) {
-        m_actions.erase(m_actions.begin());
+
+    m_historyBytes += action->getMemoryUsage();
+    at(m_count) = std::move(action);
+    m_count++;
+    m_currentIndex = m_count;
+    m_lastPushTime = key.empty() ? std::chrono::steady_clock::time_point{} : now;
+    m_gestureCanMerge = m_inGesture && !key.empty();
+    trimHistory();
+}
+
+void UndoRedoManager::beginGesture() {
+    breakCoalescing();
+    m_inGesture = true;
+}
+
+void UndoRedoManager::endGesture() {
+    m_inGesture = false;
+    breakCoalescing();
+}
+
+void UndoRedoManager::trimHistory() {
+    // Drop the oldest steps, always keeping the newest one; steps still to be redone are kept
+    while (m_count > 1 && m_currentIndex > 0
+           && (m_count > m_maxHistorySize || m_historyBytes > m_maxHistoryBytes)) {
+        auto& slot = at(0);
+        m_historyBytes -= slot->getMemoryUsage();
+        slot.reset();
+        m_head = (m_head + 1) % m_ring.size();
+        m_count--;
         m_currentIndex--;
     }
 }
 
+void UndoRedoManager::setMaxHistorySize(size_t size) {
+    m_maxHistorySize = std::max<size_t>(1, size);
+    trimHistory();
+}
+
+void UndoRedoManager::setMaxHistoryBytes(size_t bytes) {
+    m_maxHistoryBytes = bytes;
+    trimHistory();
+}
+
 bool UndoRedoManager::undo() {
     if (!canUndo()) {
         return false;
     }
-    
+
+    breakCoalescing();
     m_currentIndex--;
-    m_actions[m_currentIndex]->undo();
+    at(m_currentIndex)->undo();
     return true;
 }
 
@@ -39,29 +104,34 @@ bool UndoRedoManager::redo() {
     if (!canRedo()) {
         return false;
     }
-    
-    m_actions[m_currentIndex]->redo();
+
+    breakCoalescing();
+    at(m_currentIndex)->redo();
     m_currentIndex++;
     return true;
 }
 
 void UndoRedoManager::clear() {
-    m_actions.clear();
+    m_ring.clear();
+    m_head = 0;
+    m_count = 0;
     m_currentIndex = 0;
+    m_historyBytes = 0;
+    breakCoalescing();
 }
 
 std::string UndoRedoManager::getUndoDescription() const {
     if (!canUndo()) {
         return "";
     }
-    return m_actions[m_currentIndex - 1]->getDescription();
+    return at(m_currentIndex - 1)->getDescription();
 }
 
 std::string UndoRedoManager::getRedoDescription() const {
     if (!canRedo()) {
         return "";
     }
-    return m_actions[m_currentIndex]->getDescription();
+    return at(m_currentIndex)->getDescription();
 }
 
 } // namespace aether
@@ -1,16 +1,544 @@
 #include "aether/EncoderBackend.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+
+#ifdef AETHER_FFMPEG_ENABLED
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/avutil.h>
+#include <libavcodec/bsf.h>
+#include <libavutil/opt.h>
+#include <libswscale/swscale.h>
+}
+#endif
 
 namespace aether {
 
+#ifdef AETHER_FFMPEG_ENABLED
+
+namespace {
+
+struct FFmpegFrame : EncoderFrame {
+    AVFrame* frame = nullptr;
+    ~FFmpegFrame() override { av_frame_free(&frame); }
+};
+
+struct FFmpegPacket : EncoderPacket {
+    AVPacket* packet = nullptr;
+    bool segmentStart = false; // first packet of a freshly opened encoder
+    ~FFmpegPacket() override { av_packet_free(&packet); }
+};
+
+/** Video stream of a source file, opened for reading packets without decoding them. */
+struct PacketReader {
+    AVFormatContext* format = nullptr;
+    AVStream* stream = nullptr;
+    int64_t startTs = 0;
+
+    ~PacketReader() { avformat_close_input(&format); }
+
+    bool open(const std::string& path) {
+        if (avformat_open_input(&format, path.c_str(), nullptr, nullptr) < 0) return false;
+        if (avformat_find_stream_info(format, nullptr) < 0) return false;
+        const int index = av_find_best_stream(format, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        if (index < 0) return false;
+        for (unsigned i = 0; i < format->nb_streams; i++) {
+            if (static_cast<int>(i) != index) format->streams[i]->discard = AVDISCARD_ALL;
+        }
+        stream = format->streams[index];
+        startTs = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+        return true;
+    }
+
+    /** Source time as the timeline sees it: milliseconds from the stream's first frame. */
+    int64_t toMs(int64_t ts) const { return av_rescale_q(ts - startTs, stream->time_base, AVRational{1, 1000}); }
+
+    void seek(int64_t ms) {
+        const int64_t ts = startTs + av_rescale_q(std::max<int64_t>(ms, 0), AVRational{1, 1000}, stream->time_base);
+        av_seek_frame(format, stream->index, ts, AVSEEK_FLAG_BACKWARD);
+    }
+
+    /** Next packet of the video stream; false at the end of the file. */
+    bool read(AVPacket* packet) {
+        while (av_read_frame(format, packet) >= 0) {
+            if (packet->stream_index == stream->index && packet->pts != AV_NOPTS_VALUE) return true;
+            av_packet_unref(packet);
+        }
+        return false;
+    }
+};
+
+/** Length-prefixed (MP4-style) H.264/HEVC, which needs converting for containers without global headers. */
+bool isLengthPrefixed(const AVCodecParameters* par) {
+    return (par->codec_id == AV_CODEC_ID_H264 || par->codec_id == AV_CODEC_ID_HEVC) && par->extradata_size > 0
+        && par->extradata[0] == 1;
+}
+
+std::string errorString(int err) {
+    char buf[AV_ERROR_MAX_STRING_SIZE] = {};
+    av_strerror(err, buf, sizeof(buf));
+    return buf;
+}
+
+} // namespace
+
 class FFmpegEncoder : public IEncoderBackend {
 public:
-    bool open(const EncodeParams& params) override { (void)params; return true; }
+    ~FFmpegEncoder() override { close(); }
+
+    bool open(const EncodeParams& params) override {
+        close();
+        {
+            std::lock_guard<std::mutex> lock(m_errorMutex);
+            m_error.clear();
+        }
+        if (avformat_alloc_output_context2(&m_format, nullptr, nullptr, params.outputPath.c_str()) < 0 || !m_format)
+            return fail("Unknown output format for " + params.outputPath);
+
+        const AVCodec* codec = nullptr;
+        if (!params.codec.empty()) {
+            codec = avcodec_find_encoder_by_name(params.codec.c_str());
+            if (!codec) {
+                const AVCodecDescriptor* desc = avcodec_descriptor_get_by_name(params.codec.c_str());
+                if (desc) codec = avcodec_find_encoder(desc->id);
+            }
+        } else {
+            codec = avcodec_find_encoder(m_format->oformat->video_codec);
+        }
+        if (!codec) return fail("No encoder for " + (params.codec.empty() ? std::string("the container") : params.codec));
+        m_encoder = codec;
+        m_params = params;
+        if (!openCodec()) return false;
+        // Decoders may hold this many frames back for reordering; written DTS leave room for it
+        m_reorderDelay = m_codec->has_b_frames;
+        // Conversion and muxing run beside encode(), which may reopen m_codec, so they keep their own copy of these
+        m_width = m_codec->width;
+        m_height = m_codec->height;
+        m_pixelFormat = m_codec->pix_fmt;
+        m_timeBase = m_codec->time_base;
+
+        m_stream = avformat_new_stream(m_format, nullptr);
+        if (!m_stream || avcodec_parameters_from_context(m_stream->codecpar, m_codec) < 0)
+            return fail("Could not create the output stream");
+        m_stream->time_base = m_timeBase;
+        int err = 0;
+        if (!(m_format->oformat->flags & AVFMT_NOFILE)) {
+            err = avio_open(&m_format->pb, params.outputPath.c_str(), AVIO_FLAG_WRITE);
+            if (err < 0) return fail("Could not create " + params.outputPath + ": " + errorString(err));
+        }
+        // The header goes out with the first packet, so useStreamHeaders() can still change it
+        const AVCodecParameters* par = m_stream->codecpar;
+        m_encoderHeaders.assign(par->extradata, par->extradata + par->extradata_size);
+        m_opened = true;
+        m_nextPts = 0;
+        m_dtsShift = 0;
+        return true;
+    }
+
     bool encodeFrame(const void* rgbData, uint32_t width, uint32_t height) override {
-        (void)rgbData; (void)width; (void)height; return true;
+        std::unique_ptr<EncoderFrame> frame = convertFrame(rgbData, width, height);
+        if (!frame) return false;
+        std::vector<std::unique_ptr<EncoderPacket>> packets;
+        if (!encode(std::move(frame), packets)) return false;
+        for (auto& p : packets) {
+            if (!writePacket(std::move(p))) return false;
+        }
+        return true;
+    }
+
+    std::unique_ptr<EncoderFrame> convertFrame(const void* rgbaData, uint32_t width, uint32_t height) override {
+        if (!m_opened) return nullptr;
+        auto out = std::make_unique<FFmpegFrame>();
+        out->frame = av_frame_alloc();
+        if (!out->frame) return nullptr;
+        out->frame->format = m_pixelFormat;
+        out->frame->width = m_width;
+        out->frame->height = m_height;
+        if (av_frame_get_buffer(out->frame, 0) < 0) return nullptr;
+
+        SwsContext* sws = acquireScaler(static_cast<int>(width), static_cast<int>(height));
+        if (!sws) return nullptr;
+        const uint8_t* src[1] = {static_cast<const uint8_t*>(rgbaData)};
+        const int srcStride[1] = {static_cast<int>(width) * 4};
+        sws_scale(sws, src, srcStride, 0, static_cast<int>(height), out->frame->data, out->frame->linesize);
+        releaseScaler(sws);
+        return out;
+    }
+
+    bool encode(std::unique_ptr<EncoderFrame> frame, std::vector<std::unique_ptr<EncoderPacket>>& out) override {
+        if (!m_codec) return fail("Encoder is not open");
+        AVFrame* av = nullptr;
+        if (frame) {
+            if (m_flushed) {
+                // Drained: start over, so the next GOP cannot refer to anything before it
+                avcodec_free_context(&m_codec);
+                m_flushed = false;
+                if (!openCodec()) return false;
+            }
+            av = static_cast<FFmpegFrame*>(frame.get())->frame;
+            av->pts = frame->index >= 0 ? frame->index : m_nextPts;
+            m_nextPts = av->pts + 1;
+        } else if (m_flushed) {
+            return true;
+        } else {
+            m_flushed = true;
+        }
+        int err = avcodec_send_frame(m_codec, av);
+        if (err < 0) return fail("Encoding failed: " + errorString(err));
+        for (;;) {
+            auto packet = std::make_unique<FFmpegPacket>();
+            packet->packet = av_packet_alloc();
+            err = avcodec_receive_packet(m_codec, packet->packet);
+            if (err == AVERROR(EAGAIN) || err == AVERROR_EOF) break;
+            if (err < 0) return fail("Encoding failed: " + errorString(err));
+            // Left in the codec time base; the stream's is only final once the header is written
+            packet->packet->stream_index = m_stream->index;
+            packet->segmentStart = m_segmentStart;
+            m_segmentStart = false;
+            out.push_back(std::move(packet));
+        }
+        return true;
+    }
+
+    bool writePacket(std::unique_ptr<EncoderPacket> packet) override {
+        if (!m_opened) return fail("Encoder is not open");
+        if (!m_headerWritten && !writeHeader()) return false;
+        auto* p = static_cast<FFmpegPacket*>(packet.get());
+        av_packet_rescale_ts(p->packet, m_timeBase, m_stream->time_base);
+        return write(p->packet, p->segmentStart);
+    }
+
+    CopySpan findCopySpan(const std::string& sourcePath, int64_t fromMs, int64_t toMs) override {
+        CopySpan rejected;
+        auto reject = [&rejected](std::string reason) {
+            rejected.rejection = std::move(reason);
+            return rejected;
+        };
+        if (!m_opened || toMs <= fromMs) return reject("nothing to copy");
+        PacketReader reader;
+        if (!reader.open(sourcePath)) return reject("could not be read");
+        const AVCodecParameters* par = reader.stream->codecpar;
+        const AVCodecParameters* out = m_stream->codecpar;
+        AVRational rate = reader.stream->avg_frame_rate.num > 0 ? reader.stream->avg_frame_rate : reader.stream->r_frame_rate;
+        if (par->codec_id != out->codec_id)
+            return reject(std::string("coded as ") + avcodec_get_name(par->codec_id) + ", the output as " + avcodec_get_name(out->codec_id));
+        if (par->width != out->width || par->height != out->height) return reject("frame size differs from the output's");
+        if (par->format != out->format) return reject("pixel format differs from the output's");
+        if (rate.num <= 0 || std::abs(av_q2d(rate) - av_q2d(av_inv_q(m_timeBase))) > 0.01)
+            return reject("frame rate differs from the output's");
+        if (m_format->oformat->flags & AVFMT_GLOBALHEADER) {
+            // One set of stream headers covers the whole file, so they must be the output's own
+            if (par->extradata_size != out->extradata_size
+                || (par->extradata_size > 0 && std::memcmp(par->extradata, out->extradata, par->extradata_size) != 0)) {
+                rejected.headersDiffer = true;
+                return reject("stream headers differ from the output's");
+            }
+        }
+
+        // A keyframe is clean when no packet after it in decode order shows before it,
+        // i.e. nothing from the following GOP refers back into the previous one
+        struct Keyframe {
+            int64_t ms;
+            bool clean;
+        };
+        constexpr int kLeadingWindow = 16; // leading pictures follow their keyframe closely
+        std::vector<Keyframe> keys;
+        int sinceLastKey = 0;
+        bool atEnd = true;
+        int64_t endMs = 0;
+        AVPacket* pkt = av_packet_alloc();
+        reader.seek(fromMs);
+        while (reader.read(pkt)) {
+            const int64_t ms = reader.toMs(pkt->pts);
+            endMs = std::max(endMs, reader.toMs(pkt->pts + std::max<int64_t>(pkt->duration, 0)));
+            if (pkt->flags & AV_PKT_FLAG_KEY) {
+                if (!keys.empty() && keys.back().ms >= toMs) {
+                    av_packet_unref(pkt);
+                    atEnd = false;
+                    break;
+                }
+                keys.push_back({ms, true});
+                sinceLastKey = 0;
+            } else if (!keys.empty()) {
+                if (ms < keys.back().ms) keys.back().clean = false;
+                if (++sinceLastKey >= kLeadingWindow && keys.back().ms >= toMs) {
+                    av_packet_unref(pkt);
+                    atEnd = false;
+                    break;
+                }
+            }
+            av_packet_unref(pkt);
+        }
+        av_packet_free(&pkt);
+
+        CopySpan span;
+        span.startMs = -1;
+        for (const Keyframe& k : keys) {
+            if (!k.clean || k.ms < fromMs) continue;
+            if (span.startMs < 0) {
+                span.startMs = k.ms;
+            } else if (k.ms <= toMs) {
+                span.endMs = k.ms;
+            }
+        }
+        // The end of the file is as good a boundary as a clean keyframe
+        if (span.startMs >= 0 && atEnd && toMs >= endMs) span.endMs = toMs;
+        if (span.startMs < 0 || span.isEmpty()) return reject("no clean keyframes to cut at in the range");
+        m_reorderDelay = std::max(m_reorderDelay, par->video_delay);
+        return span;
+    }
+
+    bool copyPackets(const std::string& sourcePath, const CopySpan& span, int64_t firstFrame) override {
+        if (!m_opened) return fail("Encoder is not open");
+        if (!m_headerWritten && !writeHeader()) return false;
+        PacketReader reader;
+        if (!reader.open(sourcePath)) return fail("Could not read " + sourcePath);
+
+        AVBSFContext* bsf = nullptr;
+        if (!(m_format->oformat->flags & AVFMT_GLOBALHEADER) && isLengthPrefixed(reader.stream->codecpar)) {
+            const AVBitStreamFilter* filter =
+                av_bsf_get_by_name(reader.stream->codecpar->codec_id == AV_CODEC_ID_H264 ? "h264_mp4toannexb" : "hevc_mp4toannexb");
+            if (!filter || av_bsf_alloc(filter, &bsf) < 0) return fail("Could not convert " + sourcePath);
+            avcodec_parameters_copy(bsf->par_in, reader.stream->codecpar);
+            bsf->time_base_in = reader.stream->time_base;
+            if (av_bsf_init(bsf) < 0) {
+                av_bsf_free(&bsf);
+                return fail("Could not convert " + sourcePath);
+            }
+        }
+
+        const AVRational sourceBase = reader.stream->time_base;
+        const int64_t offset = av_rescale_q(firstFrame, m_timeBase, m_stream->time_base);
+        int64_t basePts = AV_NOPTS_VALUE;
+        bool first = true;
+        bool ok = true;
+        AVPacket* pkt = av_packet_alloc();
+        reader.seek(span.startMs);
+        while (ok && reader.read(pkt)) {
+            const int64_t ms = reader.toMs(pkt->pts);
+            const bool key = pkt->flags & AV_PKT_FLAG_KEY;
+            if (basePts == AV_NOPTS_VALUE && key && ms == span.startMs) basePts = pkt->pts;
+            if (key && ms >= span.endMs) {
+                av_packet_unref(pkt);
+                break;
+            }
+            if (basePts == AV_NOPTS_VALUE || ms < span.startMs || ms >= span.endMs) {
+                av_packet_unref(pkt);
+                continue;
+            }
+            pkt->pts = av_rescale_q(pkt->pts - basePts, sourceBase, m_stream->time_base) + offset;
+            if (pkt->dts != AV_NOPTS_VALUE) pkt->dts = av_rescale_q(pkt->dts - basePts, sourceBase, m_stream->time_base) + offset;
+            pkt->duration = av_rescale_q(pkt->duration, sourceBase, m_stream->time_base);
+            pkt->stream_index = m_stream->index;
+            pkt->pos = -1;
+            if (!bsf) {
+                ok = write(pkt, first);
+                first = false;
+                continue;
+            }
+            // The filter only rewrites the bitstream; timestamps pass through unchanged
+            if (av_bsf_send_packet(bsf, pkt) < 0) {
+                av_packet_unref(pkt);
+                ok = fail("Could not convert " + sourcePath);
+                break;
+            }
+            while (ok && av_bsf_receive_packet(bsf, pkt) == 0) {
+                pkt->stream_index = m_stream->index;
+                ok = write(pkt, first);
+                first = false;
+            }
+        }
+        av_packet_free(&pkt);
+        av_bsf_free(&bsf);
+        if (ok && first) return fail("No packets to copy from " + sourcePath);
+        return ok;
+    }
+
+    bool useStreamHeaders(const std::string& sourcePath) override {
+        if (!m_opened) return fail("Encoder is not open");
+        if (m_headerWritten) return fail("The file header is already written");
+        std::vector<uint8_t> headers = m_encoderHeaders;
+        if (!sourcePath.empty()) {
+            PacketReader reader;
+            if (!reader.open(sourcePath)) return fail("Could not read " + sourcePath);
+            const AVCodecParameters* par = reader.stream->codecpar;
+            headers.assign(par->extradata, par->extradata + par->extradata_size);
+        }
+        AVCodecParameters* par = m_stream->codecpar;
+        av_freep(&par->extradata);
+        par->extradata_size = 0;
+        if (headers.empty()) return true;
+        par->extradata = static_cast<uint8_t*>(av_mallocz(headers.size() + AV_INPUT_BUFFER_PADDING_SIZE));
+        if (!par->extradata) return fail("Out of memory");
+        std::memcpy(par->extradata, headers.data(), headers.size());
+        par->extradata_size = static_cast<int>(headers.size());
+        return true;
+    }
+
+    void close() override {
+        if (m_opened) {
+            std::vector<std::unique_ptr<EncoderPacket>> tail;
+            if (encode(nullptr, tail)) {
+                for (auto& p : tail) writePacket(std::move(p));
+            }
+            if (m_headerWritten || writeHeader()) av_write_trailer(m_format);
+            m_opened = false;
+            m_headerWritten = false;
+        }
+        if (m_format && !(m_format->oformat->flags & AVFMT_NOFILE)) avio_closep(&m_format->pb);
+        avformat_free_context(m_format);
+        m_format = nullptr;
+        m_stream = nullptr;
+        avcodec_free_context(&m_codec);
+        for (SwsContext* sws : m_scalers) sws_freeContext(sws);
+        m_scalers.clear();
+        m_freeScalers.clear();
+        m_flushed = false;
+    }
+
+    std::string getLastError() const override {
+        std::lock_guard<std::mutex> lock(m_errorMutex);
+        return m_error;
+    }
+
+private:
+    bool openCodec() {
+        m_codec = avcodec_alloc_context3(m_encoder);
+        if (!m_codec) return fail("Out of memory");
+        m_codec->width = static_cast<int>(m_params.width);
+        m_codec->height = static_cast<int>(m_params.height);
+        m_codec->framerate = av_d2q(m_params.fps > 0.0 ? m_params.fps : 24.0, 100000);
+        m_codec->time_base = av_inv_q(m_codec->framerate);
+        m_codec->pix_fmt = pickPixelFormat(m_encoder);
+        if (m_params.bitrateKbps > 0) m_codec->bit_rate = static_cast<int64_t>(m_params.bitrateKbps) * 1000;
+        if (m_params.maxBitrateKbps > 0) m_codec->rc_max_rate = static_cast<int64_t>(m_params.maxBitrateKbps) * 1000;
+        if (m_params.bufferSizeKbits > 0) m_codec->rc_buffer_size = static_cast<int>(m_params.bufferSizeKbits) * 1000;
+        if (m_params.gopSize > 0) m_codec->gop_size = static_cast<int>(m_params.gopSize);
+        m_codec->thread_count = static_cast<int>(m_params.encoderThreads);
+        if (m_format->oformat->flags & AVFMT_GLOBALHEADER) m_codec->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+        const int err = avcodec_open2(m_codec, m_encoder, nullptr);
+        if (err < 0) return fail("Could not open encoder: " + errorString(err));
+        m_segmentStart = true;
+        return true;
+    }
+
+    bool writeHeader() {
+        const int err = avformat_write_header(m_format, nullptr);
+        if (err < 0) return fail("Could not write the file header: " + errorString(err));
+        m_headerWritten = true;
+        return true;
+    }
+
+    /**
+     * Output is a chain of independently coded runs (encoder sessions and
+     * copied spans), each with its own reordering delay. Every run's DTS are
+     * moved so that its first packet decodes m_reorderDelay frames before it
+     * is shown; the runs then join with DTS that keep increasing.
+     */
+    bool write(AVPacket* pkt, bool segmentStart) {
+        if (segmentStart && pkt->pts != AV_NOPTS_VALUE && pkt->dts != AV_NOPTS_VALUE) {
+            const int64_t headroom = av_rescale_q(m_reorderDelay, m_timeBase, m_stream->time_base);
+            m_dtsShift = std::min<int64_t>(0, (pkt->pts - pkt->dts) - headroom);
+        }
+        if (pkt->dts != AV_NOPTS_VALUE) pkt->dts += m_dtsShift;
+        const int err = av_interleaved_write_frame(m_format, pkt);
+        if (err < 0) return fail("Writing the file failed: " + errorString(err));
+        return true;
+    }
+
+    bool fail(const std::string& error) {
+        std::lock_guard<std::mutex> lock(m_errorMutex);
+        m_error = error;
+        return false;
+    }
+
+    static AVPixelFormat pickPixelFormat(const AVCodec* codec) {
+        const AVPixelFormat* formats = nullptr;
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(61, 13, 100)
+        const void* configs = nullptr;
+        int count = 0;
+        if (avcodec_get_supported_config(nullptr, codec, AV_CODEC_CONFIG_PIX_FORMAT, 0, &configs, &count) >= 0)
+            formats = static_cast<const AVPixelFormat*>(configs);
+#else
+        formats = codec->pix_fmts;
+#endif
+        if (!formats) return AV_PIX_FMT_YUV420P;
+        for (const AVPixelFormat* f = formats; *f != AV_PIX_FMT_NONE; f++) {
+            if (*f == AV_PIX_FMT_YUV420P) return *f;
+        }
+        return formats[0];
+    }
+
+    // Conversion runs on several threads; each borrows its own scaler from the pool
+    SwsContext* acquireScaler(int srcWidth, int srcHeight) {
+        SwsContext* sws = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_scalerMutex);
+            if (!m_freeScalers.empty()) {
+                sws = m_freeScalers.back();
+                m_freeScalers.pop_back();
+            }
+        }
+        SwsContext* cached = sws_getCachedContext(sws, srcWidth, srcHeight, AV_PIX_FMT_RGBA, m_width, m_height,
+                                                  m_pixelFormat, SWS_BICUBIC, nullptr, nullptr, nullptr);
+        std::lock_guard<std::mutex> lock(m_scalerMutex);
+        if (cached != sws) {
+            if (sws) m_scalers.erase(std::find(m_scalers.begin(), m_scalers.end(), sws));
+            if (cached) m_scalers.push_back(cached);
+        }
+        return cached;
+    }
+
+    void releaseScaler(SwsContext* sws) {
+        std::lock_guard<std::mutex> lock(m_scalerMutex);
+        m_freeScalers.push_back(sws);
     }
+
+    EncodeParams m_params;
+    const AVCodec* m_encoder = nullptr;
+    AVFormatContext* m_format = nullptr;
+    AVCodecContext* m_codec = nullptr;
+    AVStream* m_stream = nullptr;
+    bool m_opened = false;
+    bool m_headerWritten = false; // on the first packet
+    bool m_flushed = false;
+    bool m_segmentStart = false;
+    int64_t m_nextPts = 0; // encode() only
+    int m_width = 0;
+    int m_height = 0;
+    AVPixelFormat m_pixelFormat = AV_PIX_FMT_NONE;
+    AVRational m_timeBase{1, 1}; // the codec's, fixed for the whole file
+    std::vector<uint8_t> m_encoderHeaders; // the encoder's extradata, for useStreamHeaders("")
+    int m_reorderDelay = 0; // frames
+    int64_t m_dtsShift = 0; // stream time base, for the current run
+
+    std::mutex m_scalerMutex;
+    std::vector<SwsContext*> m_scalers;     // every scaler made, for close()
+    std::vector<SwsContext*> m_freeScalers; // not borrowed right now
+
+    mutable std::mutex m_errorMutex;
+    std::string m_error;
+};
+
+#else
+
+/** Without FFmpeg there is nothing to encode with; open() says so. */
+class FFmpegEncoder : public IEncoderBackend {
+public:
+    bool open(const EncodeParams&) override { return false; }
+    bool encodeFrame(const void*, uint32_t, uint32_t) override { return false; }
     void close() override {}
+    std::unique_ptr<EncoderFrame> convertFrame(const void*, uint32_t, uint32_t) override { return nullptr; }
+    bool encode(std::unique_ptr<EncoderFrame>, std::vector<std::unique_ptr<EncoderPacket>>&) override { return false; }
+    bool writePacket(std::unique_ptr<EncoderPacket>) override { return false; }
+    std::string getLastError() const override { return "This build has no FFmpeg support"; }
 };
 
+#endif
+
 std::unique_ptr<IEncoderBackend> createEncoderBackend() {
     return std::make_unique<FFmpegEncoder>();
 }
@@ -1,37 +1,296 @@
-#include "../../include/aether/AetherLink.h"
+#include "aether/AetherLink.h"
 #include <iostream>
 #include <sstream>
 #include <random>
 #include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
 #ifdef _WIN32
 #include <winsock2.h>
 #include <ws2tcpip.h>
 #pragma comment(lib, "ws2_32.lib")
 #else
 #include <sys/socket.h>
+#include <sys/select.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
+#include <netdb.h>
 #include <unistd.h>
 #endif
 
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
 namespace aether {
 
+namespace {
+
+#ifdef _WIN32
+using SocketHandle = SOCKET;
+const SocketHandle kInvalidSocket = INVALID_SOCKET;
+void closeSocket(SocketHandle s) { closesocket(s); }
+void shutdownSocket(SocketHandle s) { ::shutdown(s, SD_BOTH); }
+#else
+using SocketHandle = int;
+const SocketHandle kInvalidSocket = -1;
+void closeSocket(SocketHandle s) { ::close(s); }
+void shutdownSocket(SocketHandle s) { ::shutdown(s, SHUT_RDWR); }
+#endif
+
+constexpr uint32_t kProtocolVersion = 1;
+constexpr uint32_t kMaxMessageBytes = 64u << 20;
+constexpr size_t kChunkPieceBytes = 256 * 1024; // small enough for heartbeats to get through between pieces
+constexpr int kMissedHeartbeats = 5;
+constexpr uint32_t kMaxRangeAttempts = 3;
+const char kDiscoverRequest[] = "AETHERLINK?";
+const char kDiscoverReply[] = "AETHERLINK";
+
+enum class MessageType : uint8_t {
+    Hello = 1,   // worker: protocol version, node id, cores, slots, GPU name
+    Job,         // master: job id, payload; sent before a worker's first range of the job
+    Range,       // master: job id, range index, first frame, frame count, file extension
+    Cancel,      // master: job id; the job ended, so its ranges stop and its payload goes
+    Heartbeat,   // both; a worker's lists (job id, range index, frames done) for the ranges it renders
+    ChunkBegin,  // worker: job id, range index, file size
+    ChunkData,   // worker: job id, range index, bytes
+    ChunkEnd,    // worker: job id, range index
+    RangeFailed, // worker: job id, range index, error
+};
+
+/** Builds one message: length, type, then the fields in order. */
+class MessageWriter {
+public:
+    explicit MessageWriter(MessageType type) : m_data(4, 0) { m_data.push_back(static_cast<uint8_t>(type)); }
+
+    MessageWriter& u32(uint32_t v) {
+        for (int i = 0; i < 4; i++) m_data.push_back(static_cast<uint8_t>(v >> (8 * i)));
+        return *this;
+    }
+    MessageWriter& i64(int64_t v) {
+        for (int i = 0; i < 8; i++) m_data.push_back(static_cast<uint8_t>(static_cast<uint64_t>(v) >> (8 * i)));
+        return *this;
+    }
+    MessageWriter& bytes(const void* data, size_t size) {
+        u32(static_cast<uint32_t>(size));
+        m_data.insert(m_data.end(), static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+        return *this;
+    }
+    MessageWriter& str(const std::string& s) { return bytes(s.data(), s.size()); }
+
+    /** The message with its length filled in. */
+    const std::vector<uint8_t>& finish() {
+        const uint32_t length = static_cast<uint32_t>(m_data.size() - 4);
+        for (int i = 0; i < 4; i++) m_data[i] = static_cast<uint8_t>(length >> (8 * i));
+        return m_data;
+    }
+
+private:
+    std::vector<uint8_t> m_data;
+};
+
+/** Reads a message body's fields in the order they were written. */
+class MessageReader {
+public:
+    explicit MessageReader(const std::vector<uint8_t>& body) : m_data(body.data()), m_left(body.size()) {}
+
+    uint32_t u32() {
+        const uint8_t* p = take(4);
+        uint32_t v = 0;
+        for (int i = 0; p && i < 4; i++) v |= static_cast<uint32_t>(p[i]) << (8 * i);
+        return v;
+    }
+    int64_t i64() {
+        const uint8_t* p = take(8);
+        uint64_t v = 0;
+        for (int i = 0; p && i < 8; i++) v |= static_cast<uint64_t>(p[i]) << (8 * i);
+        return static_cast<int64_t>(v);
+    }
+    std::vector<uint8_t> bytes() {
+        const uint32_t size = u32();
+        const uint8_t* p = take(size);
+        return p ? std::vector<uint8_t>(p, p + size) : std::vector<uint8_t>();
+    }
+    std::string str() {
+        const uint32_t size = u32();
+        const uint8_t* p = take(size);
+        return p ? std::string(reinterpret_cast<const char*>(p), size) : std::string();
+    }
+    /** False once a read ran past the end of the body. */
+    bool ok() const { return m_ok; }
+
+private:
+    const uint8_t* take(size_t size) {
+        if (!m_ok || size > m_left) {
+            m_ok = false;
+            return nullptr;
+        }
+        const uint8_t* p = m_data;
+        m_data += size;
+        m_left -= size;
+        return p;
+    }
+
+    const uint8_t* m_data;
+    size_t m_left;
+    bool m_ok = true;
+};
+
+bool sendAll(SocketHandle s, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        const int n = ::send(s, reinterpret_cast<const char*>(data), static_cast<int>(std::min<size_t>(size, 1 << 20)), MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool recvAll(SocketHandle s, uint8_t* data, size_t size) {
+    while (size > 0) {
+        const int n = ::recv(s, reinterpret_cast<char*>(data), static_cast<int>(std::min<size_t>(size, 1 << 20)), 0);
+        if (n <= 0) return false;
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+/** 1 when s can be read, 0 on timeout, -1 on error. */
+int waitReadable(SocketHandle s, int timeoutMs) {
+    fd_set readSet;
+    FD_ZERO(&readSet);
+    FD_SET(s, &readSet);
+    struct timeval timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_usec = (timeoutMs % 1000) * 1000;
+    const int result = select(static_cast<int>(s) + 1, &readSet, nullptr, nullptr, &timeout);
+    return result < 0 ? -1 : (result > 0 ? 1 : 0);
+}
+
+bool readMessage(SocketHandle s, MessageType& type, std::vector<uint8_t>& body) {
+    uint8_t header[5];
+    if (!recvAll(s, header, sizeof(header))) return false;
+    const uint32_t length = header[0] | header[1] << 8 | header[2] << 16 | static_cast<uint32_t>(header[3]) << 24;
+    if (length < 1 || length > kMaxMessageBytes) return false;
+    type = static_cast<MessageType>(header[4]);
+    body.resize(length - 1);
+    return body.empty() || recvAll(s, body.data(), body.size());
+}
+
+void setNoDelay(SocketHandle s) {
+    int one = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&one), sizeof(one));
+}
+
+SocketHandle connectTo(const std::string& host, uint16_t port) {
+    struct addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* addresses = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0) return kInvalidSocket;
+    SocketHandle result = kInvalidSocket;
+    for (struct addrinfo* a = addresses; a && result == kInvalidSocket; a = a->ai_next) {
+        SocketHandle s = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (s == kInvalidSocket) continue;
+        if (connect(s, a->ai_addr, static_cast<int>(a->ai_addrlen)) == 0) {
+            result = s;
+        } else {
+            closeSocket(s);
+        }
+    }
+    freeaddrinfo(addresses);
+    return result;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+/** The other end of a connection: a worker on the master, the master on a worker. */
+struct AetherLink::Peer {
+    SocketHandle socket = kInvalidSocket;
+    NetworkNode node;
+    std::thread thread;                  // master: reads the worker's messages
+    std::atomic<bool> closed{false};
+    std::chrono::steady_clock::time_point connectedAt;
+    std::chrono::steady_clock::time_point lastSeen;        // guarded by m_mutex
+    std::vector<std::string> jobsSent;                     // master: jobs whose payload the worker has
+    std::vector<std::pair<Job*, uint32_t>> assigned;       // master: ranges the worker is rendering
+    std::map<std::pair<std::string, uint32_t>, int64_t> progress; // frames done of those, from heartbeats
+    std::mutex sendMutex;
+
+    bool send(MessageWriter& message) {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        const std::vector<uint8_t>& data = message.finish();
+        if (closed || !sendAll(socket, data.data(), data.size())) {
+            closed = true;
+            return false;
+        }
+        return true;
+    }
+
+    /** Once no thread reads from the socket any more. */
+    void close() {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        closed = true;
+        if (socket != kInvalidSocket) closeSocket(socket);
+        socket = kInvalidSocket;
+    }
+};
+
+struct AetherLink::Job {
+    enum class Range { Pending, Assigned, Done };
+
+    RenderJob info;
+    std::shared_ptr<const std::vector<uint8_t>> payload;
+    std::vector<Range> ranges;
+    std::vector<uint32_t> attempts; // failures reported or workers lost, per range
+    int64_t reusedFrames = 0;       // in ranges done before the job was submitted
+    std::chrono::steady_clock::time_point submittedAt;
+    bool reported = false;          // the completed callback has run
+};
+
+/** A range a worker has been given. */
+struct AetherLink::WorkItem {
+    std::string jobId;
+    uint32_t range = 0;
+    int64_t firstFrame = 0;
+    int64_t frameCount = 0;
+    std::string extension;
+    std::shared_ptr<const std::vector<uint8_t>> payload;
+    uint64_t connection = 0;
+    std::atomic<bool> cancelled{false};
+    std::atomic<int64_t> framesDone{0};
+};
+
 AetherLink& AetherLink::getInstance() {
     static AetherLink instance;
     return instance;
 }
 
+AetherLink::AetherLink() = default;
+
+AetherLink::~AetherLink() {
+    shutdown();
+}
+
 bool AetherLink::initialize(NodeRole role, uint16_t port) {
     std::lock_guard<std::mutex> lock(m_mutex);
-    
+
     if (m_initialized) {
         return true;
     }
-    
+
     m_role = role;
     m_port = port;
     m_nodeId = generateNodeId();
-    
+
 #ifdef _WIN32
     WSADATA wsaData;
     if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
@@ -39,39 +298,25 @@ bool AetherLink::initialize(NodeRole role, uint16_t port) {
         return false;
     }
 #endif
-    
+
     m_initialized = true;
-    std::cout << "Aether Link initialized as " << (role == NodeRole::Master ? "Master" : "Worker") 
+    std::cout << "Aether Link initialized as " << (role == NodeRole::Master ? "Master" : "Worker")
               << " on port " << port << std::endl;
     return true;
 }
 
 void AetherLink::shutdown() {
+    stopServer();
+
     std::lock_guard<std::mutex> lock(m_mutex);
-    
     if (!m_initialized) {
         return;
     }
-    
-    stopServer();
-    
-    if (m_serverThread.joinable()) {
-        m_shouldStop = true;
-        m_serverThread.join();
-    }
-    
-    if (m_workerThread.joinable()) {
-        m_workerThread.join();
-    }
-    
-    if (m_discoveryThread.joinable()) {
-        m_discoveryThread.join();
-    }
-    
+
 #ifdef _WIN32
     WSACleanup();
 #endif
-    
+
     m_initialized = false;
 }
 
@@ -79,256 +324,933 @@ std::string AetherLink::generateNodeId() {
     std::random_device rd;
     std::mt19937 gen(rd());
     std::uniform_int_distribution<> dis(0, 15);
-    
+
     std::stringstream ss;
     ss << "NODE-";
     for (int i = 0; i < 8; i++) {
         ss << std::hex << dis(gen);
     }
-    
+
     return ss.str();
 }
 
 bool AetherLink::startServer() {
     std::lock_guard<std::mutex> lock(m_mutex);
-    
+
+    if (!m_initialized) {
+        std::cerr << "Aether Link is not initialized" << std::endl;
+        return false;
+    }
     if (m_serverRunning) {
         return true;
     }
-    
+
     m_shouldStop = false;
-    m_serverRunning = true;
-    
+
     if (m_role == NodeRole::Master) {
+        SocketHandle listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (listenSocket == kInvalidSocket) {
+            std::cerr << "Failed to create socket" << std::endl;
+            return false;
+        }
+        int one = 1;
+        setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&one), sizeof(one));
+
+        struct sockaddr_in serverAddr = {};
+        serverAddr.sin_family = AF_INET;
+        serverAddr.sin_addr.s_addr = INADDR_ANY;
+        serverAddr.sin_port = htons(m_port);
+        if (bind(listenSocket, reinterpret_cast<struct sockaddr*>(&serverAddr), sizeof(serverAddr)) != 0 ||
+            listen(listenSocket, SOMAXCONN) != 0) {
+            std::cerr << "Failed to listen on port " << m_port << std::endl;
+            closeSocket(listenSocket);
+            return false;
+        }
+        socklen_t addrLen = sizeof(serverAddr);
+        getsockname(listenSocket, reinterpret_cast<struct sockaddr*>(&serverAddr), &addrLen);
+        m_port = ntohs(serverAddr.sin_port);
+        m_listenSocket = static_cast<intptr_t>(listenSocket);
+
         m_serverThread = std::thread(&AetherLink::serverThread, this);
+        m_schedulerThread = std::thread(&AetherLink::schedulerThread, this);
+        if (m_autoDiscovery) {
+            m_discoveryThread = std::thread(&AetherLink::discoveryThread, this);
+        }
+    } else {
+        if (m_workerSlots == 0) {
+            m_workerSlots = std::clamp(std::thread::hardware_concurrency() / 4, 1u, 8u);
+        }
+        for (uint32_t i = 0; i < m_workerSlots; i++) {
+            m_renderThreads.emplace_back(&AetherLink::renderThread, this);
+        }
+        m_workerThread = std::thread(&AetherLink::workerThread, this);
     }
-    
-    m_workerThread = std::thread(&AetherLink::workerThread, this);
-    
-    if (m_autoDiscovery) {
-        m_discoveryThread = std::thread(&AetherLink::discoveryThread, this);
-    }
-    
-    std::cout << "Aether Link server started" << std::endl;
+
+    m_serverRunning = true;
+    std::cout << "Aether Link server started on port " << m_port << std::endl;
     return true;
 }
 
 void AetherLink::stopServer() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    
-    if (!m_serverRunning) {
-        return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_serverRunning) {
+            return;
+        }
+        m_shouldStop = true;
+        m_serverRunning = false;
+        // Unblocks the threads reading from them
+        for (const auto& peer : m_peers) {
+            peer->closed = true;
+            shutdownSocket(peer->socket);
+        }
+        if (m_master) {
+            m_master->closed = true;
+            shutdownSocket(m_master->socket);
+        }
+        m_workQueue.clear();
+        for (const auto& item : m_rendering) {
+            item->cancelled = true;
+        }
+        m_condition.notify_all();
+    }
+
+    for (std::thread* thread : { &m_serverThread, &m_schedulerThread, &m_workerThread, &m_discoveryThread }) {
+        if (thread->joinable()) thread->join();
+    }
+    for (std::thread& thread : m_renderThreads) {
+        thread.join();
+    }
+    m_renderThreads.clear();
+    if (m_listenSocket != -1) {
+        closeSocket(static_cast<SocketHandle>(m_listenSocket));
+        m_listenSocket = -1;
+    }
+
+    std::vector<std::shared_ptr<Peer>> peers;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        peers.swap(m_peers);
+        m_payloads.clear();
+    }
+    for (const auto& peer : peers) {
+        if (peer->thread.joinable()) peer->thread.join();
+        peer->close();
     }
-    
-    m_shouldStop = true;
-    m_serverRunning = false;
-    
+
     std::cout << "Aether Link server stopped" << std::endl;
 }
 
 void AetherLink::serverThread() {
-    std::cout << "Aether Link server thread started on port " << m_port << std::endl;
-    
-#ifdef _WIN32
-    SOCKET listenSocket = INVALID_SOCKET;
-    SOCKET clientSocket = INVALID_SOCKET;
-    struct sockaddr_in serverAddr, clientAddr;
-    int clientAddrLen = sizeof(clientAddr);
-    
-    listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (listenSocket == INVALID_SOCKET) {
-        std::cerr << "Failed to create socket: " << WSAGetLastError() << std::endl;
-        return;
+    const SocketHandle listenSocket = static_cast<SocketHandle>(m_listenSocket);
+    std::cout << "Aether Link listening on port " << m_port << std::endl;
+
+    while (!m_shouldStop) {
+        const int ready = waitReadable(listenSocket, 200);
+        if (ready < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            continue;
+        }
+        if (ready == 0) {
+            continue;
+        }
+        struct sockaddr_in clientAddr = {};
+        socklen_t clientAddrLen = sizeof(clientAddr);
+        const SocketHandle clientSocket = accept(listenSocket, reinterpret_cast<struct sockaddr*>(&clientAddr), &clientAddrLen);
+        if (clientSocket == kInvalidSocket) {
+            continue;
+        }
+        setNoDelay(clientSocket);
+
+        auto peer = std::make_shared<Peer>();
+        peer->socket = clientSocket;
+        char clientIP[INET_ADDRSTRLEN] = {};
+        inet_ntop(AF_INET, &clientAddr.sin_addr, clientIP, INET_ADDRSTRLEN);
+        peer->node.ipAddress = clientIP;
+        peer->node.port = ntohs(clientAddr.sin_port);
+        peer->node.isOnline = true;
+        peer->connectedAt = peer->lastSeen = std::chrono::steady_clock::now();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_peers.push_back(peer);
+        peer->thread = std::thread(&AetherLink::peerThread, this, peer);
     }
-    
-    serverAddr.sin_family = AF_INET;
-    serverAddr.sin_addr.s_addr = INADDR_ANY;
-    serverAddr.sin_port = htons(m_port);
-    
-    if (bind(listenSocket, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR) {
-        std::cerr << "Bind failed: " << WSAGetLastError() << std::endl;
-        closesocket(listenSocket);
-        return;
+}
+
+void AetherLink::peerThread(std::shared_ptr<Peer> peer) {
+    struct Incoming {
+        std::ofstream file;
+        std::string path;
+        int64_t expectedBytes = 0; // as ChunkBegin announced
+        int64_t receivedBytes = 0;
+    };
+    std::map<std::pair<std::string, uint32_t>, Incoming> incoming; // chunk files being received
+    // The range this worker was given, or null
+    auto findAssigned = [&](const std::string& jobId, uint32_t range) -> Job* {
+        for (const auto& [job, index] : peer->assigned) {
+            if (index == range && job->info.jobId == jobId) return job;
+        }
+        return nullptr;
+    };
+    auto unassign = [&](Job* job, uint32_t range) {
+        peer->assigned.erase(std::find(peer->assigned.begin(), peer->assigned.end(), std::make_pair(job, range)));
+        peer->progress.erase({ job->info.jobId, range });
+    };
+
+    MessageType type;
+    std::vector<uint8_t> body;
+    while (!m_shouldStop && !peer->closed && readMessage(peer->socket, type, body)) {
+        MessageReader in(body);
+        std::unique_lock<std::mutex> lock(m_mutex);
+        peer->lastSeen = std::chrono::steady_clock::now();
+
+        switch (type) {
+        case MessageType::Hello: {
+            const uint32_t version = in.u32();
+            peer->node.nodeId = in.str();
+            peer->node.availableCores = in.u32();
+            peer->node.renderSlots = in.u32();
+            peer->node.gpuName = in.str();
+            if (version != kProtocolVersion) {
+                std::cerr << "Worker " << peer->node.ipAddress << " speaks protocol " << version << ", not " << kProtocolVersion << std::endl;
+                peer->closed = true;
+                break;
+            }
+            std::cout << "Worker connected: " << peer->node.nodeId << " (" << peer->node.ipAddress << ", "
+                      << peer->node.renderSlots << " slots)" << std::endl;
+            m_scheduleRequested = true;
+            m_condition.notify_all();
+            break;
+        }
+        case MessageType::Heartbeat: {
+            const uint32_t count = in.u32();
+            for (uint32_t i = 0; i < count && in.ok(); i++) {
+                const std::string jobId = in.str();
+                const uint32_t range = in.u32();
+                const int64_t frames = in.i64();
+                auto it = peer->progress.find({ jobId, range });
+                if (it != peer->progress.end()) it->second = frames;
+            }
+            break;
+        }
+        case MessageType::ChunkBegin: {
+            const std::string jobId = in.str();
+            const uint32_t range = in.u32();
+            Job* job = findAssigned(jobId, range);
+            if (!job) break; // cancelled or given to another worker meanwhile
+            Incoming& item = incoming[{ jobId, range }];
+            item.path = job->info.ranges[range].resultPath + ".partial";
+            item.expectedBytes = in.i64();
+            if (!in.ok()) item.expectedBytes = -1; // never matches, so the range is rendered again
+            item.receivedBytes = 0;
+            lock.unlock();
+            std::error_code ec;
+            std::filesystem::create_directories(std::filesystem::path(item.path).parent_path(), ec);
+            item.file.open(item.path, std::ios::binary | std::ios::trunc);
+            break;
+        }
+        case MessageType::ChunkData: {
+            const std::string jobId = in.str();
+            const uint32_t range = in.u32();
+            lock.unlock();
+            const std::vector<uint8_t> data = in.bytes();
+            auto it = incoming.find({ jobId, range });
+            if (it != incoming.end()) {
+                it->second.file.write(reinterpret_cast<const char*>(data.data()), data.size());
+                it->second.receivedBytes += static_cast<int64_t>(data.size());
+            }
+            break;
+        }
+        case MessageType::ChunkEnd: {
+            const std::string jobId = in.str();
+            const uint32_t range = in.u32();
+            auto it = incoming.find({ jobId, range });
+            if (it == incoming.end()) break;
+            lock.unlock();
+            it->second.file.close();
+            // A worker whose read of its file stopped short still ends the chunk; the size tells
+            const bool written = !it->second.file.fail() && it->second.receivedBytes == it->second.expectedBytes;
+            const std::string partialPath = it->second.path;
+            incoming.erase(it);
+            lock.lock();
+
+            Job* job = findAssigned(jobId, range);
+            std::error_code ec;
+            if (!job || !written) {
+                std::filesystem::remove(partialPath, ec);
+                if (job) {
+                    unassign(job, range);
+                    job->ranges[range] = Job::Range::Pending;
+                }
+            } else {
+                RenderRange& result = job->info.ranges[range];
+                std::filesystem::rename(partialPath, result.resultPath, ec);
+                unassign(job, range);
+                if (ec) {
+                    job->ranges[range] = Job::Range::Pending;
+                } else {
+                    job->ranges[range] = Job::Range::Done;
+                    result.done = true;
+                    peer->node.framesRendered += result.frameCount;
+                    if (std::all_of(job->ranges.begin(), job->ranges.end(), [](Job::Range r) { return r == Job::Range::Done; })) {
+                        job->info.status = JobStatus::Completed;
+                        std::cout << "Job completed: " << job->info.jobId << std::endl;
+                    }
+                }
+            }
+            m_scheduleRequested = true;
+            m_condition.notify_all();
+            break;
+        }
+        case MessageType::RangeFailed: {
+            const std::string jobId = in.str();
+            const uint32_t range = in.u32();
+            const std::string error = in.str();
+            Job* job = findAssigned(jobId, range);
+            if (!job) break;
+            unassign(job, range);
+            std::cerr << "Range " << range << " of " << jobId << " failed on " << peer->node.nodeId << ": " << error << std::endl;
+            if (++job->attempts[range] >= kMaxRangeAttempts) {
+                job->info.status = JobStatus::Failed;
+                job->info.error = error;
+            } else {
+                job->ranges[range] = Job::Range::Pending;
+            }
+            m_scheduleRequested = true;
+            m_condition.notify_all();
+            break;
+        }
+        default:
+            peer->closed = true;
+            break;
+        }
+        if (!in.ok()) {
+            peer->closed = true;
+        }
     }
-    
-    if (listen(listenSocket, SOMAXCONN) == SOCKET_ERROR) {
-        std::cerr << "Listen failed: " << WSAGetLastError() << std::endl;
-        closesocket(listenSocket);
-        return;
+
+    peer->closed = true;
+    for (auto& [key, item] : incoming) {
+        item.file.close();
+        std::error_code ec;
+        std::filesystem::remove(item.path, ec);
     }
-    
-    std::cout << "Server listening on port " << m_port << std::endl;
-    
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_scheduleRequested = true;
+    m_condition.notify_all();
+}
+
+void AetherLink::schedulerThread() {
+    struct Assignment {
+        std::shared_ptr<Peer> peer;
+        const Job* job;
+        uint32_t range;
+        std::shared_ptr<const std::vector<uint8_t>> payload; // set when the worker does not have it yet
+    };
+    auto nextHeartbeat = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
     while (!m_shouldStop) {
-        fd_set readSet;
-        FD_ZERO(&readSet);
-        FD_SET(listenSocket, &readSet);
-        
-        struct timeval timeout;
-        timeout.tv_sec = 1;
-        timeout.tv_usec = 0;
-        
-        int result = select(0, &readSet, NULL, NULL, &timeout);
-        if (result > 0 && FD_ISSET(listenSocket, &readSet)) {
-            clientSocket = accept(listenSocket, (struct sockaddr*)&clientAddr, &clientAddrLen);
-            if (clientSocket != INVALID_SOCKET) {
-                char clientIP[INET_ADDRSTRLEN];
-                inet_ntop(AF_INET, &clientAddr.sin_addr, clientIP, INET_ADDRSTRLEN);
-                std::cout << "Worker connected: " << clientIP << std::endl;
-                
-                NetworkNode node;
-                node.nodeId = "NODE-" + std::string(clientIP);
-                node.ipAddress = clientIP;
-                node.port = ntohs(clientAddr.sin_port);
-                node.isOnline = true;
-                
-                {
-                    std::lock_guard<std::mutex> lock(m_mutex);
-                    m_connectedNodes.push_back(node);
+        const auto now = std::chrono::steady_clock::now();
+
+        // Workers that went away: their ranges go back to the queue until they have been lost too often
+        std::vector<std::shared_ptr<Peer>> lost;
+        for (auto it = m_peers.begin(); it != m_peers.end();) {
+            Peer& peer = **it;
+            if (!peer.closed && now - peer.lastSeen <= m_heartbeatInterval * kMissedHeartbeats) {
+                ++it;
+                continue;
+            }
+            for (const auto& [job, range] : peer.assigned) {
+                if (job->ranges[range] != Job::Range::Assigned) continue;
+                // A range that keeps taking its worker down counts as failing, like a reported failure
+                if (++job->attempts[range] >= kMaxRangeAttempts) {
+                    job->info.status = JobStatus::Failed;
+                    job->info.error = "Range " + std::to_string(range) + " was lost with its worker " +
+                                      std::to_string(kMaxRangeAttempts) + " times";
+                } else {
+                    job->ranges[range] = Job::Range::Pending;
                 }
-                
-                closesocket(clientSocket);
             }
+            if (!peer.node.nodeId.empty()) {
+                std::cout << "Worker lost: " << peer.node.nodeId << ", " << peer.assigned.size() << " ranges requeued" << std::endl;
+            }
+            peer.assigned.clear();
+            peer.progress.clear();
+            lost.push_back(*it);
+            it = m_peers.erase(it);
         }
+
+        // Jobs that ended early: the workers still rendering them stop
+        std::vector<std::pair<std::shared_ptr<Peer>, std::string>> cancels;
+        for (const auto& peer : m_peers) {
+            for (auto it = peer->assigned.begin(); it != peer->assigned.end();) {
+                const Job* job = it->first;
+                if (job->info.status == JobStatus::Processing) {
+                    ++it;
+                    continue;
+                }
+                const std::pair<std::shared_ptr<Peer>, std::string> cancel(peer, job->info.jobId);
+                if (std::find(cancels.begin(), cancels.end(), cancel) == cancels.end()) cancels.push_back(cancel);
+                peer->progress.erase({ job->info.jobId, it->second });
+                it = peer->assigned.erase(it);
+            }
+        }
+
+        // Pending ranges go to the least loaded workers, in the order the jobs came
+        std::vector<Assignment> assignments;
+        for (const auto& job : m_jobs) {
+            if (job->info.status != JobStatus::Pending && job->info.status != JobStatus::Processing) continue;
+            for (uint32_t range = 0; range < job->ranges.size(); range++) {
+                if (job->ranges[range] != Job::Range::Pending) continue;
+                std::shared_ptr<Peer> best;
+                double bestLoad = 1.0;
+                for (const auto& peer : m_peers) {
+                    if (peer->closed || peer->node.renderSlots == 0) continue;
+                    const double load = static_cast<double>(peer->assigned.size()) / peer->node.renderSlots;
+                    if (load < bestLoad) {
+                        best = peer;
+                        bestLoad = load;
+                    }
+                }
+                if (!best) break; // every worker is busy
+
+                job->ranges[range] = Job::Range::Assigned;
+                job->info.status = JobStatus::Processing;
+                best->assigned.emplace_back(job.get(), range);
+                best->progress[{ job->info.jobId, range }] = 0;
+                const bool sendPayload = std::find(best->jobsSent.begin(), best->jobsSent.end(), job->info.jobId) == best->jobsSent.end();
+                if (sendPayload) best->jobsSent.push_back(job->info.jobId);
+                assignments.push_back({ best, job.get(), range, sendPayload ? job->payload : nullptr });
+            }
+        }
+
+        // Ended jobs are reported once; their payload is dropped here and on the workers that have it
+        std::vector<RenderJob> finished;
+        for (const auto& job : m_jobs) {
+            if (job->reported || job->info.status == JobStatus::Pending || job->info.status == JobStatus::Processing) continue;
+            job->reported = true;
+            updateJobProgress(*job);
+            finished.push_back(job->info);
+            job->payload.reset();
+            for (const auto& peer : m_peers) {
+                auto sent = std::find(peer->jobsSent.begin(), peer->jobsSent.end(), job->info.jobId);
+                if (sent == peer->jobsSent.end()) continue;
+                peer->jobsSent.erase(sent);
+                const std::pair<std::shared_ptr<Peer>, std::string> cancel(peer, job->info.jobId);
+                if (std::find(cancels.begin(), cancels.end(), cancel) == cancels.end()) cancels.push_back(cancel);
+            }
+        }
+
+        std::vector<std::shared_ptr<Peer>> heartbeatPeers;
+        if (now >= nextHeartbeat) {
+            heartbeatPeers = m_peers;
+            nextHeartbeat = now + m_heartbeatInterval;
+        }
+
+        // Messages may block on a slow connection, so they are sent without the lock. Jobs are never
+        // removed, and the fields of theirs read below do not change after submission; payloads are
+        // held by the assignments.
+        lock.unlock();
+        for (const auto& peer : lost) {
+            shutdownSocket(peer->socket);
+            if (peer->thread.joinable()) peer->thread.join();
+            peer->close();
+        }
+        for (const auto& [peer, jobId] : cancels) {
+            MessageWriter message(MessageType::Cancel);
+            message.str(jobId);
+            peer->send(message);
+        }
+        for (const Assignment& a : assignments) {
+            if (a.payload) {
+                MessageWriter message(MessageType::Job);
+                message.str(a.job->info.jobId).bytes(a.payload->data(), a.payload->size());
+                a.peer->send(message);
+            }
+            const RenderRange& range = a.job->info.ranges[a.range];
+            MessageWriter message(MessageType::Range);
+            message.str(a.job->info.jobId).u32(a.range).i64(range.firstFrame).i64(range.frameCount)
+                   .str(std::filesystem::path(range.resultPath).extension().string());
+            a.peer->send(message); // a failed send closes the peer, which requeues its ranges next time round
+        }
+        for (const auto& peer : heartbeatPeers) {
+            MessageWriter message(MessageType::Heartbeat);
+            message.u32(0);
+            peer->send(message);
+        }
+        if (m_jobCompletedCallback) {
+            for (const RenderJob& job : finished) {
+                m_jobCompletedCallback(job);
+            }
+        }
+        lock.lock();
+
+        m_condition.wait_for(lock, std::chrono::milliseconds(100), [this]() { return m_shouldStop || m_scheduleRequested; });
+        m_scheduleRequested = false;
     }
-    
-    closesocket(listenSocket);
-#else
-    std::cout << "Server thread (Linux not fully implemented)" << std::endl;
-    while (!m_shouldStop) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    }
-#endif
 }
 
 void AetherLink::workerThread() {
-    if (m_role != NodeRole::Worker) {
-        return;
-    }
-    
-    std::cout << "Worker thread started" << std::endl;
-    
     while (!m_shouldStop) {
-        std::this_thread::sleep_for(std::chrono::seconds(5));
-        
+        std::string host;
+        uint16_t port = 0;
         {
             std::lock_guard<std::mutex> lock(m_mutex);
-            for (auto& job : m_jobQueue) {
-                if (job.status == JobStatus::Pending) {
-                    job.status = JobStatus::Processing;
-                    std::cout << "Processing job: " << job.jobId << std::endl;
-                    
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                    
-                    job.status = JobStatus::Completed;
-                    
-                    if (m_jobCompletedCallback) {
-                        m_jobCompletedCallback(job);
+            host = m_masterAddress;
+            port = m_masterPort;
+        }
+        const SocketHandle masterSocket = host.empty() ? kInvalidSocket : connectTo(host, port);
+        if (masterSocket == kInvalidSocket) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait_for(lock, std::chrono::seconds(1), [this]() { return m_shouldStop.load(); });
+            continue;
+        }
+        setNoDelay(masterSocket);
+
+        auto master = std::make_shared<Peer>();
+        master->socket = masterSocket;
+        master->node.nodeId = "MASTER-" + host;
+        master->node.ipAddress = host;
+        master->node.port = port;
+        master->node.isOnline = true;
+        master->connectedAt = std::chrono::steady_clock::now();
+        uint64_t connection = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_master = master;
+            connection = ++m_connection;
+        }
+
+        MessageWriter hello(MessageType::Hello);
+        hello.u32(kProtocolVersion).str(m_nodeId).u32(std::max(1u, std::thread::hardware_concurrency())).u32(m_workerSlots).str("");
+        master->send(hello);
+        std::cout << "Connected to master " << host << ":" << port << std::endl;
+
+        auto lastReceived = std::chrono::steady_clock::now();
+        auto lastSent = lastReceived;
+        MessageType type;
+        std::vector<uint8_t> body;
+        while (!m_shouldStop && !master->closed) {
+            const int ready = waitReadable(masterSocket, 100);
+            if (ready < 0) break;
+            if (ready > 0) {
+                if (!readMessage(masterSocket, type, body)) break;
+                lastReceived = std::chrono::steady_clock::now();
+                MessageReader in(body);
+                switch (type) {
+                case MessageType::Job: {
+                    const std::string jobId = in.str();
+                    auto payload = std::make_shared<const std::vector<uint8_t>>(in.bytes());
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_payloads[jobId] = std::move(payload);
+                    break;
+                }
+                case MessageType::Range: {
+                    auto item = std::make_shared<WorkItem>();
+                    item->jobId = in.str();
+                    item->range = in.u32();
+                    item->firstFrame = in.i64();
+                    item->frameCount = in.i64();
+                    item->extension = in.str();
+                    item->connection = connection;
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    auto it = m_payloads.find(item->jobId);
+                    if (it == m_payloads.end()) {
+                        master->closed = true; // the master sends a job before its ranges
+                        break;
+                    }
+                    item->payload = it->second;
+                    m_workQueue.push_back(std::move(item));
+                    m_condition.notify_all();
+                    break;
+                }
+                case MessageType::Cancel: {
+                    const std::string jobId = in.str();
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    cancelWorkItems(jobId);
+                    m_payloads.erase(jobId);
+                    break;
+                }
+                case MessageType::Heartbeat:
+                    break;
+                default:
+                    master->closed = true;
+                    break;
+                }
+                if (!in.ok()) {
+                    master->closed = true;
+                }
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            if (now - lastSent >= m_heartbeatInterval) {
+                MessageWriter heartbeat(MessageType::Heartbeat);
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    heartbeat.u32(static_cast<uint32_t>(m_rendering.size()));
+                    for (const auto& item : m_rendering) {
+                        heartbeat.str(item->jobId).u32(item->range).i64(item->framesDone);
                     }
                 }
+                master->send(heartbeat);
+                lastSent = now;
+            }
+            if (now - lastReceived > m_heartbeatInterval * kMissedHeartbeats) {
+                std::cerr << "Master " << host << ":" << port << " stopped responding" << std::endl;
+                break;
+            }
+        }
+
+        // Whatever the master handed out is given to other workers now
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_master.reset();
+            m_workQueue.clear();
+            for (const auto& item : m_rendering) {
+                item->cancelled = true;
             }
+            m_payloads.clear();
         }
+        master->close();
+        std::cout << "Disconnected from master " << host << ":" << port << std::endl;
+    }
+}
+
+void AetherLink::renderThread() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_shouldStop) {
+        if (m_workQueue.empty()) {
+            m_condition.wait(lock, [this]() { return m_shouldStop || !m_workQueue.empty(); });
+            continue;
+        }
+        std::shared_ptr<WorkItem> item = m_workQueue.front();
+        m_workQueue.erase(m_workQueue.begin());
+        m_rendering.push_back(item);
+        lock.unlock();
+
+        const std::string outputPath = (std::filesystem::temp_directory_path() /
+            ("aetherlink_" + m_nodeId + "_" + item->jobId + "_" + std::to_string(item->range) + item->extension)).string();
+        std::string error;
+        bool ok = false;
+        if (m_rangeRenderer) {
+            ok = m_rangeRenderer(*item->payload, item->firstFrame, item->frameCount, outputPath,
+                                 [&item](int64_t frames) { item->framesDone = frames; }, item->cancelled, error);
+        } else {
+            error = "The worker has no renderer";
+        }
+
+        lock.lock();
+        m_rendering.erase(std::find(m_rendering.begin(), m_rendering.end(), item));
+        // The master only wants the result on the connection it handed the range out on
+        std::shared_ptr<Peer> master = m_master && m_connection == item->connection ? m_master : nullptr;
+        lock.unlock();
+
+        if (master && !item->cancelled) {
+            std::ifstream file(outputPath, std::ios::binary);
+            std::error_code sizeError;
+            const uintmax_t size = ok ? std::filesystem::file_size(outputPath, sizeError) : 0;
+            if (ok && (!file || sizeError)) {
+                ok = false;
+                error = "Could not read " + outputPath;
+            }
+            if (!ok) {
+                MessageWriter message(MessageType::RangeFailed);
+                message.str(item->jobId).u32(item->range).str(error);
+                master->send(message);
+            } else {
+                MessageWriter begin(MessageType::ChunkBegin);
+                begin.str(item->jobId).u32(item->range).i64(static_cast<int64_t>(size));
+                bool sent = master->send(begin);
+                std::vector<char> piece(kChunkPieceBytes);
+                while (sent && !item->cancelled && file) {
+                    file.read(piece.data(), static_cast<std::streamsize>(piece.size()));
+                    if (file.gcount() <= 0) break;
+                    MessageWriter data(MessageType::ChunkData);
+                    data.str(item->jobId).u32(item->range).bytes(piece.data(), static_cast<size_t>(file.gcount()));
+                    sent = master->send(data);
+                }
+                if (sent && !item->cancelled) {
+                    MessageWriter end(MessageType::ChunkEnd);
+                    end.str(item->jobId).u32(item->range);
+                    master->send(end);
+                }
+            }
+        }
+        std::error_code ec;
+        std::filesystem::remove(outputPath, ec);
+        lock.lock();
+    }
+}
+
+void AetherLink::cancelWorkItems(const std::string& jobId) {
+    m_workQueue.erase(std::remove_if(m_workQueue.begin(), m_workQueue.end(),
+                                     [&jobId](const auto& item) { return item->jobId == jobId; }),
+                      m_workQueue.end());
+    for (const auto& item : m_rendering) {
+        if (item->jobId == jobId) item->cancelled = true;
     }
 }
 
 void AetherLink::discoveryThread() {
-    std::cout << "Discovery thread started (placeholder)" << std::endl;
-    
+    SocketHandle udpSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (udpSocket == kInvalidSocket) {
+        std::cerr << "Failed to create discovery socket" << std::endl;
+        return;
+    }
+    int one = 1;
+    setsockopt(udpSocket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&one), sizeof(one));
+    struct sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(m_port);
+    if (bind(udpSocket, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0) {
+        std::cerr << "Failed to bind discovery port " << m_port << std::endl;
+        closeSocket(udpSocket);
+        return;
+    }
+
+    const std::string reply = std::string(kDiscoverReply) + " " + std::to_string(m_port) + " " + m_nodeId;
     while (!m_shouldStop) {
-        std::this_thread::sleep_for(std::chrono::seconds(5));
+        if (waitReadable(udpSocket, 200) <= 0) {
+            continue;
+        }
+        char buffer[64];
+        struct sockaddr_in from = {};
+        socklen_t fromLen = sizeof(from);
+        const int n = recvfrom(udpSocket, buffer, sizeof(buffer), 0, reinterpret_cast<struct sockaddr*>(&from), &fromLen);
+        if (n == static_cast<int>(strlen(kDiscoverRequest)) && memcmp(buffer, kDiscoverRequest, n) == 0) {
+            sendto(udpSocket, reply.data(), static_cast<int>(reply.size()), 0, reinterpret_cast<struct sockaddr*>(&from), fromLen);
+        }
     }
+    closeSocket(udpSocket);
+}
+
+std::vector<NetworkNode> AetherLink::discoverNodes() {
+    std::cout << "Discovering nodes on network..." << std::endl;
+    std::vector<NetworkNode> nodes;
+    SocketHandle udpSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (udpSocket == kInvalidSocket) {
+        return nodes;
+    }
+    int one = 1;
+    setsockopt(udpSocket, SOL_SOCKET, SO_BROADCAST, reinterpret_cast<const char*>(&one), sizeof(one));
+    for (uint32_t target : { static_cast<uint32_t>(INADDR_BROADCAST), static_cast<uint32_t>(INADDR_LOOPBACK) }) {
+        struct sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(target);
+        address.sin_port = htons(m_port);
+        sendto(udpSocket, kDiscoverRequest, static_cast<int>(strlen(kDiscoverRequest)), 0,
+               reinterpret_cast<struct sockaddr*>(&address), sizeof(address));
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (std::chrono::steady_clock::now() < deadline) {
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (waitReadable(udpSocket, static_cast<int>(std::max<int64_t>(1, remaining.count()))) <= 0) {
+            break;
+        }
+        char buffer[128];
+        struct sockaddr_in from = {};
+        socklen_t fromLen = sizeof(from);
+        const int n = recvfrom(udpSocket, buffer, sizeof(buffer) - 1, 0, reinterpret_cast<struct sockaddr*>(&from), &fromLen);
+        if (n <= 0) {
+            continue;
+        }
+        buffer[n] = '\0';
+        std::istringstream reply(buffer);
+        std::string tag;
+        NetworkNode node;
+        reply >> tag >> node.port >> node.nodeId;
+        if (tag != kDiscoverReply || node.nodeId.empty()) {
+            continue;
+        }
+        char ip[INET_ADDRSTRLEN] = {};
+        inet_ntop(AF_INET, &from.sin_addr, ip, INET_ADDRSTRLEN);
+        node.ipAddress = ip;
+        node.isOnline = true;
+        const bool known = std::any_of(nodes.begin(), nodes.end(), [&node](const NetworkNode& n) { return n.nodeId == node.nodeId; });
+        if (!known) {
+            nodes.push_back(node);
+        }
+    }
+    closeSocket(udpSocket);
+    return nodes;
 }
 
 bool AetherLink::connectToNode(const std::string& ipAddress, uint16_t port) {
     std::lock_guard<std::mutex> lock(m_mutex);
-    
-    for (const auto& node : m_connectedNodes) {
-        if (node.ipAddress == ipAddress && node.port == port) {
-            return true;
-        }
+
+    if (m_role != NodeRole::Worker) {
+        std::cerr << "Only workers connect to a node; the master waits for them" << std::endl;
+        return false;
     }
-    
-    NetworkNode node;
-    node.nodeId = "NODE-" + ipAddress;
-    node.ipAddress = ipAddress;
-    node.port = port;
-    node.isOnline = true;
-    
-    m_connectedNodes.push_back(node);
-    
-    std::cout << "Connected to node: " << ipAddress << ":" << port << std::endl;
+
+    m_masterAddress = ipAddress;
+    m_masterPort = port;
+    // A connection to another master is dropped; the worker thread then connects to this one
+    if (m_master && (m_master->node.ipAddress != ipAddress || m_master->node.port != port)) {
+        m_master->closed = true;
+    }
+    m_condition.notify_all();
     return true;
 }
 
 void AetherLink::disconnectFromNode(const std::string& nodeId) {
     std::lock_guard<std::mutex> lock(m_mutex);
-    
-    m_connectedNodes.erase(
-        std::remove_if(m_connectedNodes.begin(), m_connectedNodes.end(),
-            [&nodeId](const NetworkNode& node) { return node.nodeId == nodeId; }),
-        m_connectedNodes.end()
-    );
+
+    for (const auto& peer : m_peers) {
+        if (peer->node.nodeId == nodeId) {
+            peer->closed = true;
+            shutdownSocket(peer->socket);
+        }
+    }
+    m_scheduleRequested = true;
+    m_condition.notify_all();
 }
 
 std::vector<NetworkNode> AetherLink::getConnectedNodes() const {
     std::lock_guard<std::mutex> lock(m_mutex);
-    return m_connectedNodes;
+    std::vector<NetworkNode> nodes;
+    for (const auto& peer : m_peers) {
+        if (peer->closed || peer->node.renderSlots == 0) {
+            continue;
+        }
+        NetworkNode node = peer->node;
+        node.activeRanges = static_cast<uint32_t>(peer->assigned.size());
+        const double seconds = secondsSince(peer->connectedAt);
+        node.fps = seconds > 0.0 ? node.framesRendered / seconds : 0.0;
+        nodes.push_back(node);
+    }
+    if (m_master && !m_master->closed) {
+        nodes.push_back(m_master->node);
+    }
+    return nodes;
+}
+
+std::vector<RenderRange> AetherLink::splitRange(int64_t startFrame, int64_t endFrame, int64_t chunkFrames,
+                                                const std::string& resultDir, const std::string& extension) {
+    std::vector<RenderRange> ranges;
+    const int64_t length = chunkFrames > 0 ? chunkFrames : endFrame - startFrame;
+    for (int64_t first = startFrame; length > 0 && first < endFrame; first += length) {
+        char name[32];
+        snprintf(name, sizeof(name), "chunk_%05zu", ranges.size());
+        RenderRange range;
+        range.firstFrame = first;
+        range.frameCount = std::min(length, endFrame - first);
+        range.resultPath = (std::filesystem::path(resultDir) / (name + extension)).string();
+        ranges.push_back(range);
+    }
+    return ranges;
 }
 
 std::string AetherLink::submitJob(const RenderJob& job) {
     std::lock_guard<std::mutex> lock(m_mutex);
-    
+
     if (m_role != NodeRole::Master) {
         std::cerr << "Only master can submit jobs" << std::endl;
         return "";
     }
-    
-    RenderJob newJob = job;
-    if (newJob.jobId.empty()) {
-        newJob.jobId = "JOB-" + std::to_string(m_jobQueue.size() + 1);
-    }
-    
-    newJob.status = JobStatus::Pending;
-    m_jobQueue.push_back(newJob);
-    
-    std::cout << "Job submitted: " << newJob.jobId << std::endl;
-    return newJob.jobId;
+
+    auto newJob = std::make_unique<Job>();
+    newJob->info = job;
+    if (newJob->info.jobId.empty()) {
+        newJob->info.jobId = "JOB-" + std::to_string(m_nextJobNumber++);
+    }
+    for (const auto& existing : m_jobs) {
+        if (existing->info.jobId == newJob->info.jobId) {
+            std::cerr << "Job " << newJob->info.jobId << " already exists" << std::endl;
+            return "";
+        }
+    }
+    if (newJob->info.ranges.empty()) {
+        newJob->info.ranges = splitRange(job.startFrame, job.endFrame, job.chunkFrames, job.resultDir, job.resultExtension);
+    }
+    if (newJob->info.ranges.empty()) {
+        std::cerr << "Job " << newJob->info.jobId << " has no frames" << std::endl;
+        return "";
+    }
+
+    newJob->payload = std::make_shared<const std::vector<uint8_t>>(std::move(newJob->info.payload));
+    newJob->info.payload.clear();
+    newJob->ranges.assign(newJob->info.ranges.size(), Job::Range::Pending);
+    newJob->attempts.assign(newJob->info.ranges.size(), 0);
+    for (size_t i = 0; i < newJob->info.ranges.size(); i++) {
+        RenderRange& range = newJob->info.ranges[i];
+        std::error_code ec;
+        range.done = range.done && std::filesystem::exists(range.resultPath, ec);
+        if (range.done) {
+            newJob->ranges[i] = Job::Range::Done;
+            newJob->reusedFrames += range.frameCount;
+        }
+    }
+    const bool allDone = newJob->reusedFrames == std::accumulate(newJob->info.ranges.begin(), newJob->info.ranges.end(), int64_t(0),
+        [](int64_t sum, const RenderRange& range) { return sum + range.frameCount; });
+    newJob->info.status = allDone ? JobStatus::Completed : JobStatus::Pending;
+    newJob->submittedAt = std::chrono::steady_clock::now();
+
+    const std::string jobId = newJob->info.jobId;
+    m_jobs.push_back(std::move(newJob));
+    m_scheduleRequested = true;
+    m_condition.notify_all();
+
+    std::cout << "Job submitted: " << jobId << std::endl;
+    return jobId;
 }
 
 bool AetherLink::cancelJob(const std::string& jobId) {
     std::lock_guard<std::mutex> lock(m_mutex);
-    
-    for (auto& job : m_jobQueue) {
-        if (job.jobId == jobId) {
-            if (job.status == JobStatus::Pending) {
-                job.status = JobStatus::Failed;
+
+    for (auto& job : m_jobs) {
+        if (job->info.jobId == jobId) {
+            if (job->info.status == JobStatus::Pending || job->info.status == JobStatus::Processing) {
+                job->info.status = JobStatus::Cancelled;
+                m_scheduleRequested = true;
+                m_condition.notify_all();
                 return true;
             }
         }
     }
-    
+
     return false;
 }
 
+void AetherLink::updateJobProgress(Job& job) const {
+    int64_t frames = 0;
+    for (size_t i = 0; i < job.ranges.size(); i++) {
+        if (job.ranges[i] == Job::Range::Done) frames += job.info.ranges[i].frameCount;
+    }
+    for (const auto& peer : m_peers) {
+        for (const auto& [key, done] : peer->progress) {
+            if (key.first == job.info.jobId) frames += done;
+        }
+    }
+    job.info.framesDone = frames;
+    const double seconds = secondsSince(job.submittedAt);
+    job.info.fps = seconds > 0.0 ? (frames - job.reusedFrames) / seconds : 0.0;
+}
+
 RenderJob AetherLink::getJobStatus(const std::string& jobId) const {
     std::lock_guard<std::mutex> lock(m_mutex);
-    
-    for (const auto& job : m_jobQueue) {
-        if (job.jobId == jobId) {
-            return job;
+
+    for (const auto& job : m_jobs) {
+        if (job->info.jobId == jobId) {
+            if (!job->reported) updateJobProgress(*job);
+            return job->info;
         }
     }
-    
+
     return RenderJob{};
 }
 
 std::vector<RenderJob> AetherLink::getAllJobs() const {
     std::lock_guard<std::mutex> lock(m_mutex);
-    return m_jobQueue;
-}
-
-void AetherLink::discoverNodes() {
-    std::cout << "Discovering nodes on network..." << std::endl;
+    std::vector<RenderJob> jobs;
+    for (const auto& job : m_jobs) {
+        if (!job->reported) updateJobProgress(*job);
+        jobs.push_back(job->info);
+    }
+    return jobs;
 }
 
 } // namespace aether
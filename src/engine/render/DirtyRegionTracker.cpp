@@ -0,0 +1,131 @@
+#include "aether/DirtyRegionTracker.h"
+#include <algorithm>
+
+namespace aether {
+
+void DirtyRegionTracker::setFrameSize(uint32_t width, uint32_t height) {
+    if (m_frameWidth == width && m_frameHeight == height) {
+        return;
+    }
+    m_frameWidth = width;
+    m_frameHeight = height;
+    invalidateAll();
+}
+
+void DirtyRegionTracker::addStage(const std::string& name, uint32_t footprintRadius) {
+    if (findStage(name) >= 0) {
+        return;
+    }
+    m_stages.push_back({name, footprintRadius});
+    // A new stage changes the output everywhere
+    invalidateAll();
+}
+
+void DirtyRegionTracker::removeStage(const std::string& name) {
+    int index = findStage(name);
+    if (index < 0) {
+        return;
+    }
+    m_stages.erase(m_stages.begin() + index);
+    invalidateAll();
+}
+
+void DirtyRegionTracker::clearStages() {
+    m_stages.clear();
+    invalidateAll();
+}
+
+bool DirtyRegionTracker::setStageFootprint(const std::string& name, uint32_t footprintRadius) {
+    int index = findStage(name);
+    if (index < 0) {
+        return false;
+    }
+    EffectStage& stage = m_stages[static_cast<size_t>(index)];
+    if (stage.footprintRadius != footprintRadius) {
+        stage.footprintRadius = footprintRadius;
+        // Changing a kernel size alters every output pixel of that stage
+        invalidateStage(name);
+    }
+    return true;
+}
+
+uint32_t DirtyRegionTracker::downstreamExpansion(size_t stageIndex) const {
+    uint64_t radius = 0;
+    for (size_t i = stageIndex; i < m_stages.size(); i++) {
+        radius += m_stages[i].footprintRadius;
+    }
+    return static_cast<uint32_t>(std::min<uint64_t>(radius, UINT32_MAX));
+}
+
+DirtyRect DirtyRegionTracker::invalidateParameter(const std::string& stageName, const DirtyRect& region) {
+    int index = findStage(stageName);
+    if (index < 0 || region.isEmpty()) {
+        // Unknown stage or whole-frame parameter: nothing can be culled
+        DirtyRect rect = fullFrame();
+        if (!rect.isEmpty()) {
+            m_pending.push_back(rect);
+        }
+        return rect;
+    }
+
+    DirtyRect rect = dilateAndClamp(region, downstreamExpansion(static_cast<size_t>(index)));
+    if (!rect.isEmpty()) {
+        m_pending.push_back(rect);
+    }
+    return rect;
+}
+
+DirtyRect DirtyRegionTracker::invalidateStage(const std::string& stageName) {
+    return invalidateParameter(stageName, DirtyRect{});
+}
+
+void DirtyRegionTracker::invalidateAll() {
+    m_pending.clear();
+    DirtyRect rect = fullFrame();
+    if (!rect.isEmpty()) {
+        m_pending.push_back(rect);
+    }
+}
+
+std::vector<DirtyRect> DirtyRegionTracker::takePendingRegions() {
+    std::vector<DirtyRect> regions;
+    regions.swap(m_pending);
+    return regions;
+}
+
+DirtyRect DirtyRegionTracker::fullFrame() const {
+    return DirtyRect{0, 0, m_frameWidth, m_frameHeight};
+}
+
+DirtyRect DirtyRegionTracker::dilateAndClamp(const DirtyRect& rect, uint32_t radius) const {
+    if (m_frameWidth == 0 || m_frameHeight == 0) {
+        return DirtyRect{};
+    }
+
+    int64_t left = static_cast<int64_t>(rect.x) - radius;
+    int64_t top = static_cast<int64_t>(rect.y) - radius;
+    int64_t right = static_cast<int64_t>(rect.x) + rect.width + radius;
+    int64_t bottom = static_cast<int64_t>(rect.y) + rect.height + radius;
+
+    left = std::clamp<int64_t>(left, 0, m_frameWidth);
+    top = std::clamp<int64_t>(top, 0, m_frameHeight);
+    right = std::clamp<int64_t>(right, 0, m_frameWidth);
+    bottom = std::clamp<int64_t>(bottom, 0, m_frameHeight);
+
+    if (right <= left || bottom <= top) {
+        return DirtyRect{};
+    }
+    return DirtyRect{static_cast<uint32_t>(left), static_cast<uint32_t>(top),
+                     static_cast<uint32_t>(right - left), static_cast<uint32_t>(bottom - top)};
+}
+
+int DirtyRegionTracker::findStage(const std::string& name) const {
+    for (size_t i = 0; i < m_stages.size(); i++) {
+        if (m_stages[i].name == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+} // namespace aether
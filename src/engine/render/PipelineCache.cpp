@@ -0,0 +1,253 @@
+#include "aether/PipelineCache.h"
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace aether {
+
+namespace {
+
+std::string toHex(const uint8_t* bytes, size_t count) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(count * 2);
+    for (size_t i = 0; i < count; i++) {
+        hex.push_back(digits[bytes[i] >> 4]);
+        hex.push_back(digits[bytes[i] & 0x0f]);
+    }
+    return hex;
+}
+
+} // namespace
+
+PipelineCache::PipelineCache() = default;
+
+PipelineCache::~PipelineCache() {
+    shutdown();
+}
+
+std::string PipelineCache::defaultCacheDirectory() {
+#ifdef _WIN32
+    const char* localAppData = std::getenv("LOCALAPPDATA");
+    if (localAppData) {
+        return std::string(localAppData) + "\\AetherStudio\\PipelineCache";
+    }
+    return ".\\cache";
+#else
+    const char* xdgCache = std::getenv("XDG_CACHE_HOME");
+    if (xdgCache && *xdgCache) {
+        return std::string(xdgCache) + "/AetherStudio";
+    }
+    const char* home = std::getenv("HOME");
+    if (home) {
+        return std::string(home) + "/.cache/AetherStudio";
+    }
+    return "./cache";
+#endif
+}
+
+bool PipelineCache::initialize(VkPhysicalDevice physicalDevice, VkDevice device, const std::string& cacheDirectory) {
+    if (m_cache != VK_NULL_HANDLE) {
+        return true;
+    }
+    m_physicalDevice = physicalDevice;
+    m_device = device;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    std::string directory = cacheDirectory.empty() ? defaultCacheDirectory() : cacheDirectory;
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    m_filePath = (std::filesystem::path(directory) /
+                  ("pipelines_" + toHex(properties.pipelineCacheUUID, VK_UUID_SIZE) + ".bin")).string();
+
+    std::vector<uint8_t> initialData;
+    m_loadedFromDisk = readCacheFile(properties, initialData);
+
+    VkPipelineCacheCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = initialData.size();
+    createInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+    if (vkCreatePipelineCache(m_device, &createInfo, nullptr, &m_cache) != VK_SUCCESS) {
+        // A corrupt blob can be rejected by the driver; retry empty
+        createInfo.initialDataSize = 0;
+        createInfo.pInitialData = nullptr;
+        m_loadedFromDisk = false;
+        if (vkCreatePipelineCache(m_device, &createInfo, nullptr, &m_cache) != VK_SUCCESS) {
+            std::cerr << "Failed to create pipeline cache" << std::endl;
+            return false;
+        }
+    }
+
+    std::cout << "Pipeline cache: " << m_filePath << (m_loadedFromDisk ? " (warm)" : " (cold)") << std::endl;
+    return true;
+}
+
+bool PipelineCache::readCacheFile(const VkPhysicalDeviceProperties& properties, std::vector<uint8_t>& data) const {
+    std::ifstream file(m_filePath, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::streamsize size = file.tellg();
+    if (size < static_cast<std::streamsize>(16 + VK_UUID_SIZE)) {
+        return false;
+    }
+    data.resize(static_cast<size_t>(size));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(data.data()), size)) {
+        data.clear();
+        return false;
+    }
+
+    // VkPipelineCacheHeaderVersionOne: length, version, vendorID, deviceID, UUID
+    uint32_t header[4];
+    std::memcpy(header, data.data(), sizeof(header));
+    bool valid = header[0] >= 16 + VK_UUID_SIZE &&
+                 header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+                 header[2] == properties.vendorID &&
+                 header[3] == properties.deviceID &&
+                 std::memcmp(data.data() + 16, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    if (!valid) {
+        std::cout << "Discarding pipeline cache from a different driver: " << m_filePath << std::endl;
+        data.clear();
+    }
+    return valid;
+}
+
+bool PipelineCache::save() {
+    if (m_cache == VK_NULL_HANDLE || m_filePath.empty()) {
+        return false;
+    }
+
+    // Another cache on this GPU (another engine, another process) may have saved since this one
+    // was loaded. Saving the union keeps its pipelines instead of overwriting them; merging into
+    // a temporary cache leaves m_cache free for builds still running on other threads.
+    VkPipelineCache source = m_cache;
+    VkPipelineCache merged = VK_NULL_HANDLE;
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_physicalDevice, &properties);
+    std::vector<uint8_t> onDisk;
+    if (readCacheFile(properties, onDisk)) {
+        VkPipelineCacheCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        createInfo.initialDataSize = onDisk.size();
+        createInfo.pInitialData = onDisk.data();
+        if (vkCreatePipelineCache(m_device, &createInfo, nullptr, &merged) == VK_SUCCESS) {
+            if (vkMergePipelineCaches(m_device, merged, 1, &m_cache) == VK_SUCCESS) {
+                source = merged;
+            }
+        } else {
+            merged = VK_NULL_HANDLE;
+        }
+    }
+
+    size_t size = 0;
+    std::vector<uint8_t> data;
+    bool fetched = vkGetPipelineCacheData(m_device, source, &size, nullptr) == VK_SUCCESS && size > 0;
+    if (fetched) {
+        data.resize(size);
+        fetched = vkGetPipelineCacheData(m_device, source, &size, data.data()) == VK_SUCCESS;
+    }
+    if (merged != VK_NULL_HANDLE) {
+        vkDestroyPipelineCache(m_device, merged, nullptr);
+    }
+    if (!fetched) {
+        return false;
+    }
+
+    // Write-then-rename so a crash mid-write never leaves a truncated cache
+    std::string tempPath = m_filePath + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Failed to write pipeline cache: " << tempPath << std::endl;
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(size));
+        if (!file) {
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tempPath, m_filePath, ec);
+    if (ec) {
+        std::cerr << "Failed to replace pipeline cache: " << ec.message() << std::endl;
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+void PipelineCache::shutdown() {
+    waitForPendingBuilds();
+    if (m_cache != VK_NULL_HANDLE) {
+        save();
+        vkDestroyPipelineCache(m_device, m_cache, nullptr);
+        m_cache = VK_NULL_HANDLE;
+    }
+    m_device = VK_NULL_HANDLE;
+    m_physicalDevice = VK_NULL_HANDLE;
+    m_loadedFromDisk = false;
+}
+
+VkPipeline PipelineCache::createComputePipeline(const uint32_t* code, size_t wordCount, VkPipelineLayout layout) {
+    if (m_device == VK_NULL_HANDLE || code == nullptr || wordCount == 0) {
+        return VK_NULL_HANDLE;
+    }
+
+    VkShaderModuleCreateInfo moduleInfo{};
+    moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    moduleInfo.codeSize = wordCount * sizeof(uint32_t);
+    moduleInfo.pCode = code;
+
+    VkShaderModule module = VK_NULL_HANDLE;
+    if (vkCreateShaderModule(m_device, &moduleInfo, nullptr, &module) != VK_SUCCESS) {
+        std::cerr << "Failed to create compute shader module" << std::endl;
+        return VK_NULL_HANDLE;
+    }
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = module;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.layout = layout;
+
+    // VkPipelineCache is internally synchronized, so worker threads can share it
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if (vkCreateComputePipelines(m_device, m_cache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+        std::cerr << "Failed to create compute pipeline" << std::endl;
+        pipeline = VK_NULL_HANDLE;
+    }
+    vkDestroyShaderModule(m_device, module, nullptr);
+    return pipeline;
+}
+
+std::shared_future<VkPipeline> PipelineCache::createComputePipelineAsync(std::vector<uint32_t> code, VkPipelineLayout layout) {
+    std::shared_future<VkPipeline> future =
+        std::async(std::launch::async, [this, code = std::move(code), layout]() {
+            return createComputePipeline(code.data(), code.size(), layout);
+        }).share();
+
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
+    m_pending.push_back(future);
+    return future;
+}
+
+void PipelineCache::waitForPendingBuilds() {
+    std::vector<std::shared_future<VkPipeline>> pending;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        pending.swap(m_pending);
+    }
+    for (auto& future : pending) {
+        future.wait();
+    }
+}
+
+} // namespace aether
@@ -1,6 +1,16 @@
 #include "../../include/aether/RenderView.h"
 #include "../../include/aether/TilingRenderer.h"
+#include "VulkanRenderer.h"
+#include "aether/DirtyRegionTracker.h"
+#include "aether/EffectChain.h"
+#include "aether/PipelineCache.h"
+#include "aether/ShaderLibrary.h"
+#include "aether/VulkanVFXEngine.h"
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -8,7 +18,127 @@
 
 namespace aether {
 
-RenderView::RenderView() {}
+namespace {
+
+uint32_t findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeBits,
+                        VkMemoryPropertyFlags properties) {
+  VkPhysicalDeviceMemoryProperties memoryProperties;
+  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+  for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+    if ((typeBits & (1u << i)) &&
+        (memoryProperties.memoryTypes[i].propertyFlags & properties) ==
+            properties) {
+      return i;
+    }
+  }
+  return UINT32_MAX;
+}
+
+void imageBarrier(VkCommandBuffer commandBuffer, VkImage image,
+                  VkImageLayout oldLayout, VkImageLayout newLayout,
+                  VkAccessFlags srcAccess, VkAccessFlags dstAccess,
+                  VkPipelineStageFlags srcStage,
+                  VkPipelineStageFlags dstStage) {
+  VkImageMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.srcAccessMask = srcAccess;
+  barrier.dstAccessMask = dstAccess;
+  barrier.oldLayout = oldLayout;
+  barrier.newLayout = newLayout;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = image;
+  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.baseMipLevel = 0;
+  barrier.subresourceRange.levelCount = 1;
+  barrier.subresourceRange.baseArrayLayer = 0;
+  barrier.subresourceRange.layerCount = 1;
+  vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, nullptr, 0,
+                       nullptr, 1, &barrier);
+}
+
+VkBufferImageCopy fullImageCopy(uint32_t width, uint32_t height) {
+  VkBufferImageCopy region{};
+  region.bufferOffset = 0;
+  region.bufferRowLength = 0;
+  region.bufferImageHeight = 0;
+  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  region.imageSubresource.mipLevel = 0;
+  region.imageSubresource.baseArrayLayer = 0;
+  region.imageSubresource.layerCount = 1;
+  region.imageOffset = {0, 0, 0};
+  region.imageExtent = {width, height, 1};
+  return region;
+}
+
+// Pixels a stage's output reads around itself; the dirty tracker uses the same measure
+uint64_t stageFootprint(const CompiledStage &stage) {
+  return stage.access == EffectAccess::PerPixel
+             ? 0
+             : EffectChainCompiler::footprintOf(stage.op);
+}
+
+DirtyRect dilate(const DirtyRect &rect, uint64_t radius, uint32_t width,
+                 uint32_t height) {
+  const uint64_t left = rect.x > radius ? rect.x - radius : 0;
+  const uint64_t top = rect.y > radius ? rect.y - radius : 0;
+  const uint64_t right =
+      std::min<uint64_t>(width, uint64_t(rect.x) + rect.width + radius);
+  const uint64_t bottom =
+      std::min<uint64_t>(height, uint64_t(rect.y) + rect.height + radius);
+  return DirtyRect{static_cast<uint32_t>(left), static_cast<uint32_t>(top),
+                   static_cast<uint32_t>(right - left),
+                   static_cast<uint32_t>(bottom - top)};
+}
+
+// Copies target.width x target.height pixels from (srcX, srcY) of src to
+// (target.x, target.y) of dst
+void copyRect(const CpuImage &src, uint32_t srcX, uint32_t srcY, CpuImage &dst,
+              const DirtyRect &target) {
+  const size_t rowBytes = static_cast<size_t>(target.width) * 4;
+  for (uint32_t row = 0; row < target.height; row++) {
+    std::memcpy(dst.rgba.data() +
+                    (static_cast<size_t>(target.y + row) * dst.width +
+                     target.x) *
+                        4,
+                src.rgba.data() +
+                    (static_cast<size_t>(srcY + row) * src.width + srcX) * 4,
+                rowBytes);
+  }
+}
+
+// Four independent multiply-xor lanes over 64-bit words; only equality matters
+uint64_t hashPixels(const CpuImage &image) {
+  const size_t bytes = static_cast<size_t>(image.width) * image.height * 4;
+  const size_t words = bytes / 8;
+  const uint64_t prime = 0x100000001b3ull;
+  uint64_t lanes[4] = {0xcbf29ce484222325ull, 0x84222325cbf29ce4ull,
+                       0x9e3779b97f4a7c15ull, 0xc2b2ae3d27d4eb4full};
+  const uint8_t *data = image.rgba.data();
+  size_t i = 0;
+  for (; i + 4 <= words; i += 4) {
+    for (size_t lane = 0; lane < 4; lane++) {
+      uint64_t word;
+      std::memcpy(&word, data + (i + lane) * 8, 8);
+      lanes[lane] = (lanes[lane] ^ word) * prime;
+    }
+  }
+  uint64_t hash = image.width * 0x9e3779b97f4a7c15ull ^ image.height;
+  for (uint64_t lane : lanes) {
+    hash = (hash ^ lane) * prime;
+  }
+  for (size_t b = i * 8; b < bytes; b++) {
+    hash = (hash ^ data[b]) * prime;
+  }
+  return hash;
+}
+
+} // namespace
+
+RenderView::RenderView()
+    : m_dirtyTracker(std::make_unique<DirtyRegionTracker>()),
+      m_compiledChain(std::make_unique<CompiledEffectChain>()),
+      m_tileImage(std::make_unique<CpuImage>()) {}
 
 RenderView::~RenderView() { shutdown(); }
 
@@ -23,6 +153,9 @@ bool RenderView::initialize(VkDevice device, VkPhysicalDevice physicalDevice,
   m_graphicsQueue = graphicsQueue;
   m_commandPool = commandPool;
 
+  // Warm pipeline cache from disk before any pipeline is built
+  initializePipelineCache();
+
   // Create descriptor set layout
   if (!createDescriptorSetLayout()) {
     std::cerr << "Failed to create descriptor set layout" << std::endl;
@@ -38,6 +171,7 @@ bool RenderView::initialize(VkDevice device, VkPhysicalDevice physicalDevice,
       m_tilingRenderer.reset();
     }
   }
+  m_dirtyTracker->setFrameSize(m_settings.width, m_settings.height);
 
   // Load default shaders
   const char *defaultVertexShader = R"(
@@ -114,14 +248,95 @@ void RenderView::shutdown() {
     m_descriptorSetLayout = VK_NULL_HANDLE;
   }
 
+  destroyComputeTargets();
+  if (m_vfxEngine) {
+    m_vfxEngine->shutdown();
+    m_vfxEngine.reset();
+  }
+
+  if (m_pipelineCache) {
+    m_pipelineCache->shutdown();
+    m_pipelineCache.reset();
+  }
+
   if (m_tilingRenderer) {
     m_tilingRenderer->shutdown();
     m_tilingRenderer.reset();
   }
 
+  if (m_offscreenRenderer) {
+    m_offscreenRenderer->shutdown();
+    m_offscreenRenderer.reset();
+    m_device = VK_NULL_HANDLE;
+    m_physicalDevice = VK_NULL_HANDLE;
+    m_graphicsQueue = VK_NULL_HANDLE;
+    m_commandPool = VK_NULL_HANDLE;
+  }
+  m_headless = false;
+
   m_initialized = false;
 }
 
+bool RenderView::initializeHeadless(uint32_t width, uint32_t height) {
+  if (m_initialized) {
+    return m_headless;
+  }
+  if (width == 0 || height == 0) {
+    std::cerr << "Invalid headless render size" << std::endl;
+    return false;
+  }
+
+  m_headless = true;
+  m_settings.width = width;
+  m_settings.height = height;
+  m_settings.fitToWindow = false;
+
+  const char *forced = std::getenv("AETHER_HEADLESS_BACKEND");
+  bool forceCpu = forced != nullptr && std::string(forced) == "cpu";
+
+  if (!forceCpu) {
+    auto renderer = std::make_unique<VulkanRenderer>();
+    if (renderer->initializeHeadless(width, height)) {
+      m_device = renderer->getDevice();
+      m_physicalDevice = renderer->getPhysicalDevice();
+      m_graphicsQueue = renderer->getGraphicsQueue();
+      m_commandPool = renderer->getCommandPool();
+      m_offscreenRenderer = std::move(renderer);
+      initializePipelineCache();
+      if (!createDescriptorSetLayout()) {
+        std::cerr << "Failed to create descriptor set layout" << std::endl;
+      }
+      for (const std::string &shader : listEmbeddedShaders()) {
+        loadEmbeddedShader(shader, ShaderType::Compute, shader);
+      }
+      // Compiled chains need pixel_chain for fused per-pixel runs and blur
+      // for neighbourhood stages; without them every frame runs on the CPU
+      if (findEmbeddedShader("pixel_chain") && findEmbeddedShader("blur")) {
+        m_vfxEngine = std::make_unique<VulkanVFXEngine>();
+        // One cache per device: two caches would overwrite each other's file
+        if (!m_vfxEngine->initialize(m_offscreenRenderer->getInstance(),
+                                     m_physicalDevice, m_device,
+                                     m_pipelineCache.get())) {
+          m_vfxEngine.reset();
+        }
+      }
+      if (!m_vfxEngine) {
+        std::cerr << "Compute shaders unavailable, effects run on the CPU "
+                     "backend"
+                  << std::endl;
+      }
+    } else {
+      std::cerr << "Headless Vulkan unavailable, using CPU effect backend"
+                << std::endl;
+    }
+  }
+  m_backend = m_vfxEngine ? RenderBackend::Vulkan : RenderBackend::Cpu;
+
+  m_dirtyTracker->setFrameSize(width, height);
+  m_initialized = true;
+  return true;
+}
+
 bool RenderView::loadShader(const std::string &name, ShaderType type,
                             const std::string &source) {
   VkShaderModule module = VK_NULL_HANDLE;
@@ -130,6 +345,45 @@ bool RenderView::loadShader(const std::string &name, ShaderType type,
     return false;
   }
 
+  storeShader(name, type, module, source);
+  return true;
+}
+
+bool RenderView::loadShaderSpirv(const std::string &name, ShaderType type,
+                                 const uint32_t *code, size_t wordCount) {
+  if (m_device == VK_NULL_HANDLE || code == nullptr || wordCount == 0) {
+    return false;
+  }
+
+  VkShaderModuleCreateInfo createInfo{};
+  createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+  createInfo.codeSize = wordCount * sizeof(uint32_t);
+  createInfo.pCode = code;
+
+  VkShaderModule module = VK_NULL_HANDLE;
+  if (vkCreateShaderModule(m_device, &createInfo, nullptr, &module) !=
+      VK_SUCCESS) {
+    std::cerr << "Failed to create shader module: " << name << std::endl;
+    return false;
+  }
+
+  storeShader(name, type, module, std::string());
+  return true;
+}
+
+bool RenderView::loadEmbeddedShader(const std::string &name, ShaderType type,
+                                    const std::string &shaderName) {
+  const EmbeddedShader *shader = findEmbeddedShader(shaderName);
+  if (shader == nullptr) {
+    std::cerr << "No embedded SPIR-V for shader: " << shaderName << std::endl;
+    return false;
+  }
+  return loadShaderSpirv(name, type, shader->code, shader->wordCount);
+}
+
+void RenderView::storeShader(const std::string &name, ShaderType type,
+                             VkShaderModule module,
+                             const std::string &source) {
   // Remove old shader if exists
   if (m_shaders.find(name) != m_shaders.end()) {
     if (m_shaders[name].module != VK_NULL_HANDLE) {
@@ -145,11 +399,20 @@ bool RenderView::loadShader(const std::string &name, ShaderType type,
   m_shaders[name] = shader;
 
   std::cout << "Shader loaded: " << name << std::endl;
-  return true;
 }
 
 bool RenderView::loadShaderFromFile(const std::string &name, ShaderType type,
                                     const std::string &filePath) {
+  // Precompiled SPIR-V (glslc output) needs no runtime compiler
+  if (filePath.size() > 4 &&
+      filePath.compare(filePath.size() - 4, 4, ".spv") == 0) {
+    std::vector<uint32_t> words;
+    if (!loadSpirvFile(filePath, words)) {
+      return false;
+    }
+    return loadShaderSpirv(name, type, words.data(), words.size());
+  }
+
   std::ifstream file(filePath);
   if (!file.is_open()) {
     std::cerr << "Failed to open shader file: " << filePath << std::endl;
@@ -190,8 +453,10 @@ bool RenderView::compileShader(const std::string &source, ShaderType type,
   // 1. GLSL to SPIR-V compiler (glslc from Vulkan SDK)
   // 2. Or runtime compilation using shaderc library
 
-  // For now, return false as we can't compile GLSL without a compiler
-  std::cerr << "Shader compilation not implemented - requires SPIR-V compiler"
+  // For now, return false as we can't compile GLSL without a compiler.
+  // Shaders in shaders/ are compiled at build time: use loadEmbeddedShader()
+  // or load the .spv through loadShaderFromFile().
+  std::cerr << "Runtime GLSL compilation not available - use precompiled SPIR-V"
             << std::endl;
   (void)module;
   return false;
@@ -256,6 +521,8 @@ bool RenderView::createPipeline(const std::string &vertexShader,
   // 8. Color blend state
   // 9. Dynamic state
   // 10. Pipeline layout
+  // Pass m_pipelineCache->getHandle() to vkCreateGraphicsPipelines so later
+  // launches reuse the driver's compiled code.
 
   std::cout << "Pipeline creation placeholder - requires SPIR-V shaders"
             << std::endl;
@@ -299,6 +566,11 @@ void RenderView::render(VkCommandBuffer commandBuffer) {
     return;
   }
 
+  // The view's render pass clears its target and it keeps no rendered image
+  // between frames, so every visible tile is drawn each frame. Re-rendering
+  // only dirty tiles into a persistent image is done by renderOffscreen().
+  m_dirtyTracker->takePendingRegions();
+
   // Use tiling renderer if enabled
   if (m_useTiling && m_tilingRenderer) {
     // Update viewport for tiling
@@ -312,9 +584,8 @@ void RenderView::render(VkCommandBuffer commandBuffer) {
     m_tilingRenderer->updateViewport(viewportX, viewportY, viewportW,
                                      viewportH);
 
-    // Render only visible tiles
-    const auto &visibleTiles = m_tilingRenderer->getVisibleTiles();
-    for (const auto &tile : visibleTiles) {
+    // Tiles outside the viewport are culled
+    for (const auto &tile : m_tilingRenderer->getVisibleTiles()) {
       // Set scissor for tile
       VkRect2D scissor;
       scissor.offset.x = tile.x;
@@ -360,7 +631,11 @@ void RenderView::endRender(VkCommandBuffer commandBuffer) {
 
 bool RenderView::addEffect(const std::string &name,
                            const std::string &shaderName) {
-  if (getShader(shaderName) == nullptr) {
+  // Headless renders can run effects the chain compiler implements even when
+  // no GPU module was compiled for them
+  bool cpuCapable =
+      m_headless && EffectChainCompiler::isKnownEffect(shaderName);
+  if (getShader(shaderName) == nullptr && !cpuCapable) {
     return false;
   }
 
@@ -371,6 +646,10 @@ bool RenderView::addEffect(const std::string &name,
   }
 
   m_activeEffects.push_back(name);
+  m_effectShaders[name] = shaderName;
+  m_chainDirty = true;
+  m_dirtyTracker->addStage(
+      name, EffectChainCompiler::footprintOf({name, shaderName, {}}));
   return true;
 }
 
@@ -378,9 +657,527 @@ void RenderView::removeEffect(const std::string &name) {
   m_activeEffects.erase(
       std::remove(m_activeEffects.begin(), m_activeEffects.end(), name),
       m_activeEffects.end());
+  m_effectShaders.erase(name);
+  m_effectParameters.erase(name);
+  m_chainDirty = true;
+  m_dirtyTracker->removeStage(name);
+}
+
+void RenderView::clearEffects() {
+  m_activeEffects.clear();
+  m_effectShaders.clear();
+  m_effectParameters.clear();
+  m_chainDirty = true;
+  m_dirtyTracker->clearStages();
+}
+
+void RenderView::setEffectParameters(const std::string &name,
+                                     const std::vector<float> &pushConstants) {
+  m_effectParameters[name] = pushConstants;
+  m_chainDirty = true;
+  auto shader = m_effectShaders.find(name);
+  if (shader != m_effectShaders.end()) {
+    // A new radius changes how far later edits to this stage spread
+    m_dirtyTracker->setStageFootprint(
+        name,
+        EffectChainCompiler::footprintOf({name, shader->second, pushConstants}));
+  }
+  m_dirtyTracker->invalidateStage(name);
+}
+
+void RenderView::invalidateEffectParameter(const std::string &effectName,
+                                           uint32_t x, uint32_t y,
+                                           uint32_t width, uint32_t height) {
+  m_dirtyTracker->invalidateParameter(effectName,
+                                      DirtyRect{x, y, width, height});
+}
+
+void RenderView::invalidateEffect(const std::string &effectName) {
+  m_dirtyTracker->invalidateStage(effectName);
+}
+
+void RenderView::invalidateAll() {
+  m_dirtyTracker->invalidateAll();
+  if (m_tilingRenderer) {
+    m_tilingRenderer->invalidateAll();
+  }
 }
 
-void RenderView::clearEffects() { m_activeEffects.clear(); }
+float RenderView::getLastRecomputedTileFraction() const {
+  if (!m_useTiling || !m_tilingRenderer || !m_headless) {
+    return 1.0f;
+  }
+  return m_tilingRenderer->getLastUpdateStats().recomputedFraction;
+}
+
+bool RenderView::renderOffscreen(const CpuImage &input, CpuImage &output) {
+  if (!m_initialized || !m_headless || !input.isValid()) {
+    return false;
+  }
+  m_lastPassTimings.clear();
+
+  const std::vector<DirtyRect> regions = takeDirtyRegions(input);
+  if (regions.empty()) {
+    output = *m_tileImage;
+    return true;
+  }
+
+  // The chain runs as compute passes on the headless device; the CPU backend
+  // covers devices without the compute shaders and failed submissions
+  if (m_vfxEngine) {
+    if (renderOffscreenGpu(input, regions, *m_tileImage)) {
+      m_backend = RenderBackend::Vulkan;
+      output = *m_tileImage;
+      return true;
+    }
+    std::cerr << "Offscreen GPU render failed, retrying on CPU" << std::endl;
+    m_lastPassTimings.clear();
+  }
+
+  m_backend = RenderBackend::Cpu;
+  if (!renderOffscreenCpu(input, regions, *m_tileImage)) {
+    // The tiles were taken as clean; start over with a full frame next time
+    *m_tileImage = CpuImage();
+    return false;
+  }
+  output = *m_tileImage;
+  return true;
+}
+
+std::vector<DirtyRect> RenderView::takeDirtyRegions(const CpuImage &input) {
+  const uint32_t width = input.width;
+  const uint32_t height = input.height;
+  m_dirtyTracker->setFrameSize(width, height);
+  std::vector<DirtyRect> pending = m_dirtyTracker->takePendingRegions();
+
+  // The kept image is only valid for the same input pixels
+  const uint64_t inputHash = hashPixels(input);
+  const bool reusable = m_tileImage->width == width &&
+                        m_tileImage->height == height &&
+                        inputHash == m_tileInputHash;
+  m_tileInputHash = inputHash;
+  if (m_tileImage->width != width || m_tileImage->height != height) {
+    m_tileImage->resize(width, height);
+  }
+
+  const DirtyRect fullFrame{0, 0, width, height};
+  if (!m_useTiling) {
+    // Tiles are re-made for the next tiled frame
+    m_tilingRenderer.reset();
+    return {fullFrame};
+  }
+
+  if (!m_tilingRenderer || !reusable) {
+    m_tilingRenderer = std::make_unique<TilingRenderer>();
+    if (!m_tilingRenderer->initialize(width, height, m_tileSize)) {
+      m_tilingRenderer.reset();
+      return {fullFrame};
+    }
+    // Offscreen frames have no viewport: every tile is visible
+    m_tilingRenderer->updateViewport(0, 0, width, height);
+  }
+
+  for (const DirtyRect &rect : pending) {
+    m_tilingRenderer->invalidateRegion(rect.x, rect.y, rect.width,
+                                       rect.height);
+  }
+  std::vector<DirtyRect> regions;
+  for (const Tile &tile : m_tilingRenderer->takeDirtyVisibleTiles()) {
+    regions.push_back(DirtyRect{tile.x, tile.y, tile.width, tile.height});
+  }
+  return regions;
+}
+
+bool RenderView::compareBackends(const CpuImage &input, ImageDiff &diff,
+                                 uint8_t tolerance) {
+  if (!m_initialized || !m_vfxEngine || !input.isValid()) {
+    return false;
+  }
+  const std::vector<DirtyRect> fullFrame{
+      DirtyRect{0, 0, input.width, input.height}};
+  CpuImage gpu;
+  CpuImage cpu;
+  gpu.resize(input.width, input.height);
+  cpu.resize(input.width, input.height);
+  m_lastPassTimings.clear();
+  if (!renderOffscreenGpu(input, fullFrame, gpu)) {
+    return false;
+  }
+  m_lastPassTimings.clear();
+  if (!renderOffscreenCpu(input, fullFrame, cpu)) {
+    return false;
+  }
+  diff = CpuEffectBackend::compare(gpu, cpu, tolerance);
+  if (diff.sizeMismatch || diff.differingPixels > 0) {
+    std::cerr << "GPU and CPU effect backends differ: " << diff.differingPixels
+              << " pixels, max delta " << diff.maxChannelDelta << ", PSNR "
+              << diff.psnr << " dB" << std::endl;
+  }
+  return true;
+}
+
+bool RenderView::renderOffscreenGpu(const CpuImage &input,
+                                    const std::vector<DirtyRect> &regions,
+                                    CpuImage &frame) {
+  const CompiledEffectChain &chain = compiledChain();
+  const uint32_t width = input.width;
+  const uint32_t height = input.height;
+  if (!createComputeTargets(width, height)) {
+    return false;
+  }
+  m_vfxEngine->waitForPipelines();
+
+  const VkDeviceSize size = static_cast<VkDeviceSize>(width) * height * 4;
+  void *mapped = nullptr;
+  if (vkMapMemory(m_device, m_stagingMemory, 0, size, 0, &mapped) !=
+      VK_SUCCESS) {
+    std::cerr << "Failed to map staging buffer" << std::endl;
+    return false;
+  }
+  std::memcpy(mapped, input.rgba.data(), static_cast<size_t>(size));
+  vkUnmapMemory(m_device, m_stagingMemory);
+
+  if (!m_offscreenRenderer->beginFrame()) {
+    return false;
+  }
+  // The frame fence has signalled, so the previous frame's descriptor sets and
+  // table buffers are free again
+  m_vfxEngine->beginFrame();
+  VkCommandBuffer commandBuffer = m_offscreenRenderer->beginCommands();
+  if (commandBuffer == VK_NULL_HANDLE) {
+    return false;
+  }
+
+  const VkBufferImageCopy upload = fullImageCopy(width, height);
+  imageBarrier(commandBuffer, m_computeImages[0], VK_IMAGE_LAYOUT_UNDEFINED,
+               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0,
+               VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+               VK_PIPELINE_STAGE_TRANSFER_BIT);
+  vkCmdCopyBufferToImage(commandBuffer, m_stagingBuffer, m_computeImages[0],
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &upload);
+  imageBarrier(commandBuffer, m_computeImages[0],
+               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL,
+               VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+               VK_PIPELINE_STAGE_TRANSFER_BIT,
+               VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+  imageBarrier(commandBuffer, m_computeImages[1], VK_IMAGE_LAYOUT_UNDEFINED,
+               VK_IMAGE_LAYOUT_GENERAL, 0, VK_ACCESS_SHADER_WRITE_BIT,
+               VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+               VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+  // A stage computes its regions grown by what the later stages read around
+  // them, so the last stage sees valid pixels everywhere it samples
+  std::vector<uint64_t> halo(chain.stages.size(), 0);
+  for (size_t i = chain.stages.size(); i > 1; i--) {
+    halo[i - 2] = halo[i - 1] + stageFootprint(chain.stages[i - 1]);
+  }
+
+  // One pass per compiled stage, ping-ponging between the two images
+  bool recorded = true;
+  size_t current = 0;
+  for (size_t i = 0; i < chain.stages.size() && recorded; i++) {
+    const CompiledStage &stage = chain.stages[i];
+    m_offscreenRenderer->beginPassTiming(commandBuffer, stage.name);
+    for (const DirtyRect &region : regions) {
+      const DirtyRect rect = dilate(region, halo[i], width, height);
+      if (stage.access == EffectAccess::PerPixel) {
+        recorded = m_vfxEngine->dispatchPixelChain(
+            commandBuffer, m_computeViews[current], m_computeViews[1 - current],
+            rect.x, rect.y, rect.width, rect.height, stage.kernel);
+      } else {
+        // blur { float radius }, defaulting as the CPU backend does
+        float radius = stage.op.params.empty() ? 1.0f : stage.op.params[0];
+        recorded = m_vfxEngine->dispatchBlur(
+            commandBuffer, m_computeViews[current], m_computeViews[1 - current],
+            rect.x, rect.y, rect.width, rect.height, radius);
+      }
+      if (!recorded) {
+        std::cerr << "No compute pipeline for stage " << stage.name
+                  << std::endl;
+        break;
+      }
+    }
+    m_offscreenRenderer->endPassTiming(commandBuffer);
+    current = 1 - current;
+  }
+
+  // Copy the regions back to where they sit in the frame
+  std::vector<VkBufferImageCopy> readback;
+  for (const DirtyRect &region : regions) {
+    VkBufferImageCopy copy = fullImageCopy(region.width, region.height);
+    copy.bufferOffset =
+        (static_cast<VkDeviceSize>(region.y) * width + region.x) * 4;
+    copy.bufferRowLength = width;
+    copy.bufferImageHeight = height;
+    copy.imageOffset = {static_cast<int32_t>(region.x),
+                        static_cast<int32_t>(region.y), 0};
+    readback.push_back(copy);
+  }
+  imageBarrier(commandBuffer, m_computeImages[current], VK_IMAGE_LAYOUT_GENERAL,
+               VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+               VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+               VK_ACCESS_TRANSFER_READ_BIT,
+               VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                   VK_PIPELINE_STAGE_TRANSFER_BIT,
+               VK_PIPELINE_STAGE_TRANSFER_BIT);
+  vkCmdCopyImageToBuffer(commandBuffer, m_computeImages[current],
+                         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_stagingBuffer,
+                         static_cast<uint32_t>(readback.size()),
+                         readback.data());
+
+  VkBufferMemoryBarrier hostBarrier{};
+  hostBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  hostBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  hostBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  hostBarrier.buffer = m_stagingBuffer;
+  hostBarrier.offset = 0;
+  hostBarrier.size = VK_WHOLE_SIZE;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1,
+                       &hostBarrier, 0, nullptr);
+
+  // Submitted even when a stage was skipped so the frame fence signals
+  m_offscreenRenderer->endCommands();
+  m_offscreenRenderer->endFrame();
+  if (!recorded) {
+    return false;
+  }
+
+  if (vkMapMemory(m_device, m_stagingMemory, 0, size, 0, &mapped) !=
+      VK_SUCCESS) {
+    std::cerr << "Failed to map staging buffer" << std::endl;
+    return false;
+  }
+  CpuImage staged;
+  staged.width = width;
+  staged.height = height;
+  staged.rgba.assign(static_cast<const uint8_t *>(mapped),
+                     static_cast<const uint8_t *>(mapped) + size);
+  vkUnmapMemory(m_device, m_stagingMemory);
+  for (const DirtyRect &region : regions) {
+    copyRect(staged, region.x, region.y, frame, region);
+  }
+
+  for (const GpuPassTiming &timing :
+       m_offscreenRenderer->getLastPassTimings()) {
+    m_lastPassTimings.push_back({timing.name, timing.milliseconds, true});
+  }
+  return true;
+}
+
+bool RenderView::createComputeTargets(uint32_t width, uint32_t height) {
+  if (m_stagingBuffer != VK_NULL_HANDLE && width == m_computeWidth &&
+      height == m_computeHeight) {
+    return true;
+  }
+  destroyComputeTargets();
+
+  for (int i = 0; i < 2; i++) {
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+    imageInfo.extent = {width, height, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT |
+                      VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+                      VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (vkCreateImage(m_device, &imageInfo, nullptr, &m_computeImages[i]) !=
+        VK_SUCCESS) {
+      std::cerr << "Failed to create compute image" << std::endl;
+      destroyComputeTargets();
+      return false;
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(m_device, m_computeImages[i], &requirements);
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = requirements.size;
+    allocInfo.memoryTypeIndex =
+        findMemoryType(m_physicalDevice, requirements.memoryTypeBits,
+                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (allocInfo.memoryTypeIndex == UINT32_MAX) {
+      // Software ICDs may not flag anything as device-local
+      allocInfo.memoryTypeIndex =
+          findMemoryType(m_physicalDevice, requirements.memoryTypeBits, 0);
+    }
+    if (allocInfo.memoryTypeIndex == UINT32_MAX ||
+        vkAllocateMemory(m_device, &allocInfo, nullptr, &m_computeMemory[i]) !=
+            VK_SUCCESS ||
+        vkBindImageMemory(m_device, m_computeImages[i], m_computeMemory[i],
+                          0) != VK_SUCCESS) {
+      std::cerr << "Failed to allocate compute image memory" << std::endl;
+      destroyComputeTargets();
+      return false;
+    }
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = m_computeImages[i];
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.baseMipLevel = 0;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount = 1;
+    if (vkCreateImageView(m_device, &viewInfo, nullptr, &m_computeViews[i]) !=
+        VK_SUCCESS) {
+      std::cerr << "Failed to create compute image view" << std::endl;
+      destroyComputeTargets();
+      return false;
+    }
+  }
+
+  VkBufferCreateInfo bufferInfo{};
+  bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  bufferInfo.size = static_cast<VkDeviceSize>(width) * height * 4;
+  bufferInfo.usage =
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  if (vkCreateBuffer(m_device, &bufferInfo, nullptr, &m_stagingBuffer) !=
+      VK_SUCCESS) {
+    std::cerr << "Failed to create staging buffer" << std::endl;
+    destroyComputeTargets();
+    return false;
+  }
+  VkMemoryRequirements requirements;
+  vkGetBufferMemoryRequirements(m_device, m_stagingBuffer, &requirements);
+  VkMemoryAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  allocInfo.allocationSize = requirements.size;
+  allocInfo.memoryTypeIndex = findMemoryType(
+      m_physicalDevice, requirements.memoryTypeBits,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+  if (allocInfo.memoryTypeIndex == UINT32_MAX ||
+      vkAllocateMemory(m_device, &allocInfo, nullptr, &m_stagingMemory) !=
+          VK_SUCCESS ||
+      vkBindBufferMemory(m_device, m_stagingBuffer, m_stagingMemory, 0) !=
+          VK_SUCCESS) {
+    std::cerr << "No host-visible memory for the staging buffer" << std::endl;
+    destroyComputeTargets();
+    return false;
+  }
+
+  m_computeWidth = width;
+  m_computeHeight = height;
+  return true;
+}
+
+void RenderView::destroyComputeTargets() {
+  if (m_device == VK_NULL_HANDLE) {
+    return;
+  }
+  for (int i = 0; i < 2; i++) {
+    if (m_computeViews[i] != VK_NULL_HANDLE) {
+      vkDestroyImageView(m_device, m_computeViews[i], nullptr);
+      m_computeViews[i] = VK_NULL_HANDLE;
+    }
+    if (m_computeImages[i] != VK_NULL_HANDLE) {
+      vkDestroyImage(m_device, m_computeImages[i], nullptr);
+      m_computeImages[i] = VK_NULL_HANDLE;
+    }
+    if (m_computeMemory[i] != VK_NULL_HANDLE) {
+      vkFreeMemory(m_device, m_computeMemory[i], nullptr);
+      m_computeMemory[i] = VK_NULL_HANDLE;
+    }
+  }
+  if (m_stagingBuffer != VK_NULL_HANDLE) {
+    vkDestroyBuffer(m_device, m_stagingBuffer, nullptr);
+    m_stagingBuffer = VK_NULL_HANDLE;
+  }
+  if (m_stagingMemory != VK_NULL_HANDLE) {
+    vkFreeMemory(m_device, m_stagingMemory, nullptr);
+    m_stagingMemory = VK_NULL_HANDLE;
+  }
+  m_computeWidth = 0;
+  m_computeHeight = 0;
+}
+
+bool RenderView::renderOffscreenCpu(const CpuImage &input,
+                                    const std::vector<DirtyRect> &regions,
+                                    CpuImage &frame) {
+  const CompiledEffectChain &chain = compiledChain();
+
+  // Each region is rendered from a crop grown by the chain's total footprint;
+  // clamping at the crop's edges then cannot reach the pixels kept
+  uint64_t halo = 0;
+  for (const CompiledStage &stage : chain.stages) {
+    halo += stageFootprint(stage);
+  }
+
+  std::vector<double> stageMilliseconds(chain.stages.size(), 0.0);
+  CpuImage crop;
+  CpuImage result;
+  for (const DirtyRect &region : regions) {
+    const DirtyRect source = dilate(region, halo, input.width, input.height);
+    crop.resize(source.width, source.height);
+    copyRect(input, source.x, source.y, crop,
+             DirtyRect{0, 0, source.width, source.height});
+
+    std::vector<double> regionMilliseconds;
+    if (!EffectChainCompiler::execute(chain, crop, result,
+                                      &regionMilliseconds)) {
+      return false;
+    }
+    for (size_t i = 0; i < regionMilliseconds.size(); i++) {
+      stageMilliseconds[i] += regionMilliseconds[i];
+    }
+    copyRect(result, region.x - source.x, region.y - source.y, frame, region);
+  }
+
+  for (size_t i = 0; i < stageMilliseconds.size(); i++) {
+    m_lastPassTimings.push_back(
+        {chain.stages[i].name, stageMilliseconds[i], false});
+  }
+  return true;
+}
+
+const CompiledEffectChain &RenderView::compiledChain() {
+  if (m_chainDirty) {
+    std::vector<EffectOp> ops;
+    ops.reserve(m_activeEffects.size());
+    for (const std::string &effect : m_activeEffects) {
+      auto params = m_effectParameters.find(effect);
+      ops.push_back({effect, m_effectShaders[effect],
+                     params != m_effectParameters.end()
+                         ? params->second
+                         : std::vector<float>()});
+    }
+    *m_compiledChain = EffectChainCompiler::compile(ops);
+    m_chainDirty = false;
+  }
+  return *m_compiledChain;
+}
+
+size_t RenderView::getCompiledPassCount() {
+  return compiledChain().stages.size();
+}
+
+float RenderView::getChainBandwidthRatio() {
+  return compiledChain().bandwidthRatio();
+}
+
+bool RenderView::initializePipelineCache() {
+  if (m_pipelineCache) {
+    return true;
+  }
+  auto cache = std::make_unique<PipelineCache>();
+  if (!cache->initialize(m_physicalDevice, m_device)) {
+    return false;
+  }
+  m_pipelineCache = std::move(cache);
+  return true;
+}
 
 bool RenderView::createUniformBuffers() {
   // Uniform buffer creation would go here
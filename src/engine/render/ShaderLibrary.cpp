@@ -0,0 +1,86 @@
+#include "aether/ShaderLibrary.h"
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace aether {
+
+namespace {
+
+constexpr uint32_t kSpirvMagic = 0x07230203;
+
+#ifdef AETHER_EMBEDDED_SHADERS
+// Word lists generated from shaders/*.comp (see aether_shaders in CMakeLists.txt)
+constexpr uint32_t kBlurSpirv[] = {
+#include "shaders/blur.comp.inc"
+};
+
+constexpr uint32_t kColorCorrectionSpirv[] = {
+#include "shaders/color_correction.comp.inc"
+};
+
+constexpr uint32_t kPixelChainSpirv[] = {
+#include "shaders/pixel_chain.comp.inc"
+};
+
+constexpr EmbeddedShader kEmbeddedShaders[] = {
+    {"blur", kBlurSpirv, std::size(kBlurSpirv)},
+    {"color_correction", kColorCorrectionSpirv, std::size(kColorCorrectionSpirv)},
+    {"pixel_chain", kPixelChainSpirv, std::size(kPixelChainSpirv)},
+};
+
+static_assert(kBlurSpirv[0] == kSpirvMagic, "blur.comp.inc is not SPIR-V");
+static_assert(kColorCorrectionSpirv[0] == kSpirvMagic, "color_correction.comp.inc is not SPIR-V");
+static_assert(kPixelChainSpirv[0] == kSpirvMagic, "pixel_chain.comp.inc is not SPIR-V");
+#endif
+
+} // namespace
+
+const EmbeddedShader* findEmbeddedShader(const std::string& name) {
+#ifdef AETHER_EMBEDDED_SHADERS
+    for (const EmbeddedShader& shader : kEmbeddedShaders) {
+        if (name == shader.name) {
+            return &shader;
+        }
+    }
+#else
+    (void)name;
+#endif
+    return nullptr;
+}
+
+std::vector<std::string> listEmbeddedShaders() {
+    std::vector<std::string> names;
+#ifdef AETHER_EMBEDDED_SHADERS
+    for (const EmbeddedShader& shader : kEmbeddedShaders) {
+        names.emplace_back(shader.name);
+    }
+#endif
+    return names;
+}
+
+bool loadSpirvFile(const std::string& filePath, std::vector<uint32_t>& words) {
+    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open SPIR-V file: " << filePath << std::endl;
+        return false;
+    }
+
+    std::streamsize size = file.tellg();
+    if (size <= 0 || size % sizeof(uint32_t) != 0) {
+        std::cerr << "Invalid SPIR-V size in " << filePath << std::endl;
+        return false;
+    }
+
+    words.resize(static_cast<size_t>(size) / sizeof(uint32_t));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(words.data()), size);
+    if (!file || words[0] != kSpirvMagic) {
+        std::cerr << "Not a SPIR-V module: " << filePath << std::endl;
+        words.clear();
+        return false;
+    }
+    return true;
+}
+
+} // namespace aether
@@ -29,6 +29,9 @@ bool TilingRenderer::initialize(uint32_t imageWidth, uint32_t imageHeight, uint3
 void TilingRenderer::shutdown() {
     m_allTiles.clear();
     m_visibleTiles.clear();
+    m_tilesX = 0;
+    m_tilesY = 0;
+    m_lastUpdateStats = TileUpdateStats{};
     m_initialized = false;
 }
 
@@ -37,6 +40,8 @@ void TilingRenderer::generateTiles() {
     
     uint32_t tilesX = static_cast<uint32_t>(std::ceil(static_cast<float>(m_imageWidth) / m_tileSize));
     uint32_t tilesY = static_cast<uint32_t>(std::ceil(static_cast<float>(m_imageHeight) / m_tileSize));
+    m_tilesX = tilesX;
+    m_tilesY = tilesY;
     
     for (uint32_t y = 0; y < tilesY; y++) {
         for (uint32_t x = 0; x < tilesX; x++) {
@@ -46,6 +51,7 @@ void TilingRenderer::generateTiles() {
             tile.width = std::min(m_tileSize, m_imageWidth - tile.x);
             tile.height = std::min(m_tileSize, m_imageHeight - tile.y);
             tile.isVisible = false;
+            tile.isDirty = true;
             
             m_allTiles.push_back(tile);
         }
@@ -121,4 +127,60 @@ std::vector<Tile> TilingRenderer::getTilesInRegion(uint32_t x, uint32_t y, uint3
     return tiles;
 }
 
+void TilingRenderer::invalidateRegion(uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+    if (m_allTiles.empty() || width == 0 || height == 0 || x >= m_imageWidth || y >= m_imageHeight) {
+        return;
+    }
+
+    // Tile grid is regular, so the covered range is computed directly instead of testing every tile
+    // Compared against the space left so that x + width cannot wrap
+    uint32_t right = width > m_imageWidth - x ? m_imageWidth : x + width;
+    uint32_t bottom = height > m_imageHeight - y ? m_imageHeight : y + height;
+    uint32_t firstColumn = x / m_tileSize;
+    uint32_t firstRow = y / m_tileSize;
+    uint32_t lastColumn = std::min(m_tilesX - 1, (right - 1) / m_tileSize);
+    uint32_t lastRow = std::min(m_tilesY - 1, (bottom - 1) / m_tileSize);
+
+    for (uint32_t row = firstRow; row <= lastRow; row++) {
+        for (uint32_t column = firstColumn; column <= lastColumn; column++) {
+            m_allTiles[tileIndex(column, row)].isDirty = true;
+        }
+    }
+}
+
+void TilingRenderer::invalidateAll() {
+    for (auto& tile : m_allTiles) {
+        tile.isDirty = true;
+    }
+}
+
+std::vector<Tile> TilingRenderer::takeDirtyVisibleTiles() {
+    std::vector<Tile> dirtyTiles;
+
+    for (auto& tile : m_allTiles) {
+        if (tile.isVisible && tile.isDirty) {
+            dirtyTiles.push_back(tile);
+            tile.isDirty = false;
+        }
+    }
+
+    m_lastUpdateStats.recomputedTiles = static_cast<uint32_t>(dirtyTiles.size());
+    m_lastUpdateStats.totalTiles = static_cast<uint32_t>(m_allTiles.size());
+    m_lastUpdateStats.recomputedFraction = m_allTiles.empty()
+        ? 0.0f
+        : static_cast<float>(dirtyTiles.size()) / static_cast<float>(m_allTiles.size());
+
+    return dirtyTiles;
+}
+
+uint32_t TilingRenderer::getDirtyTileCount() const {
+    uint32_t count = 0;
+    for (const auto& tile : m_allTiles) {
+        if (tile.isDirty) {
+            count++;
+        }
+    }
+    return count;
+}
+
 } // namespace aether
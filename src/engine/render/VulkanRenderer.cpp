@@ -6,6 +6,7 @@
 #include <stdexcept>
 #include <set>
 #include <algorithm>
+#include <cstring>
 
 #define VK_CHECK(x) \
     do { \
@@ -85,6 +86,8 @@ bool VulkanRenderer::initialize(Window* window) {
         return false;
     }
 
+    createTimestampQueries();
+
     return true;
 }
 
@@ -93,6 +96,11 @@ void VulkanRenderer::shutdown() {
         vkDeviceWaitIdle(m_device);
     }
 
+    for (auto pool : m_timestampPools) {
+        vkDestroyQueryPool(m_device, pool, nullptr);
+    }
+    m_timestampPools.clear();
+
     for (auto fence : m_inFlightFences) {
         vkDestroyFence(m_device, fence, nullptr);
     }
@@ -124,6 +132,12 @@ void VulkanRenderer::shutdown() {
         vkDestroyInstance(m_instance, nullptr);
         m_instance = VK_NULL_HANDLE;
     }
+
+    m_inFlightFences.clear();
+    m_renderFinishedSemaphores.clear();
+    m_imageAvailableSemaphores.clear();
+    m_swapchainImages.clear();
+    m_headless = false;
 }
 
 bool VulkanRenderer::createInstance() {
@@ -344,6 +358,11 @@ bool VulkanRenderer::createLogicalDevice() {
 
     vkGetDeviceQueue(m_device, graphicsQueueFamily, 0, &m_graphicsQueue);
     vkGetDeviceQueue(m_device, presentQueueFamily, 0, &m_presentQueue);
+    m_graphicsQueueFamily = graphicsQueueFamily;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_physicalDevice, &properties);
+    m_deviceType = properties.deviceType;
 
     return true;
 }
@@ -463,6 +482,10 @@ void VulkanRenderer::destroySwapchain() {
         m_swapchain = VK_NULL_HANDLE;
     }
 
+    if (m_headless) {
+        destroyOffscreenTarget();
+    }
+
     if (m_renderPass != VK_NULL_HANDLE) {
         vkDestroyRenderPass(m_device, m_renderPass, nullptr);
         m_renderPass = VK_NULL_HANDLE;
@@ -506,7 +529,8 @@ bool VulkanRenderer::createRenderPass() {
     colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    // Headless frames are copied to the readback buffer right after the pass
+    colorAttachment.finalLayout = m_headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
     VkAttachmentReference colorAttachmentRef{};
     colorAttachmentRef.attachment = 0;
@@ -525,14 +549,24 @@ bool VulkanRenderer::createRenderPass() {
     dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
     dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
 
+    VkSubpassDependency readbackDependency{};
+    readbackDependency.srcSubpass = 0;
+    readbackDependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+    readbackDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    readbackDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    readbackDependency.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    readbackDependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    VkSubpassDependency dependencies[] = {dependency, readbackDependency};
+
     VkRenderPassCreateInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
     renderPassInfo.attachmentCount = 1;
     renderPassInfo.pAttachments = &colorAttachment;
     renderPassInfo.subpassCount = 1;
     renderPassInfo.pSubpasses = &subpass;
-    renderPassInfo.dependencyCount = 1;
-    renderPassInfo.pDependencies = &dependency;
+    renderPassInfo.dependencyCount = m_headless ? 2 : 1;
+    renderPassInfo.pDependencies = dependencies;
 
     if (vkCreateRenderPass(m_device, &renderPassInfo, nullptr, &m_renderPass) != VK_SUCCESS) {
         std::cerr << "Failed to create render pass" << std::endl;
@@ -570,7 +604,7 @@ bool VulkanRenderer::createCommandPool() {
     VkCommandPoolCreateInfo poolInfo{};
     poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
     poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-    poolInfo.queueFamilyIndex = 0; // Simplified
+    poolInfo.queueFamilyIndex = m_graphicsQueueFamily;
 
     if (vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_commandPool) != VK_SUCCESS) {
         std::cerr << "Failed to create command pool" << std::endl;
@@ -621,9 +655,7 @@ bool VulkanRenderer::createSyncObjects() {
     return true;
 }
 
-void VulkanRenderer::beginRenderPass() {
-    VkCommandBuffer commandBuffer = m_commandBuffers[m_currentImageIndex];
-    
+bool VulkanRenderer::beginCommandBuffer(VkCommandBuffer commandBuffer) {
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     beginInfo.flags = 0;
@@ -631,6 +663,21 @@ void VulkanRenderer::beginRenderPass() {
 
     if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
         std::cerr << "Failed to begin recording command buffer" << std::endl;
+        return false;
+    }
+
+    if (m_currentFrame < m_timestampPools.size()) {
+        vkCmdResetQueryPool(commandBuffer, m_timestampPools[m_currentFrame], 0, kMaxTimedPasses * 2);
+        m_timedPassNames[m_currentFrame].clear();
+        m_passTimingOpen = false;
+    }
+    return true;
+}
+
+void VulkanRenderer::beginRenderPass() {
+    VkCommandBuffer commandBuffer = m_commandBuffers[m_currentImageIndex];
+    
+    if (!beginCommandBuffer(commandBuffer)) {
         return;
     }
 
@@ -653,16 +700,62 @@ void VulkanRenderer::endRenderPass() {
     
     vkCmdEndRenderPass(commandBuffer);
 
+    if (m_headless) {
+        VkBufferImageCopy region{};
+        region.bufferOffset = 0;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {m_swapchainExtent.width, m_swapchainExtent.height, 1};
+        vkCmdCopyImageToBuffer(commandBuffer, m_swapchainImages[0], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            m_readbackBuffer, 1, &region);
+
+        VkBufferMemoryBarrier hostBarrier{};
+        hostBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        hostBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        hostBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        hostBarrier.buffer = m_readbackBuffer;
+        hostBarrier.offset = 0;
+        hostBarrier.size = VK_WHOLE_SIZE;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+            0, 0, nullptr, 1, &hostBarrier, 0, nullptr);
+    }
+
     if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
         std::cerr << "Failed to record command buffer" << std::endl;
     }
 }
 
+VkCommandBuffer VulkanRenderer::beginCommands() {
+    VkCommandBuffer commandBuffer = m_commandBuffers[m_currentImageIndex];
+    return beginCommandBuffer(commandBuffer) ? commandBuffer : VK_NULL_HANDLE;
+}
+
+void VulkanRenderer::endCommands() {
+    if (vkEndCommandBuffer(m_commandBuffers[m_currentImageIndex]) != VK_SUCCESS) {
+        std::cerr << "Failed to record command buffer" << std::endl;
+    }
+}
+
 bool VulkanRenderer::beginFrame() {
     if (m_swapchainImages.empty() || m_currentFrame >= m_inFlightFences.size()) {
         return false;
     }
     vkWaitForFences(m_device, 1, &m_inFlightFences[m_currentFrame], VK_TRUE, UINT64_MAX);
+    collectPassTimings(m_currentFrame);
+
+    if (m_headless) {
+        m_currentImageIndex = 0;
+        vkResetFences(m_device, 1, &m_inFlightFences[m_currentFrame]);
+        vkResetCommandBuffer(m_commandBuffers[m_currentImageIndex], 0);
+        return true;
+    }
 
     uint32_t imageIndex = 0;
     VkResult result = vkAcquireNextImageKHR(m_device, m_swapchain, UINT64_MAX,
@@ -690,6 +783,22 @@ bool VulkanRenderer::beginFrame() {
 }
 
 void VulkanRenderer::endFrame() {
+    if (m_headless) {
+        // No presentation: submit and wait so the readback buffer is valid on return
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &m_commandBuffers[m_currentImageIndex];
+        if (vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, m_inFlightFences[m_currentFrame]) != VK_SUCCESS) {
+            std::cerr << "Failed to submit offscreen command buffer" << std::endl;
+            return;
+        }
+        vkWaitForFences(m_device, 1, &m_inFlightFences[m_currentFrame], VK_TRUE, UINT64_MAX);
+        collectPassTimings(m_currentFrame);
+        m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+        return;
+    }
+
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
@@ -723,4 +832,358 @@ void VulkanRenderer::endFrame() {
     m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 }
 
+bool VulkanRenderer::initializeHeadless(uint32_t width, uint32_t height) {
+    if (width == 0 || height == 0) {
+        std::cerr << "Invalid offscreen dimensions" << std::endl;
+        return false;
+    }
+    m_headless = true;
+    m_window = nullptr;
+
+    if (!createHeadlessInstance()) {
+        shutdown();
+        return false;
+    }
+
+    if (!selectHeadlessPhysicalDevice()) {
+        shutdown();
+        return false;
+    }
+
+    if (!createHeadlessDevice()) {
+        shutdown();
+        return false;
+    }
+
+    if (!createOffscreenTarget(width, height) ||
+        !createRenderPass() ||
+        !createFramebuffers() ||
+        !createCommandPool() ||
+        !createCommandBuffers() ||
+        !createSyncObjects()) {
+        shutdown();
+        return false;
+    }
+
+    createTimestampQueries();
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_physicalDevice, &properties);
+    std::cout << "Headless Vulkan renderer initialized on " << properties.deviceName
+              << (isSoftwareDevice() ? " (software)" : "") << ": " << width << "x" << height
+              << (supportsTimestamps() ? ", timestamps enabled" : "") << std::endl;
+    return true;
+}
+
+bool VulkanRenderer::createHeadlessInstance() {
+    VkApplicationInfo appInfo{};
+    appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    appInfo.pApplicationName = "Aether Studio (headless)";
+    appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+    appInfo.pEngineName = "Aether";
+    appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+    // lavapipe and older drivers may not expose 1.3; nothing here needs more than 1.1
+    appInfo.apiVersion = VK_API_VERSION_1_1;
+
+    VkInstanceCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    createInfo.pApplicationInfo = &appInfo;
+    createInfo.enabledExtensionCount = 0;
+    createInfo.ppEnabledExtensionNames = nullptr;
+    createInfo.enabledLayerCount = 0;
+
+    if (vkCreateInstance(&createInfo, nullptr, &m_instance) != VK_SUCCESS) {
+        std::cerr << "Failed to create headless Vulkan instance" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool VulkanRenderer::selectHeadlessPhysicalDevice() {
+    uint32_t deviceCount = 0;
+    vkEnumeratePhysicalDevices(m_instance, &deviceCount, nullptr);
+    if (deviceCount == 0) {
+        std::cerr << "No Vulkan-capable devices found" << std::endl;
+        return false;
+    }
+
+    std::vector<VkPhysicalDevice> devices(deviceCount);
+    vkEnumeratePhysicalDevices(m_instance, &deviceCount, devices.data());
+
+    // Any device with a graphics queue will do; prefer real GPUs over software rasterizers
+    auto rank = [](VkPhysicalDeviceType type) {
+        switch (type) {
+            case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: return 4;
+            case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return 3;
+            case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: return 2;
+            case VK_PHYSICAL_DEVICE_TYPE_CPU: return 1;
+            default: return 0;
+        }
+    };
+
+    int bestRank = -1;
+    for (const auto& device : devices) {
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
+
+        uint32_t graphicsFamily = UINT32_MAX;
+        for (uint32_t i = 0; i < queueFamilies.size(); i++) {
+            if (queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+                graphicsFamily = i;
+                break;
+            }
+        }
+        if (graphicsFamily == UINT32_MAX) {
+            continue;
+        }
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(device, &properties);
+        if (rank(properties.deviceType) > bestRank) {
+            bestRank = rank(properties.deviceType);
+            m_physicalDevice = device;
+            m_graphicsQueueFamily = graphicsFamily;
+            m_deviceType = properties.deviceType;
+        }
+    }
+
+    if (m_physicalDevice == VK_NULL_HANDLE) {
+        std::cerr << "No Vulkan device with a graphics queue found" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool VulkanRenderer::createHeadlessDevice() {
+    float queuePriority = 1.0f;
+    VkDeviceQueueCreateInfo queueCreateInfo{};
+    queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueCreateInfo.queueFamilyIndex = m_graphicsQueueFamily;
+    queueCreateInfo.queueCount = 1;
+    queueCreateInfo.pQueuePriorities = &queuePriority;
+
+    VkPhysicalDeviceFeatures deviceFeatures{};
+
+    VkDeviceCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    createInfo.queueCreateInfoCount = 1;
+    createInfo.pQueueCreateInfos = &queueCreateInfo;
+    createInfo.pEnabledFeatures = &deviceFeatures;
+    createInfo.enabledExtensionCount = 0;
+
+    if (vkCreateDevice(m_physicalDevice, &createInfo, nullptr, &m_device) != VK_SUCCESS) {
+        std::cerr << "Failed to create headless logical device" << std::endl;
+        return false;
+    }
+
+    vkGetDeviceQueue(m_device, m_graphicsQueueFamily, 0, &m_graphicsQueue);
+    m_presentQueue = m_graphicsQueue;
+    return true;
+}
+
+uint32_t VulkanRenderer::findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const {
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &memoryProperties);
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+        if ((typeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return i;
+        }
+    }
+    return UINT32_MAX;
+}
+
+bool VulkanRenderer::createOffscreenTarget(uint32_t width, uint32_t height) {
+    m_swapchainImageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+    m_swapchainExtent = {width, height};
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = m_swapchainImageFormat;
+    imageInfo.extent = {width, height, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkImage image = VK_NULL_HANDLE;
+    VK_CHECK(vkCreateImage(m_device, &imageInfo, nullptr, &image));
+    // Keep the offscreen image in the swapchain slots so framebuffer/command buffer code is shared
+    m_swapchainImages.assign(1, image);
+
+    VkMemoryRequirements imageRequirements;
+    vkGetImageMemoryRequirements(m_device, image, &imageRequirements);
+    VkMemoryAllocateInfo imageAlloc{};
+    imageAlloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    imageAlloc.allocationSize = imageRequirements.size;
+    imageAlloc.memoryTypeIndex = findMemoryType(imageRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (imageAlloc.memoryTypeIndex == UINT32_MAX) {
+        // Software ICDs may not flag anything as device-local
+        imageAlloc.memoryTypeIndex = findMemoryType(imageRequirements.memoryTypeBits, 0);
+    }
+    VK_CHECK(vkAllocateMemory(m_device, &imageAlloc, nullptr, &m_offscreenMemory));
+    VK_CHECK(vkBindImageMemory(m_device, image, m_offscreenMemory, 0));
+
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = static_cast<VkDeviceSize>(width) * height * 4;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VK_CHECK(vkCreateBuffer(m_device, &bufferInfo, nullptr, &m_readbackBuffer));
+
+    VkMemoryRequirements bufferRequirements;
+    vkGetBufferMemoryRequirements(m_device, m_readbackBuffer, &bufferRequirements);
+    VkMemoryAllocateInfo bufferAlloc{};
+    bufferAlloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    bufferAlloc.allocationSize = bufferRequirements.size;
+    bufferAlloc.memoryTypeIndex = findMemoryType(bufferRequirements.memoryTypeBits,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    if (bufferAlloc.memoryTypeIndex == UINT32_MAX) {
+        std::cerr << "No host-visible memory for offscreen readback" << std::endl;
+        return false;
+    }
+    VK_CHECK(vkAllocateMemory(m_device, &bufferAlloc, nullptr, &m_readbackMemory));
+    VK_CHECK(vkBindBufferMemory(m_device, m_readbackBuffer, m_readbackMemory, 0));
+
+    return createImageViews();
+}
+
+void VulkanRenderer::destroyOffscreenTarget() {
+    for (auto image : m_swapchainImages) {
+        vkDestroyImage(m_device, image, nullptr);
+    }
+    m_swapchainImages.clear();
+
+    if (m_offscreenMemory != VK_NULL_HANDLE) {
+        vkFreeMemory(m_device, m_offscreenMemory, nullptr);
+        m_offscreenMemory = VK_NULL_HANDLE;
+    }
+    if (m_readbackBuffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(m_device, m_readbackBuffer, nullptr);
+        m_readbackBuffer = VK_NULL_HANDLE;
+    }
+    if (m_readbackMemory != VK_NULL_HANDLE) {
+        vkFreeMemory(m_device, m_readbackMemory, nullptr);
+        m_readbackMemory = VK_NULL_HANDLE;
+    }
+}
+
+bool VulkanRenderer::readbackFrame(std::vector<uint8_t>& rgba) const {
+    if (!m_headless || m_readbackMemory == VK_NULL_HANDLE) {
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(m_swapchainExtent.width) * m_swapchainExtent.height * 4;
+    void* mapped = nullptr;
+    if (vkMapMemory(m_device, m_readbackMemory, 0, size, 0, &mapped) != VK_SUCCESS) {
+        std::cerr << "Failed to map readback buffer" << std::endl;
+        return false;
+    }
+    rgba.resize(size);
+    std::memcpy(rgba.data(), mapped, size);
+    vkUnmapMemory(m_device, m_readbackMemory);
+    return true;
+}
+
+bool VulkanRenderer::createTimestampQueries() {
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_physicalDevice, &properties);
+
+    uint32_t validBits = m_graphicsQueueFamily < queueFamilies.size()
+        ? queueFamilies[m_graphicsQueueFamily].timestampValidBits : 0;
+    if (validBits == 0 || properties.limits.timestampPeriod <= 0.0f) {
+        m_timestampPeriodNs = 0.0f;
+        return false;
+    }
+    m_timestampMask = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+
+    VkQueryPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = kMaxTimedPasses * 2;
+
+    m_timestampPools.resize(MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE);
+    for (auto& pool : m_timestampPools) {
+        if (vkCreateQueryPool(m_device, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+            std::cerr << "Failed to create timestamp query pool; pass timings disabled" << std::endl;
+            for (auto created : m_timestampPools) {
+                if (created != VK_NULL_HANDLE) vkDestroyQueryPool(m_device, created, nullptr);
+            }
+            m_timestampPools.clear();
+            return false;
+        }
+    }
+    m_timedPassNames.assign(MAX_FRAMES_IN_FLIGHT, {});
+    m_timingsPending.assign(MAX_FRAMES_IN_FLIGHT, false);
+    m_timestampPeriodNs = properties.limits.timestampPeriod;
+    return true;
+}
+
+void VulkanRenderer::beginPassTiming(VkCommandBuffer commandBuffer, const std::string& name) {
+    if (m_currentFrame >= m_timestampPools.size()) {
+        return;
+    }
+    auto& names = m_timedPassNames[m_currentFrame];
+    if (m_passTimingOpen || names.size() >= kMaxTimedPasses) {
+        return;
+    }
+    uint32_t query = static_cast<uint32_t>(names.size()) * 2;
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_timestampPools[m_currentFrame], query);
+    names.push_back(name);
+    m_passTimingOpen = true;
+}
+
+void VulkanRenderer::endPassTiming(VkCommandBuffer commandBuffer) {
+    if (!m_passTimingOpen || m_currentFrame >= m_timestampPools.size()) {
+        return;
+    }
+    uint32_t query = static_cast<uint32_t>(m_timedPassNames[m_currentFrame].size()) * 2 - 1;
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_timestampPools[m_currentFrame], query);
+    m_passTimingOpen = false;
+    m_timingsPending[m_currentFrame] = true;
+}
+
+void VulkanRenderer::collectPassTimings(size_t frameSlot) {
+    if (frameSlot >= m_timestampPools.size() || !m_timingsPending[frameSlot]) {
+        return;
+    }
+    m_timingsPending[frameSlot] = false;
+
+    const auto& names = m_timedPassNames[frameSlot];
+    // An unterminated last pass has no end timestamp
+    size_t completed = names.size();
+    if (completed > 0 && m_passTimingOpen && frameSlot == m_currentFrame) {
+        completed--;
+    }
+    if (completed == 0) {
+        return;
+    }
+
+    std::vector<uint64_t> timestamps(completed * 2);
+    VkResult result = vkGetQueryPoolResults(m_device, m_timestampPools[frameSlot], 0,
+        static_cast<uint32_t>(timestamps.size()), timestamps.size() * sizeof(uint64_t), timestamps.data(),
+        sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS) {
+        return;
+    }
+
+    m_lastPassTimings.clear();
+    for (size_t i = 0; i < completed; i++) {
+        uint64_t begin = timestamps[i * 2] & m_timestampMask;
+        uint64_t end = timestamps[i * 2 + 1] & m_timestampMask;
+        uint64_t ticks = (end - begin) & m_timestampMask;
+        m_lastPassTimings.push_back({names[i], static_cast<double>(ticks) * m_timestampPeriodNs / 1.0e6});
+    }
+}
+
 } // namespace aether
@@ -3,6 +3,7 @@
 #include <vulkan/vulkan.h>
 #include <vector>
 #include <memory>
+#include <string>
 
 namespace aether {
 class Window;
@@ -10,6 +11,11 @@ class Window;
 
 namespace aether {
 
+struct GpuPassTiming {
+    std::string name;
+    double milliseconds = 0.0;
+};
+
 class VulkanRenderer {
 public:
     VulkanRenderer();
@@ -19,11 +25,28 @@ public:
     VulkanRenderer& operator=(const VulkanRenderer&) = delete;
 
     bool initialize(Window* window);
+    // Offscreen mode: no surface or swapchain; renders into a single image that is
+    // copied to a host-visible buffer each frame. Works with software ICDs (lavapipe).
+    bool initializeHeadless(uint32_t width, uint32_t height);
     void shutdown();
 
+    bool isHeadless() const { return m_headless; }
+    bool isSoftwareDevice() const { return m_deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU; }
+    /** Copies the last headless frame (RGBA8, tightly packed). Call after endFrame(). */
+    bool readbackFrame(std::vector<uint8_t>& rgba) const;
+
+    // Per-pass GPU timing via timestamp queries; no-ops when the queue has no timestamp support
+    bool supportsTimestamps() const { return m_timestampPeriodNs > 0.0f; }
+    void beginPassTiming(VkCommandBuffer commandBuffer, const std::string& name);
+    void endPassTiming(VkCommandBuffer commandBuffer);
+    const std::vector<GpuPassTiming>& getLastPassTimings() const { return m_lastPassTimings; }
+
     bool beginFrame();
     void beginRenderPass();
     void endRenderPass();
+    /** Between beginFrame() and endFrame(): records compute/transfer work instead of a render pass. */
+    VkCommandBuffer beginCommands();
+    void endCommands();
     void endFrame();
 
     VkInstance getInstance() const { return m_instance; }
@@ -55,6 +78,15 @@ private:
     bool createCommandPool();
     bool createCommandBuffers();
     bool createSyncObjects();
+    bool createHeadlessInstance();
+    bool selectHeadlessPhysicalDevice();
+    bool createHeadlessDevice();
+    bool createOffscreenTarget(uint32_t width, uint32_t height);
+    void destroyOffscreenTarget();
+    bool beginCommandBuffer(VkCommandBuffer commandBuffer);
+    bool createTimestampQueries();
+    void collectPassTimings(size_t frameSlot);
+    uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const;
 
     VkInstance m_instance = VK_NULL_HANDLE;
     VkSurfaceKHR m_surface = VK_NULL_HANDLE;
@@ -82,6 +114,24 @@ private:
 
     bool m_framebufferResized = false;
     Window* m_window = nullptr;
+    uint32_t m_graphicsQueueFamily = 0;
+    VkPhysicalDeviceType m_deviceType = VK_PHYSICAL_DEVICE_TYPE_OTHER;
+
+    // Headless target
+    bool m_headless = false;
+    VkDeviceMemory m_offscreenMemory = VK_NULL_HANDLE;
+    VkBuffer m_readbackBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory m_readbackMemory = VK_NULL_HANDLE;
+
+    // Timestamp queries (one pool per frame in flight, two queries per pass)
+    static constexpr uint32_t kMaxTimedPasses = 32;
+    std::vector<VkQueryPool> m_timestampPools;
+    std::vector<std::vector<std::string>> m_timedPassNames;
+    std::vector<bool> m_timingsPending;
+    std::vector<GpuPassTiming> m_lastPassTimings;
+    float m_timestampPeriodNs = 0.0f;
+    uint64_t m_timestampMask = ~0ull;
+    bool m_passTimingOpen = false;
 };
 
 } // namespace aether
@@ -0,0 +1,164 @@
+#include "aether/CpuEffectBackend.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace aether {
+
+namespace {
+
+uint8_t toUnorm8(float v) {
+    v = std::clamp(v, 0.0f, 1.0f);
+    return static_cast<uint8_t>(v * 255.0f + 0.5f);
+}
+
+} // namespace
+
+bool CpuEffectBackend::supportsEffect(const std::string& shaderName) const {
+    return shaderName == "blur" || shaderName == "color_correction";
+}
+
+bool CpuEffectBackend::apply(const std::string& shaderName, const std::vector<float>& pushConstants,
+                             const CpuImage& input, CpuImage& output) const {
+    if (!input.isValid()) {
+        return false;
+    }
+
+    if (shaderName == "blur") {
+        float radius = pushConstants.empty() ? 1.0f : pushConstants[0];
+        boxBlur(input, output, radius);
+        return true;
+    }
+
+    if (shaderName == "color_correction") {
+        float lift[4];
+        float gamma[4];
+        float gain[4];
+        unpackColorCorrection(pushConstants, lift, gamma, gain);
+        colorCorrection(input, output, lift, gamma, gain);
+        return true;
+    }
+
+    return false;
+}
+
+void CpuEffectBackend::boxBlur(const CpuImage& input, CpuImage& output, float radius) {
+    const uint32_t width = input.width;
+    const uint32_t height = input.height;
+    // Same kernel as blur.comp: (2r+1)^2 box with clamp-to-edge, evaluated separably
+    const int r = static_cast<int>(std::max(1.0f, radius));
+    const uint32_t taps = static_cast<uint32_t>(2 * r + 1);
+    const uint32_t sampleCount = taps * taps;
+
+    std::vector<uint32_t> horizontal(static_cast<size_t>(width) * height * 4);
+    for (uint32_t y = 0; y < height; y++) {
+        const uint8_t* row = input.rgba.data() + static_cast<size_t>(y) * width * 4;
+        uint32_t* dst = horizontal.data() + static_cast<size_t>(y) * width * 4;
+        for (uint32_t x = 0; x < width; x++) {
+            uint32_t sum[4] = {0, 0, 0, 0};
+            for (int dx = -r; dx <= r; dx++) {
+                int sx = std::clamp(static_cast<int>(x) + dx, 0, static_cast<int>(width) - 1);
+                const uint8_t* p = row + static_cast<size_t>(sx) * 4;
+                sum[0] += p[0];
+                sum[1] += p[1];
+                sum[2] += p[2];
+                sum[3] += p[3];
+            }
+            std::copy(sum, sum + 4, dst + static_cast<size_t>(x) * 4);
+        }
+    }
+
+    output.resize(width, height);
+    const uint32_t half = sampleCount / 2;
+    for (uint32_t y = 0; y < height; y++) {
+        uint8_t* dst = output.rgba.data() + static_cast<size_t>(y) * width * 4;
+        for (uint32_t x = 0; x < width; x++) {
+            uint32_t sum[4] = {0, 0, 0, 0};
+            for (int dy = -r; dy <= r; dy++) {
+                int sy = std::clamp(static_cast<int>(y) + dy, 0, static_cast<int>(height) - 1);
+                const uint32_t* p = horizontal.data() + (static_cast<size_t>(sy) * width + x) * 4;
+                sum[0] += p[0];
+                sum[1] += p[1];
+                sum[2] += p[2];
+                sum[3] += p[3];
+            }
+            for (int c = 0; c < 4; c++) {
+                dst[static_cast<size_t>(x) * 4 + c] = static_cast<uint8_t>((sum[c] + half) / sampleCount);
+            }
+        }
+    }
+}
+
+void CpuEffectBackend::unpackColorCorrection(const std::vector<float>& pushConstants,
+                                             float lift[4], float gamma[4], float gain[4]) {
+    for (size_t i = 0; i < 4; i++) {
+        lift[i] = i < pushConstants.size() ? pushConstants[i] : 0.0f;
+        gamma[i] = i + 4 < pushConstants.size() ? pushConstants[i + 4] : 1.0f;
+        gain[i] = i + 8 < pushConstants.size() ? pushConstants[i + 8] : 1.0f;
+    }
+}
+
+void CpuEffectBackend::buildColorCorrectionTable(const float lift[4], const float gamma[4], const float gain[4],
+                                                 uint8_t table[4][256]) {
+    for (int c = 0; c < 4; c++) {
+        float invGamma = gamma[c] != 0.0f ? 1.0f / gamma[c] : 1.0f;
+        for (int v = 0; v < 256; v++) {
+            float x = static_cast<float>(v) / 255.0f + lift[c];
+            x = std::pow(std::max(x, 0.0001f), invGamma);
+            table[c][v] = toUnorm8(x * gain[c]);
+        }
+    }
+}
+
+void CpuEffectBackend::colorCorrection(const CpuImage& input, CpuImage& output,
+                                       const float lift[4], const float gamma[4], const float gain[4]) {
+    // 8-bit input has only 256 possible values per channel, so evaluate the
+    // lift/gamma/gain curve once per channel and map through a table
+    uint8_t table[4][256];
+    buildColorCorrectionTable(lift, gamma, gain, table);
+
+    const size_t pixelCount = static_cast<size_t>(input.width) * input.height;
+    if (&output != &input) {
+        output.resize(input.width, input.height);
+    }
+    const uint8_t* src = input.rgba.data();
+    uint8_t* dst = output.rgba.data();
+    for (size_t i = 0; i < pixelCount; i++) {
+        dst[i * 4 + 0] = table[0][src[i * 4 + 0]];
+        dst[i * 4 + 1] = table[1][src[i * 4 + 1]];
+        dst[i * 4 + 2] = table[2][src[i * 4 + 2]];
+        dst[i * 4 + 3] = table[3][src[i * 4 + 3]];
+    }
+}
+
+ImageDiff CpuEffectBackend::compare(const CpuImage& a, const CpuImage& b, uint8_t tolerance) {
+    ImageDiff diff;
+    if (a.width != b.width || a.height != b.height || !a.isValid() || !b.isValid()) {
+        diff.sizeMismatch = true;
+        return diff;
+    }
+
+    const size_t pixelCount = static_cast<size_t>(a.width) * a.height;
+    double squaredError = 0.0;
+    for (size_t i = 0; i < pixelCount; i++) {
+        bool differs = false;
+        for (size_t c = 0; c < 4; c++) {
+            int delta = std::abs(static_cast<int>(a.rgba[i * 4 + c]) - static_cast<int>(b.rgba[i * 4 + c]));
+            diff.maxChannelDelta = std::max(diff.maxChannelDelta, static_cast<uint32_t>(delta));
+            squaredError += static_cast<double>(delta) * delta;
+            if (delta > tolerance) {
+                differs = true;
+            }
+        }
+        if (differs) {
+            diff.differingPixels++;
+        }
+    }
+
+    double mse = squaredError / static_cast<double>(pixelCount * 4);
+    diff.psnr = mse > 0.0 ? 10.0 * std::log10((255.0 * 255.0) / mse)
+                          : std::numeric_limits<double>::infinity();
+    return diff;
+}
+
+} // namespace aether
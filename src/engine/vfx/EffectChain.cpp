@@ -0,0 +1,279 @@
+#include "aether/EffectChain.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace aether {
+
+namespace {
+
+// Bits in pixel_chain.comp's lutStepMask
+constexpr size_t kMaxKernelSteps = 32;
+
+uint8_t toUnorm8(float v) {
+    v = std::clamp(v, 0.0f, 1.0f);
+    return static_cast<uint8_t>(v * 255.0f + 0.5f);
+}
+
+bool isSeparable(const std::string& shaderName) {
+    return shaderName == "color_correction" || shaderName == "gain";
+}
+
+void identityTable(uint8_t table[4][256]) {
+    for (int c = 0; c < 4; c++) {
+        for (int v = 0; v < 256; v++) {
+            table[c][v] = static_cast<uint8_t>(v);
+        }
+    }
+}
+
+void buildTable(const EffectOp& op, uint8_t table[4][256]) {
+    if (op.shaderName == "color_correction") {
+        float lift[4];
+        float gamma[4];
+        float gain[4];
+        CpuEffectBackend::unpackColorCorrection(op.params, lift, gamma, gain);
+        CpuEffectBackend::buildColorCorrectionTable(lift, gamma, gain, table);
+        return;
+    }
+
+    // gain { vec4 gain }
+    for (int c = 0; c < 4; c++) {
+        float gain = static_cast<size_t>(c) < op.params.size() ? op.params[static_cast<size_t>(c)] : 1.0f;
+        for (int v = 0; v < 256; v++) {
+            table[c][v] = toUnorm8(static_cast<float>(v) / 255.0f * gain);
+        }
+    }
+}
+
+// Applying `first` then `second` equals one lookup through second[first[v]]
+void composeTables(uint8_t first[4][256], const uint8_t second[4][256]) {
+    for (int c = 0; c < 4; c++) {
+        for (int v = 0; v < 256; v++) {
+            first[c][v] = second[c][first[c][v]];
+        }
+    }
+}
+
+// lut3d { float size; float rgb[size^3 * 3] }
+bool unpackLut(const EffectOp& op, uint32_t& size, std::vector<float>& lut) {
+    if (op.params.empty()) {
+        return false;
+    }
+    size = static_cast<uint32_t>(op.params[0]);
+    size_t expected = static_cast<size_t>(size) * size * size * 3;
+    if (size < 2 || op.params.size() < expected + 1) {
+        std::cerr << "lut3d effect " << op.name << " has an incomplete table" << std::endl;
+        return false;
+    }
+    lut.assign(op.params.begin() + 1, op.params.begin() + 1 + static_cast<std::ptrdiff_t>(expected));
+    return true;
+}
+
+void sampleLut(const std::vector<float>& lut, uint32_t size, const float in[3], float out[3]) {
+    const float scale = static_cast<float>(size - 1);
+    uint32_t i0[3];
+    uint32_t i1[3];
+    float f[3];
+    for (int c = 0; c < 3; c++) {
+        float p = std::clamp(in[c], 0.0f, 1.0f) * scale;
+        i0[c] = static_cast<uint32_t>(p);
+        i1[c] = std::min(i0[c] + 1, size - 1);
+        f[c] = p - static_cast<float>(i0[c]);
+    }
+
+    auto at = [&](uint32_t r, uint32_t g, uint32_t b, int c) {
+        return lut[((static_cast<size_t>(b) * size + g) * size + r) * 3 + static_cast<size_t>(c)];
+    };
+    for (int c = 0; c < 3; c++) {
+        float c00 = at(i0[0], i0[1], i0[2], c) * (1.0f - f[0]) + at(i1[0], i0[1], i0[2], c) * f[0];
+        float c10 = at(i0[0], i1[1], i0[2], c) * (1.0f - f[0]) + at(i1[0], i1[1], i0[2], c) * f[0];
+        float c01 = at(i0[0], i0[1], i1[2], c) * (1.0f - f[0]) + at(i1[0], i0[1], i1[2], c) * f[0];
+        float c11 = at(i0[0], i1[1], i1[2], c) * (1.0f - f[0]) + at(i1[0], i1[1], i1[2], c) * f[0];
+        float c0 = c00 * (1.0f - f[1]) + c10 * f[1];
+        float c1 = c01 * (1.0f - f[1]) + c11 * f[1];
+        out[c] = c0 * (1.0f - f[2]) + c1 * f[2];
+    }
+}
+
+} // namespace
+
+void FusedPixelKernel::apply(const CpuImage& input, CpuImage& output) const {
+    if (&output != &input) {
+        output.resize(input.width, input.height);
+    }
+    const size_t pixelCount = static_cast<size_t>(input.width) * input.height;
+    const uint8_t* src = input.rgba.data();
+    uint8_t* dst = output.rgba.data();
+
+    // Single pass: each pixel is loaded once, runs every step, and is stored once
+    for (size_t i = 0; i < pixelCount; i++) {
+        uint8_t px[4] = {src[i * 4 + 0], src[i * 4 + 1], src[i * 4 + 2], src[i * 4 + 3]};
+        for (const Step& step : steps) {
+            if (step.type == StepType::Table) {
+                px[0] = step.table[0][px[0]];
+                px[1] = step.table[1][px[1]];
+                px[2] = step.table[2][px[2]];
+                px[3] = step.table[3][px[3]];
+            } else {
+                float in[3] = {px[0] / 255.0f, px[1] / 255.0f, px[2] / 255.0f};
+                float out[3];
+                sampleLut(step.lut, step.lutSize, in, out);
+                px[0] = toUnorm8(out[0]);
+                px[1] = toUnorm8(out[1]);
+                px[2] = toUnorm8(out[2]);
+            }
+        }
+        dst[i * 4 + 0] = px[0];
+        dst[i * 4 + 1] = px[1];
+        dst[i * 4 + 2] = px[2];
+        dst[i * 4 + 3] = px[3];
+    }
+}
+
+bool EffectChainCompiler::isKnownEffect(const std::string& shaderName) {
+    return isSeparable(shaderName) || shaderName == "lut3d" || shaderName == "blur";
+}
+
+EffectAccess EffectChainCompiler::accessOf(const std::string& shaderName) {
+    return shaderName == "blur" ? EffectAccess::Neighbourhood : EffectAccess::PerPixel;
+}
+
+uint32_t EffectChainCompiler::footprintOf(const EffectOp& op) {
+    if (accessOf(op.shaderName) == EffectAccess::PerPixel) {
+        return 0;
+    }
+    // blur { float radius }, as blur.comp reads it
+    const float radius = op.params.empty() ? 1.0f : op.params[0];
+    return static_cast<uint32_t>(std::clamp(radius, 1.0f, 65535.0f));
+}
+
+CompiledEffectChain EffectChainCompiler::compile(const std::vector<EffectOp>& effects) {
+    CompiledEffectChain chain;
+    chain.effectCount = effects.size();
+
+    CompiledStage* open = nullptr; // fused stage still accepting per-pixel effects
+    for (size_t i = 0; i < effects.size(); i++) {
+        const EffectOp& op = effects[i];
+        if (!isKnownEffect(op.shaderName)) {
+            std::cerr << "Effect chain: unknown effect " << op.shaderName << " (" << op.name << "), skipped"
+                      << std::endl;
+            continue;
+        }
+
+        if (accessOf(op.shaderName) == EffectAccess::Neighbourhood) {
+            CompiledStage stage;
+            stage.name = op.name;
+            stage.access = EffectAccess::Neighbourhood;
+            stage.effectIndices.push_back(i);
+            stage.op = op;
+            chain.stages.push_back(std::move(stage));
+            open = nullptr;
+            continue;
+        }
+
+        FusedPixelKernel::Step step;
+        if (isSeparable(op.shaderName)) {
+            buildTable(op, step.table);
+        } else {
+            step.type = FusedPixelKernel::StepType::Lut3D;
+            if (!unpackLut(op, step.lutSize, step.lut)) {
+                continue;
+            }
+        }
+
+        // The GPU kernel shares one LUT size per dispatch and has a fixed step budget
+        if (open) {
+            auto& steps = open->kernel.steps;
+            bool lutSizeClash = false;
+            if (step.type == FusedPixelKernel::StepType::Lut3D) {
+                for (const auto& existing : steps) {
+                    if (existing.type == FusedPixelKernel::StepType::Lut3D && existing.lutSize != step.lutSize) {
+                        lutSizeClash = true;
+                    }
+                }
+            }
+            if (lutSizeClash || steps.size() >= kMaxKernelSteps) {
+                open = nullptr;
+            }
+        }
+
+        if (!open) {
+            CompiledStage stage;
+            stage.access = EffectAccess::PerPixel;
+            chain.stages.push_back(std::move(stage));
+            open = &chain.stages.back();
+        }
+
+        open->name += open->name.empty() ? op.name : "+" + op.name;
+        open->effectIndices.push_back(i);
+        auto& steps = open->kernel.steps;
+        if (step.type == FusedPixelKernel::StepType::Table && !steps.empty() &&
+            steps.back().type == FusedPixelKernel::StepType::Table) {
+            // Adjacent separable effects collapse into one lookup
+            composeTables(steps.back().table, step.table);
+        } else {
+            steps.push_back(std::move(step));
+        }
+    }
+    return chain;
+}
+
+bool EffectChainCompiler::execute(const CompiledEffectChain& chain, const CpuImage& input, CpuImage& output,
+                                  std::vector<double>* stageMilliseconds) {
+    if (!input.isValid()) {
+        return false;
+    }
+    if (chain.isEmpty()) {
+        output = input;
+        return true;
+    }
+
+    CpuImage ping;
+    CpuImage pong;
+    CpuImage source;
+    const CpuImage* current = &input;
+    if (&output == &input) {
+        // Neighbourhood stages cannot run in place
+        source = input;
+        current = &source;
+    }
+    CpuEffectBackend backend;
+    for (size_t i = 0; i < chain.stages.size(); i++) {
+        const CompiledStage& stage = chain.stages[i];
+        // Last stage writes straight into the caller's image
+        CpuImage& target = (i + 1 == chain.stages.size()) ? output : (current == &ping ? pong : ping);
+
+        auto start = std::chrono::steady_clock::now();
+        if (stage.access == EffectAccess::PerPixel) {
+            stage.kernel.apply(*current, target);
+        } else if (!backend.apply(stage.op.shaderName, stage.op.params, *current, target)) {
+            return false;
+        }
+        auto end = std::chrono::steady_clock::now();
+        if (stageMilliseconds) {
+            stageMilliseconds->push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        current = &target;
+    }
+    return true;
+}
+
+std::vector<uint32_t> EffectChainCompiler::packGpuTables(const FusedPixelKernel& kernel) {
+    std::vector<uint32_t> packed;
+    for (const auto& step : kernel.steps) {
+        if (step.type != FusedPixelKernel::StepType::Table) {
+            continue;
+        }
+        for (int v = 0; v < 256; v++) {
+            packed.push_back(static_cast<uint32_t>(step.table[0][v]) |
+                             (static_cast<uint32_t>(step.table[1][v]) << 8) |
+                             (static_cast<uint32_t>(step.table[2][v]) << 16) |
+                             (static_cast<uint32_t>(step.table[3][v]) << 24));
+        }
+    }
+    return packed;
+}
+
+} // namespace aether
@@ -0,0 +1,269 @@
+#include "aether/ParticleSystem.h"
+#include "aether/ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AETHER_PARTICLES_SSE2 1
+#endif
+
+namespace aether {
+
+namespace {
+
+// Fixed chunking for compaction so per-chunk alive counts line up between passes
+constexpr size_t kCompactChunk = 16384;
+constexpr size_t kUpdateGrain = 8192;
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// splitmix64: cheap, and independent streams per chunk from a single seed
+uint64_t nextRandom(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+float randomRange(uint64_t& state, float lo, float hi) {
+    float unit = static_cast<float>(nextRandom(state) >> 40) * (1.0f / 16777216.0f);
+    return lo + (hi - lo) * unit;
+}
+
+} // namespace
+
+void ParticleSystem::Storage::resize(size_t n) {
+    posX.resize(n);
+    posY.resize(n);
+    velX.resize(n);
+    velY.resize(n);
+    age.resize(n);
+    lifetime.resize(n);
+    color.resize(n);
+}
+
+ParticleSystem::ParticleSystem(size_t capacity) {
+    setCapacity(capacity);
+}
+
+void ParticleSystem::setCapacity(size_t capacity) {
+    m_capacity = capacity;
+    m_front.resize(capacity);
+    m_back.resize(capacity);
+    m_alive = std::min(m_alive, capacity);
+}
+
+ThreadPool& ParticleSystem::pool() const {
+    return m_pool ? *m_pool : ThreadPool::getInstance();
+}
+
+void ParticleSystem::clear() {
+    m_alive = 0;
+    m_emitAccumulator = 0.0f;
+}
+
+void ParticleSystem::spawnRange(size_t begin, size_t end, uint64_t seed) {
+    const ParticleEmitterSettings& e = m_emitter;
+    uint64_t state = seed ^ (static_cast<uint64_t>(begin) * 0xD1B54A32D192ED03ull);
+    for (size_t i = begin; i < end; i++) {
+        float angle = e.directionRadians + randomRange(state, -e.spreadRadians, e.spreadRadians);
+        float speed = randomRange(state, e.speedMin, e.speedMax);
+        float offsetAngle = randomRange(state, 0.0f, 6.2831853f);
+        float offset = e.spawnRadius * std::sqrt(randomRange(state, 0.0f, 1.0f));
+        m_front.posX[i] = e.x + offset * std::cos(offsetAngle);
+        m_front.posY[i] = e.y + offset * std::sin(offsetAngle);
+        m_front.velX[i] = speed * std::cos(angle);
+        m_front.velY[i] = speed * std::sin(angle);
+        m_front.age[i] = 0.0f;
+        m_front.lifetime[i] = randomRange(state, e.lifetimeMin, e.lifetimeMax);
+        m_front.color[i] = e.color;
+    }
+}
+
+size_t ParticleSystem::emit(size_t count) {
+    count = std::min(count, m_capacity - m_alive);
+    if (count == 0) {
+        return 0;
+    }
+    const size_t begin = m_alive;
+    const uint64_t seed = nextRandom(m_frameSeed);
+    pool().parallelFor(begin, begin + count, kUpdateGrain, [this, seed](size_t chunkBegin, size_t chunkEnd) {
+        spawnRange(chunkBegin, chunkEnd, seed);
+    });
+    m_alive += count;
+    return count;
+}
+
+void ParticleSystem::integrate(size_t begin, size_t end, float deltaTime) {
+    const float damping = std::max(0.0f, 1.0f - m_forces.drag * deltaTime);
+    const float gx = m_forces.gravityX * deltaTime;
+    const float gy = m_forces.gravityY * deltaTime;
+    float* px = m_front.posX.data();
+    float* py = m_front.posY.data();
+    float* vx = m_front.velX.data();
+    float* vy = m_front.velY.data();
+    float* age = m_front.age.data();
+
+    size_t i = begin;
+#ifdef AETHER_PARTICLES_SSE2
+    const __m128 vDamping = _mm_set1_ps(damping);
+    const __m128 vGx = _mm_set1_ps(gx);
+    const __m128 vGy = _mm_set1_ps(gy);
+    const __m128 vDt = _mm_set1_ps(deltaTime);
+    for (; i + 4 <= end; i += 4) {
+        __m128 nvx = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(vx + i), vDamping), vGx);
+        __m128 nvy = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(vy + i), vDamping), vGy);
+        _mm_storeu_ps(vx + i, nvx);
+        _mm_storeu_ps(vy + i, nvy);
+        _mm_storeu_ps(px + i, _mm_add_ps(_mm_loadu_ps(px + i), _mm_mul_ps(nvx, vDt)));
+        _mm_storeu_ps(py + i, _mm_add_ps(_mm_loadu_ps(py + i), _mm_mul_ps(nvy, vDt)));
+        _mm_storeu_ps(age + i, _mm_add_ps(_mm_loadu_ps(age + i), vDt));
+    }
+#endif
+    // Scalar tail (and the whole range without SSE2); branch-free so it auto-vectorizes
+    for (; i < end; i++) {
+        vx[i] = vx[i] * damping + gx;
+        vy[i] = vy[i] * damping + gy;
+        px[i] += vx[i] * deltaTime;
+        py[i] += vy[i] * deltaTime;
+        age[i] += deltaTime;
+    }
+}
+
+size_t ParticleSystem::compact() {
+    const size_t chunks = (m_alive + kCompactChunk - 1) / kCompactChunk;
+    m_chunkAlive.assign(chunks + 1, 0);
+
+    // Pass 1: live particles per chunk
+    pool().parallelFor(0, chunks, 1, [this](size_t chunkBegin, size_t chunkEnd) {
+        for (size_t c = chunkBegin; c < chunkEnd; c++) {
+            size_t first = c * kCompactChunk;
+            size_t last = std::min(m_alive, first + kCompactChunk);
+            size_t live = 0;
+            for (size_t i = first; i < last; i++) {
+                live += m_front.age[i] < m_front.lifetime[i] ? 1 : 0;
+            }
+            m_chunkAlive[c + 1] = live;
+        }
+    });
+
+    // Exclusive prefix sum gives each chunk its output offset
+    for (size_t c = 1; c <= chunks; c++) {
+        m_chunkAlive[c] += m_chunkAlive[c - 1];
+    }
+    const size_t survivors = m_chunkAlive[chunks];
+    if (survivors == m_alive) {
+        return 0;
+    }
+
+    // Pass 2: stable copy of survivors into the back buffer, then swap
+    pool().parallelFor(0, chunks, 1, [this](size_t chunkBegin, size_t chunkEnd) {
+        for (size_t c = chunkBegin; c < chunkEnd; c++) {
+            size_t first = c * kCompactChunk;
+            size_t last = std::min(m_alive, first + kCompactChunk);
+            size_t out = m_chunkAlive[c];
+            for (size_t i = first; i < last; i++) {
+                if (m_front.age[i] < m_front.lifetime[i]) {
+                    m_back.posX[out] = m_front.posX[i];
+                    m_back.posY[out] = m_front.posY[i];
+                    m_back.velX[out] = m_front.velX[i];
+                    m_back.velY[out] = m_front.velY[i];
+                    m_back.age[out] = m_front.age[i];
+                    m_back.lifetime[out] = m_front.lifetime[i];
+                    m_back.color[out] = m_front.color[i];
+                    out++;
+                }
+            }
+        }
+    });
+    std::swap(m_front, m_back);
+
+    size_t removed = m_alive - survivors;
+    m_alive = survivors;
+    return removed;
+}
+
+void ParticleSystem::update(float deltaTime) {
+    ParticleFrameStats stats;
+
+    auto start = std::chrono::steady_clock::now();
+    if (m_emitter.ratePerSecond > 0.0f && deltaTime > 0.0f) {
+        m_emitAccumulator += m_emitter.ratePerSecond * deltaTime;
+        size_t whole = static_cast<size_t>(m_emitAccumulator);
+        m_emitAccumulator -= static_cast<float>(whole);
+        stats.emitted = emit(whole);
+    }
+    stats.emitMs = elapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    pool().parallelFor(0, m_alive, kUpdateGrain, [this, deltaTime](size_t chunkBegin, size_t chunkEnd) {
+        integrate(chunkBegin, chunkEnd, deltaTime);
+    });
+    stats.updateMs = elapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    stats.removed = compact();
+    stats.compactMs = elapsedMs(start);
+
+    stats.alive = m_alive;
+    m_lastStats = stats;
+}
+
+void ParticleSystem::render(CpuImage& target) const {
+    if (!target.isValid() || m_alive == 0) {
+        return;
+    }
+    const int width = static_cast<int>(target.width);
+    const int height = static_cast<int>(target.height);
+    // One band of rows per thread, each writing only its own rows
+    ThreadPool& threads = pool();
+    const size_t bandRows = (target.height + threads.getConcurrency() - 1) / threads.getConcurrency();
+    const size_t bands = (target.height + bandRows - 1) / bandRows;
+
+    // Counting sort of the on-screen particles by band, so each band visits only its own
+    m_bandStart.assign(bands + 1, 0);
+    for (size_t i = 0; i < m_alive; i++) {
+        int x = static_cast<int>(std::floor(m_front.posX[i]));
+        int y = static_cast<int>(std::floor(m_front.posY[i]));
+        if (x >= 0 && x < width && y >= 0 && y < height) {
+            m_bandStart[static_cast<size_t>(y) / bandRows + 1]++;
+        }
+    }
+    for (size_t band = 0; band < bands; band++) {
+        m_bandStart[band + 1] += m_bandStart[band];
+    }
+    m_bandParticles.resize(m_bandStart[bands]);
+    std::vector<size_t> fill(m_bandStart.begin(), m_bandStart.end() - 1);
+    for (size_t i = 0; i < m_alive; i++) {
+        int x = static_cast<int>(std::floor(m_front.posX[i]));
+        int y = static_cast<int>(std::floor(m_front.posY[i]));
+        if (x >= 0 && x < width && y >= 0 && y < height) {
+            m_bandParticles[fill[static_cast<size_t>(y) / bandRows]++] = static_cast<uint32_t>(i);
+        }
+    }
+
+    threads.parallelFor(0, bands, 1, [&](size_t bandBegin, size_t bandEnd) {
+        for (size_t k = m_bandStart[bandBegin]; k < m_bandStart[bandEnd]; k++) {
+            const size_t i = m_bandParticles[k];
+            int x = static_cast<int>(std::floor(m_front.posX[i]));
+            int y = static_cast<int>(std::floor(m_front.posY[i]));
+            // Fade out over the particle's life
+            float fade = 1.0f - m_front.age[i] / m_front.lifetime[i];
+            uint32_t color = m_front.color[i];
+            float alpha = static_cast<float>(color >> 24) / 255.0f * fade;
+            uint8_t* dst = target.rgba.data() + (static_cast<size_t>(y) * target.width + static_cast<size_t>(x)) * 4;
+            for (int c = 0; c < 3; c++) {
+                float src = static_cast<float>((color >> (c * 8)) & 0xFF) * alpha;
+                int sum = dst[c] + static_cast<int>(src + 0.5f);
+                dst[c] = static_cast<uint8_t>(std::min(sum, 255));
+            }
+            dst[3] = 255;
+        }
+    });
+}
+
+} // namespace aether
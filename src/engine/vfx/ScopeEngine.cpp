@@ -0,0 +1,519 @@
+#include "aether/ScopeEngine.h"
+#include "aether/ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AETHER_SCOPES_SSE2 1
+#endif
+
+namespace aether {
+
+namespace {
+
+constexpr uint32_t kLevels = 256;
+constexpr uint32_t kHistogramHeight = 128;
+constexpr uint32_t kLogTableSize = 4096;
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// BT.709 Y'CbCr -> R'G'B' in Q6 fixed point, small enough for 16-bit lanes
+struct YuvToRgb {
+    int yOffset;
+    int yScale;
+    int rCr;
+    int gCb;
+    int gCr;
+    int bCb;
+};
+
+YuvToRgb yuvToRgbCoefficients(bool limitedRange) {
+    const double yScale = limitedRange ? 255.0 / 219.0 : 1.0;
+    const double cScale = limitedRange ? 255.0 / 224.0 : 1.0;
+    YuvToRgb k;
+    k.yOffset = limitedRange ? 16 : 0;
+    k.yScale = static_cast<int>(std::lround(yScale * 64.0));
+    k.rCr = static_cast<int>(std::lround(1.5748 * cScale * 64.0));
+    k.gCb = static_cast<int>(std::lround(0.1873 * cScale * 64.0));
+    k.gCr = static_cast<int>(std::lround(0.4681 * cScale * 64.0));
+    k.bCb = static_cast<int>(std::lround(1.8556 * cScale * 64.0));
+    return k;
+}
+
+uint8_t clampByte(int v) {
+    return static_cast<uint8_t>(std::clamp(v, 0, 255));
+}
+
+// Planar Y/Cb/Cr -> planar R/G/B for n samples
+void convertYuvToRgb(const uint8_t* y, const uint8_t* cb, const uint8_t* cr,
+                     uint8_t* r, uint8_t* g, uint8_t* b, size_t n, const YuvToRgb& k) {
+    size_t i = 0;
+#ifdef AETHER_SCOPES_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i yOffset = _mm_set1_epi16(static_cast<int16_t>(k.yOffset));
+    const __m128i yScale = _mm_set1_epi16(static_cast<int16_t>(k.yScale));
+    const __m128i chromaOffset = _mm_set1_epi16(128);
+    const __m128i rCr = _mm_set1_epi16(static_cast<int16_t>(k.rCr));
+    const __m128i gCb = _mm_set1_epi16(static_cast<int16_t>(k.gCb));
+    const __m128i gCr = _mm_set1_epi16(static_cast<int16_t>(k.gCr));
+    const __m128i bCb = _mm_set1_epi16(static_cast<int16_t>(k.bCb));
+    const __m128i round = _mm_set1_epi16(32);
+    for (; i + 8 <= n; i += 8) {
+        __m128i yv = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(y + i)), zero);
+        __m128i cbv = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(cb + i)), zero);
+        __m128i crv = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(cr + i)), zero);
+        yv = _mm_mullo_epi16(_mm_sub_epi16(yv, yOffset), yScale);
+        cbv = _mm_sub_epi16(cbv, chromaOffset);
+        crv = _mm_sub_epi16(crv, chromaOffset);
+        // Saturating adds: anything that saturates is far above 255 after the shift anyway
+        __m128i rv = _mm_adds_epi16(yv, _mm_mullo_epi16(crv, rCr));
+        __m128i gv = _mm_subs_epi16(_mm_subs_epi16(yv, _mm_mullo_epi16(cbv, gCb)), _mm_mullo_epi16(crv, gCr));
+        __m128i bv = _mm_adds_epi16(yv, _mm_mullo_epi16(cbv, bCb));
+        rv = _mm_srai_epi16(_mm_adds_epi16(rv, round), 6);
+        gv = _mm_srai_epi16(_mm_adds_epi16(gv, round), 6);
+        bv = _mm_srai_epi16(_mm_adds_epi16(bv, round), 6);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(r + i), _mm_packus_epi16(rv, rv));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(g + i), _mm_packus_epi16(gv, gv));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(b + i), _mm_packus_epi16(bv, bv));
+    }
+#endif
+    for (; i < n; i++) {
+        int yv = (y[i] - k.yOffset) * k.yScale;
+        int cbv = cb[i] - 128;
+        int crv = cr[i] - 128;
+        r[i] = clampByte((yv + crv * k.rCr + 32) >> 6);
+        g[i] = clampByte((yv - cbv * k.gCb - crv * k.gCr + 32) >> 6);
+        b[i] = clampByte((yv + cbv * k.bCb + 32) >> 6);
+    }
+}
+
+// Planar R/G/B -> planar full-range BT.709 Y/Cb/Cr for n samples.
+// Y weights sum to 256 (Q8); chroma scales are 1/1.8556 and 1/1.5748 in Q7.
+void convertRgbToYuv(const uint8_t* r, const uint8_t* g, const uint8_t* b,
+                     uint8_t* y, uint8_t* cb, uint8_t* cr, size_t n) {
+    size_t i = 0;
+#ifdef AETHER_SCOPES_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i kr = _mm_set1_epi16(54);
+    const __m128i kg = _mm_set1_epi16(183);
+    const __m128i kb = _mm_set1_epi16(19);
+    const __m128i kcb = _mm_set1_epi16(69);
+    const __m128i kcr = _mm_set1_epi16(81);
+    const __m128i roundY = _mm_set1_epi16(128);
+    const __m128i roundC = _mm_set1_epi16(64);
+    const __m128i chromaOffset = _mm_set1_epi16(128);
+    for (; i + 8 <= n; i += 8) {
+        __m128i rv = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(r + i)), zero);
+        __m128i gv = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(g + i)), zero);
+        __m128i bv = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(b + i)), zero);
+        // At most 255 * 256 + 128, so the unsigned 16-bit sum cannot wrap
+        __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(rv, kr), _mm_mullo_epi16(gv, kg)),
+                                    _mm_add_epi16(_mm_mullo_epi16(bv, kb), roundY));
+        __m128i yv = _mm_srli_epi16(sum, 8);
+        __m128i cbv = _mm_srai_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(bv, yv), kcb), roundC), 7);
+        __m128i crv = _mm_srai_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(rv, yv), kcr), roundC), 7);
+        cbv = _mm_add_epi16(cbv, chromaOffset);
+        crv = _mm_add_epi16(crv, chromaOffset);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(y + i), _mm_packus_epi16(yv, yv));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(cb + i), _mm_packus_epi16(cbv, cbv));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(cr + i), _mm_packus_epi16(crv, crv));
+    }
+#endif
+    for (; i < n; i++) {
+        int yv = (r[i] * 54 + g[i] * 183 + b[i] * 19 + 128) >> 8;
+        y[i] = static_cast<uint8_t>(yv);
+        cb[i] = clampByte((((b[i] - yv) * 69 + 64) >> 7) + 128);
+        cr[i] = clampByte((((r[i] - yv) * 81 + 64) >> 7) + 128);
+    }
+}
+
+uint32_t maxOf(const std::vector<uint32_t>& bins) {
+    return bins.empty() ? 0 : *std::max_element(bins.begin(), bins.end());
+}
+
+// log(1 + count) / log(1 + max), scaled to 0..255; counts below kLogTableSize come from a table
+class DensityMap {
+public:
+    DensityMap(uint32_t maxCount, float intensity) {
+        m_scale = maxCount > 0 ? 255.0f * intensity / std::log1p(static_cast<float>(maxCount)) : 0.0f;
+        for (uint32_t i = 0; i < kLogTableSize; i++) {
+            m_table[i] = toByte(i);
+        }
+    }
+    uint8_t operator()(uint32_t count) const {
+        return count < kLogTableSize ? m_table[count] : toByte(count);
+    }
+
+private:
+    uint8_t toByte(uint32_t count) const {
+        float v = std::log1p(static_cast<float>(count)) * m_scale;
+        return static_cast<uint8_t>(std::min(v + 0.5f, 255.0f));
+    }
+    float m_scale = 0.0f;
+    uint8_t m_table[kLogTableSize];
+};
+
+} // namespace
+
+bool ScopeFrame::isValid() const {
+    if (width == 0 || height == 0 || !planes[0]) {
+        return false;
+    }
+    if (format == Format::Rgb24) {
+        return strides[0] >= width * 3;
+    }
+    return planes[1] && planes[2] && strides[0] >= width;
+}
+
+ScopeEngine::ScopeEngine() {
+    // Hue of every Cb/Cr bin at mid luma; the vectorscope shows each bin in its own colour
+    m_vectorscopeTint.resize(static_cast<size_t>(kLevels) * kLevels * 3);
+    for (uint32_t cr = 0; cr < kLevels; cr++) {
+        for (uint32_t cb = 0; cb < kLevels; cb++) {
+            float u = (static_cast<float>(cb) - 128.0f) / 128.0f;
+            float v = (static_cast<float>(cr) - 128.0f) / 128.0f;
+            float y = 0.75f;
+            float r = y + 1.5748f * v * 0.5f;
+            float g = y - (0.1873f * u + 0.4681f * v) * 0.5f;
+            float b = y + 1.8556f * u * 0.5f;
+            uint8_t* tint = m_vectorscopeTint.data() + (static_cast<size_t>(cr) * kLevels + cb) * 3;
+            tint[0] = static_cast<uint8_t>(std::clamp(r, 0.25f, 1.0f) * 255.0f);
+            tint[1] = static_cast<uint8_t>(std::clamp(g, 0.25f, 1.0f) * 255.0f);
+            tint[2] = static_cast<uint8_t>(std::clamp(b, 0.25f, 1.0f) * 255.0f);
+        }
+    }
+}
+
+ThreadPool& ScopeEngine::pool() const {
+    return m_pool ? *m_pool : ThreadPool::getInstance();
+}
+
+uint32_t ScopeEngine::chooseSampleStep(uint32_t width, uint32_t height, uint64_t sampleBudget) {
+    const uint64_t pixels = static_cast<uint64_t>(width) * height;
+    if (sampleBudget == 0 || pixels <= sampleBudget) {
+        return 1;
+    }
+    // Same step in both directions keeps the sampling grid isotropic
+    return static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(pixels) / static_cast<double>(sampleBudget))));
+}
+
+bool ScopeEngine::analyze(const ScopeFrame& frame, ScopeResult& result) {
+    if (!frame.isValid()) {
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    const uint32_t columns = std::max(1u, m_settings.waveformColumns);
+    const uint32_t step = chooseSampleStep(frame.width, frame.height, m_settings.sampleBudget);
+    const size_t sampledWidth = (frame.width + step - 1) / step;
+    const size_t sampledRows = (frame.height + step - 1) / step;
+
+    m_sampleColumn.resize(sampledWidth);
+    for (size_t s = 0; s < sampledWidth; s++) {
+        uint64_t x = static_cast<uint64_t>(s) * step;
+        m_sampleColumn[s] = static_cast<uint16_t>(std::min<uint64_t>(x * columns / frame.width, columns - 1));
+    }
+
+    // Fixed chunk count so each chunk owns one set of bins for the whole frame
+    ThreadPool& threads = pool();
+    const size_t chunkCount = std::max<size_t>(1, std::min(threads.getConcurrency(), sampledRows));
+    if (m_bins.size() < chunkCount) {
+        m_bins.resize(chunkCount);
+    }
+    const size_t rowsPerChunk = (sampledRows + chunkCount - 1) / chunkCount;
+
+    threads.parallelFor(0, chunkCount, 1, [&](size_t chunkBegin, size_t chunkEnd) {
+        for (size_t chunk = chunkBegin; chunk < chunkEnd; chunk++) {
+            Bins& bins = m_bins[chunk];
+            bins.waveform.assign(static_cast<size_t>(columns) * kLevels, 0);
+            bins.parade.assign(static_cast<size_t>(columns) * kLevels * 3, 0);
+            bins.vectorscope.assign(static_cast<size_t>(kLevels) * kLevels, 0);
+            bins.histogram.assign(static_cast<size_t>(kLevels) * 4, 0);
+            size_t rowBegin = chunk * rowsPerChunk;
+            size_t rowEnd = std::min(sampledRows, rowBegin + rowsPerChunk);
+            if (rowBegin < rowEnd) {
+                accumulateRows(frame, step, rowBegin, rowEnd, bins);
+            }
+        }
+    });
+    reduceBins(chunkCount);
+    result.accumulateMs = elapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    resolveImages(result);
+    result.resolveMs = elapsedMs(start);
+
+    result.frameWidth = frame.width;
+    result.frameHeight = frame.height;
+    result.sampleStep = step;
+    result.samples = static_cast<uint64_t>(sampledWidth) * sampledRows;
+    return true;
+}
+
+void ScopeEngine::accumulateRows(const ScopeFrame& frame, uint32_t step, size_t rowBegin, size_t rowEnd,
+                                 Bins& bins) const {
+    const size_t n = m_sampleColumn.size();
+    // Planar scratch rows: Y, Cb, Cr, R, G, B
+    std::vector<uint8_t> scratch(n * 6);
+    uint8_t* ys = scratch.data();
+    uint8_t* cbs = ys + n;
+    uint8_t* crs = cbs + n;
+    uint8_t* rs = crs + n;
+    uint8_t* gs = rs + n;
+    uint8_t* bs = gs + n;
+
+    const bool rgbInput = frame.format == ScopeFrame::Format::Rgb24;
+    const uint32_t chromaShiftX = frame.format == ScopeFrame::Format::Yuv444 ? 0 : 1;
+    const uint32_t chromaShiftY = frame.format == ScopeFrame::Format::Yuv420 ? 1 : 0;
+    const YuvToRgb k = yuvToRgbCoefficients(frame.limitedRange);
+
+    const size_t columns = bins.waveform.size() / kLevels;
+    const size_t paradePlane = columns * kLevels;
+    uint32_t* waveform = bins.waveform.data();
+    uint32_t* parade = bins.parade.data();
+    uint32_t* vectorscope = bins.vectorscope.data();
+    uint32_t* histogram = bins.histogram.data();
+    const uint16_t* sampleColumn = m_sampleColumn.data();
+
+    for (size_t row = rowBegin; row < rowEnd; row++) {
+        const size_t y = row * step;
+        if (rgbInput) {
+            const uint8_t* src = frame.planes[0] + y * frame.strides[0];
+            for (size_t s = 0; s < n; s++) {
+                const uint8_t* p = src + s * step * 3;
+                rs[s] = p[0];
+                gs[s] = p[1];
+                bs[s] = p[2];
+            }
+            convertRgbToYuv(rs, gs, bs, ys, cbs, crs, n);
+        } else {
+            const uint8_t* srcY = frame.planes[0] + y * frame.strides[0];
+            const uint8_t* srcCb = frame.planes[1] + (y >> chromaShiftY) * frame.strides[1];
+            const uint8_t* srcCr = frame.planes[2] + (y >> chromaShiftY) * frame.strides[2];
+            for (size_t s = 0; s < n; s++) {
+                const size_t x = s * step;
+                ys[s] = srcY[x];
+                cbs[s] = srcCb[x >> chromaShiftX];
+                crs[s] = srcCr[x >> chromaShiftX];
+            }
+            convertYuvToRgb(ys, cbs, crs, rs, gs, bs, n, k);
+        }
+
+        for (size_t s = 0; s < n; s++) {
+            const size_t column = static_cast<size_t>(sampleColumn[s]) * kLevels;
+            waveform[column + ys[s]]++;
+            parade[column + rs[s]]++;
+            parade[paradePlane + column + gs[s]]++;
+            parade[2 * paradePlane + column + bs[s]]++;
+            vectorscope[static_cast<size_t>(crs[s]) * kLevels + cbs[s]]++;
+            histogram[ys[s]]++;
+            histogram[kLevels + rs[s]]++;
+            histogram[2 * kLevels + gs[s]]++;
+            histogram[3 * kLevels + bs[s]]++;
+        }
+    }
+}
+
+void ScopeEngine::reduceBins(size_t chunkCount) {
+    if (chunkCount <= 1) {
+        return;
+    }
+    auto sumInto = [&](std::vector<uint32_t> Bins::*member) {
+        std::vector<uint32_t>& total = m_bins[0].*member;
+        pool().parallelFor(0, total.size(), 16384, [&](size_t begin, size_t end) {
+            for (size_t chunk = 1; chunk < chunkCount; chunk++) {
+                const uint32_t* src = (m_bins[chunk].*member).data();
+                for (size_t i = begin; i < end; i++) {
+                    total[i] += src[i];
+                }
+            }
+        });
+    };
+    sumInto(&Bins::waveform);
+    sumInto(&Bins::parade);
+    sumInto(&Bins::vectorscope);
+    sumInto(&Bins::histogram);
+}
+
+void ScopeEngine::resolveImages(ScopeResult& result) {
+    const Bins& bins = m_bins[0];
+    const uint32_t columns = static_cast<uint32_t>(bins.waveform.size() / kLevels);
+    const float intensity = m_settings.intensity;
+
+    // Waveform: greenish trace, level 255 at the top
+    {
+        DensityMap density(maxOf(bins.waveform), intensity);
+        result.waveform.resize(columns, kLevels);
+        pool().parallelFor(0, kLevels, 32, [&](size_t rowBegin, size_t rowEnd) {
+            for (size_t row = rowBegin; row < rowEnd; row++) {
+                const size_t level = kLevels - 1 - row;
+                uint8_t* dst = result.waveform.rgba.data() + row * columns * 4;
+                for (uint32_t c = 0; c < columns; c++) {
+                    uint8_t v = density(bins.waveform[static_cast<size_t>(c) * kLevels + level]);
+                    dst[c * 4 + 0] = static_cast<uint8_t>(v * 3 / 4);
+                    dst[c * 4 + 1] = v;
+                    dst[c * 4 + 2] = static_cast<uint8_t>(v * 3 / 4);
+                    dst[c * 4 + 3] = 255;
+                }
+            }
+        });
+    }
+
+    // Parade: R | G | B side by side, each in its own colour
+    {
+        DensityMap density(maxOf(bins.parade), intensity);
+        const uint32_t width = columns * 3;
+        const size_t plane = static_cast<size_t>(columns) * kLevels;
+        result.parade.resize(width, kLevels);
+        pool().parallelFor(0, kLevels, 32, [&](size_t rowBegin, size_t rowEnd) {
+            for (size_t row = rowBegin; row < rowEnd; row++) {
+                const size_t level = kLevels - 1 - row;
+                uint8_t* dst = result.parade.rgba.data() + row * width * 4;
+                for (uint32_t channel = 0; channel < 3; channel++) {
+                    const uint32_t* src = bins.parade.data() + channel * plane;
+                    for (uint32_t c = 0; c < columns; c++) {
+                        uint8_t v = density(src[static_cast<size_t>(c) * kLevels + level]);
+                        uint8_t* px = dst + (static_cast<size_t>(channel) * columns + c) * 4;
+                        px[0] = channel == 0 ? v : static_cast<uint8_t>(v / 4);
+                        px[1] = channel == 1 ? v : static_cast<uint8_t>(v / 4);
+                        px[2] = channel == 2 ? v : static_cast<uint8_t>(v / 4);
+                        px[3] = 255;
+                    }
+                }
+            }
+        });
+    }
+
+    // Vectorscope: Cb to the right, Cr up, each bin tinted with its hue
+    {
+        DensityMap density(maxOf(bins.vectorscope), intensity);
+        result.vectorscope.resize(kLevels, kLevels);
+        pool().parallelFor(0, kLevels, 32, [&](size_t rowBegin, size_t rowEnd) {
+            for (size_t row = rowBegin; row < rowEnd; row++) {
+                const size_t cr = kLevels - 1 - row;
+                const uint32_t* src = bins.vectorscope.data() + cr * kLevels;
+                const uint8_t* tint = m_vectorscopeTint.data() + cr * kLevels * 3;
+                uint8_t* dst = result.vectorscope.rgba.data() + row * kLevels * 4;
+                for (uint32_t cb = 0; cb < kLevels; cb++) {
+                    uint32_t v = density(src[cb]);
+                    dst[cb * 4 + 0] = static_cast<uint8_t>(tint[cb * 3 + 0] * v / 255);
+                    dst[cb * 4 + 1] = static_cast<uint8_t>(tint[cb * 3 + 1] * v / 255);
+                    dst[cb * 4 + 2] = static_cast<uint8_t>(tint[cb * 3 + 2] * v / 255);
+                    dst[cb * 4 + 3] = 255;
+                }
+            }
+        });
+    }
+
+    // Histogram: filled luma in grey with R, G and B added on top, linear counts
+    {
+        const uint32_t peak = std::max(1u, maxOf(bins.histogram));
+        uint32_t heights[4][kLevels];
+        for (uint32_t channel = 0; channel < 4; channel++) {
+            for (uint32_t level = 0; level < kLevels; level++) {
+                uint64_t count = bins.histogram[channel * kLevels + level];
+                heights[channel][level] = static_cast<uint32_t>(count * kHistogramHeight / peak);
+            }
+        }
+        result.histogram.resize(kLevels, kHistogramHeight);
+        for (uint32_t row = 0; row < kHistogramHeight; row++) {
+            const uint32_t fromBottom = kHistogramHeight - 1 - row;
+            uint8_t* dst = result.histogram.rgba.data() + static_cast<size_t>(row) * kLevels * 4;
+            for (uint32_t level = 0; level < kLevels; level++) {
+                int base = fromBottom < heights[0][level] ? 70 : 0;
+                dst[level * 4 + 0] = clampByte(base + (fromBottom < heights[1][level] ? 170 : 0));
+                dst[level * 4 + 1] = clampByte(base + (fromBottom < heights[2][level] ? 170 : 0));
+                dst[level * 4 + 2] = clampByte(base + (fromBottom < heights[3][level] ? 170 : 0));
+                dst[level * 4 + 3] = 255;
+            }
+        }
+    }
+}
+
+ScopeWorker::ScopeWorker(ResultCallback onResult) : m_onResult(std::move(onResult)) {
+    m_thread = std::thread([this]() { workerLoop(); });
+}
+
+ScopeWorker::~ScopeWorker() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void ScopeWorker::setSettings(const ScopeSettings& settings) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pendingSettings = settings;
+    m_settingsChanged = true;
+}
+
+void ScopeWorker::submit(const ScopeFrame& frame, std::shared_ptr<const void> owner) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_hasPending) {
+            m_droppedFrames++;
+        }
+        m_pendingFrame = frame;
+        m_pendingOwner = std::move(owner);
+        m_hasPending = true;
+    }
+    m_condition.notify_one();
+}
+
+std::shared_ptr<const ScopeResult> ScopeWorker::latestResult() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_latest;
+}
+
+void ScopeWorker::workerLoop() {
+    for (;;) {
+        ScopeFrame frame;
+        std::shared_ptr<const void> owner;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_stopping || m_hasPending; });
+            if (m_stopping) {
+                return;
+            }
+            frame = m_pendingFrame;
+            owner = std::move(m_pendingOwner);
+            m_hasPending = false;
+            if (m_settingsChanged) {
+                m_engine.setSettings(m_pendingSettings);
+                m_settingsChanged = false;
+            }
+        }
+
+        // Reuse the image buffers of the result before last once nobody is drawing it
+        std::shared_ptr<ScopeResult> result;
+        if (m_spare && m_spare.use_count() == 1) {
+            result = std::move(m_spare);
+        } else {
+            result = std::make_shared<ScopeResult>();
+        }
+        bool ok = m_engine.analyze(frame, *result);
+        owner.reset();
+        if (!ok) {
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_spare = std::move(m_latest);
+            m_latest = std::move(result);
+        }
+        if (m_onResult) {
+            m_onResult();
+        }
+    }
+}
+
+} // namespace aether
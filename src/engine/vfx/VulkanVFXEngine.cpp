@@ -1,50 +1,574 @@
 #include "aether/VulkanVFXEngine.h"
+#include "aether/CpuEffectBackend.h"
+#include "aether/EffectChain.h"
+#include "aether/ParticleSystem.h"
+#include "aether/PipelineCache.h"
+#include "aether/ShaderLibrary.h"
+#include <vulkan/vulkan.h>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <iostream>
 
 namespace aether {
 
+struct VulkanVFXEngine::PendingPipelines {
+    std::shared_future<VkPipeline> blur;
+    std::shared_future<VkPipeline> colorCorrection;
+    std::shared_future<VkPipeline> pixelChain;
+};
+
+/**
+ * Per-frame descriptor sets, released by beginFrame(), and the pixel_chain table buffers. A
+ * buffer stays mapped and keeps its contents while dispatches ask for them; one a frame did
+ * not use becomes a spare for other contents, and a spare no frame took is freed.
+ */
+struct VulkanVFXEngine::FrameResources {
+    struct Buffer {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        void* mapped = nullptr;
+        VkDeviceSize capacity = 0;
+        std::vector<uint8_t> contents; // what the GPU reads, to match later requests against
+        bool used = false;             // by a dispatch since the last beginFrame()
+
+        void destroy(VkDevice device) {
+            vkDestroyBuffer(device, buffer, nullptr);
+            if (memory != VK_NULL_HANDLE) {
+                vkFreeMemory(device, memory, nullptr); // unmaps it too
+            }
+        }
+    };
+    std::vector<VkDescriptorPool> pools;
+    size_t activePool = 0;
+    std::vector<Buffer> buffers;
+    std::vector<Buffer> spares;
+};
+
+namespace {
+
+// Sets per descriptor pool; a frame that needs more opens another pool
+constexpr uint32_t kSetsPerPool = 64;
+// Smallest storage buffer allocated; sizes above it round up to a power of two so spares fit more requests
+constexpr VkDeviceSize kMinBufferCapacity = 4096;
+// Bits in pixel_chain.comp's lutStepMask
+constexpr size_t kMaxChainSteps = 32;
+
+bool isReady(const std::shared_future<VkPipeline>& future) {
+    return !future.valid() || future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+VkDescriptorSetLayout createSetLayout(VkDevice device, const VkDescriptorType* types, uint32_t count) {
+    std::vector<VkDescriptorSetLayoutBinding> bindings(count);
+    for (uint32_t i = 0; i < count; i++) {
+        bindings[i] = {};
+        bindings[i].binding = i;
+        bindings[i].descriptorType = types[i];
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    VkDescriptorSetLayoutCreateInfo setLayoutInfo{};
+    setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutInfo.bindingCount = count;
+    setLayoutInfo.pBindings = bindings.data();
+
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    if (vkCreateDescriptorSetLayout(device, &setLayoutInfo, nullptr, &setLayout) != VK_SUCCESS) {
+        return VK_NULL_HANDLE;
+    }
+    return setLayout;
+}
+
+std::vector<uint32_t> copyCode(const EmbeddedShader* shader) {
+    return std::vector<uint32_t>(shader->code, shader->code + shader->wordCount);
+}
+
+VkPipelineLayout createComputeLayout(VkDevice device, VkDescriptorSetLayout setLayout, uint32_t pushConstantSize) {
+    VkPushConstantRange pushRange{};
+    pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushRange.offset = 0;
+    pushRange.size = pushConstantSize;
+
+    VkPipelineLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &setLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushRange;
+
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &layout) != VK_SUCCESS) {
+        return VK_NULL_HANDLE;
+    }
+    return layout;
+}
+
+VkDescriptorPool createDescriptorPool(VkDevice device) {
+    VkDescriptorPoolSize poolSizes[2] = {};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    poolSizes[0].descriptorCount = kSetsPerPool * 2;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[1].descriptorCount = kSetsPerPool * 2;
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = kSetsPerPool;
+    poolInfo.poolSizeCount = 2;
+    poolInfo.pPoolSizes = poolSizes;
+
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+        return VK_NULL_HANDLE;
+    }
+    return pool;
+}
+
+// Bindings 0/1 are the input/output images, 2.. the storage buffers
+void writeDescriptorSet(VkDevice device, VkDescriptorSet set, VkImageView input, VkImageView output,
+                        const VkBuffer* buffers, uint32_t bufferCount) {
+    VkDescriptorImageInfo images[2] = {};
+    images[0].imageView = input;
+    images[0].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    images[1].imageView = output;
+    images[1].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    std::vector<VkDescriptorBufferInfo> bufferInfos(bufferCount);
+    std::vector<VkWriteDescriptorSet> writes(2 + bufferCount);
+    for (uint32_t i = 0; i < writes.size(); i++) {
+        writes[i] = {};
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = set;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        if (i < 2) {
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            writes[i].pImageInfo = &images[i];
+        } else {
+            bufferInfos[i - 2].buffer = buffers[i - 2];
+            bufferInfos[i - 2].offset = 0;
+            bufferInfos[i - 2].range = VK_WHOLE_SIZE;
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[i].pBufferInfo = &bufferInfos[i - 2];
+        }
+    }
+    vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+// Every shader's push constants end with { int originX, originY, endX, endY }: the region to compute
+void recordDispatch(VkCommandBuffer commandBuffer, VkPipeline pipeline, VkPipelineLayout layout, VkDescriptorSet set,
+                    const void* pushConstants, uint32_t pushConstantSize, uint32_t x, uint32_t y, uint32_t width,
+                    uint32_t height) {
+    const int32_t region[4] = {static_cast<int32_t>(x), static_cast<int32_t>(y), static_cast<int32_t>(x + width),
+                               static_cast<int32_t>(y + height)};
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0, 1, &set, 0, nullptr);
+    vkCmdPushConstants(commandBuffer, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, pushConstantSize, pushConstants);
+    vkCmdPushConstants(commandBuffer, layout, VK_SHADER_STAGE_COMPUTE_BIT, pushConstantSize, sizeof(region), region);
+    // All shaders use 8x8 workgroups
+    vkCmdDispatch(commandBuffer, (width + 7) / 8, (height + 7) / 8, 1);
+
+    // The next pass may read this output, or overwrite the image this pass read
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+} // namespace
+
 VulkanVFXEngine::VulkanVFXEngine() = default;
 
 VulkanVFXEngine::~VulkanVFXEngine() {
     shutdown();
 }
 
-bool VulkanVFXEngine::initialize(void* vulkanInstance, void* physicalDevice, void* device) {
+bool VulkanVFXEngine::initialize(void* vulkanInstance, void* physicalDevice, void* device, PipelineCache* sharedCache) {
     if (m_initialized) return true;
     (void)vulkanInstance;
-    (void)physicalDevice;
+    m_physicalDevice = physicalDevice;
     m_device = device;
+    if (sharedCache != nullptr) {
+        m_pipelineCache = sharedCache;
+    } else if (device != nullptr && physicalDevice != nullptr) {
+        m_ownedPipelineCache = std::make_unique<PipelineCache>();
+        if (m_ownedPipelineCache->initialize(static_cast<VkPhysicalDevice>(physicalDevice), static_cast<VkDevice>(device))) {
+            m_pipelineCache = m_ownedPipelineCache.get();
+        } else {
+            m_ownedPipelineCache.reset();
+        }
+    }
     m_initialized = createComputePipelines();
     return m_initialized;
 }
 
 void VulkanVFXEngine::shutdown() {
+    VkDevice device = static_cast<VkDevice>(m_device);
+    if (device != VK_NULL_HANDLE) {
+        collectPipelines(true);
+        beginFrame();
+        if (m_frame) {
+            for (VkDescriptorPool pool : m_frame->pools) {
+                vkDestroyDescriptorPool(device, pool, nullptr);
+            }
+            for (FrameResources::Buffer& buffer : m_frame->buffers) {
+                buffer.destroy(device);
+            }
+            for (FrameResources::Buffer& buffer : m_frame->spares) {
+                buffer.destroy(device);
+            }
+        }
+        vkDestroyPipeline(device, static_cast<VkPipeline>(m_blurPipeline), nullptr);
+        vkDestroyPipeline(device, static_cast<VkPipeline>(m_colorCorrectionPipeline), nullptr);
+        vkDestroyPipeline(device, static_cast<VkPipeline>(m_pixelChainPipeline), nullptr);
+        vkDestroyPipelineLayout(device, static_cast<VkPipelineLayout>(m_blurLayout), nullptr);
+        vkDestroyPipelineLayout(device, static_cast<VkPipelineLayout>(m_colorCorrectionLayout), nullptr);
+        vkDestroyPipelineLayout(device, static_cast<VkPipelineLayout>(m_pixelChainLayout), nullptr);
+        vkDestroyDescriptorSetLayout(device, static_cast<VkDescriptorSetLayout>(m_descriptorSetLayout), nullptr);
+        vkDestroyDescriptorSetLayout(device, static_cast<VkDescriptorSetLayout>(m_pixelChainSetLayout), nullptr);
+    }
+    // A shared cache is saved by its owner
+    if (m_ownedPipelineCache) {
+        m_ownedPipelineCache->shutdown();
+        m_ownedPipelineCache.reset();
+    }
+    m_pipelineCache = nullptr;
+    m_pending.reset();
+    m_frame.reset();
     m_blurPipeline = nullptr;
     m_colorCorrectionPipeline = nullptr;
     m_particlesPipeline = nullptr;
+    m_pixelChainPipeline = nullptr;
+    m_blurLayout = nullptr;
+    m_colorCorrectionLayout = nullptr;
+    m_pixelChainLayout = nullptr;
+    m_descriptorSetLayout = nullptr;
+    m_pixelChainSetLayout = nullptr;
     m_device = nullptr;
+    m_physicalDevice = nullptr;
     m_initialized = false;
 }
 
-void VulkanVFXEngine::dispatchBlur(uint32_t width, uint32_t height, float radius) {
-    (void)width;
-    (void)height;
-    (void)radius;
-    if (!m_initialized || !m_blurPipeline) return;
+void VulkanVFXEngine::beginFrame() {
+    VkDevice device = static_cast<VkDevice>(m_device);
+    if (device == VK_NULL_HANDLE || !m_frame) {
+        return;
+    }
+    for (VkDescriptorPool pool : m_frame->pools) {
+        vkResetDescriptorPool(device, pool, 0);
+    }
+    m_frame->activePool = 0;
+    // The GPU is done with the last frame, so buffers it did not use can take other contents
+    for (FrameResources::Buffer& buffer : m_frame->spares) {
+        buffer.destroy(device);
+    }
+    m_frame->spares.clear();
+    std::vector<FrameResources::Buffer> kept;
+    for (FrameResources::Buffer& buffer : m_frame->buffers) {
+        std::vector<FrameResources::Buffer>& list = buffer.used ? kept : m_frame->spares;
+        buffer.used = false;
+        list.push_back(std::move(buffer));
+    }
+    m_frame->buffers = std::move(kept);
+}
+
+void* VulkanVFXEngine::allocateDescriptorSet(void* setLayout) {
+    VkDevice device = static_cast<VkDevice>(m_device);
+    VkDescriptorSetLayout layout = static_cast<VkDescriptorSetLayout>(setLayout);
+    if (!m_frame) {
+        m_frame = std::make_unique<FrameResources>();
+    }
+    while (true) {
+        if (m_frame->activePool == m_frame->pools.size()) {
+            VkDescriptorPool pool = createDescriptorPool(device);
+            if (pool == VK_NULL_HANDLE) {
+                std::cerr << "VFX: failed to create descriptor pool" << std::endl;
+                return nullptr;
+            }
+            m_frame->pools.push_back(pool);
+        }
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = m_frame->pools[m_frame->activePool];
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &layout;
+
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        VkResult result = vkAllocateDescriptorSets(device, &allocInfo, &set);
+        if (result == VK_SUCCESS) {
+            return set;
+        }
+        if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) {
+            std::cerr << "VFX: failed to allocate descriptor set" << std::endl;
+            return nullptr;
+        }
+        m_frame->activePool++;
+    }
+}
+
+void* VulkanVFXEngine::createStorageBuffer(const void* data, size_t size) {
+    VkDevice device = static_cast<VkDevice>(m_device);
+    VkPhysicalDevice physicalDevice = static_cast<VkPhysicalDevice>(m_physicalDevice);
+    if (!m_frame) {
+        m_frame = std::make_unique<FrameResources>();
+    }
+
+    // Tables and LUTs mostly stay the same from frame to frame
+    for (FrameResources::Buffer& buffer : m_frame->buffers) {
+        if (buffer.contents.size() == size && std::memcmp(buffer.contents.data(), data, size) == 0) {
+            buffer.used = true;
+            return buffer.buffer;
+        }
+    }
+
+    // The smallest spare that fits, otherwise a new buffer
+    auto best = m_frame->spares.end();
+    for (auto it = m_frame->spares.begin(); it != m_frame->spares.end(); ++it) {
+        if (it->capacity >= size && (best == m_frame->spares.end() || it->capacity < best->capacity)) {
+            best = it;
+        }
+    }
+    FrameResources::Buffer buffer;
+    if (best != m_frame->spares.end()) {
+        buffer = std::move(*best);
+        m_frame->spares.erase(best);
+    } else {
+        buffer.capacity = kMinBufferCapacity;
+        while (buffer.capacity < size) {
+            buffer.capacity *= 2;
+        }
+
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = buffer.capacity;
+        bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer.buffer) != VK_SUCCESS) {
+            std::cerr << "VFX: failed to create storage buffer" << std::endl;
+            return nullptr;
+        }
+
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(device, buffer.buffer, &requirements);
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+        const VkMemoryPropertyFlags wanted = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        uint32_t memoryType = UINT32_MAX;
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+            if ((requirements.memoryTypeBits & (1u << i)) &&
+                (memoryProperties.memoryTypes[i].propertyFlags & wanted) == wanted) {
+                memoryType = i;
+                break;
+            }
+        }
+
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = requirements.size;
+        allocInfo.memoryTypeIndex = memoryType;
+        if (memoryType == UINT32_MAX ||
+            vkAllocateMemory(device, &allocInfo, nullptr, &buffer.memory) != VK_SUCCESS ||
+            vkBindBufferMemory(device, buffer.buffer, buffer.memory, 0) != VK_SUCCESS ||
+            vkMapMemory(device, buffer.memory, 0, VK_WHOLE_SIZE, 0, &buffer.mapped) != VK_SUCCESS) {
+            std::cerr << "VFX: failed to allocate storage buffer memory" << std::endl;
+            buffer.destroy(device);
+            return nullptr;
+        }
+    }
+    std::memcpy(buffer.mapped, data, size);
+    buffer.contents.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+    buffer.used = true;
+    m_frame->buffers.push_back(std::move(buffer));
+    return m_frame->buffers.back().buffer;
 }
 
-void VulkanVFXEngine::dispatchColorCorrection(uint32_t width, uint32_t height) {
-    (void)width;
-    (void)height;
-    if (!m_initialized || !m_colorCorrectionPipeline) return;
+bool VulkanVFXEngine::dispatchBlur(void* commandBuffer, void* input, void* output, uint32_t x, uint32_t y,
+                                   uint32_t width, uint32_t height, float radius) {
+    collectPipelines(false);
+    if (!m_initialized || !m_blurPipeline) return false;
+
+    VkDescriptorSet set = static_cast<VkDescriptorSet>(allocateDescriptorSet(m_descriptorSetLayout));
+    if (set == VK_NULL_HANDLE) return false;
+    writeDescriptorSet(static_cast<VkDevice>(m_device), set, static_cast<VkImageView>(input),
+                       static_cast<VkImageView>(output), nullptr, 0);
+    recordDispatch(static_cast<VkCommandBuffer>(commandBuffer), static_cast<VkPipeline>(m_blurPipeline),
+                   static_cast<VkPipelineLayout>(m_blurLayout), set, &radius, sizeof(radius), x, y, width,
+                   height);
+    return true;
+}
+
+bool VulkanVFXEngine::dispatchColorCorrection(void* commandBuffer, void* input, void* output, uint32_t x, uint32_t y,
+                                              uint32_t width, uint32_t height, const std::vector<float>& pushConstants) {
+    collectPipelines(false);
+    if (!m_initialized || !m_colorCorrectionPipeline) return false;
+
+    // { vec4 lift; vec4 gamma; vec4 gain }
+    float push[12];
+    CpuEffectBackend::unpackColorCorrection(pushConstants, push, push + 4, push + 8);
+
+    VkDescriptorSet set = static_cast<VkDescriptorSet>(allocateDescriptorSet(m_descriptorSetLayout));
+    if (set == VK_NULL_HANDLE) return false;
+    writeDescriptorSet(static_cast<VkDevice>(m_device), set, static_cast<VkImageView>(input),
+                       static_cast<VkImageView>(output), nullptr, 0);
+    recordDispatch(static_cast<VkCommandBuffer>(commandBuffer), static_cast<VkPipeline>(m_colorCorrectionPipeline),
+                   static_cast<VkPipelineLayout>(m_colorCorrectionLayout), set, push, sizeof(push), x, y, width,
+                   height);
+    return true;
+}
+
+bool VulkanVFXEngine::canDispatchPixelChain(const FusedPixelKernel& kernel) {
+    if (kernel.steps.size() > kMaxChainSteps) {
+        return false;
+    }
+    uint32_t lutSize = 0;
+    for (const auto& step : kernel.steps) {
+        if (step.type != FusedPixelKernel::StepType::Lut3D) {
+            continue;
+        }
+        if (step.lut.size() != static_cast<size_t>(step.lutSize) * step.lutSize * step.lutSize * 3 ||
+            (lutSize != 0 && step.lutSize != lutSize)) {
+            return false;
+        }
+        lutSize = step.lutSize;
+    }
+    return true;
+}
+
+bool VulkanVFXEngine::dispatchPixelChain(void* commandBuffer, void* input, void* output, uint32_t x, uint32_t y,
+                                         uint32_t width, uint32_t height, const FusedPixelKernel& kernel) {
+    collectPipelines(false);
+    if (!m_initialized || !m_pixelChainPipeline || !canDispatchPixelChain(kernel)) return false;
+
+    // { uint stepCount; uint lutStepMask; uint lutSize }
+    uint32_t push[3] = {static_cast<uint32_t>(kernel.steps.size()), 0, 0};
+    std::vector<float> luts;
+    for (size_t i = 0; i < kernel.steps.size(); i++) {
+        const auto& step = kernel.steps[i];
+        if (step.type == FusedPixelKernel::StepType::Lut3D) {
+            push[1] |= 1u << i;
+            push[2] = step.lutSize;
+            luts.insert(luts.end(), step.lut.begin(), step.lut.end());
+        }
+    }
+    std::vector<uint32_t> tables = EffectChainCompiler::packGpuTables(kernel);
+    // Storage buffers cannot be empty; an unused binding gets one placeholder element
+    if (tables.empty()) tables.push_back(0);
+    if (luts.empty()) luts.push_back(0.0f);
+
+    VkBuffer buffers[2] = {
+        static_cast<VkBuffer>(createStorageBuffer(tables.data(), tables.size() * sizeof(uint32_t))),
+        static_cast<VkBuffer>(createStorageBuffer(luts.data(), luts.size() * sizeof(float)))};
+    if (buffers[0] == VK_NULL_HANDLE || buffers[1] == VK_NULL_HANDLE) return false;
+
+    VkDescriptorSet set = static_cast<VkDescriptorSet>(allocateDescriptorSet(m_pixelChainSetLayout));
+    if (set == VK_NULL_HANDLE) return false;
+    writeDescriptorSet(static_cast<VkDevice>(m_device), set, static_cast<VkImageView>(input),
+                       static_cast<VkImageView>(output), buffers, 2);
+    recordDispatch(static_cast<VkCommandBuffer>(commandBuffer), static_cast<VkPipeline>(m_pixelChainPipeline),
+                   static_cast<VkPipelineLayout>(m_pixelChainLayout), set, push, sizeof(push), x, y, width,
+                   height);
+    return true;
 }
 
 void VulkanVFXEngine::dispatchParticles(uint32_t count, float deltaTime) {
-    (void)count;
-    (void)deltaTime;
-    if (!m_initialized || !m_particlesPipeline) return;
+    // No particle compute shader yet: the SoA simulation runs on the CPU thread pool
+    ParticleSystem& particles = getParticleSystem();
+    if (particles.getCapacity() < count) {
+        particles.setCapacity(count);
+    }
+    if (particles.getAliveCount() < count) {
+        particles.emit(count - particles.getAliveCount());
+    }
+    particles.update(deltaTime);
+}
+
+ParticleSystem& VulkanVFXEngine::getParticleSystem() {
+    if (!m_particles) {
+        m_particles = std::make_unique<ParticleSystem>(0);
+    }
+    return *m_particles;
+}
+
+bool VulkanVFXEngine::arePipelinesReady() {
+    collectPipelines(false);
+    return !m_pending;
+}
+
+void VulkanVFXEngine::waitForPipelines() {
+    collectPipelines(true);
+}
+
+void VulkanVFXEngine::collectPipelines(bool wait) {
+    if (!m_pending) {
+        return;
+    }
+    if (!wait && !(isReady(m_pending->blur) && isReady(m_pending->colorCorrection) &&
+                   isReady(m_pending->pixelChain))) {
+        return;
+    }
+    if (m_pending->blur.valid()) {
+        m_blurPipeline = m_pending->blur.get();
+    }
+    if (m_pending->colorCorrection.valid()) {
+        m_colorCorrectionPipeline = m_pending->colorCorrection.get();
+    }
+    if (m_pending->pixelChain.valid()) {
+        m_pixelChainPipeline = m_pending->pixelChain.get();
+    }
+    m_pending.reset();
 }
 
 bool VulkanVFXEngine::createComputePipelines() {
+    VkDevice device = static_cast<VkDevice>(m_device);
+    if (device == VK_NULL_HANDLE || !m_pipelineCache) {
+        // No device yet: dispatches stay no-ops
+        return true;
+    }
+
+    const EmbeddedShader* blur = findEmbeddedShader("blur");
+    const EmbeddedShader* colorCorrection = findEmbeddedShader("color_correction");
+    if (!blur || !colorCorrection) {
+        std::cerr << "VFX: compute shaders were not embedded at build time; GPU effects disabled" << std::endl;
+        return true;
+    }
+
+    // All shaders read binding 0 and write binding 1 as rgba8 storage images;
+    // pixel_chain also reads its tables and LUTs from two storage buffers
+    const VkDescriptorType imageTypes[] = {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE};
+    const VkDescriptorType chainTypes[] = {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                                           VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER};
+    VkDescriptorSetLayout setLayout = createSetLayout(device, imageTypes, 2);
+    VkDescriptorSetLayout chainSetLayout = createSetLayout(device, chainTypes, 4);
+    m_descriptorSetLayout = setLayout;
+    m_pixelChainSetLayout = chainSetLayout;
+    if (setLayout == VK_NULL_HANDLE || chainSetLayout == VK_NULL_HANDLE) {
+        std::cerr << "VFX: failed to create descriptor set layout" << std::endl;
+        return false;
+    }
+
+    // Push-constant sizes: blur { float radius }, color_correction { vec4 lift, gamma, gain },
+    // pixel_chain { uint stepCount, lutStepMask, lutSize }, each followed by { int originX, originY, endX, endY }
+    const uint32_t regionSize = 4 * sizeof(int32_t);
+    VkPipelineLayout blurLayout = createComputeLayout(device, setLayout, sizeof(float) + regionSize);
+    VkPipelineLayout colorLayout = createComputeLayout(device, setLayout, 3 * 4 * sizeof(float) + regionSize);
+    VkPipelineLayout chainLayout = createComputeLayout(device, chainSetLayout, 3 * sizeof(uint32_t) + regionSize);
+    m_blurLayout = blurLayout;
+    m_colorCorrectionLayout = colorLayout;
+    m_pixelChainLayout = chainLayout;
+    if (blurLayout == VK_NULL_HANDLE || colorLayout == VK_NULL_HANDLE || chainLayout == VK_NULL_HANDLE) {
+        std::cerr << "VFX: failed to create pipeline layouts" << std::endl;
+        return false;
+    }
+
+    m_pending = std::make_unique<PendingPipelines>();
+    m_pending->blur = m_pipelineCache->createComputePipelineAsync(copyCode(blur), blurLayout);
+    m_pending->colorCorrection = m_pipelineCache->createComputePipelineAsync(copyCode(colorCorrection), colorLayout);
+    if (const EmbeddedShader* pixelChain = findEmbeddedShader("pixel_chain")) {
+        m_pending->pixelChain = m_pipelineCache->createComputePipelineAsync(copyCode(pixelChain), chainLayout);
+    }
     return true;
 }
 
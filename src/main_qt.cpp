@@ -6,12 +6,15 @@
 #include <vulkan/vulkan.h>
 
 #include <QApplication>
+#include <QCoreApplication>
 #include <QMessageBox>
 #include <QString>
 #include <QDir>
 
 #include "qt/MainWindow.h"
 #include "aether/LicenseManager.h"
+#include "aether/AetherLink.h"
+#include "aether/DistributedExport.h"
 
 #include <optional>
 #include <string>
@@ -19,6 +22,7 @@
 #include <fstream>
 #include <sstream>
 #include <cstring>
+#include <iostream>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -248,13 +252,9 @@ std::optional<std::string> PreFlightCheck() {
     return std::nullopt;
 }
 
-} // namespace
-
-int main(int argc, char* argv[]) {
-    QApplication a(argc, argv);
-
 #ifdef _WIN32
-    // Add application directory to DLL search path so FFmpeg (and other) DLLs next to exe are found first
+// Add application directory to DLL search path so FFmpeg (and other) DLLs next to exe are found first
+void useAppDirForDlls() {
     QString appDir = QCoreApplication::applicationDirPath();
     if (!appDir.isEmpty()) {
         QByteArray path = appDir.toLocal8Bit();
@@ -262,6 +262,57 @@ int main(int argc, char* argv[]) {
             QDir::setCurrent(appDir);
         }
     }
+}
+#endif
+
+bool isRenderNode(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--render-node") == 0) return true;
+    }
+    return false;
+}
+
+// Headless render node: renders chunks of the master's exports until the process is stopped.
+int runRenderNode(QCoreApplication& app) {
+    const QStringList args = QCoreApplication::arguments();
+    const int nodeArg = args.indexOf(QStringLiteral("--render-node"));
+    const int slotsArg = args.indexOf(QStringLiteral("--slots"));
+    const QString master = nodeArg + 1 < args.size() ? args.at(nodeArg + 1) : QString();
+    const uint32_t workerSlots = slotsArg >= 0 && slotsArg + 1 < args.size() ? args.at(slotsArg + 1).toUInt() : 0;
+    const int colon = master.lastIndexOf(QLatin1Char(':'));
+    const QString host = colon > 0 ? master.left(colon) : master;
+    const uint16_t port = colon > 0 ? static_cast<uint16_t>(master.mid(colon + 1).toUInt()) : 8888;
+    if (host.isEmpty() || port == 0) {
+        std::cerr << "Usage: AetherStudioQt --render-node <host>[:port] [--slots N]" << std::endl;
+        return 1;
+    }
+
+    aether::AetherLink& link = aether::AetherLink::getInstance();
+    if (!link.initialize(aether::NodeRole::Worker, port)) return 1;
+    link.setWorkerSlots(workerSlots);
+    link.setRangeRenderer(&aether::DistributedExport::renderRange);
+    if (!link.startServer() || !link.connectToNode(host.toStdString(), port)) return 1;
+    const int result = app.exec();
+    link.shutdown();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    // Render nodes have no window: they run on a QCoreApplication, so they need no display,
+    // and skip the checks below
+    if (isRenderNode(argc, argv)) {
+        QCoreApplication app(argc, argv);
+#ifdef _WIN32
+        useAppDirForDlls();
+#endif
+        return runRenderNode(app);
+    }
+
+    QApplication a(argc, argv);
+#ifdef _WIN32
+    useAppDirForDlls();
 #endif
 
     std::optional<std::string> err = PreFlightCheck();
@@ -41,7 +41,14 @@ AnimationPageWidget::AnimationPageWidget(QWidget* parent)
     mainLayout->addWidget(split);
 }
 
-AnimationPageWidget::~AnimationPageWidget() = default;
+AnimationPageWidget::~AnimationPageWidget() {
+    // The view is a child widget and outlives m_nodeGraph; detach its model listener first
+    if (m_nodeGraphView) m_nodeGraphView->setModel(nullptr);
+}
+
+void AnimationPageWidget::modelsReloaded() {
+    m_keyframeTimeline->update();
+}
 
 void AnimationPageWidget::onNodeSelected(uint32_t nodeId) {
     buildDefaultParametersForNode(nodeId);
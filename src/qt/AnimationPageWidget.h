@@ -16,6 +16,11 @@ public:
     explicit AnimationPageWidget(QWidget* parent = nullptr);
     ~AnimationPageWidget() override;
 
+    NodeGraphModel* nodeGraph() const { return m_nodeGraph.get(); }
+    KeyframeModel* keyframeModel() const { return m_keyframeModel.get(); }
+    /** Repaints after the models were replaced wholesale (project load). */
+    void modelsReloaded();
+
 private slots:
     void onNodeSelected(uint32_t nodeId);
 
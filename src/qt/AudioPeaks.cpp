@@ -0,0 +1,450 @@
+#include "aether/AudioPeaks.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef AETHER_FFMPEG_ENABLED
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/avutil.h>
+}
+#endif
+
+namespace aether {
+
+namespace {
+
+constexpr uint32_t kPeakMagic = 0x4B504541; // "AEPK"
+constexpr uint32_t kPeakVersion = 1;
+constexpr int kMaxLevels = 16;
+constexpr qint64 kDiskBudgetBytes = 512LL * 1024 * 1024;
+// What an entry without a mapped file counts against the memory budget
+constexpr size_t kEmptyEntryBytes = 1024;
+// A QSaveFile temporary this old is left over from a write that never finished
+constexpr qint64 kStaleTempSecs = 10 * 60;
+
+// Little-endian on every platform we ship; the file is a cache, so a foreign one is just regenerated
+struct PeakFileHeader {
+    uint32_t magic = kPeakMagic;
+    uint32_t version = kPeakVersion;
+    uint32_t sampleRate = 0;
+    uint32_t channels = 0;
+    uint32_t baseSamplesPerBin = 0;
+    uint32_t levelCount = 0;
+    uint64_t totalSamples = 0;
+};
+struct PeakLevelHeader {
+    uint64_t offset = 0; // bytes from the start of the file
+    uint64_t count = 0;
+};
+static_assert(sizeof(PeakBin) == 6, "PeakBin is stored as-is in peak files");
+
+/** Folds sample frames into base-level bins as they are decoded. */
+struct BinAccumulator {
+    std::vector<PeakBin> bins;
+    float minValue = 1.0f;
+    float maxValue = -1.0f;
+    double sumSquares = 0.0;
+    int frames = 0;
+    int channels = 1;
+    qint64 totalSamples = 0;
+
+    void add(float v) {
+        minValue = std::min(minValue, v);
+        maxValue = std::max(maxValue, v);
+        sumSquares += static_cast<double>(v) * v;
+    }
+    void endFrame() {
+        totalSamples++;
+        if (++frames == AudioPeaks::kBaseSamplesPerBin) flush();
+    }
+    void flush() {
+        if (frames == 0) return;
+        auto quantize = [](double v) { return static_cast<int16_t>(std::lround(std::clamp(v, -1.0, 1.0) * 32767.0)); };
+        PeakBin bin;
+        bin.min = quantize(minValue);
+        bin.max = quantize(maxValue);
+        bin.rms = quantize(std::sqrt(sumSquares / (static_cast<double>(frames) * channels)));
+        bins.push_back(bin);
+        minValue = 1.0f;
+        maxValue = -1.0f;
+        sumSquares = 0.0;
+        frames = 0;
+    }
+};
+
+/** Merges a pyramid level into the next, kLevelFactor bins at a time. */
+std::vector<PeakBin> reduceLevel(const std::vector<PeakBin>& level) {
+    std::vector<PeakBin> next((level.size() + AudioPeaks::kLevelFactor - 1) / AudioPeaks::kLevelFactor);
+    for (size_t i = 0; i < next.size(); i++) {
+        const size_t from = i * AudioPeaks::kLevelFactor;
+        const size_t to = std::min(level.size(), from + AudioPeaks::kLevelFactor);
+        int16_t lo = level[from].min, hi = level[from].max;
+        double sumSquares = 0.0;
+        for (size_t j = from; j < to; j++) {
+            lo = std::min(lo, level[j].min);
+            hi = std::max(hi, level[j].max);
+            sumSquares += static_cast<double>(level[j].rms) * level[j].rms;
+        }
+        next[i].min = lo;
+        next[i].max = hi;
+        next[i].rms = static_cast<int16_t>(std::lround(std::sqrt(sumSquares / static_cast<double>(to - from))));
+    }
+    return next;
+}
+
+bool writePeakFile(const QString& peakFile, int sampleRate, int channels, qint64 totalSamples,
+                   std::vector<PeakBin> base) {
+    std::vector<std::vector<PeakBin>> levels;
+    levels.push_back(std::move(base));
+    while (levels.back().size() > 1 && static_cast<int>(levels.size()) < kMaxLevels)
+        levels.push_back(reduceLevel(levels.back()));
+
+    PeakFileHeader header;
+    header.sampleRate = static_cast<uint32_t>(sampleRate);
+    header.channels = static_cast<uint32_t>(channels);
+    header.baseSamplesPerBin = AudioPeaks::kBaseSamplesPerBin;
+    header.levelCount = static_cast<uint32_t>(levels.size());
+    header.totalSamples = static_cast<uint64_t>(totalSamples);
+    std::vector<PeakLevelHeader> table(levels.size());
+    uint64_t offset = sizeof(PeakFileHeader) + sizeof(PeakLevelHeader) * table.size();
+    for (size_t i = 0; i < levels.size(); i++) {
+        table[i].offset = offset;
+        table[i].count = levels[i].size();
+        offset += levels[i].size() * sizeof(PeakBin);
+    }
+
+    QSaveFile file(peakFile);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(table.data()), static_cast<qint64>(table.size() * sizeof(PeakLevelHeader)));
+    for (const std::vector<PeakBin>& level : levels)
+        file.write(reinterpret_cast<const char*>(level.data()), static_cast<qint64>(level.size() * sizeof(PeakBin)));
+    return file.commit();
+}
+
+} // namespace
+
+// ---- Peak file ----
+
+std::shared_ptr<const AudioPeaks> AudioPeaks::open(const QString& peakFile) {
+    std::shared_ptr<AudioPeaks> peaks(new AudioPeaks());
+    peaks->m_file.setFileName(peakFile);
+    if (!peaks->m_file.open(QIODevice::ReadOnly)) return nullptr;
+    const qint64 size = peaks->m_file.size();
+    if (size < static_cast<qint64>(sizeof(PeakFileHeader))) return nullptr;
+    const uchar* data = peaks->m_file.map(0, size);
+    if (!data) return nullptr;
+
+    PeakFileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != kPeakMagic || header.version != kPeakVersion || header.sampleRate == 0
+        || header.baseSamplesPerBin == 0 || header.levelCount == 0 || header.levelCount > kMaxLevels)
+        return nullptr;
+    if (static_cast<qint64>(sizeof(PeakFileHeader) + sizeof(PeakLevelHeader) * header.levelCount) > size)
+        return nullptr;
+
+    qint64 samplesPerBin = header.baseSamplesPerBin;
+    for (uint32_t i = 0; i < header.levelCount; i++) {
+        PeakLevelHeader entry;
+        std::memcpy(&entry, data + sizeof(PeakFileHeader) + sizeof(PeakLevelHeader) * i, sizeof(entry));
+        if (entry.count == 0 || entry.offset % alignof(PeakBin) != 0
+            || entry.offset + entry.count * sizeof(PeakBin) > static_cast<uint64_t>(size))
+            return nullptr;
+        Level level;
+        level.bins = reinterpret_cast<const PeakBin*>(data + entry.offset);
+        level.count = static_cast<qint64>(entry.count);
+        level.samplesPerBin = samplesPerBin;
+        peaks->m_levels.push_back(level);
+        samplesPerBin *= kLevelFactor;
+    }
+    peaks->m_sampleRate = static_cast<int>(header.sampleRate);
+    peaks->m_channels = static_cast<int>(header.channels);
+    peaks->m_totalSamples = static_cast<qint64>(header.totalSamples);
+    peaks->m_mappedBytes = size;
+    return peaks;
+}
+
+void AudioPeaks::render(double startMs, double msPerPixel, int pixels, PeakBin* out) const {
+    if (pixels <= 0) return;
+    if (m_levels.empty() || msPerPixel <= 0.0) {
+        std::fill(out, out + pixels, PeakBin());
+        return;
+    }
+    const double samplesPerPixel = msPerPixel * m_sampleRate / 1000.0;
+    // Coarsest level with at least one bin per pixel: at most kLevelFactor bins are merged per pixel
+    size_t index = 0;
+    while (index + 1 < m_levels.size() && static_cast<double>(m_levels[index + 1].samplesPerBin) <= samplesPerPixel)
+        index++;
+    const Level& level = m_levels[index];
+    const double binsPerPixel = samplesPerPixel / static_cast<double>(level.samplesPerBin);
+    const double firstBin = startMs * m_sampleRate / 1000.0 / static_cast<double>(level.samplesPerBin);
+
+    for (int x = 0; x < pixels; x++) {
+        const double position = firstBin + x * binsPerPixel;
+        const qint64 from = static_cast<qint64>(std::floor(position));
+        const qint64 to = std::max(from + 1, static_cast<qint64>(std::floor(position + binsPerPixel)));
+        PeakBin& bin = out[x];
+        if (to <= 0 || from >= level.count) {
+            bin = PeakBin();
+            continue;
+        }
+        const qint64 a = std::max<qint64>(0, from);
+        const qint64 b = std::min(level.count, to);
+        int16_t lo = level.bins[a].min, hi = level.bins[a].max;
+        double sumSquares = 0.0;
+        for (qint64 i = a; i < b; i++) {
+            lo = std::min(lo, level.bins[i].min);
+            hi = std::max(hi, level.bins[i].max);
+            sumSquares += static_cast<double>(level.bins[i].rms) * level.bins[i].rms;
+        }
+        bin.min = lo;
+        bin.max = hi;
+        bin.rms = static_cast<int16_t>(std::lround(std::sqrt(sumSquares / static_cast<double>(b - a))));
+    }
+}
+
+// ---- Generation ----
+
+#ifdef AETHER_FFMPEG_ENABLED
+namespace {
+
+float sampleAt(const AVFrame* frame, int channel, int channels, int index) {
+    const AVSampleFormat format = static_cast<AVSampleFormat>(frame->format);
+    const bool planar = av_sample_fmt_is_planar(format);
+    const uint8_t* base = planar ? frame->extended_data[channel] : frame->extended_data[0];
+    const int i = planar ? index : index * channels + channel;
+    switch (av_get_packed_sample_fmt(format)) {
+    case AV_SAMPLE_FMT_U8: return (reinterpret_cast<const uint8_t*>(base)[i] - 128) / 128.0f;
+    case AV_SAMPLE_FMT_S16: return reinterpret_cast<const int16_t*>(base)[i] / 32768.0f;
+    case AV_SAMPLE_FMT_S32: return static_cast<float>(reinterpret_cast<const int32_t*>(base)[i] / 2147483648.0);
+    case AV_SAMPLE_FMT_S64: return static_cast<float>(reinterpret_cast<const int64_t*>(base)[i] / 9223372036854775808.0);
+    case AV_SAMPLE_FMT_FLT: return reinterpret_cast<const float*>(base)[i];
+    case AV_SAMPLE_FMT_DBL: return static_cast<float>(reinterpret_cast<const double*>(base)[i]);
+    default: return 0.0f;
+    }
+}
+
+void accumulateFrame(const AVFrame* frame, BinAccumulator& acc) {
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 24, 100)
+    const int channels = frame->ch_layout.nb_channels;
+#else
+    const int channels = frame->channels;
+#endif
+    if (channels <= 0) return;
+    // A mid-stream layout change keeps the bin's RMS normalised by the channel count it started with
+    if (acc.frames == 0) acc.channels = channels;
+    for (int s = 0; s < frame->nb_samples; s++) {
+        for (int c = 0; c < channels; c++) acc.add(sampleAt(frame, c, channels, s));
+        acc.endFrame();
+    }
+}
+
+} // namespace
+
+bool AudioPeaks::generate(const QString& mediaPath, const QString& peakFile, const std::atomic<bool>* cancel) {
+    AVFormatContext* fmt = nullptr;
+    if (avformat_open_input(&fmt, mediaPath.toUtf8().constData(), nullptr, nullptr) < 0) return false;
+    if (avformat_find_stream_info(fmt, nullptr) < 0) {
+        avformat_close_input(&fmt);
+        return false;
+    }
+    const int stream = av_find_best_stream(fmt, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+    if (stream < 0) {
+        avformat_close_input(&fmt);
+        return false;
+    }
+    AVStream* st = fmt->streams[stream];
+    const AVCodec* dec = avcodec_find_decoder(st->codecpar->codec_id);
+    AVCodecContext* codec = dec ? avcodec_alloc_context3(dec) : nullptr;
+    if (!codec || avcodec_parameters_to_context(codec, st->codecpar) < 0 || avcodec_open2(codec, dec, nullptr) < 0) {
+        avcodec_free_context(&codec);
+        avformat_close_input(&fmt);
+        return false;
+    }
+    // Only the audio stream is demuxed; video packets are not even read into memory
+    for (unsigned i = 0; i < fmt->nb_streams; i++)
+        if (static_cast<int>(i) != stream) fmt->streams[i]->discard = AVDISCARD_ALL;
+
+    BinAccumulator acc;
+    AVFrame* frame = av_frame_alloc();
+    AVPacket* pkt = av_packet_alloc();
+    bool cancelled = false;
+    auto drain = [&]() {
+        while (avcodec_receive_frame(codec, frame) == 0) {
+            accumulateFrame(frame, acc);
+            av_frame_unref(frame);
+        }
+    };
+    while (av_read_frame(fmt, pkt) >= 0) {
+        if (cancel && cancel->load()) {
+            av_packet_unref(pkt);
+            cancelled = true;
+            break;
+        }
+        if (pkt->stream_index == stream && avcodec_send_packet(codec, pkt) >= 0) drain();
+        av_packet_unref(pkt);
+    }
+    if (!cancelled) {
+        avcodec_send_packet(codec, nullptr);
+        drain();
+        acc.flush();
+    }
+    const int sampleRate = codec->sample_rate;
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 24, 100)
+    const int channels = codec->ch_layout.nb_channels;
+#else
+    const int channels = codec->channels;
+#endif
+
+    av_packet_free(&pkt);
+    av_frame_free(&frame);
+    avcodec_free_context(&codec);
+    avformat_close_input(&fmt);
+    if (cancelled || acc.bins.empty() || sampleRate <= 0) return false;
+    return writePeakFile(peakFile, sampleRate, channels, acc.totalSamples, std::move(acc.bins));
+}
+#else
+bool AudioPeaks::generate(const QString&, const QString&, const std::atomic<bool>*) {
+    return false;
+}
+#endif
+
+// ---- Cache ----
+
+AudioPeakCache::AudioPeakCache(ReadyCallback onReady, const QString& diskDir, size_t memoryBudgetBytes)
+    : m_onReady(std::move(onReady)), m_diskDir(diskDir), m_memoryBudget(memoryBudgetBytes) {
+    QDir().mkpath(m_diskDir);
+    // One file at a time: decoding is sequential reads of whole files, which compete for the disk
+    m_thread = std::thread([this]() {
+        trimDisk(kDiskBudgetBytes);
+        workerLoop();
+    });
+}
+
+AudioPeakCache::~AudioPeakCache() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_queue.clear();
+    }
+    m_condition.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+std::shared_ptr<const AudioPeaks> AudioPeakCache::peaks(const QString& mediaPath) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(mediaPath);
+    if (it != m_entries.end()) {
+        m_lru.splice(m_lru.begin(), m_lru, it.value().lru);
+        return it.value().peaks;
+    }
+    store(mediaPath, nullptr);
+    // It may have been evicted while still queued
+    if (std::find(m_queue.begin(), m_queue.end(), mediaPath) == m_queue.end()) {
+        m_queue.push_back(mediaPath);
+        m_condition.notify_one();
+    }
+    return nullptr;
+}
+
+size_t AudioPeakCache::getMemoryBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_memoryBytes;
+}
+
+size_t AudioPeakCache::entryBytes(const Entry& entry) {
+    return entry.peaks ? static_cast<size_t>(entry.peaks->getMappedBytes()) : kEmptyEntryBytes;
+}
+
+void AudioPeakCache::store(const QString& mediaPath, std::shared_ptr<const AudioPeaks> peaks) {
+    auto existing = m_entries.find(mediaPath);
+    if (existing != m_entries.end()) {
+        m_memoryBytes -= entryBytes(existing.value());
+        m_lru.erase(existing.value().lru);
+        m_entries.erase(existing);
+    }
+    Entry entry;
+    m_lru.push_front(mediaPath);
+    entry.lru = m_lru.begin();
+    entry.peaks = std::move(peaks);
+    m_memoryBytes += entryBytes(entry);
+    m_entries.insert(mediaPath, entry);
+
+    // An evicted file is mapped again, or queued again, the next time it is drawn
+    while (m_memoryBytes > m_memoryBudget && m_lru.size() > 1) {
+        auto it = m_entries.find(m_lru.back());
+        m_memoryBytes -= entryBytes(it.value());
+        m_entries.erase(it);
+        m_lru.pop_back();
+    }
+}
+
+QString AudioPeakCache::peakPath(const QString& mediaPath) const {
+    // Identity of the file's contents, so an edited or replaced file gets new peaks
+    const QFileInfo info(mediaPath);
+    if (!info.exists()) return QString();
+    const QString identity = info.canonicalFilePath() + QLatin1Char('|') + QString::number(info.size())
+                           + QLatin1Char('|') + QString::number(info.lastModified().toMSecsSinceEpoch());
+    const QByteArray hash = QCryptographicHash::hash(identity.toUtf8(), QCryptographicHash::Md5).toHex();
+    return m_diskDir + QLatin1Char('/') + QString::fromLatin1(hash) + QStringLiteral(".peaks");
+}
+
+void AudioPeakCache::workerLoop() {
+    for (;;) {
+        QString mediaPath;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+            if (m_stopping) return;
+            mediaPath = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        const QString file = peakPath(mediaPath);
+        std::shared_ptr<const AudioPeaks> peaks;
+        if (!file.isEmpty()) {
+            peaks = AudioPeaks::open(file);
+            if (peaks) {
+                // Mark it used so trimDisk keeps it
+                QFile touch(file);
+                if (touch.open(QIODevice::ReadWrite))
+                    touch.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+            } else if (AudioPeaks::generate(mediaPath, file, &m_stopping)) {
+                peaks = AudioPeaks::open(file);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopping) return;
+            // Failures stay in the table so a file without audio is not decoded on every paint
+            store(mediaPath, std::move(peaks));
+        }
+        if (m_onReady) m_onReady();
+    }
+}
+
+void AudioPeakCache::trimDisk(qint64 maxBytes) const {
+    // Newest first: keep until the budget is spent, delete the rest
+    const QDir dir(m_diskDir);
+    const QFileInfoList files = dir.entryInfoList({QStringLiteral("*.peaks")}, QDir::Files, QDir::Time);
+    qint64 total = 0;
+    for (const QFileInfo& f : files) {
+        total += f.size();
+        if (total > maxBytes) QFile::remove(f.filePath());
+    }
+    // QSaveFile temporaries of writes interrupted by a crash
+    const QDateTime staleBefore = QDateTime::currentDateTime().addSecs(-kStaleTempSecs);
+    for (const QFileInfo& f : dir.entryInfoList({QStringLiteral("*.peaks.*")}, QDir::Files)) {
+        if (f.lastModified() < staleBefore) QFile::remove(f.filePath());
+    }
+}
+
+} // namespace aether
@@ -0,0 +1,381 @@
+#include "aether/ChunkedExport.h"
+#include "aether/DistributedExport.h"
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <algorithm>
+#include <cmath>
+
+namespace aether {
+
+namespace {
+
+const QString kManifestName = QStringLiteral("manifest");
+
+/** What the chunks in a work directory were rendered for. */
+struct ChunkManifest {
+    int64_t chunkFrames = 0;
+    QByteArray jobHash;
+};
+
+bool readManifest(const QDir& dir, ChunkManifest& manifest) {
+    QFile file(dir.filePath(kManifestName));
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    for (const QByteArray& line : file.readAll().split('\n')) {
+        const qsizetype eq = line.indexOf('=');
+        if (eq < 0) continue;
+        const QByteArray key = line.left(eq);
+        const QByteArray value = line.mid(eq + 1).trimmed();
+        if (key == "chunkFrames") manifest.chunkFrames = value.toLongLong();
+        else if (key == "job") manifest.jobHash = value;
+    }
+    return manifest.chunkFrames > 0 && !manifest.jobHash.isEmpty();
+}
+
+bool writeManifest(const QDir& dir, const ChunkManifest& manifest) {
+    QSaveFile file(dir.filePath(kManifestName));
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.write("chunkFrames=" + QByteArray::number(static_cast<qlonglong>(manifest.chunkFrames)) + "\n");
+    file.write("job=" + manifest.jobHash + "\n");
+    return file.commit();
+}
+
+/** Chunk files of an earlier run, including partial ones. */
+void removeChunks(QDir dir) {
+    for (const QString& name : dir.entryList({QStringLiteral("chunk_*")}, QDir::Files)) dir.remove(name);
+}
+
+/** Where a chunk is written until it is complete; keeps the extension so the muxer is picked from it. */
+QString partialPath(const std::string& chunkPath) {
+    const QFileInfo info(QString::fromStdString(chunkPath));
+    return info.dir().filePath(info.completeBaseName() + QStringLiteral(".partial.") + info.suffix());
+}
+
+/** Adds the counters of one chunk engine's stages to a running total. */
+void accumulate(std::vector<ExportStageStats>& total, const std::vector<ExportStageStats>& stages) {
+    if (total.empty()) {
+        total = stages;
+        return;
+    }
+    for (size_t i = 0; i < total.size() && i < stages.size(); i++) {
+        total[i].frames += stages[i].frames;
+        total[i].busyMs += stages[i].busyMs;
+    }
+}
+
+} // namespace
+
+ChunkedExport::ChunkedExport() : m_backendFactory(createEncoderBackend) {}
+
+ChunkedExport::~ChunkedExport() {
+    cancel();
+    wait();
+}
+
+std::vector<ExportChunk> ChunkedExport::planChunks(int64_t totalFrames, const EncodeParams& params, uint32_t parallelChunks,
+                                                   double maxChunkSeconds, const std::string& workDir, int64_t fixedChunkFrames) {
+    const int64_t gop = params.gopSize > 0 ? params.gopSize : std::max<int64_t>(1, std::llround(params.fps * 2.0));
+    const int64_t maxFrames = std::max<int64_t>(gop, static_cast<int64_t>(maxChunkSeconds * params.fps) / gop * gop);
+    // Several chunks per worker, so the last few do not leave most of the workers idle
+    const int64_t perWorker = (totalFrames + 4 * std::max<uint32_t>(parallelChunks, 1) - 1) / (4 * std::max<uint32_t>(parallelChunks, 1));
+    const int64_t chunkFrames = fixedChunkFrames > 0 ? fixedChunkFrames
+                                                   : std::clamp((perWorker + gop - 1) / gop * gop, gop, maxFrames);
+
+    const QString suffix = QFileInfo(QString::fromStdString(params.outputPath)).suffix();
+    const QDir dir(QString::fromStdString(workDir));
+    std::vector<ExportChunk> chunks;
+    for (int64_t first = 0; first < totalFrames; first += chunkFrames) {
+        ExportChunk chunk;
+        chunk.firstFrame = first;
+        chunk.frameCount = std::min(chunkFrames, totalFrames - first);
+        chunk.path = dir.filePath(QStringLiteral("chunk_%1.%2").arg(chunks.size(), 5, 10, QChar('0')).arg(suffix)).toStdString();
+        chunks.push_back(std::move(chunk));
+    }
+    return chunks;
+}
+
+bool ChunkedExport::concatenate(const std::vector<ExportChunk>& chunks, const EncodeParams& params,
+                                const BackendFactory& backendFactory, std::string& error) {
+    std::unique_ptr<IEncoderBackend> backend = backendFactory ? backendFactory() : nullptr;
+    if (!backend) {
+        error = "No encoder";
+        return false;
+    }
+    if (!backend->open(params)) {
+        error = backend->getLastError();
+        backend->close();
+        return false;
+    }
+    // Every packet is copied, so the output can carry the chunks' own stream headers;
+    // chunks never adopt a source's headers, so they all share the first one's
+    if (!chunks.empty()) backend->useStreamHeaders(chunks.front().path);
+    // Large enough to reach the end of any chunk, which is what makes the whole file one span
+    constexpr int64_t kWholeFile = INT64_MAX / 4;
+    bool ok = true;
+    for (const ExportChunk& chunk : chunks) {
+        const CopySpan span = backend->findCopySpan(chunk.path, 0, kWholeFile);
+        if (span.isEmpty() || span.startMs != 0) {
+            error = "Chunk " + chunk.path + " does not match the output settings"
+                    + (span.rejection.empty() ? std::string() : ": " + span.rejection);
+            ok = false;
+            break;
+        }
+        if (!backend->copyPackets(chunk.path, span, chunk.firstFrame)) {
+            error = backend->getLastError();
+            ok = false;
+            break;
+        }
+    }
+    backend->close();
+    if (!ok) QFile::remove(QString::fromStdString(params.outputPath));
+    return ok;
+}
+
+std::string ChunkedExport::jobHash(const std::vector<uint8_t>& payload, int64_t totalFrames) {
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    hash.addData(QByteArray(reinterpret_cast<const char*>(payload.data()), static_cast<qsizetype>(payload.size())));
+    hash.addData(QByteArray::number(static_cast<qlonglong>(totalFrames)));
+    return hash.result().toHex().toStdString();
+}
+
+int64_t ChunkedExport::reusableChunkFrames(const std::string& workDir, const std::string& jobHash) {
+    ChunkManifest manifest;
+    if (!readManifest(QDir(QString::fromStdString(workDir)), manifest)) return 0;
+    return manifest.jobHash == QByteArray::fromStdString(jobHash) ? manifest.chunkFrames : 0;
+}
+
+bool ChunkedExport::resetWorkDir(const std::string& workDir, const std::string& jobHash, int64_t chunkFrames) {
+    const QDir dir(QString::fromStdString(workDir));
+    removeChunks(dir);
+    ChunkManifest manifest;
+    manifest.chunkFrames = chunkFrames;
+    manifest.jobHash = QByteArray::fromStdString(jobHash);
+    return writeManifest(dir, manifest);
+}
+
+void ChunkedExport::clearWorkDir(const std::string& workDir) {
+    QDir dir(QString::fromStdString(workDir));
+    removeChunks(dir);
+    dir.remove(kManifestName);
+}
+
+bool ChunkedExport::start(const ExportRequest& request, const std::string& workDir, uint32_t parallelChunks,
+                          FinishedCallback onFinished) {
+    if (m_running) {
+        m_lastError = "An export is already running";
+        return false;
+    }
+    wait();
+    m_lastError.clear();
+    const int64_t totalFrames = ExportEngine::frameCount(request);
+    if (totalFrames <= 0 || request.params.fps <= 0.0) {
+        m_lastError = "Nothing to export";
+        return false;
+    }
+    if (!QDir().mkpath(QString::fromStdString(workDir))) {
+        m_lastError = "Could not create " + workDir;
+        return false;
+    }
+
+    const uint32_t cores = std::max(1u, std::thread::hardware_concurrency());
+    m_parallel = parallelChunks > 0 ? parallelChunks : std::clamp(cores / 4, 1u, 8u);
+    m_request = request;
+    EncodeParams& params = m_request.params;
+    // Every chunk must be encoded alike for the joins to be seamless
+    if (params.gopSize == 0) params.gopSize = static_cast<uint32_t>(std::max(1.0, std::round(params.fps * 2.0)));
+    if (params.encoderThreads == 0) params.encoderThreads = std::max(1u, cores / m_parallel);
+    if (params.bitrateKbps > 0 && params.maxBitrateKbps == 0) {
+        params.maxBitrateKbps = params.bitrateKbps * 3 / 2;
+        params.bufferSizeKbits = params.bitrateKbps * 2;
+    }
+
+    // Chunks of an earlier run are only reused for the same job cut the same way
+    std::vector<uint8_t> payload;
+    if (!DistributedExport::encodePayload(m_request, payload, m_lastError)) {
+        return false;
+    }
+    const std::string hash = jobHash(payload, totalFrames);
+    int64_t chunkFrames = reusableChunkFrames(workDir, hash);
+    if (chunkFrames == 0 || (m_chunkFrames > 0 && chunkFrames != m_chunkFrames)) {
+        chunkFrames = planChunks(totalFrames, params, m_parallel, m_maxChunkSeconds, workDir, m_chunkFrames).front().frameCount;
+        if (!resetWorkDir(workDir, hash, chunkFrames)) {
+            m_lastError = "Could not write the manifest in " + workDir;
+            return false;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_workDir = workDir;
+    m_chunks = planChunks(totalFrames, params, m_parallel, m_maxChunkSeconds, workDir, chunkFrames);
+    m_reusedFrames = 0;
+    for (ExportChunk& chunk : m_chunks) {
+        chunk.done = QFile::exists(QString::fromStdString(chunk.path));
+        if (chunk.done) m_reusedFrames += chunk.frameCount;
+    }
+    m_engines.clear();
+    for (uint32_t i = 0; i < m_parallel; i++) m_engines.push_back(std::make_unique<ExportEngine>());
+    m_engineChunk.assign(m_parallel, -1);
+    m_finishedSlots.clear();
+    m_finishedStages.clear();
+    m_finishedFrames = 0;
+    m_copiedFrames = 0;
+    m_copyRejections.clear();
+    m_finished = false;
+    m_ok = false;
+    m_error.clear();
+    m_cancelled = false;
+    m_onFinished = std::move(onFinished);
+    m_startTime = std::chrono::steady_clock::now();
+    m_running = true;
+    m_thread = std::thread([this]() { run(); });
+    return true;
+}
+
+void ChunkedExport::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    size_t next = 0;
+    bool stopping = false;
+    for (;;) {
+        if (!stopping && (m_cancelled || !m_error.empty())) {
+            stopping = true;
+            for (size_t slot = 0; slot < m_engines.size(); slot++) {
+                if (m_engineChunk[slot] >= 0) m_engines[slot]->cancel();
+            }
+        }
+        for (size_t slot = 0; !stopping && slot < m_engines.size(); slot++) {
+            if (m_engineChunk[slot] >= 0) continue;
+            while (next < m_chunks.size() && m_chunks[next].done) next++;
+            if (next == m_chunks.size()) break;
+            const ExportChunk& chunk = m_chunks[next];
+            ExportRequest request = m_request;
+            request.startMs = m_request.startMs + std::llround(chunk.firstFrame * 1000.0 / m_request.params.fps);
+            request.endMs = -1;
+            request.frameCount = chunk.frameCount;
+            request.params.outputPath = partialPath(chunk.path).toStdString();
+            // The join gives the output one set of headers, the encoder's
+            request.adoptStreamHeaders = false;
+            // The chunk engines running at once share the export's node cache budget
+            request.nodeCacheBytes = m_request.nodeCacheBytes / std::max<size_t>(m_engines.size(), 1);
+            // The callback only reports; the slot is collected below, on this thread
+            const bool started = m_engines[slot]->start(request, m_backendFactory(), [this, slot](const ExportStats&) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_finishedSlots.push_back(static_cast<int>(slot));
+                m_condition.notify_all();
+            });
+            if (!started) {
+                if (m_error.empty()) m_error = m_engines[slot]->getLastError();
+                break;
+            }
+            m_engineChunk[slot] = static_cast<int>(next++);
+        }
+        if (std::none_of(m_engineChunk.begin(), m_engineChunk.end(), [](int c) { return c >= 0; })) {
+            if (stopping || !m_error.empty() || next == m_chunks.size()) break;
+            continue;
+        }
+        m_condition.wait(lock, [&]() { return !m_finishedSlots.empty() || (!stopping && m_cancelled); });
+
+        for (int slot : m_finishedSlots) {
+            ExportEngine& engine = *m_engines[slot];
+            engine.wait();
+            const ExportStats stats = engine.getStats();
+            accumulate(m_finishedStages, stats.stages);
+            for (const std::string& rejection : stats.copyRejections) {
+                if (std::find(m_copyRejections.begin(), m_copyRejections.end(), rejection) == m_copyRejections.end())
+                    m_copyRejections.push_back(rejection);
+            }
+            ExportChunk& chunk = m_chunks[m_engineChunk[slot]];
+            m_engineChunk[slot] = -1;
+            if (!stats.ok) {
+                if (m_error.empty() && !m_cancelled) m_error = stats.error;
+                continue;
+            }
+            const QString finalPath = QString::fromStdString(chunk.path);
+            QFile::remove(finalPath);
+            if (!QFile::rename(partialPath(chunk.path), finalPath)) {
+                if (m_error.empty()) m_error = "Could not finish " + chunk.path;
+                continue;
+            }
+            chunk.done = true;
+            m_finishedFrames += chunk.frameCount;
+            m_copiedFrames += stats.copiedFrames;
+        }
+        m_finishedSlots.clear();
+    }
+
+    const bool rendered = !m_cancelled && m_error.empty();
+    const std::vector<ExportChunk> chunks = m_chunks;
+    lock.unlock();
+
+    std::string error;
+    bool ok = false;
+    if (rendered) {
+        ok = concatenate(chunks, m_request.params, m_backendFactory, error);
+        // The chunks are only needed until the output exists
+        if (ok) clearWorkDir(m_workDir);
+    }
+
+    lock.lock();
+    if (rendered && !ok) m_error = error;
+    if (!ok && m_cancelled && m_error.empty()) m_error = "Export cancelled";
+    m_finished = true;
+    m_ok = ok;
+    m_finishedElapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_startTime).count();
+    lock.unlock();
+
+    const ExportStats result = getStats();
+    m_running = false;
+    if (m_onFinished) m_onFinished(result);
+}
+
+void ChunkedExport::cancel() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_running || m_finished) return;
+    m_cancelled = true;
+    m_condition.notify_all();
+}
+
+void ChunkedExport::wait() {
+    if (m_thread.joinable()) m_thread.join();
+}
+
+ExportStats ChunkedExport::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ExportStats s;
+    s.finished = m_finished;
+    s.ok = m_ok;
+    s.error = m_error;
+    s.elapsedMs = m_finished ? m_finishedElapsedMs
+                             : std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_startTime).count();
+    for (const ExportChunk& chunk : m_chunks) s.totalFrames += chunk.frameCount;
+    s.framesDone = m_reusedFrames + m_finishedFrames;
+    s.copiedFrames = m_copiedFrames;
+    s.copyRejections = m_copyRejections;
+    s.stages = m_finishedStages;
+    for (size_t slot = 0; slot < m_engines.size(); slot++) {
+        if (m_engineChunk[slot] < 0) continue;
+        const ExportStats chunk = m_engines[slot]->getStats();
+        s.framesDone += chunk.framesDone;
+        s.copiedFrames += chunk.copiedFrames;
+        accumulate(s.stages, chunk.stages);
+    }
+
+    const double seconds = s.elapsedMs / 1000.0;
+    // Reused chunks cost nothing this run, so they do not count towards its speed
+    s.fps = seconds > 0.0 ? (s.framesDone - m_reusedFrames) / seconds : 0.0;
+    for (ExportStageStats& stage : s.stages) {
+        stage.workers *= m_parallel;
+        stage.fps = seconds > 0.0 ? stage.frames / seconds : 0.0;
+        stage.utilisation = s.elapsedMs > 0.0 ? std::min(1.0, stage.busyMs / (s.elapsedMs * stage.workers)) : 0.0;
+    }
+    return s;
+}
+
+std::vector<ExportChunk> ChunkedExport::getChunks() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_chunks;
+}
+
+} // namespace aether
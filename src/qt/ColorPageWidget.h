@@ -12,6 +12,8 @@ class ColorPageWidget : public QWidget {
 public:
     explicit ColorPageWidget(QWidget* parent = nullptr);
 
+    VideoScopesWidget* scopes() const { return m_scopes; }
+
 private:
     ColorWheelsWidget* m_wheels = nullptr;
     VideoScopesWidget* m_scopes = nullptr;
@@ -4,9 +4,10 @@
 
 namespace aether {
 
-DeliverPageWidget::DeliverPageWidget(QWidget* parent) : QWidget(parent) {
+DeliverPageWidget::DeliverPageWidget(RenderQueue* queue, QWidget* parent) : QWidget(parent) {
     QVBoxLayout* layout = new QVBoxLayout(this);
-    layout->addWidget(new RenderQueueWidget(this), 1);
+    m_renderQueue = new RenderQueueWidget(queue, this);
+    layout->addWidget(m_renderQueue, 1);
 }
 
 } // namespace aether
@@ -4,10 +4,18 @@
 
 namespace aether {
 
+class RenderQueue;
+class RenderQueueWidget;
+
 class DeliverPageWidget : public QWidget {
     Q_OBJECT
 public:
-    explicit DeliverPageWidget(QWidget* parent = nullptr);
+    explicit DeliverPageWidget(RenderQueue* queue, QWidget* parent = nullptr);
+
+    RenderQueueWidget* renderQueue() const { return m_renderQueue; }
+
+private:
+    RenderQueueWidget* m_renderQueue = nullptr;
 };
 
 } // namespace aether
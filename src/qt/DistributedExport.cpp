@@ -0,0 +1,292 @@
+#include "aether/DistributedExport.h"
+#include "aether/KeyframeModel.h"
+#include "aether/NodeGraphModel.h"
+#include "ProjectModel.h"
+#include <QByteArray>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <cmath>
+
+namespace aether {
+
+namespace {
+
+constexpr quint32 kPayloadMagic = 0x58444541; // "AEDX"
+constexpr quint32 kPayloadVersion = 1;
+} // namespace
+
+DistributedExport::DistributedExport(AetherLink& link) : m_link(link), m_backendFactory(createEncoderBackend) {}
+
+DistributedExport::~DistributedExport() {
+    cancel();
+    wait();
+}
+
+bool DistributedExport::encodePayload(const ExportRequest& request, std::vector<uint8_t>& payload, std::string& error) {
+    // The project goes as a saved file, the format workers already read
+    QTemporaryDir dir;
+    const QString projectPath = dir.filePath(QStringLiteral("project.aeth"));
+    ProjectWriter writer;
+    if (!dir.isValid() || !writer.save(projectPath, request.project)) {
+        error = writer.getLastError().isEmpty() ? "Could not save the project for the workers" : writer.getLastError().toStdString();
+        return false;
+    }
+    QFile file(projectPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = "Could not read " + projectPath.toStdString();
+        return false;
+    }
+
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    const EncodeParams& params = request.params;
+    out << kPayloadMagic << kPayloadVersion
+        << QString::fromStdString(params.outputPath) << quint32(params.width) << quint32(params.height) << params.fps
+        << quint32(params.bitrateKbps) << quint32(params.maxBitrateKbps) << quint32(params.bufferSizeKbits)
+        << QString::fromStdString(params.codec) << quint32(params.gopSize)
+        << qint64(request.startMs) << request.smartRender << quint32(request.convertThreads) << quint32(request.queueDepth)
+        << file.readAll();
+    payload.assign(data.begin(), data.end());
+    return true;
+}
+
+bool DistributedExport::renderRange(const std::vector<uint8_t>& payload, int64_t firstFrame, int64_t frameCount,
+                                    const std::string& outputPath, const std::function<void(int64_t)>& progress,
+                                    const std::atomic<bool>& cancelled, std::string& error) {
+    QDataStream in(QByteArray(reinterpret_cast<const char*>(payload.data()), static_cast<qsizetype>(payload.size())));
+    quint32 magic = 0, version = 0, width = 0, height = 0, bitrate = 0, maxBitrate = 0, bufferSize = 0, gopSize = 0;
+    quint32 convertThreads = 0, queueDepth = 0;
+    QString outputName, codec;
+    qint64 startMs = 0;
+    ExportRequest request;
+    QByteArray project;
+    in >> magic >> version;
+    if (magic != kPayloadMagic || version != kPayloadVersion) {
+        error = "The master sent a job this version cannot render";
+        return false;
+    }
+    in >> outputName >> width >> height >> request.params.fps >> bitrate >> maxBitrate >> bufferSize >> codec >> gopSize
+       >> startMs >> request.smartRender >> convertThreads >> queueDepth >> project;
+    if (in.status() != QDataStream::Ok) {
+        error = "The job from the master is incomplete";
+        return false;
+    }
+    request.params.width = width;
+    request.params.height = height;
+    request.params.bitrateKbps = bitrate;
+    request.params.maxBitrateKbps = maxBitrate;
+    request.params.bufferSizeKbits = bufferSize;
+    request.params.codec = codec.toStdString();
+    request.params.gopSize = gopSize;
+    request.convertThreads = convertThreads;
+    request.queueDepth = queueDepth;
+    // This range, as ChunkedExport would render it as a chunk
+    request.startMs = startMs + std::llround(firstFrame * 1000.0 / request.params.fps);
+    request.endMs = -1;
+    request.frameCount = frameCount;
+    request.params.outputPath = outputPath;
+    request.adoptStreamHeaders = false;
+
+    QTemporaryDir dir;
+    QFile file(dir.filePath(QStringLiteral("project.aeth")));
+    if (!dir.isValid() || !file.open(QIODevice::WriteOnly) || file.write(project) != project.size()) {
+        error = "Could not store the job's project";
+        return false;
+    }
+    file.close();
+    ProjectModel model;
+    NodeGraphModel nodeGraph;
+    KeyframeModel keyframes;
+    QString projectName, saveLocation, loadError;
+    ProjectSettings settings;
+    if (!ProjectFile::loadProject(file.fileName(), model, &nodeGraph, &keyframes, &projectName, &saveLocation, &settings, &loadError)) {
+        error = "Could not read the job's project: " + loadError.toStdString();
+        return false;
+    }
+    request.project = ProjectFile::capture(model, &nodeGraph, &keyframes, projectName, saveLocation, settings);
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool finished = false;
+    ExportEngine engine;
+    if (!engine.start(request, createEncoderBackend(), [&](const ExportStats&) {
+            std::lock_guard<std::mutex> lock(mutex);
+            finished = true;
+            condition.notify_all();
+        })) {
+        error = engine.getLastError();
+        return false;
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        bool cancelling = false;
+        while (!condition.wait_for(lock, std::chrono::milliseconds(200), [&]() { return finished; })) {
+            progress(engine.getStats().framesDone);
+            if (cancelled && !cancelling) {
+                cancelling = true;
+                engine.cancel();
+            }
+        }
+    }
+    engine.wait();
+    const ExportStats stats = engine.getStats();
+    if (!stats.ok) {
+        error = stats.error;
+        return false;
+    }
+    progress(stats.framesDone);
+    return true;
+}
+
+bool DistributedExport::start(const ExportRequest& request, const std::string& workDir, FinishedCallback onFinished) {
+    if (m_running) {
+        m_lastError = "An export is already running";
+        return false;
+    }
+    wait();
+    m_lastError.clear();
+    const int64_t totalFrames = ExportEngine::frameCount(request);
+    if (totalFrames <= 0 || request.params.fps <= 0.0) {
+        m_lastError = "Nothing to export";
+        return false;
+    }
+    if (m_link.getRole() != NodeRole::Master || !m_link.isServerRunning()) {
+        m_lastError = "Aether Link is not running as a master";
+        return false;
+    }
+    if (!QDir().mkpath(QString::fromStdString(workDir))) {
+        m_lastError = "Could not create " + workDir;
+        return false;
+    }
+
+    // Encoded alike on every worker, as ChunkedExport encodes its chunks
+    ExportRequest shared = request;
+    EncodeParams& params = shared.params;
+    if (params.gopSize == 0) params.gopSize = static_cast<uint32_t>(std::max(1.0, std::round(params.fps * 2.0)));
+    params.encoderThreads = 0; // each worker's own machine decides
+    if (params.bitrateKbps > 0 && params.maxBitrateKbps == 0) {
+        params.maxBitrateKbps = params.bitrateKbps * 3 / 2;
+        params.bufferSizeKbits = params.bitrateKbps * 2;
+    }
+    uint32_t workerSlots = 0;
+    for (const NetworkNode& node : m_link.getConnectedNodes()) workerSlots += node.renderSlots;
+
+    RenderJob job;
+    if (!encodePayload(shared, job.payload, m_lastError)) {
+        return false;
+    }
+
+    // Chunks of an earlier run are only reused for the same job cut the same way
+    const std::string hash = ChunkedExport::jobHash(job.payload, totalFrames);
+    int64_t chunkFrames = ChunkedExport::reusableChunkFrames(workDir, hash);
+    if (chunkFrames == 0) {
+        chunkFrames = ChunkedExport::planChunks(totalFrames, params, std::max(workerSlots, 1u), m_maxChunkSeconds, workDir)
+                          .front().frameCount;
+        if (!ChunkedExport::resetWorkDir(workDir, hash, chunkFrames)) {
+            m_lastError = "Could not write the manifest in " + workDir;
+            return false;
+        }
+    }
+    const std::vector<ExportChunk> chunks = ChunkedExport::planChunks(totalFrames, params, std::max(workerSlots, 1u),
+                                                                      m_maxChunkSeconds, workDir, chunkFrames);
+    for (const ExportChunk& chunk : chunks) {
+        RenderRange range;
+        range.firstFrame = chunk.firstFrame;
+        range.frameCount = chunk.frameCount;
+        range.resultPath = chunk.path;
+        range.done = QFile::exists(QString::fromStdString(chunk.path));
+        job.ranges.push_back(std::move(range));
+    }
+    const std::string jobId = m_link.submitJob(job);
+    if (jobId.empty()) {
+        m_lastError = "Aether Link did not take the job";
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_params = params;
+        m_chunks = chunks;
+        m_workDir = workDir;
+        m_jobId = jobId;
+        m_cancelled = false;
+        m_finished = false;
+        m_result = ExportStats();
+    }
+    m_onFinished = std::move(onFinished);
+    m_startTime = std::chrono::steady_clock::now();
+    m_running = true;
+    m_thread = std::thread(&DistributedExport::run, this);
+    return true;
+}
+
+void DistributedExport::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    RenderJob job;
+    for (;;) {
+        if (m_cancelled) {
+            m_link.cancelJob(m_jobId);
+        }
+        job = m_link.getJobStatus(m_jobId);
+        if (job.status != JobStatus::Pending && job.status != JobStatus::Processing) break;
+        m_condition.wait_for(lock, std::chrono::milliseconds(200), [this]() { return m_cancelled; });
+    }
+    const std::vector<ExportChunk> chunks = m_chunks;
+    lock.unlock();
+
+    std::string error;
+    bool ok = false;
+    if (job.status == JobStatus::Completed) {
+        ok = ChunkedExport::concatenate(chunks, m_params, m_backendFactory, error);
+        // The chunks are only needed until the output exists
+        if (ok) ChunkedExport::clearWorkDir(m_workDir);
+    } else if (job.status == JobStatus::Failed) {
+        error = job.error;
+    } else {
+        error = "Export cancelled";
+    }
+
+    ExportStats result;
+    result.ok = ok;
+    result.finished = true;
+    result.error = error;
+    result.framesDone = job.framesDone;
+    for (const ExportChunk& chunk : chunks) result.totalFrames += chunk.frameCount;
+    result.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_startTime).count();
+    result.fps = job.fps;
+    lock.lock();
+    m_result = result;
+    m_finished = true;
+    lock.unlock();
+
+    m_running = false;
+    if (m_onFinished) m_onFinished(result);
+}
+
+void DistributedExport::cancel() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_running || m_finished) return;
+    m_cancelled = true;
+    m_condition.notify_all();
+}
+
+void DistributedExport::wait() {
+    if (m_thread.joinable()) m_thread.join();
+}
+
+ExportStats DistributedExport::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_finished) return m_result;
+    ExportStats s;
+    const RenderJob job = m_link.getJobStatus(m_jobId);
+    for (const ExportChunk& chunk : m_chunks) s.totalFrames += chunk.frameCount;
+    s.framesDone = job.framesDone;
+    s.fps = job.fps;
+    s.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_startTime).count();
+    return s;
+}
+
+} // namespace aether
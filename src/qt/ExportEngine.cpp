@@ -0,0 +1,782 @@
+#include "aether/ExportEngine.h"
+#include "aether/KeyframeModel.h"
+#include "aether/NodeGraphExecutor.h"
+#include "aether/NodeGraphModel.h"
+#include "aether/NodeResultCache.h"
+#include "ProjectModel.h"
+#include <QFile>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <map>
+#include <thread>
+
+#ifdef AETHER_FFMPEG_ENABLED
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/avutil.h>
+#include <libswscale/swscale.h>
+}
+#endif
+
+namespace aether {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * Bounded queue between two stages, keyed by frame index. pop() hands frames
+ * out strictly in order, so a stage with several workers may finish frames
+ * out of order and the next stage still sees them in sequence. push() blocks
+ * while the frame is more than capacity ahead of the consumer; the frame the
+ * consumer waits for always fits, so a full queue cannot deadlock.
+ */
+template <typename T>
+class StageQueue {
+public:
+    explicit StageQueue(int64_t capacity) : m_capacity(std::max<int64_t>(capacity, 1)) {}
+
+    /** Number of frames that will pass; set before any stage runs. */
+    void setEnd(int64_t end) { m_end = end; }
+
+    bool push(int64_t index, T item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_spaceFree.wait(lock, [&]() { return m_aborted || index < m_next + m_capacity; });
+        if (m_aborted) return false;
+        m_items.emplace(index, std::move(item));
+        if (index == m_next) m_itemReady.notify_all();
+        return true;
+    }
+
+    /** Next frame in order; false once every frame has been taken, or after abort(). */
+    bool pop(int64_t& index, T& item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_itemReady.wait(lock, [&]() {
+            return m_aborted || m_next == m_end || (!m_items.empty() && m_items.begin()->first == m_next);
+        });
+        if (m_aborted || m_next == m_end) return false;
+        auto it = m_items.begin();
+        index = it->first;
+        item = std::move(it->second);
+        m_items.erase(it);
+        m_next++;
+        m_spaceFree.notify_all();
+        // Another consumer may be waiting for the frame that is already queued behind this one
+        m_itemReady.notify_all();
+        return true;
+    }
+
+    void abort() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_aborted = true;
+        }
+        m_spaceFree.notify_all();
+        m_itemReady.notify_all();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_spaceFree;
+    std::condition_variable m_itemReady;
+    std::map<int64_t, T> m_items;
+    const int64_t m_capacity;
+    int64_t m_end = 0;
+    int64_t m_next = 0;
+    bool m_aborted = false;
+};
+
+struct StageCounter {
+    const char* name = "";
+    uint32_t workers = 1;
+    std::atomic<int64_t> frames{0};
+    std::atomic<int64_t> busyNs{0};
+};
+
+/** Adds the time until it goes out of scope to a stage's busy time. */
+class BusyTimer {
+public:
+    explicit BusyTimer(StageCounter& counter) : m_counter(counter), m_start(Clock::now()) {}
+    ~BusyTimer() {
+        m_counter.busyNs += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start).count();
+    }
+
+private:
+    StageCounter& m_counter;
+    Clock::time_point m_start;
+};
+
+void fillBlack(CpuImage& image, uint32_t width, uint32_t height) {
+    image.width = width;
+    image.height = height;
+    image.rgba.resize(static_cast<size_t>(width) * height * 4);
+    uint8_t* p = image.rgba.data();
+    for (size_t i = 0, n = static_cast<size_t>(width) * height; i < n; i++, p += 4) {
+        p[0] = p[1] = p[2] = 0;
+        p[3] = 255;
+    }
+}
+
+#ifdef AETHER_FFMPEG_ENABLED
+/**
+ * Sequential decoder over one source file. Export walks each clip forward a
+ * frame at a time, so frameAt() decodes onward from the previous frame and only
+ * seeks when the target lies behind it or far ahead.
+ */
+class SourceDecoder {
+public:
+    ~SourceDecoder() {
+        if (m_sws) sws_freeContext(m_sws);
+        av_packet_free(&m_packet);
+        av_frame_free(&m_current);
+        av_frame_free(&m_pending);
+        avcodec_free_context(&m_codec);
+        avformat_close_input(&m_format);
+    }
+
+    bool open(const QString& path) {
+        if (avformat_open_input(&m_format, path.toUtf8().constData(), nullptr, nullptr) < 0) return false;
+        if (avformat_find_stream_info(m_format, nullptr) < 0) return false;
+        m_stream = av_find_best_stream(m_format, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        if (m_stream < 0) return false;
+        for (unsigned i = 0; i < m_format->nb_streams; i++) {
+            if (static_cast<int>(i) != m_stream) m_format->streams[i]->discard = AVDISCARD_ALL;
+        }
+        AVStream* st = m_format->streams[m_stream];
+        const AVCodec* dec = avcodec_find_decoder(st->codecpar->codec_id);
+        m_codec = dec ? avcodec_alloc_context3(dec) : nullptr;
+        if (!m_codec || avcodec_parameters_to_context(m_codec, st->codecpar) < 0) return false;
+        m_codec->thread_count = 0;
+        if (avcodec_open2(m_codec, dec, nullptr) < 0) return false;
+        m_timeBase = st->time_base;
+        m_startTs = st->start_time != AV_NOPTS_VALUE ? st->start_time : 0;
+        m_current = av_frame_alloc();
+        m_pending = av_frame_alloc();
+        m_packet = av_packet_alloc();
+        return m_current && m_pending && m_packet;
+    }
+
+    /** Draws the frame showing at sourceMs into canvas, fitted to it or at native size, centred. */
+    bool frameAt(int64_t sourceMs, bool scaleToFrame, CpuImage& canvas) {
+        const bool behind = m_haveCurrent && sourceMs < ptsMs(m_current);
+        const bool farAhead = m_haveCurrent && !m_draining && sourceMs - ptsMs(m_current) > kSeekThresholdMs;
+        if (!m_haveCurrent || behind || farAhead) seek(sourceMs);
+        for (;;) {
+            if (!m_havePending) {
+                if (!decodeNext(m_pending)) break;
+                m_havePending = true;
+            }
+            if (m_haveCurrent && ptsMs(m_pending) > sourceMs) break;
+            std::swap(m_current, m_pending);
+            m_haveCurrent = true;
+            m_havePending = false;
+        }
+        if (!m_haveCurrent) return false;
+        draw(scaleToFrame, canvas);
+        return true;
+    }
+
+private:
+    static constexpr int64_t kSeekThresholdMs = 2000;
+
+    int64_t ptsMs(const AVFrame* frame) const {
+        const int64_t ts = frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp : frame->pts;
+        if (ts == AV_NOPTS_VALUE) return 0;
+        return av_rescale_q(ts - m_startTs, m_timeBase, AVRational{1, 1000});
+    }
+
+    void seek(int64_t sourceMs) {
+        const int64_t ts = m_startTs + av_rescale_q(std::max<int64_t>(sourceMs, 0), AVRational{1, 1000}, m_timeBase);
+        av_seek_frame(m_format, m_stream, ts, AVSEEK_FLAG_BACKWARD);
+        avcodec_flush_buffers(m_codec);
+        m_haveCurrent = false;
+        m_havePending = false;
+        m_draining = false;
+    }
+
+    bool decodeNext(AVFrame* frame) {
+        for (;;) {
+            const int ret = avcodec_receive_frame(m_codec, frame);
+            if (ret == 0) return true;
+            if (ret != AVERROR(EAGAIN)) return false;
+            if (m_draining) return false;
+            if (av_read_frame(m_format, m_packet) < 0) {
+                avcodec_send_packet(m_codec, nullptr);
+                m_draining = true;
+                continue;
+            }
+            if (m_packet->stream_index == m_stream) avcodec_send_packet(m_codec, m_packet);
+            av_packet_unref(m_packet);
+        }
+    }
+
+    void draw(bool scaleToFrame, CpuImage& canvas) {
+        const int fw = m_current->width;
+        const int fh = m_current->height;
+        const int cw = static_cast<int>(canvas.width);
+        const int ch = static_cast<int>(canvas.height);
+        int dw = fw;
+        int dh = fh;
+        if (scaleToFrame && fw > 0 && fh > 0) {
+            const double scale = std::min(static_cast<double>(cw) / fw, static_cast<double>(ch) / fh);
+            dw = std::max(1, static_cast<int>(std::lround(fw * scale)));
+            dh = std::max(1, static_cast<int>(std::lround(fh * scale)));
+        }
+        m_sws = sws_getCachedContext(m_sws, fw, fh, static_cast<AVPixelFormat>(m_current->format), dw, dh,
+                                     AV_PIX_FMT_RGBA, SWS_BICUBIC, nullptr, nullptr, nullptr);
+        if (!m_sws) return;
+        m_scaled.resize(static_cast<size_t>(dw) * dh * 4);
+        uint8_t* dst[1] = {m_scaled.data()};
+        int dstStride[1] = {dw * 4};
+        sws_scale(m_sws, m_current->data, m_current->linesize, 0, fh, dst, dstStride);
+
+        // Centre on the canvas, cropping whatever overhangs it
+        const int dx = (cw - dw) / 2;
+        const int dy = (ch - dh) / 2;
+        const int x0 = std::max(0, dx);
+        const int x1 = std::min(cw, dx + dw);
+        const int y0 = std::max(0, dy);
+        const int y1 = std::min(ch, dy + dh);
+        if (x1 <= x0) return;
+        for (int y = y0; y < y1; y++) {
+            std::memcpy(canvas.rgba.data() + (static_cast<size_t>(y) * cw + x0) * 4,
+                        m_scaled.data() + (static_cast<size_t>(y - dy) * dw + (x0 - dx)) * 4,
+                        static_cast<size_t>(x1 - x0) * 4);
+        }
+    }
+
+    AVFormatContext* m_format = nullptr;
+    AVCodecContext* m_codec = nullptr;
+    AVFrame* m_current = nullptr; // latest frame at or before the last target
+    AVFrame* m_pending = nullptr; // decoded one past it
+    AVPacket* m_packet = nullptr;
+    SwsContext* m_sws = nullptr;
+    int m_stream = -1;
+    AVRational m_timeBase{1, 1000};
+    int64_t m_startTs = 0;
+    bool m_haveCurrent = false;
+    bool m_havePending = false;
+    bool m_draining = false;
+    std::vector<uint8_t> m_scaled;
+};
+#else
+class SourceDecoder {
+public:
+    bool open(const QString&) { return false; }
+    bool frameAt(int64_t, bool, CpuImage&) { return false; }
+};
+#endif
+
+/** A run of output frames, either rendered or copied from its source as it is. */
+struct ExportSegment {
+    int64_t firstFrame = 0;
+    int64_t endFrame = 0;
+    bool copy = false;
+    std::string sourcePath; // copy only
+    CopySpan span;          // copy only
+};
+
+/** A frame from the decode stage, with a key naming its pixels for the node result cache. */
+struct DecodedFrame {
+    CpuImage image;
+    uint64_t sourceKey = 0;
+};
+
+// Keys a decoded frame by what produced it (clip source, source time, scaling and
+// output size), so the effects stage need not hash the pixels
+uint64_t sourceFrameKey(const TimelineClip* clip, int64_t sourceMs, uint32_t width, uint32_t height) {
+    auto mix = [](uint64_t key, uint64_t value) { return key ^ (value + 0x9E3779B97F4A7C15ull + (key << 6) + (key >> 2)); };
+    uint64_t key = mix(width, height);
+    if (clip) {
+        key = mix(key, std::hash<std::string>{}(clip->mediaPath.toStdString()));
+        key = mix(key, static_cast<uint64_t>(sourceMs));
+        key = mix(key, clip->scaleToFrame ? 1 : 2);
+    }
+    return key ? key : 1; // 0 asks the executor to hash the pixels
+}
+
+/** What the encoder hands the muxer: the packets of one frame, or a span to copy. */
+struct MuxItem {
+    std::vector<std::unique_ptr<EncoderPacket>> packets;
+    const ExportSegment* copy = nullptr;
+    int64_t frames = 0; // output frames complete once this item is written
+};
+
+} // namespace
+
+struct ExportEngine::Pipeline {
+    enum Stage { Decode, Effects, Convert, Encode, Mux, StageCount };
+
+    Pipeline(const ExportRequest& r, std::unique_ptr<IEncoderBackend> b, FinishedCallback f, int64_t total,
+             std::atomic<bool>& runningFlag)
+        : request(r), backend(std::move(b)), onFinished(std::move(f)), totalFrames(total), running(runningFlag)
+        , resultCache(r.nodeCacheBytes), decoded(r.queueDepth), graded(r.queueDepth), converted(r.queueDepth), muxQueue(r.queueDepth) {
+        static const char* const kNames[StageCount] = {"decode", "effects", "convert", "encode", "mux"};
+        for (int i = 0; i < StageCount; i++) stages[i].name = kNames[i];
+        stages[Convert].workers = std::max<uint32_t>(request.convertThreads, 1);
+    }
+
+    ExportRequest request;
+    std::unique_ptr<IEncoderBackend> backend;
+    FinishedCallback onFinished;
+    const int64_t totalFrames;
+    std::atomic<bool>& running;
+    NodeGraphExecutor executor;
+    NodeResultCache resultCache; // this export's only; emptied when the effects stage ends
+    bool applyGraph = false;
+
+    std::vector<ExportSegment> segments;
+    // Encoded frames are numbered densely through the queues; run i starts at
+    // dense index encodedRuns[i].first and output frame encodedRuns[i].second
+    std::vector<std::pair<int64_t, int64_t>> encodedRuns;
+    int64_t encodedFrames = 0;
+
+    Clock::time_point startTime = Clock::now();
+    std::array<StageCounter, StageCount> stages;
+    std::atomic<int64_t> framesDone{0};
+    std::atomic<int64_t> copiedFrames{0};
+    std::atomic<bool> aborted{false};
+
+    StageQueue<DecodedFrame> decoded;
+    StageQueue<CpuImage> graded;
+    StageQueue<std::unique_ptr<EncoderFrame>> converted;
+    StageQueue<MuxItem> muxQueue; // per encoded segment one item per frame plus the flush; one per copied segment
+
+    mutable std::mutex resultMutex;
+    std::string error;
+    std::vector<std::string> copyRejections;
+    bool finished = false;
+    bool ok = false;
+    double finishedElapsedMs = 0.0;
+
+    std::vector<std::thread> threads;
+
+    int64_t frameTimeMs(int64_t frame) const {
+        return request.startMs + static_cast<int64_t>(std::llround(frame * 1000.0 / request.params.fps));
+    }
+    int64_t frameAtMs(int64_t timeMs) const {
+        return static_cast<int64_t>(std::llround((timeMs - request.startMs) * request.params.fps / 1000.0));
+    }
+    int64_t outputFrame(int64_t encodedIndex) const {
+        auto it = std::upper_bound(encodedRuns.begin(), encodedRuns.end(), encodedIndex,
+                                   [](int64_t i, const auto& run) { return i < run.first; });
+        return std::prev(it)->second + (encodedIndex - std::prev(it)->first);
+    }
+
+    /** The clip showing at timeMs: the first video track's, as in the monitor. */
+    const TimelineClip* clipAt(int64_t timeMs) const {
+        if (!request.project.timeline) return nullptr;
+        for (const Track& track : request.project.timeline->tracks) {
+            if (!track.isVideo) continue;
+            const int c = track.clipAt(timeMs);
+            if (c >= 0) return &track.clips[c];
+        }
+        return nullptr;
+    }
+
+    void run();
+    void planSegments();
+
+    void rejectCopy(const std::string& path, const std::string& reason) {
+        const std::string note = path + ": " + reason;
+        std::lock_guard<std::mutex> lock(resultMutex);
+        if (std::find(copyRejections.begin(), copyRejections.end(), note) == copyRejections.end())
+            copyRejections.push_back(note);
+    }
+
+    void abort(const std::string& message) {
+        {
+            std::lock_guard<std::mutex> lock(resultMutex);
+            if (finished) return;
+            if (error.empty()) error = message;
+        }
+        aborted = true;
+        decoded.abort();
+        graded.abort();
+        converted.abort();
+        muxQueue.abort();
+    }
+
+    void decodeLoop();
+    void effectsLoop();
+    void convertLoop();
+    void encodeLoop();
+    void muxLoop();
+    ExportStats stats() const;
+};
+
+void ExportEngine::Pipeline::run() {
+    // Finding copyable spans reads through the sources' packets, so it is done here rather than in start()
+    planSegments();
+    threads.emplace_back([this]() { decodeLoop(); });
+    threads.emplace_back([this]() { effectsLoop(); });
+    for (uint32_t i = 0; i < stages[Convert].workers; i++) threads.emplace_back([this]() { convertLoop(); });
+    threads.emplace_back([this]() { encodeLoop(); });
+    muxLoop();
+}
+
+void ExportEngine::Pipeline::planSegments() {
+    auto addEncoded = [&](int64_t first, int64_t end) {
+        if (end <= first) return;
+        if (!segments.empty() && !segments.back().copy && segments.back().endFrame == first) {
+            segments.back().endFrame = end;
+            return;
+        }
+        ExportSegment segment;
+        segment.firstFrame = first;
+        segment.endFrame = end;
+        segments.push_back(std::move(segment));
+    };
+
+    // Untouched clips are copied GOP by GOP; only the GOPs cut by an edit are re-encoded
+    const bool smart = request.smartRender && !applyGraph;
+    if (!smart) addEncoded(0, totalFrames);
+    for (int64_t i = 0; smart && i < totalFrames && !aborted;) {
+        const TimelineClip* clip = clipAt(frameTimeMs(i));
+        int64_t j = i + 1;
+        while (j < totalFrames && clipAt(frameTimeMs(j)) == clip) j++;
+        if (smart && clip && std::abs(clip->speedRatio - 1.0) < 1e-9) {
+            const int64_t toSource = clip->sourceInMs - clip->timelineStartMs;
+            const std::string path = clip->mediaPath.toStdString();
+            const int64_t fromMs = frameTimeMs(i) + toSource;
+            const int64_t toMs = frameTimeMs(j) + toSource;
+            CopySpan span = backend->findCopySpan(path, fromMs, toMs);
+            // A source under the whole export can lend the output its stream headers,
+            // but only if nothing is left to encode with the encoder's own
+            if (span.headersDiffer && request.adoptStreamHeaders && i == 0 && j == totalFrames
+                && backend->useStreamHeaders(path)) {
+                span = backend->findCopySpan(path, fromMs, toMs);
+                const bool whole = !span.isEmpty() && frameAtMs(span.startMs - toSource) <= 0
+                                   && frameAtMs(span.endMs - toSource) >= totalFrames;
+                if (!whole) {
+                    backend->useStreamHeaders({});
+                    span = CopySpan();
+                    span.rejection = "stream headers differ from the output's and the export cannot be copied whole";
+                }
+            }
+            if (span.isEmpty()) rejectCopy(path, span.rejection);
+            if (!span.isEmpty()) {
+                const int64_t first = std::clamp(frameAtMs(span.startMs - toSource), i, j);
+                const int64_t end = std::clamp(frameAtMs(span.endMs - toSource), first, j);
+                if (end > first) {
+                    addEncoded(i, first);
+                    ExportSegment segment;
+                    segment.firstFrame = first;
+                    segment.endFrame = end;
+                    segment.copy = true;
+                    segment.sourcePath = path;
+                    segment.span = span;
+                    segments.push_back(std::move(segment));
+                    addEncoded(end, j);
+                    i = j;
+                    continue;
+                }
+            }
+        }
+        addEncoded(i, j);
+        i = j;
+    }
+
+    int64_t muxItems = 0;
+    for (const ExportSegment& segment : segments) {
+        if (segment.copy) {
+            muxItems++;
+            continue;
+        }
+        encodedRuns.emplace_back(encodedFrames, segment.firstFrame);
+        encodedFrames += segment.endFrame - segment.firstFrame;
+        muxItems += segment.endFrame - segment.firstFrame + 1;
+    }
+    decoded.setEnd(encodedFrames);
+    graded.setEnd(encodedFrames);
+    converted.setEnd(encodedFrames);
+    muxQueue.setEnd(muxItems);
+}
+
+void ExportEngine::Pipeline::decodeLoop() {
+    const uint32_t width = request.params.width;
+    const uint32_t height = request.params.height;
+
+    // A few sources stay open so cutting back and forth between clips does not reopen files
+    constexpr size_t kOpenSources = 4;
+    std::vector<std::pair<QString, std::unique_ptr<SourceDecoder>>> sources;
+
+    for (int64_t i = 0; i < encodedFrames && !aborted; i++) {
+        DecodedFrame frame;
+        {
+            BusyTimer busy(stages[Decode]);
+            fillBlack(frame.image, width, height);
+            const int64_t t = frameTimeMs(outputFrame(i));
+            const TimelineClip* clip = clipAt(t);
+            frame.sourceKey = sourceFrameKey(nullptr, 0, width, height);
+            if (clip) {
+                auto it = std::find_if(sources.begin(), sources.end(),
+                                       [&](const auto& s) { return s.first == clip->mediaPath; });
+                if (it == sources.end()) {
+                    auto decoder = std::make_unique<SourceDecoder>();
+                    if (!decoder->open(clip->mediaPath)) {
+                        abort("Could not decode " + clip->mediaPath.toStdString());
+                        return;
+                    }
+                    if (sources.size() >= kOpenSources) sources.pop_back();
+                    sources.emplace(sources.begin(), clip->mediaPath, std::move(decoder));
+                } else if (it != sources.begin()) {
+                    std::rotate(sources.begin(), it, it + 1);
+                }
+                const int64_t sourceMs = clip->sourceInMs + static_cast<int64_t>((t - clip->timelineStartMs) * clip->speedRatio);
+                // Past the end of the file the last frame holds
+                sources.front().second->frameAt(sourceMs, clip->scaleToFrame, frame.image);
+                frame.sourceKey = sourceFrameKey(clip, sourceMs, width, height);
+            }
+        }
+        if (!decoded.push(i, std::move(frame))) return;
+        stages[Decode].frames++;
+    }
+}
+
+void ExportEngine::Pipeline::effectsLoop() {
+    int64_t index = 0;
+    DecodedFrame frame;
+    while (decoded.pop(index, frame)) {
+        CpuImage out;
+        {
+            BusyTimer busy(stages[Effects]);
+            if (applyGraph) {
+                if (!executor.execute(frame.image, frameTimeMs(outputFrame(index)), out, frame.sourceKey)) {
+                    abort("Effects failed: " + executor.getLastError());
+                    break;
+                }
+            } else {
+                out = std::move(frame.image);
+            }
+        }
+        if (!graded.push(index, std::move(out))) break;
+        stages[Effects].frames++;
+    }
+    // Nothing reads the cached results once the frames are through
+    resultCache.clear();
+}
+
+void ExportEngine::Pipeline::convertLoop() {
+    int64_t index = 0;
+    CpuImage frame;
+    while (graded.pop(index, frame)) {
+        std::unique_ptr<EncoderFrame> out;
+        {
+            BusyTimer busy(stages[Convert]);
+            out = backend->convertFrame(frame.rgba.data(), frame.width, frame.height);
+        }
+        if (!out) {
+            abort("Colour conversion failed: " + backend->getLastError());
+            return;
+        }
+        out->index = outputFrame(index);
+        if (!converted.push(index, std::move(out))) return;
+        stages[Convert].frames++;
+    }
+}
+
+void ExportEngine::Pipeline::encodeLoop() {
+    int64_t muxIndex = 0;
+    for (const ExportSegment& segment : segments) {
+        if (segment.copy) {
+            MuxItem item;
+            item.copy = &segment;
+            item.frames = segment.endFrame - segment.firstFrame;
+            if (!muxQueue.push(muxIndex++, std::move(item))) return;
+            continue;
+        }
+        for (int64_t f = segment.firstFrame; f < segment.endFrame; f++) {
+            int64_t index = 0;
+            std::unique_ptr<EncoderFrame> frame;
+            if (!converted.pop(index, frame)) return;
+            MuxItem item;
+            item.frames = 1;
+            bool encoded = false;
+            {
+                BusyTimer busy(stages[Encode]);
+                encoded = backend->encode(std::move(frame), item.packets);
+            }
+            if (!encoded) {
+                abort(backend->getLastError());
+                return;
+            }
+            if (!muxQueue.push(muxIndex++, std::move(item))) return;
+            stages[Encode].frames++;
+        }
+        // Drain at the end of every run, so a copied span never interleaves with delayed frames
+        MuxItem tail;
+        bool flushed = false;
+        {
+            BusyTimer busy(stages[Encode]);
+            flushed = backend->encode(nullptr, tail.packets);
+        }
+        if (!flushed) {
+            abort(backend->getLastError());
+            return;
+        }
+        if (!muxQueue.push(muxIndex++, std::move(tail))) return;
+    }
+}
+
+void ExportEngine::Pipeline::muxLoop() {
+    int64_t index = 0;
+    MuxItem item;
+    while (muxQueue.pop(index, item)) {
+        {
+            BusyTimer busy(stages[Mux]);
+            if (item.copy) {
+                if (!backend->copyPackets(item.copy->sourcePath, item.copy->span, item.copy->firstFrame))
+                    abort(backend->getLastError());
+                else
+                    copiedFrames += item.frames;
+            }
+            for (auto& packet : item.packets) {
+                if (!backend->writePacket(std::move(packet))) {
+                    abort(backend->getLastError());
+                    break;
+                }
+            }
+        }
+        if (aborted) break;
+        if (item.frames > 0) {
+            stages[Mux].frames += item.frames;
+            framesDone += item.frames;
+        }
+    }
+
+    // The other stages stop on their own once the queues are drained or aborted
+    for (std::thread& t : threads) t.join();
+    backend->close();
+    if (aborted) QFile::remove(QString::fromStdString(request.params.outputPath));
+
+    ExportStats result;
+    {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        finished = true;
+        ok = !aborted;
+        finishedElapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - startTime).count();
+    }
+    result = stats();
+    running = false;
+    if (onFinished) onFinished(result);
+}
+
+ExportStats ExportEngine::Pipeline::stats() const {
+    ExportStats s;
+    s.totalFrames = totalFrames;
+    s.framesDone = framesDone.load();
+    s.copiedFrames = copiedFrames.load();
+    {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        s.finished = finished;
+        s.ok = ok;
+        s.error = error;
+        s.copyRejections = copyRejections;
+        s.elapsedMs = finished ? finishedElapsedMs
+                               : std::chrono::duration<double, std::milli>(Clock::now() - startTime).count();
+    }
+    const double seconds = s.elapsedMs / 1000.0;
+    s.fps = seconds > 0.0 ? s.framesDone / seconds : 0.0;
+    for (const StageCounter& c : stages) {
+        ExportStageStats stage;
+        stage.name = c.name;
+        stage.workers = c.workers;
+        stage.frames = c.frames.load();
+        stage.busyMs = c.busyNs.load() / 1e6;
+        stage.fps = seconds > 0.0 ? stage.frames / seconds : 0.0;
+        stage.utilisation = s.elapsedMs > 0.0 ? std::min(1.0, stage.busyMs / (s.elapsedMs * c.workers)) : 0.0;
+        s.stages.push_back(std::move(stage));
+    }
+    return s;
+}
+
+ExportEngine::ExportEngine() = default;
+
+ExportEngine::~ExportEngine() {
+    cancel();
+    wait();
+}
+
+bool ExportEngine::start(const ExportRequest& request, std::unique_ptr<IEncoderBackend> backend,
+                         FinishedCallback onFinished) {
+    if (m_running) {
+        m_lastError = "An export is already running";
+        return false;
+    }
+    wait();
+    m_lastError.clear();
+    if (!backend) {
+        m_lastError = "No encoder";
+        return false;
+    }
+    if (request.params.fps <= 0.0 || request.params.width == 0 || request.params.height == 0) {
+        m_lastError = "Invalid output size or frame rate";
+        return false;
+    }
+
+    const int64_t totalFrames = frameCount(request);
+    if (totalFrames <= 0) {
+        m_lastError = "Nothing to export";
+        return false;
+    }
+
+    auto pipeline = std::make_unique<Pipeline>(request, std::move(backend), std::move(onFinished), totalFrames, m_running);
+    const NodeGraphModel* graph = request.project.nodeGraph.get();
+    if (graph && !graph->nodes().empty()) {
+        if (!pipeline->executor.compile(*graph)) {
+            m_lastError = "Node graph: " + pipeline->executor.getLastError();
+            return false;
+        }
+        if (request.project.keyframes)
+            pipeline->executor.setParameterSource(NodeGraphExecutor::keyframeSource(*request.project.keyframes));
+        if (request.nodeCacheBytes > 0) pipeline->executor.setResultCache(&pipeline->resultCache);
+        pipeline->applyGraph = true;
+    }
+    if (!pipeline->backend->open(request.params)) {
+        m_lastError = pipeline->backend->getLastError();
+        pipeline->backend->close();
+        return false;
+    }
+
+    m_running = true;
+    Pipeline* p = pipeline.get();
+    p->startTime = Clock::now();
+    m_pipeline = std::move(pipeline);
+    // The mux thread plans the export, starts the other stages and joins them when it finishes
+    m_muxThread = std::thread([p]() { p->run(); });
+    return true;
+}
+
+int64_t ExportEngine::frameCount(const ExportRequest& request) {
+    if (request.frameCount >= 0) return request.frameCount;
+    if (request.params.fps <= 0.0) return 0;
+    int64_t endMs = request.endMs;
+    if (endMs < 0) {
+        endMs = 0;
+        if (request.project.timeline) {
+            for (const Track& track : request.project.timeline->tracks) endMs = std::max<int64_t>(endMs, track.endMs());
+        }
+    }
+    return std::max<int64_t>(0, static_cast<int64_t>(std::ceil((endMs - request.startMs) * request.params.fps / 1000.0 - 1e-9)));
+}
+
+void ExportEngine::cancel() {
+    if (m_pipeline && m_running) m_pipeline->abort("Export cancelled");
+}
+
+void ExportEngine::wait() {
+    if (m_muxThread.joinable()) m_muxThread.join();
+}
+
+ExportStats ExportEngine::getStats() const {
+    if (!m_pipeline) return {};
+    return m_pipeline->stats();
+}
+
+} // namespace aether
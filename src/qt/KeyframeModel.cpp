@@ -1,8 +1,80 @@
 #include "aether/KeyframeModel.h"
 #include <algorithm>
+#include <climits>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AETHER_KEYFRAMES_SSE2 1
+#endif
 
 namespace aether {
 
+namespace {
+
+bool keyBefore(const Keyframe& k, int64_t timeMs) { return k.timeMs < timeMs; }
+bool keyAfter(int64_t timeMs, const Keyframe& k) { return timeMs < k.timeMs; }
+
+// Segment i with keys[i].timeMs <= t < keys[i + 1].timeMs, clamped to the first/last segment
+size_t findSegment(const std::vector<Keyframe>& keys, double timeMs) {
+    auto it = std::upper_bound(keys.begin(), keys.end(), timeMs,
+        [](double t, const Keyframe& k) { return t < static_cast<double>(k.timeMs); });
+    size_t next = static_cast<size_t>(it - keys.begin());
+    return next == 0 ? 0 : std::min(next - 1, keys.size() - 2);
+}
+
+// Checks the hinted segment and the one after it before falling back to a binary search
+size_t locateSegment(const std::vector<Keyframe>& keys, double timeMs, size_t hint) {
+    const size_t n = keys.size();
+    hint = std::min(hint, n - 2);
+    if (timeMs >= static_cast<double>(keys[hint].timeMs)) {
+        if (hint + 2 == n || timeMs < static_cast<double>(keys[hint + 1].timeMs)) return hint;
+        if (hint + 3 == n || timeMs < static_cast<double>(keys[hint + 2].timeMs)) return hint + 1;
+    }
+    return findSegment(keys, timeMs);
+}
+
+double valueInSegment(const std::vector<Keyframe>& keys, size_t segment, double timeMs) {
+    if (timeMs <= static_cast<double>(keys.front().timeMs)) return keys.front().value;
+    if (timeMs >= static_cast<double>(keys.back().timeMs)) return keys.back().value;
+    return KeyframeModel::interpolate(keys[segment], keys[segment + 1], timeMs);
+}
+
+// One coordinate of a cubic Bezier from 0 to 1 with inner control points p1, p2
+double bezierCoordinate(double p1, double p2, double u) {
+    const double inv = 1.0 - u;
+    return 3.0 * inv * inv * u * p1 + 3.0 * inv * u * u * p2 + u * u * u;
+}
+
+double bezierSlope(double p1, double p2, double u) {
+    const double inv = 1.0 - u;
+    return 3.0 * inv * inv * p1 + 6.0 * inv * u * (p2 - p1) + 3.0 * u * u * (1.0 - p2);
+}
+
+// Curve parameter u where the time coordinate equals x; Newton first, bisection if it stalls
+double solveBezierTime(double x1, double x2, double x) {
+    double u = x;
+    for (int i = 0; i < 8; i++) {
+        const double error = bezierCoordinate(x1, x2, u) - x;
+        if (std::abs(error) < 1e-7) return u;
+        const double slope = bezierSlope(x1, x2, u);
+        if (std::abs(slope) < 1e-6) break;
+        u -= error / slope;
+    }
+    double lo = 0.0;
+    double hi = 1.0;
+    u = x;
+    for (int i = 0; i < 40; i++) {
+        const double value = bezierCoordinate(x1, x2, u);
+        if (std::abs(value - x) < 1e-7) break;
+        if (value < x) lo = u; else hi = u;
+        u = 0.5 * (lo + hi);
+    }
+    return u;
+}
+
+} // namespace
+
 KeyframeModel::KeyframeModel() = default;
 
 void KeyframeModel::setNodeId(uint32_t nodeId) {
@@ -11,68 +83,266 @@ void KeyframeModel::setNodeId(uint32_t nodeId) {
 
 void KeyframeModel::setParameters(const std::vector<ParameterKeyframes>& params) {
     m_parameters = params;
+    rebuildIndex();
+}
+
+void KeyframeModel::rebuildIndex() {
+    m_handleById.clear();
+    for (size_t i = 0; i < m_parameters.size(); i++)
+        m_handleById.emplace(m_parameters[i].parameterId, static_cast<ParameterHandle>(i));
+}
+
+ParameterHandle KeyframeModel::findParameter(const std::string& parameterId) const {
+    auto it = m_handleById.find(parameterId);
+    return it != m_handleById.end() ? it->second : InvalidParameterHandle;
+}
+
+ParameterKeyframes* KeyframeModel::parameterById(const std::string& parameterId) {
+    ParameterHandle handle = findParameter(parameterId);
+    return handle != InvalidParameterHandle ? &m_parameters[static_cast<size_t>(handle)] : nullptr;
+}
+
+const std::vector<Keyframe>* KeyframeModel::keyframesOf(ParameterHandle handle) const {
+    if (handle < 0 || static_cast<size_t>(handle) >= m_parameters.size()) return nullptr;
+    return &m_parameters[static_cast<size_t>(handle)].keyframes;
 }
 
 void KeyframeModel::addKeyframe(const std::string& parameterId, int64_t timeMs, double value) {
-    for (auto& p : m_parameters) {
-        if (p.parameterId != parameterId) continue;
-        Keyframe kf;
-        kf.timeMs = timeMs;
-        kf.value = value;
-        p.keyframes.push_back(kf);
-        std::sort(p.keyframes.begin(), p.keyframes.end(), [](const Keyframe& a, const Keyframe& b) { return a.timeMs < b.timeMs; });
+    ParameterKeyframes* p = parameterById(parameterId);
+    if (!p) return;
+    auto it = std::lower_bound(p->keyframes.begin(), p->keyframes.end(), timeMs, keyBefore);
+    if (it != p->keyframes.end() && it->timeMs == timeMs) {
+        it->value = value;
         return;
     }
+    Keyframe kf;
+    kf.timeMs = timeMs;
+    kf.value = value;
+    p->keyframes.insert(it, kf);
 }
 
 void KeyframeModel::removeKeyframe(const std::string& parameterId, size_t keyframeIndex) {
-    for (auto& p : m_parameters) {
-        if (p.parameterId != parameterId) continue;
-        if (keyframeIndex < p.keyframes.size())
-            p.keyframes.erase(p.keyframes.begin() + static_cast<std::ptrdiff_t>(keyframeIndex));
-        return;
-    }
+    ParameterKeyframes* p = parameterById(parameterId);
+    if (p && keyframeIndex < p->keyframes.size())
+        p->keyframes.erase(p->keyframes.begin() + static_cast<std::ptrdiff_t>(keyframeIndex));
 }
 
 void KeyframeModel::setKeyframeValue(const std::string& parameterId, size_t keyframeIndex, double value) {
-    for (auto& p : m_parameters) {
-        if (p.parameterId != parameterId) continue;
-        if (keyframeIndex < p.keyframes.size())
-            p.keyframes[keyframeIndex].value = value;
-        return;
+    ParameterKeyframes* p = parameterById(parameterId);
+    if (p && keyframeIndex < p->keyframes.size())
+        p->keyframes[keyframeIndex].value = value;
+}
+
+size_t KeyframeModel::setKeyframeTime(const std::string& parameterId, size_t keyframeIndex, int64_t timeMs) {
+    ParameterKeyframes* p = parameterById(parameterId);
+    if (!p || keyframeIndex >= p->keyframes.size()) return keyframeIndex;
+    auto& keys = p->keyframes;
+    const auto current = keys.begin() + static_cast<std::ptrdiff_t>(keyframeIndex);
+    Keyframe moved = *current;
+    moved.timeMs = timeMs;
+
+    // Binary search for the new slot among the neighbours, then shift only the keys in between
+    size_t target;
+    if (timeMs >= current->timeMs) {
+        auto slot = std::upper_bound(current + 1, keys.end(), timeMs, keyAfter);
+        std::rotate(current, current + 1, slot);
+        target = static_cast<size_t>(slot - keys.begin()) - 1;
+    } else {
+        auto slot = std::lower_bound(keys.begin(), current, timeMs, keyBefore);
+        std::rotate(slot, current, current + 1);
+        target = static_cast<size_t>(slot - keys.begin());
+    }
+    keys[target] = moved;
+    return target;
+}
+
+void KeyframeModel::insertKeyframes(const std::string& parameterId, std::vector<Keyframe> keys) {
+    ParameterKeyframes* p = parameterById(parameterId);
+    if (!p || keys.empty()) return;
+    auto byTime = [](const Keyframe& a, const Keyframe& b) { return a.timeMs < b.timeMs; };
+    if (!std::is_sorted(keys.begin(), keys.end(), byTime))
+        std::stable_sort(keys.begin(), keys.end(), byTime);
+    // Collapse equal times, keeping the last one recorded
+    size_t out = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (out > 0 && keys[out - 1].timeMs == keys[i].timeMs)
+            keys[out - 1] = keys[i];
+        else
+            keys[out++] = keys[i];
     }
+    keys.resize(out);
+
+    auto& existing = p->keyframes;
+    auto first = std::lower_bound(existing.begin(), existing.end(), keys.front().timeMs, keyBefore);
+    auto last = std::upper_bound(first, existing.end(), keys.back().timeMs, keyAfter);
+    const auto position = first - existing.begin();
+    existing.erase(first, last);
+    existing.insert(existing.begin() + position, keys.begin(), keys.end());
 }
 
-void KeyframeModel::setKeyframeTime(const std::string& parameterId, size_t keyframeIndex, int64_t timeMs) {
-    for (auto& p : m_parameters) {
-        if (p.parameterId != parameterId) continue;
-        if (keyframeIndex < p.keyframes.size()) {
-            p.keyframes[keyframeIndex].timeMs = timeMs;
-            std::sort(p.keyframes.begin(), p.keyframes.end(), [](const Keyframe& a, const Keyframe& b) { return a.timeMs < b.timeMs; });
+size_t KeyframeModel::simplifyKeyframes(const std::string& parameterId, double tolerance, int64_t fromMs, int64_t toMs) {
+    ParameterKeyframes* p = parameterById(parameterId);
+    if (!p || p->keyframes.size() < 3) return 0;
+    auto& keys = p->keyframes;
+    const size_t begin = static_cast<size_t>(std::lower_bound(keys.begin(), keys.end(), fromMs, keyBefore) - keys.begin());
+    const size_t end = static_cast<size_t>(std::upper_bound(keys.begin(), keys.end(), toMs, keyAfter) - keys.begin());
+    if (end < begin + 3) return 0;
+
+    // Only keys inside a linear run can go: a key that starts or ends a Hold/Bezier segment stays
+    std::vector<char> keep(keys.size(), 1);
+    auto isAnchor = [&](size_t k) {
+        return k == begin || k + 1 == end || keys[k].interpolation != KeyframeInterpolation::Linear
+            || keys[k - 1].interpolation != KeyframeInterpolation::Linear;
+    };
+    std::vector<std::pair<size_t, size_t>> stack;
+    size_t runStart = begin;
+    for (size_t k = begin + 1; k < end; k++) {
+        if (!isAnchor(k)) {
+            keep[k] = 0;
+            continue;
+        }
+        if (k > runStart + 1) stack.emplace_back(runStart, k);
+        runStart = k;
+    }
+
+    while (!stack.empty()) {
+        auto [lo, hi] = stack.back();
+        stack.pop_back();
+        const Keyframe& a = keys[lo];
+        const Keyframe& b = keys[hi];
+        double worst = -1.0;
+        size_t worstIndex = lo;
+        for (size_t k = lo + 1; k < hi; k++) {
+            const double error = std::abs(interpolate(a, b, static_cast<double>(keys[k].timeMs)) - keys[k].value);
+            if (error > worst) {
+                worst = error;
+                worstIndex = k;
+            }
+        }
+        if (worst > tolerance) {
+            keep[worstIndex] = 1;
+            if (worstIndex > lo + 1) stack.emplace_back(lo, worstIndex);
+            if (hi > worstIndex + 1) stack.emplace_back(worstIndex, hi);
+        }
+    }
+
+    size_t out = 0;
+    for (size_t k = 0; k < keys.size(); k++) {
+        if (keep[k]) keys[out++] = keys[k];
+    }
+    const size_t removed = keys.size() - out;
+    keys.resize(out);
+    return removed;
+}
+
+double KeyframeModel::interpolate(const Keyframe& a, const Keyframe& b, double timeMs) {
+    const double duration = static_cast<double>(b.timeMs - a.timeMs);
+    if (duration <= 0.0) return b.value;
+    const double s = std::clamp((timeMs - static_cast<double>(a.timeMs)) / duration, 0.0, 1.0);
+    switch (a.interpolation) {
+        case KeyframeInterpolation::Hold:
+            return a.value;
+        case KeyframeInterpolation::Linear:
+            return a.value + s * (b.value - a.value);
+        case KeyframeInterpolation::Bezier: {
+            // Handles clamped into the segment keep time monotonic, so the solve is well defined
+            const double x1 = std::clamp(a.outHandle.x, 0.0, 1.0);
+            const double x2 = 1.0 - std::clamp(b.inHandle.x, 0.0, 1.0);
+            const double u = solveBezierTime(x1, x2, s);
+            const double inv = 1.0 - u;
+            const double y1 = a.value + a.outHandle.y;
+            const double y2 = b.value + b.inHandle.y;
+            return inv * inv * inv * a.value + 3.0 * inv * inv * u * y1 + 3.0 * inv * u * u * y2 + u * u * u * b.value;
         }
-        return;
     }
+    return a.value;
 }
 
 double KeyframeModel::evaluate(const std::string& parameterId, int64_t timeMs) const {
-    for (const auto& p : m_parameters) {
-        if (p.parameterId != parameterId) continue;
-        if (p.keyframes.empty()) return 0.0;
-        if (timeMs <= p.keyframes.front().timeMs) return p.keyframes.front().value;
-        if (timeMs >= p.keyframes.back().timeMs) return p.keyframes.back().value;
-        for (size_t i = 0; i + 1 < p.keyframes.size(); i++) {
-            int64_t t0 = p.keyframes[i].timeMs;
-            int64_t t1 = p.keyframes[i + 1].timeMs;
-            if (timeMs >= t0 && timeMs <= t1) {
-                double v0 = p.keyframes[i].value;
-                double v1 = p.keyframes[i + 1].value;
-                double u = static_cast<double>(timeMs - t0) / static_cast<double>(t1 - t0);
-                return v0 + u * (v1 - v0);
+    return evaluate(findParameter(parameterId), static_cast<double>(timeMs));
+}
+
+double KeyframeModel::evaluate(ParameterHandle handle, double timeMs) const {
+    const std::vector<Keyframe>* keys = keyframesOf(handle);
+    if (!keys || keys->empty()) return 0.0;
+    if (keys->size() == 1) return keys->front().value;
+    return valueInSegment(*keys, findSegment(*keys, timeMs), timeMs);
+}
+
+double KeyframeModel::evaluate(ParameterHandle handle, double timeMs, KeyframeCursor& cursor) const {
+    const std::vector<Keyframe>* keys = keyframesOf(handle);
+    if (!keys || keys->empty()) return 0.0;
+    if (keys->size() == 1) return keys->front().value;
+    cursor.segment = locateSegment(*keys, timeMs, cursor.segment);
+    return valueInSegment(*keys, cursor.segment, timeMs);
+}
+
+void KeyframeModel::evaluateBatch(ParameterHandle handle, const double* timesMs, size_t count, double* out) const {
+    KeyframeCursor cursor;
+    for (size_t i = 0; i < count; i++)
+        out[i] = evaluate(handle, timesMs[i], cursor);
+}
+
+void KeyframeModel::sampleUniform(ParameterHandle handle, double startMs, double stepMs, size_t count, double* out) const {
+    const std::vector<Keyframe>* keys = keyframesOf(handle);
+    if (!keys || keys->size() < 2 || stepMs <= 0.0) {
+        KeyframeCursor cursor;
+        for (size_t i = 0; i < count; i++)
+            out[i] = evaluate(handle, startMs + static_cast<double>(i) * stepMs, cursor);
+        return;
+    }
+
+    const double firstMs = static_cast<double>(keys->front().timeMs);
+    const double lastMs = static_cast<double>(keys->back().timeMs);
+    size_t segment = 0;
+    size_t i = 0;
+    while (i < count) {
+        const double t = startMs + static_cast<double>(i) * stepMs;
+        if (t <= firstMs || t >= lastMs) {
+            out[i++] = t <= firstMs ? keys->front().value : keys->back().value;
+            continue;
+        }
+
+        // Every sample before the segment's end key is evaluated with the same pair
+        segment = locateSegment(*keys, t, segment);
+        const Keyframe& a = (*keys)[segment];
+        const Keyframe& b = (*keys)[segment + 1];
+        const double endMs = static_cast<double>(b.timeMs);
+        size_t end = static_cast<size_t>(std::min<double>(static_cast<double>(count), std::ceil((endMs - startMs) / stepMs)));
+        while (end > i + 1 && startMs + static_cast<double>(end - 1) * stepMs >= endMs) end--;
+        end = std::max(end, i + 1);
+
+        switch (a.interpolation) {
+            case KeyframeInterpolation::Hold:
+                std::fill(out + i, out + end, a.value);
+                break;
+            case KeyframeInterpolation::Linear: {
+                // value(j) = base + j * increment, two samples per SSE2 op
+                const double slope = (b.value - a.value) / (endMs - static_cast<double>(a.timeMs));
+                const double base = a.value + (startMs - static_cast<double>(a.timeMs)) * slope;
+                const double increment = stepMs * slope;
+                size_t j = i;
+#ifdef AETHER_KEYFRAMES_SSE2
+                __m128d index = _mm_set_pd(static_cast<double>(j + 1), static_cast<double>(j));
+                const __m128d baseV = _mm_set1_pd(base);
+                const __m128d incrementV = _mm_set1_pd(increment);
+                const __m128d two = _mm_set1_pd(2.0);
+                for (; j + 2 <= end; j += 2) {
+                    _mm_storeu_pd(out + j, _mm_add_pd(baseV, _mm_mul_pd(index, incrementV)));
+                    index = _mm_add_pd(index, two);
+                }
+#endif
+                for (; j < end; j++)
+                    out[j] = base + static_cast<double>(j) * increment;
+                break;
             }
+            case KeyframeInterpolation::Bezier:
+                for (size_t j = i; j < end; j++)
+                    out[j] = interpolate(a, b, startMs + static_cast<double>(j) * stepMs);
+                break;
         }
-        return p.keyframes.back().value;
+        i = end;
     }
-    return 0.0;
 }
 
 } // namespace aether
@@ -6,6 +6,7 @@
 #include <QWheelEvent>
 #include <QVBoxLayout>
 #include <QLabel>
+#include <algorithm>
 
 namespace aether {
 
@@ -17,6 +18,7 @@ KeyframeTimelineWidget::KeyframeTimelineWidget(QWidget* parent)
 
 void KeyframeTimelineWidget::setModel(KeyframeModel* model) {
     m_model = model;
+    m_dragParam = -1;
     update();
 }
 
@@ -79,6 +81,8 @@ void KeyframeTimelineWidget::paintEvent(QPaintEvent*) {
             QString::fromStdString(params[i].displayName));
         p.setPen(QPen(QColor(70, 70, 74), 1));
         p.drawLine(m_paramNameWidth, rowY + m_rowHeight - 1, w, rowY + m_rowHeight - 1);
+        if (params[i].keyframes.size() > 1 && w > m_paramNameWidth)
+            drawValueCurve(p, static_cast<int>(i), rowY);
         for (size_t k = 0; k < params[i].keyframes.size(); k++) {
             QRect kr = keyframeRect(static_cast<int>(i), static_cast<int>(k));
             p.setBrush(QColor(94, 129, 172));
@@ -91,19 +95,61 @@ void KeyframeTimelineWidget::paintEvent(QPaintEvent*) {
     }
 }
 
+void KeyframeTimelineWidget::drawValueCurve(QPainter& p, int paramIndex, int rowY) {
+    // One sample per pixel column, evaluated in a single batch
+    const ParameterKeyframes& param = m_model->parameters()[static_cast<size_t>(paramIndex)];
+    const size_t columns = static_cast<size_t>(width() - m_paramNameWidth);
+    m_curveSamples.resize(columns);
+    m_model->sampleUniform(static_cast<ParameterHandle>(paramIndex), 0.0, 1000.0 / m_pixelsPerMs, columns,
+                           m_curveSamples.data());
+
+    const double range = param.maxValue > param.minValue ? param.maxValue - param.minValue : 1.0;
+    const double top = rowY + 3.0;
+    const double height = m_rowHeight - 6.0;
+    QPolygonF curve;
+    curve.reserve(static_cast<int>(columns));
+    for (size_t c = 0; c < columns; c++) {
+        const double normalized = std::clamp((m_curveSamples[c] - param.minValue) / range, 0.0, 1.0);
+        curve << QPointF(m_paramNameWidth + static_cast<double>(c), top + (1.0 - normalized) * height);
+    }
+    p.setPen(QPen(QColor(94, 129, 172, 110), 1));
+    p.drawPolyline(curve);
+}
+
 void KeyframeTimelineWidget::mousePressEvent(QMouseEvent* event) {
     if (event->pos().y() < m_rulerHeight && event->button() == Qt::LeftButton) {
         m_currentTimeMs = pixelToTime(event->pos().x());
         update();
         emit currentTimeChanged(m_currentTimeMs);
+    } else if (m_model && event->button() == Qt::LeftButton) {
+        const auto& params = m_model->parameters();
+        for (size_t i = 0; i < params.size() && m_dragParam < 0; i++) {
+            for (size_t k = 0; k < params[i].keyframes.size(); k++) {
+                if (keyframeRect(static_cast<int>(i), static_cast<int>(k)).contains(event->pos())) {
+                    m_dragParam = static_cast<int>(i);
+                    m_dragKey = k;
+                    break;
+                }
+            }
+        }
     }
     QWidget::mousePressEvent(event);
 }
 
 void KeyframeTimelineWidget::mouseMoveEvent(QMouseEvent* event) {
+    if (m_model && m_dragParam >= 0 && m_dragParam < static_cast<int>(m_model->parameters().size())) {
+        const std::string& id = m_model->parameters()[static_cast<size_t>(m_dragParam)].parameterId;
+        m_dragKey = m_model->setKeyframeTime(id, m_dragKey, pixelToTime(event->pos().x()));
+        update();
+    }
     QWidget::mouseMoveEvent(event);
 }
 
+void KeyframeTimelineWidget::mouseReleaseEvent(QMouseEvent* event) {
+    if (event->button() == Qt::LeftButton) m_dragParam = -1;
+    QWidget::mouseReleaseEvent(event);
+}
+
 void KeyframeTimelineWidget::wheelEvent(QWheelEvent* event) {
     if (event->angleDelta().y() != 0) {
         int delta = event->angleDelta().y() > 0 ? 1 : -1;
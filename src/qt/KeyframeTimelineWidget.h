@@ -1,7 +1,11 @@
 #pragma once
 
 #include <QWidget>
+#include <cstddef>
 #include <cstdint>
+#include <vector>
+
+class QPainter;
 
 namespace aether {
 
@@ -22,6 +26,7 @@ protected:
     void paintEvent(QPaintEvent* event) override;
     void mousePressEvent(QMouseEvent* event) override;
     void mouseMoveEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
     void wheelEvent(QWheelEvent* event) override;
 
 private:
@@ -29,6 +34,7 @@ private:
     int timeToPixel(int64_t ms) const;
     int64_t pixelToTime(int x) const;
     QRect keyframeRect(int paramIndex, int keyframeIndex) const;
+    void drawValueCurve(QPainter& p, int paramIndex, int rowY);
 
     KeyframeModel* m_model = nullptr;
     int64_t m_currentTimeMs = 0;
@@ -36,6 +42,9 @@ private:
     int m_rulerHeight = 24;
     int m_rowHeight = 28;
     int m_paramNameWidth = 120;
+    std::vector<double> m_curveSamples;
+    int m_dragParam = -1; // keyframe being dragged; m_dragKey follows it as it passes neighbours
+    size_t m_dragKey = 0;
 };
 
 } // namespace aether
@@ -10,13 +10,20 @@
 #include "PlaceholderPageWidget.h"
 #include "AnimationPageWidget.h"
 #include "ColorPageWidget.h"
+#include "VideoScopesWidget.h"
 #include "AudioPageWidget.h"
 #include "DeliverPageWidget.h"
+#include "RenderQueueWidget.h"
 #include "HomeWidget.h"
 #include "NewProjectDialog.h"
 #include "aether/ProjectSettings.h"
 #include "aether/ProjectFile.h"
+#include "aether/ProjectAutosaver.h"
+#include "aether/ExportEngine.h"
+#include "aether/DistributedExport.h"
+#include "aether/RenderQueue.h"
 #include "aether/PlaybackEngine.h"
+#include "aether/UndoRedo.h"
 
 #include <QByteArrayList>
 #include <QToolBar>
@@ -24,6 +31,7 @@
 #include <QMenu>
 #include <QAction>
 #include <QActionGroup>
+#include <QDir>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QStatusBar>
@@ -46,12 +54,11 @@
 #include <QTextStream>
 #include <QDialog>
 #include <QStringConverter>
-#include <QEventLoop>
 #include <QTimer>
 #include <QSpinBox>
 #include <QDialogButtonBox>
 #include <QFormLayout>
-#ifdef AETHER_QT_MULTIMEDIA
+#if defined(AETHER_QT_MULTIMEDIA) && !defined(AETHER_FFMPEG_ENABLED)
 #include <QMediaPlayer>
 #include <QMediaMetaData>
 #endif
@@ -60,53 +67,50 @@
 
 namespace aether {
 
-#ifdef AETHER_QT_MULTIMEDIA
-struct ProbeResult { int width = 0; int height = 0; int fps = 0; qint64 durationMs = 0; };
-static ProbeResult probeMediaFile(const QString& path) {
-    ProbeResult r;
-    QMediaPlayer player;
-    QEventLoop loop;
-    QTimer timeout;
-    timeout.setSingleShot(true);
-    connect(&timeout, &QTimer::timeout, &loop, &QEventLoop::quit);
-    auto onMeta = [&]() {
-        QMediaMetaData md = player.metaData();
+// Length given to a clip added before its media was probed, until the probe reports
+constexpr qint64 kPlaceholderClipMs = 60000;
+
+#if defined(AETHER_QT_MULTIMEDIA) && !defined(AETHER_FFMPEG_ENABLED)
+// Without libavformat the probe service cannot read anything; ask a QMediaPlayer
+// instead. It loads the file in the background; onResult runs once on the GUI
+// thread, when the media is loaded, fails to load, or after 3 s.
+static void probeWithMediaPlayer(QObject* context, const QString& path,
+                                 std::function<void(const MediaProbeResult&)> onResult) {
+    QMediaPlayer* player = new QMediaPlayer(context);
+    QTimer* timeout = new QTimer(player);
+    timeout->setSingleShot(true);
+    auto done = std::make_shared<bool>(false);
+    auto finish = [player, path, onResult, done]() {
+        if (*done) return;
+        *done = true;
+        MediaProbeResult r;
+        r.path = path;
+        const QMediaMetaData md = player->metaData();
         if (md.contains(QMediaMetaData::Key::Resolution)) {
-            QSize res = md.value(QMediaMetaData::Key::Resolution).toSize();
+            const QSize res = md.value(QMediaMetaData::Key::Resolution).toSize();
             r.width = res.width();
             r.height = res.height();
         }
         if (md.contains(QMediaMetaData::Key::VideoFrameRate)) {
-            qreal fr = md.value(QMediaMetaData::Key::VideoFrameRate).toReal();
+            const qreal fr = md.value(QMediaMetaData::Key::VideoFrameRate).toReal();
             r.fps = (fr > 0 && fr < 1000) ? static_cast<int>(fr + 0.5) : 0;
         }
-        if (player.duration() > 0)
-            r.durationMs = player.duration();
-        loop.quit();
+        r.durationMs = std::max<qint64>(player->duration(), 0);
+        r.hasVideo = player->hasVideo();
+        r.hasAudio = player->hasAudio();
+        r.ok = r.hasVideo || r.hasAudio;
+        if (!r.ok) r.error = QStringLiteral("Could not read the file");
+        player->deleteLater();
+        onResult(r);
     };
-    connect(&player, &QMediaPlayer::metaDataChanged, &loop, [&]() { onMeta(); });
-    connect(&player, &QMediaPlayer::durationChanged, &loop, [&]() { onMeta(); });
-    connect(&player, &QMediaPlayer::errorOccurred, &loop, &QEventLoop::quit);
-    player.setSource(QUrl::fromLocalFile(path));
-    timeout.start(3000);
-    loop.exec();
-    timeout.stop();
-    if (r.durationMs == 0 && player.duration() > 0)
-        r.durationMs = player.duration();
-    if (r.width == 0 && player.metaData().contains(QMediaMetaData::Key::Resolution)) {
-        QSize res = player.metaData().value(QMediaMetaData::Key::Resolution).toSize();
-        r.width = res.width();
-        r.height = res.height();
-    }
-    if (r.fps == 0 && player.metaData().contains(QMediaMetaData::Key::VideoFrameRate)) {
-        qreal fr = player.metaData().value(QMediaMetaData::Key::VideoFrameRate).toReal();
-        r.fps = (fr > 0 && fr < 1000) ? static_cast<int>(fr + 0.5) : 0;
-    }
-    return r;
+    QObject::connect(player, &QMediaPlayer::mediaStatusChanged, player, [finish](QMediaPlayer::MediaStatus status) {
+        if (status == QMediaPlayer::LoadedMedia || status == QMediaPlayer::InvalidMedia) finish();
+    });
+    QObject::connect(player, &QMediaPlayer::errorOccurred, player, [finish]() { finish(); });
+    QObject::connect(timeout, &QTimer::timeout, player, [finish]() { finish(); });
+    player->setSource(QUrl::fromLocalFile(path));
+    timeout->start(3000);
 }
-#else
-struct ProbeResult { int width = 0; int height = 0; int fps = 0; qint64 durationMs = 0; };
-static ProbeResult probeMediaFile(const QString&) { return ProbeResult{}; }
 #endif
 
 MainWindow::MainWindow(QWidget* parent)
@@ -130,6 +134,38 @@ MainWindow::MainWindow(QWidget* parent)
     // In Qt6 setVulkanInstance is on QWindow; set on render view when it is created (e.g. in MonitorWidget)
 
     m_projectModel.reset(new ProjectModel(this));
+    m_projectModel->setUndoEnabled(true);
+
+    // Autosave after a pause in editing and every minute regardless; a save with
+    // nothing changed writes nothing, which also covers edits that do not signal
+    m_autosaver.reset(new ProjectAutosaver([this](bool ok, const ProjectSaveStats& stats) {
+        if (!ok || stats.chunksWritten == 0) return;
+        QMetaObject::invokeMethod(this, [this, stats]() {
+            statusBar()->showMessage(tr("Autosaved (%1 KB, %2 ms)")
+                .arg(static_cast<double>(stats.bytesWritten) / 1024.0, 0, 'f', 1)
+                .arg(stats.milliseconds, 0, 'f', 1), 2000);
+        }, Qt::QueuedConnection);
+    }));
+    m_autosaveTimer = new QTimer(this);
+    m_autosaveTimer->setInterval(60 * 1000);
+    connect(m_autosaveTimer, &QTimer::timeout, this, &MainWindow::onAutosave);
+    m_autosaveIdleTimer = new QTimer(this);
+    m_autosaveIdleTimer->setSingleShot(true);
+    m_autosaveIdleTimer->setInterval(2000);
+    connect(m_autosaveIdleTimer, &QTimer::timeout, this, &MainWindow::onAutosave);
+    connect(m_projectModel.data(), &ProjectModel::tracksChanged, this, &MainWindow::scheduleAutosave);
+    connect(m_projectModel.data(), &ProjectModel::mediaListChanged, this, &MainWindow::scheduleAutosave);
+
+    // Probe results arrive one by one from the probe threads; apply them in batches
+    // so importing a card rebuilds the media list a few times, not once per file
+    m_probeFlushTimer = new QTimer(this);
+    m_probeFlushTimer->setSingleShot(true);
+    m_probeFlushTimer->setInterval(100);
+    connect(m_probeFlushTimer, &QTimer::timeout, this, &MainWindow::flushProbeResults);
+    m_mediaProbe.reset(new MediaProbeService([this](const MediaProbeResult& result) {
+        QMetaObject::invokeMethod(this, [this, result]() { queueProbeResult(result); }, Qt::QueuedConnection);
+    }, QApplication::applicationDirPath() + QLatin1String("/media_cache.bin")));
+
     setupDarkTheme();
     setupMenuBar();
     setupToolsToolbar();
@@ -141,6 +177,18 @@ MainWindow::MainWindow(QWidget* parent)
 }
 
 MainWindow::~MainWindow() {
+    // Finishes the queued autosave; its callback only posts events to this window
+    m_autosaver.reset();
+    m_mediaProbe.reset();
+    // Cancels a running export and joins its threads
+    m_exportEngine.reset();
+    m_distributedExport.reset();
+    // Stops listening for render nodes; they reconnect when the next distributed export starts
+    AetherLink::getInstance().shutdown();
+    // Stops the queue's jobs; they resume from their finished chunks next time
+    m_renderQueue.reset();
+    // The history's actions point at m_projectModel
+    UndoRedoManager::getInstance().clear();
     m_renderView = nullptr;
     m_renderContainer = nullptr;
 }
@@ -196,8 +244,10 @@ void MainWindow::setupMenuBar() {
             tr("Aether Project (*.aether);;All Files (*)"));
         if (!path.isEmpty()) onOpenProjectPath(path);
     });
+    fileMenu->addAction(tr("Save project"), QKeySequence::Save, this, &MainWindow::onSaveProject);
     fileMenu->addAction(tr("Import media..."), QKeySequence(Qt::CTRL | Qt::Key_I), this, &MainWindow::onImportMedia);
     fileMenu->addAction(tr("Export..."), QKeySequence(Qt::CTRL | Qt::Key_M), this, &MainWindow::onExport);
+    fileMenu->addAction(tr("Export on Render Nodes..."), this, &MainWindow::onExportOnRenderNodes);
     fileMenu->addSeparator();
     fileMenu->addAction(tr("Settings..."), this, &MainWindow::onSettings);
     fileMenu->addSeparator();
@@ -407,10 +457,25 @@ void MainWindow::setupCentralArea() {
     connect(m_mediaPage, &MediaPageWidget::addToTimelineRequested, this, &MainWindow::onAddToTimeline);
     m_stackedPages->addWidget(m_mediaPage);
     m_stackedPages->addWidget(m_centralSplitter);
-    m_stackedPages->addWidget(new AnimationPageWidget(this));
-    m_stackedPages->addWidget(new ColorPageWidget(this));
+    m_animationPage = new AnimationPageWidget(this);
+    m_stackedPages->addWidget(m_animationPage);
+    ColorPageWidget* colorPage = new ColorPageWidget(this);
+    m_stackedPages->addWidget(colorPage);
+    // Scopes ignore frames while the Color page is hidden, so this costs nothing elsewhere
+    connect(m_playbackEngine.get(), &PlaybackEngine::frameReady, colorPage, [this, colorPage]() {
+        if (colorPage->isVisible()) colorPage->scopes()->setFrame(m_playbackEngine->getCurrentFrame());
+    });
     m_stackedPages->addWidget(new AudioPageWidget(this));
-    m_stackedPages->addWidget(new DeliverPageWidget(this));
+    // Jobs left rendering when the application last stopped carry on from here
+    m_renderQueue.reset(new RenderQueue(QApplication::applicationDirPath() + QLatin1String("/render_queue"), [this]() {
+        QMetaObject::invokeMethod(this, [this]() {
+            if (m_renderQueueWidget) m_renderQueueWidget->refresh();
+        }, Qt::QueuedConnection);
+    }));
+    DeliverPageWidget* deliverPage = new DeliverPageWidget(m_renderQueue.get(), this);
+    m_renderQueueWidget = deliverPage->renderQueue();
+    connect(m_renderQueueWidget, &RenderQueueWidget::addRequested, this, &MainWindow::onAddRenderJob);
+    m_stackedPages->addWidget(deliverPage);
 
     m_pageBar = new PageBarWidget(this);
     connect(m_pageBar, &PageBarWidget::pageChanged, this, &MainWindow::onPageChanged);
@@ -427,6 +492,8 @@ void MainWindow::setupCentralArea() {
 
 void MainWindow::enterHomeState() {
     m_appState = AppState::Home;
+    if (m_autosaveTimer) m_autosaveTimer->stop();
+    if (m_autosaveIdleTimer) m_autosaveIdleTimer->stop();
     m_stackedPages->setCurrentIndex(0);
     m_currentPage = 0;
     if (m_pageBar) m_pageBar->hide();
@@ -450,6 +517,7 @@ void MainWindow::enterProjectState() {
     if (m_toolsToolbar) m_toolsToolbar->setVisible(true);
     if (m_timeline) m_timeline->setFocus();
     if (m_monitor) m_monitor->setProjectFps(m_projectSettings.fps);
+    if (m_autosaveTimer) m_autosaveTimer->start();
 }
 
 void MainWindow::setupPageNavigation() {
@@ -546,54 +614,132 @@ void MainWindow::doImportMedia() {
 
 void MainWindow::doImportMediaPaths(const QStringList& paths) {
     if (paths.isEmpty()) return;
-    int n = 0;
+    QStringList imported;
     for (const QString& path : paths) {
         QFileInfo fi(path);
         if (!fi.exists()) continue;
-        m_projectModel->addMedia(path, fi.fileName(), 0, true, path.endsWith(QStringLiteral(".mp3"), Qt::CaseInsensitive) || path.endsWith(QStringLiteral(".wav"), Qt::CaseInsensitive) ? false : true);
-        n++;
+        // A guess from the extension until the probe reports the streams
+        const bool audioOnly = path.endsWith(QStringLiteral(".mp3"), Qt::CaseInsensitive)
+                            || path.endsWith(QStringLiteral(".wav"), Qt::CaseInsensitive);
+        m_projectModel->addMedia(path, fi.fileName(), 0, !audioOnly, audioOnly);
+        imported.append(path);
     }
-    if (n > 0) statusBar()->showMessage(tr("Imported %1 file(s)").arg(n), 3000);
+    requestProbes(imported);
+    if (!imported.isEmpty()) statusBar()->showMessage(tr("Imported %1 file(s)").arg(imported.size()), 3000);
+}
+
+void MainWindow::requestProbes(const QStringList& paths) {
+#ifdef AETHER_FFMPEG_ENABLED
+    for (const QString& path : paths)
+        m_mediaProbe->request(path);
+#else
+    // Every probe would fail; clips are read when they are added to the timeline
+    (void)paths;
+#endif
+}
+
+void MainWindow::queueProbeResult(const MediaProbeResult& result) {
+    m_probeResults.push_back(result);
+    if (!m_probeFlushTimer->isActive()) m_probeFlushTimer->start();
+}
+
+void MainWindow::flushProbeResults() {
+    if (m_probeResults.empty()) return;
+    std::vector<MediaProbeResult> results;
+    results.swap(m_probeResults);
+    int failed = 0;
+    for (const MediaProbeResult& r : results) {
+        if (!r.ok) failed++;
+    }
+    m_projectModel->applyProbeResults(results);
+    fitPlaceholderClips(results);
+    if (m_timeline) m_timeline->update();
+    if (!m_matchSequencePath.isEmpty()) {
+        for (const MediaProbeResult& r : results) {
+            if (r.path != m_matchSequencePath) continue;
+            m_matchSequencePath.clear();
+            if (r.ok && r.hasVideo) offerSequenceMatch(r.path);
+            break;
+        }
+    }
+    if (m_mediaProbe->getPendingCount() > 0)
+        statusBar()->showMessage(tr("Reading media info... %1 left").arg(m_mediaProbe->getPendingCount()), 2000);
+    else if (failed > 0)
+        statusBar()->showMessage(tr("Could not read %1 file(s)").arg(failed), 3000);
 }
 
 void MainWindow::onImportMedia() {
     doImportMedia();
 }
 
-void MainWindow::onAddToTimeline(const QString& mediaPath) {
-    const auto& tracks = m_projectModel->tracks();
-    int totalClips = 0;
-    for (const Track& t : tracks)
-        totalClips += t.clips.size();
-    bool isFirstClip = (totalClips == 0);
-
-    qint64 startMs = 0;
-    for (const Track& t : tracks) {
-        for (const TimelineClip& c : t.clips) {
-            qint64 end = c.timelineStartMs + (c.sourceOutMs - c.sourceInMs);
-            if (end > startMs) startMs = end;
+void MainWindow::fitPlaceholderClips(const std::vector<MediaProbeResult>& results) {
+    for (const MediaProbeResult& r : results) {
+        for (size_t i = 0; i < m_placeholderClips.size();) {
+            if (m_placeholderClips[i].mediaPath != r.path) {
+                i++;
+                continue;
+            }
+            const PlaceholderClip placeholder = m_placeholderClips[i];
+            m_placeholderClips.erase(m_placeholderClips.begin() + static_cast<std::ptrdiff_t>(i));
+            if (!r.ok || r.isStill || r.durationMs <= 0) continue;
+            const auto& tracks = m_projectModel->tracks();
+            if (placeholder.trackIndex >= tracks.size()) continue;
+            const Track& track = tracks[placeholder.trackIndex];
+            std::vector<int> candidates;
+            track.clipsInRange(placeholder.timelineStartMs, placeholder.timelineStartMs, candidates);
+            for (int index : candidates) {
+                const TimelineClip& clip = track.clips[index];
+                // Leave it alone once the user has moved or trimmed it
+                if (clip.mediaPath != placeholder.mediaPath || clip.timelineStartMs != placeholder.timelineStartMs
+                    || clip.sourceInMs != 0 || clip.sourceOutMs != kPlaceholderClipMs)
+                    continue;
+                qint64 outMs = r.durationMs;
+                // Clips placed after the placeholder keep their place
+                if (index + 1 < track.clips.size()) {
+                    const qint64 roomMs = track.clips[index + 1].timelineStartMs - clip.timelineStartMs;
+                    outMs = std::min(outMs, static_cast<qint64>(roomMs * clip.speedRatio));
+                }
+                if (outMs > 0 && outMs != clip.sourceOutMs)
+                    m_projectModel->setClipInOut(placeholder.trackIndex, index, 0, outMs);
+                break;
+            }
         }
     }
-    qint64 durationMs = 60000;
-    bool isVideo = true;
+}
+
+void MainWindow::offerSequenceMatch(const QString& mediaPath) {
+    QMessageBox::StandardButton btn = QMessageBox::question(this, tr("Match sequence settings"),
+        tr("Match sequence settings to this clip?\n(Resolution and frame rate will be set from the clip.)"),
+        QMessageBox::Yes | QMessageBox::No, QMessageBox::Yes);
+    if (btn != QMessageBox::Yes) return;
+    int w = 1920, h = 1080, f = 30;
     for (const MediaItem& m : m_projectModel->media()) {
         if (m.path == mediaPath) {
-            durationMs = m.durationMs > 0 ? m.durationMs : 60000;
-            isVideo = m.isVideo;
+            if (m.width > 0 && m.height > 0) { w = m.width; h = m.height; }
+            if (m.fps > 0 && m.fps <= 120) f = m.fps;
             break;
         }
     }
+    m_projectSettings.width = w;
+    m_projectSettings.height = h;
+    m_projectSettings.fps = f;
+    if (m_monitor) m_monitor->setProjectFps(f);
+    statusBar()->showMessage(tr("Sequence settings matched to clip (%1×%2, %3 fps)").arg(w).arg(h).arg(f), 3000);
+}
 
-    if (isVideo) {
-        const MediaItem* item = nullptr;
-        for (const MediaItem& m : m_projectModel->media()) {
-            if (m.path == mediaPath) { item = &m; break; }
-        }
-        if (item && (item->width <= 0 || item->height <= 0)) {
-            ProbeResult r = probeMediaFile(mediaPath);
-            m_projectModel->setMediaMetadataByPath(mediaPath, r.width, r.height, r.fps);
-            if (r.durationMs > 0)
-                durationMs = r.durationMs;
+void MainWindow::onAddToTimeline(const QString& mediaPath) {
+    const auto& tracks = m_projectModel->tracks();
+    const bool isFirstClip = std::all_of(tracks.begin(), tracks.end(), [](const Track& t) { return t.clips.isEmpty(); });
+    const qint64 startMs = m_projectModel->sequenceDurationMs();
+    qint64 durationMs = 0;
+    bool isVideo = true;
+    bool probed = false;
+    for (const MediaItem& m : m_projectModel->media()) {
+        if (m.path == mediaPath) {
+            durationMs = m.durationMs;
+            isVideo = m.isVideo;
+            probed = m.probed;
+            break;
         }
     }
 
@@ -601,27 +747,23 @@ void MainWindow::onAddToTimeline(const QString& mediaPath) {
     for (int i = 0; i < tracks.size(); i++) {
         if (tracks[i].isVideo) { videoTrack = i; break; }
     }
-    m_projectModel->addClipToTrack(videoTrack, mediaPath, 0, durationMs, startMs);
+    m_projectModel->addClipToTrack(videoTrack, mediaPath, 0, durationMs > 0 ? durationMs : kPlaceholderClipMs, startMs);
+
+    if (!probed) {
+        // Added before its probe finished: the result fits the clip and answers the question below
+        if (durationMs <= 0) m_placeholderClips.push_back({mediaPath, videoTrack, startMs});
+#ifdef AETHER_FFMPEG_ENABLED
+        m_mediaProbe->request(mediaPath);
+#elif defined(AETHER_QT_MULTIMEDIA)
+        probeWithMediaPlayer(this, mediaPath, [this](const MediaProbeResult& result) { queueProbeResult(result); });
+#endif
+    }
 
     if (isFirstClip && isVideo) {
-        QMessageBox::StandardButton btn = QMessageBox::question(this, tr("Match sequence settings"),
-            tr("Match sequence settings to this clip?\n(Resolution and frame rate will be set from the clip.)"),
-            QMessageBox::Yes | QMessageBox::No, QMessageBox::Yes);
-        if (btn == QMessageBox::Yes) {
-            int w = 1920, h = 1080, f = 30;
-            for (const MediaItem& m : m_projectModel->media()) {
-                if (m.path == mediaPath) {
-                    if (m.width > 0 && m.height > 0) { w = m.width; h = m.height; }
-                    if (m.fps > 0 && m.fps <= 120) f = m.fps;
-                    break;
-                }
-            }
-            m_projectSettings.width = w;
-            m_projectSettings.height = h;
-            m_projectSettings.fps = f;
-            if (m_monitor) m_monitor->setProjectFps(f);
-            statusBar()->showMessage(tr("Sequence settings matched to clip (%1×%2, %3 fps)").arg(w).arg(h).arg(f), 3000);
-        }
+        if (probed)
+            offerSequenceMatch(mediaPath);
+        else
+            m_matchSequencePath = mediaPath;
     }
 
     m_timeline->update();
@@ -699,22 +841,17 @@ void MainWindow::updateMonitorForPlayhead() {
     m_currentMonitorClipTimelineStartMs = -1;
     for (const Track& t : tracks) {
         if (!t.isVideo) continue;
-        for (const TimelineClip& c : t.clips) {
-            qint64 span = (c.speedRatio > 0.001)
-                ? static_cast<qint64>((c.sourceOutMs - c.sourceInMs) / c.speedRatio)
-                : (c.sourceOutMs - c.sourceInMs);
-            qint64 end = c.timelineStartMs + span;
-            if (ms >= c.timelineStartMs && ms < end) {
-                qint64 posInClip = c.sourceInMs + static_cast<qint64>((ms - c.timelineStartMs) * c.speedRatio);
-                QString pathToUse = resolveProxyPath(c.mediaPath);
-                m_monitor->setSource(pathToUse.isEmpty() ? c.mediaPath : pathToUse);
-                m_monitor->setPositionMs(posInClip);
-                m_currentMonitorClipTimelineStartMs = c.timelineStartMs;
-                m_currentMonitorClipSourceInMs = c.sourceInMs;
-                m_currentMonitorClipSpeedRatio = c.speedRatio;
-                return;
-            }
-        }
+        const int clip = t.clipAt(ms);
+        if (clip < 0) continue;
+        const TimelineClip& c = t.clips[clip];
+        qint64 posInClip = c.sourceInMs + static_cast<qint64>((ms - c.timelineStartMs) * c.speedRatio);
+        QString pathToUse = resolveProxyPath(c.mediaPath);
+        m_monitor->setSource(pathToUse.isEmpty() ? c.mediaPath : pathToUse);
+        m_monitor->setPositionMs(posInClip);
+        m_currentMonitorClipTimelineStartMs = c.timelineStartMs;
+        m_currentMonitorClipSourceInMs = c.sourceInMs;
+        m_currentMonitorClipSpeedRatio = c.speedRatio;
+        return;
     }
     m_monitor->setPositionMs(ms);
 }
@@ -783,14 +920,27 @@ void MainWindow::onNewProject() {
     if (!safeName.endsWith(QLatin1String(".aether")))
         safeName += QLatin1String(".aether");
     QString projectPath = location + QLatin1Char('/') + safeName;
-    if (!ProjectFile::saveToPath(projectPath, dlg.projectName(), location, m_projectSettings)) {
-        QMessageBox::critical(this, tr("New Project"), tr("Could not create project file at:\n%1").arg(projectPath));
-        return;
+    m_projectModel->resetContents({}, {});
+    m_placeholderClips.clear();
+    m_matchSequencePath.clear();
+    if (m_animationPage) {
+        m_animationPage->nodeGraph()->clear();
+        m_animationPage->keyframeModel()->setParameters({});
+        m_animationPage->modelsReloaded();
     }
+    UndoRedoManager::getInstance().clear();
+    m_projectWriter.reset();
     m_currentProjectPath = projectPath;
+    m_currentProjectName = name;
+    m_currentProjectLocation = location;
+    if (!m_projectWriter.save(projectPath, captureProject())) {
+        QMessageBox::critical(this, tr("New Project"), tr("Could not create project file at:\n%1\n%2")
+            .arg(projectPath, m_projectWriter.getLastError()));
+        m_currentProjectPath.clear();
+        return;
+    }
     appendToRecentProjects(projectPath);
-    m_projectModel->clearMedia();
-    m_projectModel->clearAllClips();
+    m_autosaveIdleTimer->stop();
     m_timeline->setPlayheadPositionMs(0);
     m_monitor->clearSource();
     if (m_timeline) m_timeline->update();
@@ -798,22 +948,75 @@ void MainWindow::onNewProject() {
     statusBar()->showMessage(tr("Project created: %1").arg(projectPath), 3000);
 }
 
+void MainWindow::onSaveProject() {
+    if (m_currentProjectPath.isEmpty()) {
+        statusBar()->showMessage(tr("No project to save"), 2000);
+        return;
+    }
+    ProjectSaveStats stats;
+    if (!m_projectWriter.save(m_currentProjectPath, captureProject(), &stats)) {
+        QMessageBox::critical(this, tr("Save Project"), tr("Could not save project:\n%1").arg(m_projectWriter.getLastError()));
+        return;
+    }
+    statusBar()->showMessage(tr("Project saved (%1 KB, %2 ms)")
+        .arg(static_cast<double>(stats.bytesWritten) / 1024.0, 0, 'f', 1)
+        .arg(stats.milliseconds, 0, 'f', 1), 3000);
+}
+
+void MainWindow::onAutosave() {
+    m_autosaveIdleTimer->stop();
+    if (m_appState != AppState::Project || m_currentProjectPath.isEmpty()) return;
+    m_autosaver->submit(m_currentProjectPath, captureProject());
+}
+
+void MainWindow::scheduleAutosave() {
+    if (m_appState == AppState::Project) m_autosaveIdleTimer->start();
+}
+
+ProjectDocument MainWindow::captureProject() const {
+    return ProjectFile::capture(*m_projectModel,
+        m_animationPage ? m_animationPage->nodeGraph() : nullptr,
+        m_animationPage ? m_animationPage->keyframeModel() : nullptr,
+        m_currentProjectName, m_currentProjectLocation, m_projectSettings);
+}
+
 void MainWindow::onOpenProjectPath(const QString& path) {
     if (path.isEmpty() || !QFileInfo::exists(path)) {
         QMessageBox::warning(this, tr("Open Project"), tr("File not found: %1").arg(path));
         return;
     }
-    QString name, location;
+    QString loadPath = path;
+    if (ProjectAutosaver::hasNewerAutosave(path)
+        && QMessageBox::question(this, tr("Open Project"),
+               tr("An autosave newer than the saved project was found.\nRecover the autosaved version?"))
+               == QMessageBox::Yes) {
+        loadPath = ProjectAutosaver::autosavePathFor(path);
+    }
+    QString name, location, error;
     ProjectSettings loaded;
-    if (!ProjectFile::loadFromPath(path, &name, &location, &loaded)) {
-        QMessageBox::critical(this, tr("Open Project"), tr("Could not load project file."));
+    if (!ProjectFile::loadProject(loadPath, *m_projectModel, m_animationPage ? m_animationPage->nodeGraph() : nullptr,
+                                  m_animationPage ? m_animationPage->keyframeModel() : nullptr,
+                                  &name, &location, &loaded, &error)) {
+        QMessageBox::critical(this, tr("Open Project"), tr("Could not load project file.\n%1").arg(error));
         return;
     }
+    if (m_animationPage) m_animationPage->modelsReloaded();
+    m_placeholderClips.clear();
+    m_matchSequencePath.clear();
+    QStringList unprobed;
+    for (const MediaItem& m : m_projectModel->media()) {
+        if (!m.probed) unprobed.append(m.path);
+    }
+    requestProbes(unprobed);
     m_projectSettings = loaded;
     m_currentProjectPath = path;
+    m_currentProjectName = name;
+    m_currentProjectLocation = location;
     appendToRecentProjects(path);
-    m_projectModel->clearMedia();
-    m_projectModel->clearAllClips();
+    UndoRedoManager::getInstance().clear();
+    // Our writer did not produce this file; its first save rewrites it in full
+    m_projectWriter.reset();
+    m_autosaveIdleTimer->stop();
     m_timeline->setPlayheadPositionMs(0);
     m_monitor->clearSource();
     if (m_timeline) m_timeline->update();
@@ -843,11 +1046,21 @@ void MainWindow::appendToRecentProjects(const QString& path) {
 }
 
 void MainWindow::onUndo() {
-    statusBar()->showMessage(tr("Undo"), 2000);
+    auto& undoRedo = UndoRedoManager::getInstance();
+    const QString description = QString::fromStdString(undoRedo.getUndoDescription());
+    if (undoRedo.undo())
+        statusBar()->showMessage(tr("Undo %1").arg(description), 2000);
+    else
+        statusBar()->showMessage(tr("Nothing to undo"), 2000);
 }
 
 void MainWindow::onRedo() {
-    statusBar()->showMessage(tr("Redo"), 2000);
+    auto& undoRedo = UndoRedoManager::getInstance();
+    const QString description = QString::fromStdString(undoRedo.getRedoDescription());
+    if (undoRedo.redo())
+        statusBar()->showMessage(tr("Redo %1").arg(description), 2000);
+    else
+        statusBar()->showMessage(tr("Nothing to redo"), 2000);
 }
 
 void MainWindow::onCut() {
@@ -911,8 +1124,145 @@ void MainWindow::onPrevMarker() {
     statusBar()->showMessage(tr("Go to Previous Marker"), 2000);
 }
 
+bool MainWindow::makeExportRequest(const QString& title, ExportRequest& request) {
+    const QString suggested = QDir(m_currentProjectLocation).filePath(
+        (m_currentProjectName.isEmpty() ? QStringLiteral("Untitled") : m_currentProjectName) + QStringLiteral(".mp4"));
+    const QString path = QFileDialog::getSaveFileName(this, title, suggested,
+                                                      tr("Video (*.mp4 *.mov *.mkv);;All Files (*)"));
+    if (path.isEmpty()) return false;
+
+    request.project = captureProject();
+    request.params.outputPath = path.toStdString();
+    request.params.width = static_cast<uint32_t>(m_projectSettings.width);
+    request.params.height = static_cast<uint32_t>(m_projectSettings.height);
+    request.params.fps = m_projectSettings.fps;
+    request.params.bitrateKbps = static_cast<uint32_t>(m_projectSettings.bitrateKbps);
+    request.params.gopSize = static_cast<uint32_t>(m_projectSettings.fps) * 2;
+    return true;
+}
+
+bool MainWindow::confirmCancelExport() {
+    const bool local = m_exportEngine && m_exportEngine->isRunning();
+    const bool onNodes = m_distributedExport && m_distributedExport->isRunning();
+    if (!local && !onNodes) return false;
+    if (QMessageBox::question(this, tr("Export"), tr("An export is running. Cancel it?")) == QMessageBox::Yes) {
+        if (local) m_exportEngine->cancel();
+        if (onNodes) m_distributedExport->cancel();
+    }
+    return true;
+}
+
 void MainWindow::onExport() {
-    statusBar()->showMessage(tr("Export — use File > Export to render sequence"), 4000);
+    if (m_appState != AppState::Project || !m_projectModel) return;
+    if (confirmCancelExport()) return;
+    ExportRequest request;
+    if (!makeExportRequest(tr("Export"), request)) return;
+
+    if (!m_exportEngine) m_exportEngine.reset(new ExportEngine);
+    m_exportOnNodes = false;
+    const bool started = m_exportEngine->start(request, createEncoderBackend(), [this](const ExportStats&) {
+        QMetaObject::invokeMethod(this, [this]() { updateExportProgress(); }, Qt::QueuedConnection);
+    });
+    if (!started) {
+        QMessageBox::warning(this, tr("Export"),
+                             tr("Could not start the export:\n%1").arg(QString::fromStdString(m_exportEngine->getLastError())));
+        return;
+    }
+    if (!m_exportProgressTimer) {
+        m_exportProgressTimer = new QTimer(this);
+        m_exportProgressTimer->setInterval(500);
+        connect(m_exportProgressTimer, &QTimer::timeout, this, &MainWindow::updateExportProgress);
+    }
+    m_exportProgressTimer->start();
+    updateExportProgress();
+}
+
+void MainWindow::onExportOnRenderNodes() {
+    if (m_appState != AppState::Project || !m_projectModel) return;
+    if (confirmCancelExport()) return;
+    AetherLink& link = AetherLink::getInstance();
+    if (!link.isServerRunning()) {
+        link.setAutoDiscovery(true);
+        if (!link.initialize(NodeRole::Master) || !link.startServer()) {
+            QMessageBox::warning(this, tr("Export on Render Nodes"), tr("Could not listen for render nodes."));
+            return;
+        }
+    }
+    ExportRequest request;
+    if (!makeExportRequest(tr("Export on Render Nodes"), request)) return;
+
+    if (!m_distributedExport) m_distributedExport.reset(new DistributedExport(link));
+    m_exportOnNodes = true;
+    // Chunks are kept next to the output until it is joined, so a cancelled export resumes
+    const std::string workDir = request.params.outputPath + ".chunks";
+    const bool started = m_distributedExport->start(request, workDir, [this](const ExportStats&) {
+        QMetaObject::invokeMethod(this, [this]() { updateExportProgress(); }, Qt::QueuedConnection);
+    });
+    if (!started) {
+        QMessageBox::warning(this, tr("Export on Render Nodes"),
+                             tr("Could not start the export:\n%1").arg(QString::fromStdString(m_distributedExport->getLastError())));
+        return;
+    }
+    if (link.getConnectedNodes().empty())
+        QMessageBox::information(this, tr("Export on Render Nodes"),
+                                 tr("No render node is connected yet. Start one with\n"
+                                    "AetherStudioQt --render-node <this machine>:%1\n"
+                                    "on each machine; the export begins as they connect.").arg(link.getPort()));
+    if (!m_exportProgressTimer) {
+        m_exportProgressTimer = new QTimer(this);
+        m_exportProgressTimer->setInterval(500);
+        connect(m_exportProgressTimer, &QTimer::timeout, this, &MainWindow::updateExportProgress);
+    }
+    m_exportProgressTimer->start();
+    updateExportProgress();
+}
+
+void MainWindow::onAddRenderJob() {
+    if (m_appState != AppState::Project || !m_projectModel || !m_renderQueue) return;
+    ExportRequest request;
+    if (!makeExportRequest(tr("Add to Render Queue"), request)) return;
+    const QString name = QFileInfo(QString::fromStdString(request.params.outputPath)).completeBaseName();
+    std::string error;
+    if (m_renderQueue->submit(request, name, 0, &error).isEmpty()) {
+        QMessageBox::warning(this, tr("Render Queue"),
+                             tr("Could not add the job:\n%1").arg(QString::fromStdString(error)));
+        return;
+    }
+    m_renderQueueWidget->refresh();
+}
+
+void MainWindow::updateExportProgress() {
+    if (m_exportOnNodes ? !m_distributedExport : !m_exportEngine) return;
+    const ExportStats stats = m_exportOnNodes ? m_distributedExport->getStats() : m_exportEngine->getStats();
+    if (stats.finished) {
+        if (m_exportProgressTimer) m_exportProgressTimer->stop();
+        if (stats.ok) {
+            QString message = tr("Export finished: %1 frames in %2 s (%3 fps)")
+                                  .arg(stats.framesDone).arg(stats.elapsedMs / 1000.0, 0, 'f', 1).arg(stats.fps, 0, 'f', 1);
+            if (stats.copiedFrames > 0) message += tr(", %1 copied without re-encoding").arg(stats.copiedFrames);
+            if (!stats.copyRejections.empty()) {
+                // Smart render fell back to encoding somewhere; say why
+                message += tr("; re-encoded %1").arg(QString::fromStdString(stats.copyRejections.front()));
+                if (stats.copyRejections.size() > 1)
+                    message += tr(" and %1 more").arg(stats.copyRejections.size() - 1);
+            }
+            statusBar()->showMessage(message, 8000);
+        } else {
+            statusBar()->showMessage(tr("Export failed: %1").arg(QString::fromStdString(stats.error)), 8000);
+        }
+        return;
+    }
+    // The busiest stage is the one holding the others back
+    const ExportStageStats* busiest = nullptr;
+    for (const ExportStageStats& stage : stats.stages) {
+        if (!busiest || stage.utilisation > busiest->utilisation) busiest = &stage;
+    }
+    const int percent = stats.totalFrames > 0 ? static_cast<int>(stats.framesDone * 100 / stats.totalFrames) : 0;
+    QString message = tr("Exporting %1% (%2 fps)").arg(percent).arg(stats.fps, 0, 'f', 1);
+    if (busiest)
+        message += tr(", limited by %1 at %2% busy").arg(QString::fromStdString(busiest->name))
+                                                     .arg(static_cast<int>(busiest->utilisation * 100));
+    statusBar()->showMessage(message);
 }
 
 } // namespace aether
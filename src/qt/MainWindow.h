@@ -3,6 +3,9 @@
 #include <QMainWindow>
 #include <QScopedPointer>
 #include <QVulkanInstance>
+#include <vector>
+#include "aether/MediaProbe.h"
+#include "aether/ProjectFile.h"
 #include "aether/ProjectSettings.h"
 
 class QToolBar;
@@ -11,6 +14,7 @@ class QSplitter;
 class QDockWidget;
 class QStackedWidget;
 class QKeyEvent;
+class QTimer;
 
 namespace aether {
 
@@ -22,6 +26,13 @@ class TimelineWidget;
 class AetherRenderView;
 class PageBarWidget;
 class MediaPageWidget;
+class AnimationPageWidget;
+class ProjectAutosaver;
+class ExportEngine;
+class DistributedExport;
+struct ExportRequest;
+class RenderQueue;
+class RenderQueueWidget;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -36,9 +47,13 @@ public:
 private slots:
     void onSettings();
     void onNewProject();
+    void onSaveProject();
+    void onAutosave();
     void onImportMedia();
     void onOpenProjectPath(const QString& path);
     void onExport();
+    void onExportOnRenderNodes();
+    void onAddRenderJob();
     void onAddToTimeline(const QString& mediaPath);
     void onInterpretFootageRequested(const QString& mediaPath);
     void onPlayheadMoved(qint64 ms);
@@ -85,6 +100,16 @@ private:
     void enterHomeState();
     void enterProjectState();
     void appendToRecentProjects(const QString& path);
+    ProjectDocument captureProject() const;
+    void scheduleAutosave();
+    void requestProbes(const QStringList& paths);
+    void queueProbeResult(const MediaProbeResult& result);
+    void fitPlaceholderClips(const std::vector<MediaProbeResult>& results);
+    void offerSequenceMatch(const QString& mediaPath);
+    void flushProbeResults();
+    void updateExportProgress();
+    bool makeExportRequest(const QString& title, ExportRequest& request);
+    bool confirmCancelExport();
 
     enum class EditClipType { None, Video, Audio, Photo };
     EditClipType selectedClipType() const;
@@ -108,6 +133,7 @@ private:
     QStackedWidget* m_stackedPages = nullptr;
     PageBarWidget* m_pageBar = nullptr;
     MediaPageWidget* m_mediaPage = nullptr;
+    AnimationPageWidget* m_animationPage = nullptr;
     int m_currentPage = 1;
     int m_lastSelectedTrack = -1;
     int m_lastSelectedClip = -1;
@@ -116,9 +142,31 @@ private:
     ProjectSettings m_projectSettings;
     AppState m_appState = AppState::Home;
     QString m_currentProjectPath;
+    QString m_currentProjectName;
+    QString m_currentProjectLocation;
+    ProjectWriter m_projectWriter;
+    QScopedPointer<ProjectAutosaver> m_autosaver;
+    QTimer* m_autosaveTimer = nullptr;     // periodic
+    QTimer* m_autosaveIdleTimer = nullptr; // restarted by every edit
+    QScopedPointer<MediaProbeService> m_mediaProbe;
+    std::vector<MediaProbeResult> m_probeResults; // arrived, not yet applied to the model
+    struct PlaceholderClip {
+        QString mediaPath;
+        int trackIndex = 0;
+        qint64 timelineStartMs = 0;
+    };
+    std::vector<PlaceholderClip> m_placeholderClips; // added before their media's length was known
+    QString m_matchSequencePath;                     // first clip, waiting for its probe before offering to match it
+    QTimer* m_probeFlushTimer = nullptr;
     qint64 m_currentMonitorClipTimelineStartMs = -1;
     qint64 m_currentMonitorClipSourceInMs = 0;
     double m_currentMonitorClipSpeedRatio = 1.0;
+    QScopedPointer<ExportEngine> m_exportEngine;
+    QScopedPointer<DistributedExport> m_distributedExport;
+    bool m_exportOnNodes = false; // the export in progress is m_distributedExport's
+    QTimer* m_exportProgressTimer = nullptr;
+    QScopedPointer<RenderQueue> m_renderQueue;
+    RenderQueueWidget* m_renderQueueWidget = nullptr;
 };
 
 } // namespace aether
@@ -0,0 +1,318 @@
+#include "aether/MediaProbe.h"
+#include "aether/ThreadPool.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#ifdef AETHER_FFMPEG_ENABLED
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/avutil.h>
+#include <libavutil/channel_layout.h>
+}
+#endif
+
+namespace aether {
+
+namespace {
+
+constexpr quint32 kCacheMagic = 0x4145434D; // "MCEA"
+constexpr quint32 kCacheVersion = 1;
+
+void writeResult(QDataStream& out, const MediaProbeResult& r) {
+    out << r.durationMs << r.hasVideo << r.hasAudio << r.isStill
+        << qint32(r.width) << qint32(r.height) << qint32(r.fps)
+        << r.videoCodec << r.audioCodec
+        << qint32(r.audioChannels) << qint32(r.audioSampleRate) << r.audioLayout;
+}
+
+void readResult(QDataStream& in, MediaProbeResult& r) {
+    qint32 width = 0, height = 0, fps = 0, channels = 0, sampleRate = 0;
+    in >> r.durationMs >> r.hasVideo >> r.hasAudio >> r.isStill
+       >> width >> height >> fps
+       >> r.videoCodec >> r.audioCodec
+       >> channels >> sampleRate >> r.audioLayout;
+    r.width = width;
+    r.height = height;
+    r.fps = fps;
+    r.audioChannels = channels;
+    r.audioSampleRate = sampleRate;
+    r.ok = true;
+}
+
+} // namespace
+
+// ---- MediaMetadataCache ----
+
+bool MediaMetadataCache::identify(const QString& mediaPath, QString& key, qint64& size, qint64& modifiedMs) {
+    const QFileInfo info(mediaPath);
+    if (!info.exists()) return false;
+    key = info.canonicalFilePath();
+    size = info.size();
+    modifiedMs = info.lastModified().toMSecsSinceEpoch();
+    return !key.isEmpty();
+}
+
+bool MediaMetadataCache::lookup(const QString& mediaPath, MediaProbeResult& out) {
+    QString key;
+    qint64 size = 0, modifiedMs = 0;
+    if (!identify(mediaPath, key, size, modifiedMs)) return false;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) return false;
+    if (it.value().size != size || it.value().modifiedMs != modifiedMs) {
+        // The file changed since it was probed
+        m_entries.erase(it);
+        m_dirty = true;
+        return false;
+    }
+    it.value().lastUsed = ++m_clock;
+    out = it.value().result;
+    out.path = mediaPath;
+    out.fromCache = true;
+    return true;
+}
+
+void MediaMetadataCache::insert(const QString& mediaPath, const MediaProbeResult& result) {
+    if (!result.ok) return;
+    QString key;
+    qint64 size = 0, modifiedMs = 0;
+    if (!identify(mediaPath, key, size, modifiedMs)) return;
+    Entry entry;
+    entry.size = size;
+    entry.modifiedMs = modifiedMs;
+    entry.result = result;
+    entry.result.path.clear();
+    entry.result.fromCache = false;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    entry.lastUsed = ++m_clock;
+    m_entries.insert(key, entry);
+    m_dirty = true;
+    if (static_cast<size_t>(m_entries.size()) > m_maxEntries) evict();
+}
+
+void MediaMetadataCache::evict() {
+    // Drop the least recently used tenth in one pass rather than one entry per insert
+    std::vector<uint64_t> stamps;
+    stamps.reserve(static_cast<size_t>(m_entries.size()));
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it)
+        stamps.push_back(it.value().lastUsed);
+    const size_t drop = stamps.size() - m_maxEntries * 9 / 10;
+    std::nth_element(stamps.begin(), stamps.begin() + static_cast<std::ptrdiff_t>(drop - 1), stamps.end());
+    const uint64_t cutoff = stamps[drop - 1];
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (it.value().lastUsed <= cutoff)
+            it = m_entries.erase(it);
+        else
+            ++it;
+    }
+}
+
+size_t MediaMetadataCache::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<size_t>(m_entries.size());
+}
+
+bool MediaMetadataCache::isDirty() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_dirty;
+}
+
+bool MediaMetadataCache::load(const QString& cacheFile) {
+    QFile file(cacheFile);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    QDataStream in(&file);
+    quint32 magic = 0, version = 0, count = 0;
+    in >> magic >> version >> count;
+    if (magic != kCacheMagic || version != kCacheVersion) return false;
+
+    QHash<QString, Entry> entries;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+        QString key;
+        Entry entry;
+        in >> key >> entry.size >> entry.modifiedMs;
+        readResult(in, entry.result);
+        entry.lastUsed = i; // saved oldest first
+        entries.insert(key, entry);
+    }
+    if (in.status() != QDataStream::Ok) return false;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries = std::move(entries);
+    m_clock = count;
+    m_dirty = false;
+    return true;
+}
+
+bool MediaMetadataCache::save(const QString& cacheFile) {
+    std::vector<std::pair<QString, Entry>> entries;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        entries.reserve(static_cast<size_t>(m_entries.size()));
+        for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it)
+            entries.emplace_back(it.key(), it.value());
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const auto& a, const auto& b) { return a.second.lastUsed < b.second.lastUsed; });
+
+    QSaveFile file(cacheFile);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    QDataStream out(&file);
+    out << kCacheMagic << kCacheVersion << quint32(entries.size());
+    for (const auto& [key, entry] : entries) {
+        out << key << entry.size << entry.modifiedMs;
+        writeResult(out, entry.result);
+    }
+    if (!file.commit()) return false;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_dirty = false;
+    return true;
+}
+
+// ---- MediaProbeService ----
+
+MediaProbeService::MediaProbeService(ResultCallback onResult, const QString& cacheFile, size_t threadCount)
+    : m_onResult(std::move(onResult)), m_cacheFile(cacheFile) {
+    if (!m_cacheFile.isEmpty()) m_cache.load(m_cacheFile);
+    m_pool = std::make_unique<ThreadPool>(std::max<size_t>(1, threadCount));
+}
+
+MediaProbeService::~MediaProbeService() {
+    m_cancelled = true;
+    m_pool.reset(); // queued requests return at once; running probes finish
+    saveCache();
+}
+
+void MediaProbeService::request(const QString& path) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_pending.contains(path)) return;
+        m_pending.insert(path);
+    }
+    m_pool->submit([this, path]() {
+        if (m_cancelled) return;
+        MediaProbeResult result = lookupOrProbe(path);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending.remove(path);
+        }
+        if (m_onResult && !m_cancelled) m_onResult(result);
+    });
+}
+
+MediaProbeResult MediaProbeService::probeNow(const QString& path) {
+    return lookupOrProbe(path);
+}
+
+size_t MediaProbeService::getPendingCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<size_t>(m_pending.size());
+}
+
+double MediaProbeService::getAverageProbeMs() const {
+    const uint64_t probes = m_probes.load();
+    return probes ? static_cast<double>(m_probeMicros.load()) / 1000.0 / static_cast<double>(probes) : 0.0;
+}
+
+void MediaProbeService::saveCache() {
+    if (!m_cacheFile.isEmpty() && m_cache.isDirty()) m_cache.save(m_cacheFile);
+}
+
+MediaProbeResult MediaProbeService::lookupOrProbe(const QString& path) {
+    MediaProbeResult result;
+    if (m_cache.lookup(path, result)) {
+        m_cacheHits++;
+        return result;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    result = probeFile(path);
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    m_probes++;
+    m_probeMicros += static_cast<uint64_t>(elapsed.count());
+    m_cache.insert(path, result);
+    return result;
+}
+
+#ifdef AETHER_FFMPEG_ENABLED
+MediaProbeResult MediaProbeService::probeFile(const QString& path) {
+    MediaProbeResult r;
+    r.path = path;
+    AVFormatContext* fmt = nullptr;
+    const QByteArray utf8 = path.toUtf8();
+    if (avformat_open_input(&fmt, utf8.constData(), nullptr, nullptr) < 0) {
+        r.error = QStringLiteral("Could not open file");
+        return r;
+    }
+    if (avformat_find_stream_info(fmt, nullptr) < 0) {
+        avformat_close_input(&fmt);
+        r.error = QStringLiteral("Could not find stream info");
+        return r;
+    }
+
+    if (fmt->duration != AV_NOPTS_VALUE && fmt->duration > 0)
+        r.durationMs = av_rescale(fmt->duration, 1000, AV_TIME_BASE);
+
+    int video = av_find_best_stream(fmt, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (video >= 0 && (fmt->streams[video]->disposition & AV_DISPOSITION_ATTACHED_PIC)) video = -1;
+    if (video >= 0) {
+        const AVStream* st = fmt->streams[video];
+        const AVCodecParameters* par = st->codecpar;
+        r.hasVideo = true;
+        r.width = par->width;
+        r.height = par->height;
+        r.videoCodec = QString::fromUtf8(avcodec_get_name(par->codec_id));
+        AVRational rate = av_guess_frame_rate(fmt, const_cast<AVStream*>(st), nullptr);
+        if (rate.num > 0 && rate.den > 0) {
+            const double fps = av_q2d(rate);
+            r.fps = (fps > 0 && fps < 1000) ? static_cast<int>(std::lround(fps)) : 0;
+        }
+        const char* demuxer = fmt->iformat ? fmt->iformat->name : "";
+        r.isStill = std::strstr(demuxer, "image2") || std::strstr(demuxer, "_pipe");
+        if (r.durationMs == 0 && st->duration != AV_NOPTS_VALUE && st->duration > 0)
+            r.durationMs = av_rescale_q(st->duration, st->time_base, AVRational{1, 1000});
+    }
+
+    const int audio = av_find_best_stream(fmt, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+    if (audio >= 0) {
+        const AVStream* st = fmt->streams[audio];
+        const AVCodecParameters* par = st->codecpar;
+        r.hasAudio = true;
+        r.audioCodec = QString::fromUtf8(avcodec_get_name(par->codec_id));
+        r.audioSampleRate = par->sample_rate;
+        char layout[64] = {};
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 24, 100)
+        r.audioChannels = par->ch_layout.nb_channels;
+        if (av_channel_layout_describe(&par->ch_layout, layout, sizeof(layout)) > 0)
+            r.audioLayout = QString::fromUtf8(layout);
+#else
+        r.audioChannels = par->channels;
+        av_get_channel_layout_string(layout, sizeof(layout), par->channels, par->channel_layout);
+        r.audioLayout = QString::fromUtf8(layout);
+#endif
+        if (r.durationMs == 0 && st->duration != AV_NOPTS_VALUE && st->duration > 0)
+            r.durationMs = av_rescale_q(st->duration, st->time_base, AVRational{1, 1000});
+    }
+
+    avformat_close_input(&fmt);
+    r.ok = r.hasVideo || r.hasAudio;
+    if (!r.ok) r.error = QStringLiteral("No audio or video stream");
+    return r;
+}
+#else
+MediaProbeResult MediaProbeService::probeFile(const QString& path) {
+    MediaProbeResult r;
+    r.path = path;
+    r.error = QStringLiteral("Built without FFmpeg");
+    return r;
+}
+#endif
+
+} // namespace aether
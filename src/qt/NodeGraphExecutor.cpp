@@ -0,0 +1,554 @@
+#include "aether/NodeGraphExecutor.h"
+#include "aether/KeyframeModel.h"
+#include "aether/NodeResultCache.h"
+#include "aether/ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace aether {
+
+namespace {
+
+constexpr size_t kRowGrain = 16;
+constexpr float kGlowRadius = 8.0f;
+constexpr uint32_t kUnusedLevel = UINT32_MAX;
+constexpr uint64_t kNodeKeySeed = 0x6E6F64656B657931ull;
+
+uint64_t hashCombine(uint64_t seed, uint64_t value) {
+    // splitmix64 finaliser over the xor, so nearby values land far apart
+    uint64_t z = seed ^ (value + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2));
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+uint64_t doubleBits(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// Four independent lanes keep the multiply chains from serialising on large frames
+uint64_t hashImage(const CpuImage& image) {
+    const uint8_t* data = image.rgba.data();
+    const size_t size = image.rgba.size();
+    uint64_t lanes[4] = {0x243F6A8885A308D3ull, 0x13198A2E03707344ull, 0xA4093822299F31D0ull, 0x082EFA98EC4E6C89ull};
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int lane = 0; lane < 4; lane++) {
+            uint64_t word;
+            std::memcpy(&word, data + i + lane * 8, sizeof(word));
+            lanes[lane] = (lanes[lane] ^ word) * 0x100000001B3ull;
+        }
+    }
+    uint64_t hash = hashCombine(image.width, image.height);
+    for (; i < size; i++) {
+        hash = hashCombine(hash, data[i]);
+    }
+    for (uint64_t lane : lanes) {
+        hash = hashCombine(hash, lane);
+    }
+    return hash;
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+uint8_t toByte(float v) {
+    return static_cast<uint8_t>(std::clamp(v, 0.0f, 255.0f) + 0.5f);
+}
+
+void copyImage(const CpuImage& input, CpuImage& output) {
+    if (&input != &output) {
+        output = input;
+    }
+}
+
+// Straight-alpha bilinear sample; taps outside the image are transparent
+void sampleBilinear(const CpuImage& image, float x, float y, uint8_t* dst) {
+    const int x0 = static_cast<int>(std::floor(x));
+    const int y0 = static_cast<int>(std::floor(y));
+    const float fx = x - static_cast<float>(x0);
+    const float fy = y - static_cast<float>(y0);
+    const int w = static_cast<int>(image.width);
+    const int h = static_cast<int>(image.height);
+    float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    for (int tap = 0; tap < 4; tap++) {
+        const int sx = x0 + (tap & 1);
+        const int sy = y0 + (tap >> 1);
+        if (sx < 0 || sy < 0 || sx >= w || sy >= h) {
+            continue;
+        }
+        const float weight = ((tap & 1) ? fx : 1.0f - fx) * ((tap >> 1) ? fy : 1.0f - fy);
+        const uint8_t* p = image.rgba.data() + (static_cast<size_t>(sy) * image.width + sx) * 4;
+        for (int c = 0; c < 4; c++) {
+            acc[c] += weight * p[c];
+        }
+    }
+    for (int c = 0; c < 4; c++) {
+        dst[c] = toByte(acc[c]);
+    }
+}
+
+void transformImage(const CpuImage& input, CpuImage& output, double tx, double ty, double scale,
+                    double rotationDegrees, ThreadPool& pool) {
+    if (tx == 0.0 && ty == 0.0 && scale == 1.0 && std::fmod(rotationDegrees, 360.0) == 0.0) {
+        copyImage(input, output);
+        return;
+    }
+    output.resize(input.width, input.height);
+    if (std::abs(scale) < 1e-6) {
+        return;
+    }
+
+    // Inverse mapping: rotate and scale each output pixel back into the input about its centre
+    const float radians = static_cast<float>(rotationDegrees * 3.14159265358979323846 / 180.0);
+    const float cosR = std::cos(radians);
+    const float sinR = std::sin(radians);
+    const float invScale = static_cast<float>(1.0 / scale);
+    const float cx = input.width * 0.5f;
+    const float cy = input.height * 0.5f;
+    pool.parallelFor(0, output.height, kRowGrain, [&](size_t rowBegin, size_t rowEnd) {
+        for (size_t y = rowBegin; y < rowEnd; y++) {
+            uint8_t* dst = output.rgba.data() + y * output.width * 4;
+            const float dy = static_cast<float>(y) + 0.5f - cy - static_cast<float>(ty);
+            for (uint32_t x = 0; x < output.width; x++) {
+                const float dx = static_cast<float>(x) + 0.5f - cx - static_cast<float>(tx);
+                const float sx = (dx * cosR + dy * sinR) * invScale + cx - 0.5f;
+                const float sy = (-dx * sinR + dy * cosR) * invScale + cy - 0.5f;
+                sampleBilinear(input, sx, sy, dst + static_cast<size_t>(x) * 4);
+            }
+        }
+    });
+}
+
+const uint8_t* pixelAt(const CpuImage& image, uint32_t x, uint32_t y) {
+    if (x >= image.width || y >= image.height) {
+        return nullptr;
+    }
+    return image.rgba.data() + (static_cast<size_t>(y) * image.width + x) * 4;
+}
+
+// Foreground over background (straight alpha), foreground opacity scaled by mix
+void mergeImages(const CpuImage& foreground, const CpuImage& background, CpuImage& output, double mix,
+                 ThreadPool& pool) {
+    // Scheduled buffers never alias a node's inputs, so the output can be written directly
+    output.resize(background.width, background.height);
+    const float opacity = static_cast<float>(std::clamp(mix, 0.0, 1.0)) / 255.0f;
+    pool.parallelFor(0, output.height, kRowGrain, [&](size_t rowBegin, size_t rowEnd) {
+        for (size_t y = rowBegin; y < rowEnd; y++) {
+            for (uint32_t x = 0; x < output.width; x++) {
+                const uint8_t* bg = pixelAt(background, x, static_cast<uint32_t>(y));
+                const uint8_t* fg = pixelAt(foreground, x, static_cast<uint32_t>(y));
+                uint8_t* dst = output.rgba.data() + (y * output.width + x) * 4;
+                const float fa = fg ? fg[3] * opacity : 0.0f;
+                const float ba = bg[3] / 255.0f;
+                const float outA = fa + ba * (1.0f - fa);
+                if (outA <= 0.0f) {
+                    continue;
+                }
+                for (int c = 0; c < 3; c++) {
+                    const float fc = fg ? fg[c] : 0.0f;
+                    dst[c] = toByte((fc * fa + bg[c] * ba * (1.0f - fa)) / outA);
+                }
+                dst[3] = toByte(outA * 255.0f);
+            }
+        }
+    });
+}
+
+// Multiplies the image's alpha by the mask's alpha, blended with mix
+void maskImage(const CpuImage& image, const CpuImage& mask, CpuImage& output, double mix, ThreadPool& pool) {
+    copyImage(image, output);
+    const float amount = static_cast<float>(std::clamp(mix, 0.0, 1.0));
+    pool.parallelFor(0, output.height, kRowGrain, [&](size_t rowBegin, size_t rowEnd) {
+        for (size_t y = rowBegin; y < rowEnd; y++) {
+            for (uint32_t x = 0; x < output.width; x++) {
+                const uint8_t* m = pixelAt(mask, x, static_cast<uint32_t>(y));
+                const float coverage = m ? m[3] / 255.0f : 0.0f;
+                uint8_t* dst = output.rgba.data() + (y * output.width + x) * 4;
+                dst[3] = toByte(dst[3] * (1.0f - amount + amount * coverage));
+            }
+        }
+    });
+}
+
+// Bright pass above threshold, blurred and added back on top
+void glowImage(const CpuImage& input, CpuImage& output, double intensity, double threshold, ThreadPool& pool) {
+    CpuImage bright;
+    bright.resize(input.width, input.height);
+    const float cutoff = static_cast<float>(std::clamp(threshold, 0.0, 1.0)) * 255.0f;
+    const float range = std::max(1.0f, 255.0f - cutoff);
+    pool.parallelFor(0, input.height, kRowGrain, [&](size_t rowBegin, size_t rowEnd) {
+        const size_t begin = rowBegin * input.width * 4;
+        const size_t end = rowEnd * input.width * 4;
+        for (size_t i = begin; i < end; i += 4) {
+            for (int c = 0; c < 3; c++) {
+                bright.rgba[i + c] = toByte((input.rgba[i + c] - cutoff) * 255.0f / range);
+            }
+            bright.rgba[i + 3] = input.rgba[i + 3];
+        }
+    });
+
+    CpuImage halo;
+    CpuEffectBackend::boxBlur(bright, halo, kGlowRadius);
+    copyImage(input, output);
+    const float gain = static_cast<float>(std::max(0.0, intensity));
+    pool.parallelFor(0, output.height, kRowGrain, [&](size_t rowBegin, size_t rowEnd) {
+        const size_t begin = rowBegin * output.width * 4;
+        const size_t end = rowEnd * output.width * 4;
+        for (size_t i = begin; i < end; i += 4) {
+            for (int c = 0; c < 3; c++) {
+                output.rgba[i + c] = toByte(output.rgba[i + c] + halo.rgba[i + c] * gain);
+            }
+        }
+    });
+}
+
+} // namespace
+
+const std::vector<NodeParameterSpec>& NodeGraphExecutor::parameterSpecs(NodeType type) {
+    // Ids match the parameters the Animation page creates for each node type
+    static const std::vector<NodeParameterSpec> transform = {
+        {"x", 0.0}, {"y", 0.0}, {"scale", 1.0}, {"rotation", 0.0}};
+    static const std::vector<NodeParameterSpec> blur = {{"radius", 4.0}};
+    static const std::vector<NodeParameterSpec> mix = {{"mix", 1.0}};
+    static const std::vector<NodeParameterSpec> glow = {{"intensity", 1.0}, {"threshold", 0.8}};
+    switch (type) {
+        case NodeType::Transform: return transform;
+        case NodeType::Blur: return blur;
+        case NodeType::Merge: return mix;
+        case NodeType::Mask: return mix;
+        case NodeType::Glow: return glow;
+    }
+    return transform;
+}
+
+NodeParameterSource NodeGraphExecutor::keyframeSource(const KeyframeModel& model) {
+    return [&model](uint32_t nodeId, const std::string& parameterId, int64_t timeMs) -> std::optional<double> {
+        if (nodeId != model.nodeId()) {
+            return std::nullopt;
+        }
+        const ParameterHandle handle = model.findParameter(parameterId);
+        if (handle == InvalidParameterHandle || model.parameters()[static_cast<size_t>(handle)].keyframes.empty()) {
+            return std::nullopt;
+        }
+        return model.evaluate(handle, static_cast<double>(timeMs));
+    };
+}
+
+ThreadPool& NodeGraphExecutor::pool() const {
+    return m_pool ? *m_pool : ThreadPool::getInstance();
+}
+
+bool NodeGraphExecutor::compile(const NodeGraphModel& graph, uint32_t outputNodeId) {
+    m_schedule.clear();
+    m_levelStarts.clear();
+    m_previousKeys.clear();
+    m_bufferCount = 0;
+    m_lastError.clear();
+    m_compiledRevision = graph.revision();
+
+    const std::vector<Node>& nodes = graph.nodes();
+    if (nodes.empty()) {
+        m_lastError = "Node graph is empty";
+        return false;
+    }
+
+    const size_t nodeCount = nodes.size();
+    std::unordered_map<uint32_t, size_t> indexOf;
+    indexOf.reserve(nodeCount);
+    for (size_t i = 0; i < nodeCount; i++) {
+        indexOf[nodes[i].id] = i;
+    }
+
+    // Producer of each input port; a later connection into the same port replaces an earlier one
+    std::vector<std::vector<int>> producers(nodeCount);
+    for (size_t i = 0; i < nodeCount; i++) {
+        producers[i].assign(nodes[i].inputPortNames.size(), -1);
+    }
+    std::vector<bool> feedsOthers(nodeCount, false);
+    for (const NodeConnection& c : graph.connections()) {
+        auto source = indexOf.find(c.source.nodeId);
+        auto dest = indexOf.find(c.dest.nodeId);
+        if (source == indexOf.end() || dest == indexOf.end()
+            || c.dest.portIndex >= producers[dest->second].size()) {
+            continue;
+        }
+        producers[dest->second][c.dest.portIndex] = static_cast<int>(source->second);
+        feedsOthers[source->second] = true;
+    }
+
+    size_t output = nodeCount;
+    if (outputNodeId != 0) {
+        auto it = indexOf.find(outputNodeId);
+        if (it == indexOf.end()) {
+            m_lastError = "Output node " + std::to_string(outputNodeId) + " does not exist";
+            return false;
+        }
+        output = it->second;
+    } else {
+        // Highest id rather than vector position: node storage order changes on removal
+        for (size_t i = 0; i < nodeCount; i++) {
+            if (!feedsOthers[i] && (output == nodeCount || nodes[i].id > nodes[output].id)) {
+                output = i;
+            }
+        }
+        if (output == nodeCount) {
+            m_lastError = "Node graph has no output: every node feeds another";
+            return false;
+        }
+    }
+
+    // Only nodes the output depends on are scheduled
+    std::vector<bool> needed(nodeCount, false);
+    std::vector<size_t> stack = {output};
+    needed[output] = true;
+    size_t neededCount = 1;
+    while (!stack.empty()) {
+        size_t i = stack.back();
+        stack.pop_back();
+        for (int p : producers[i]) {
+            if (p >= 0 && !needed[static_cast<size_t>(p)]) {
+                needed[static_cast<size_t>(p)] = true;
+                neededCount++;
+                stack.push_back(static_cast<size_t>(p));
+            }
+        }
+    }
+
+    // Kahn's algorithm; the level of a node is one past its deepest producer
+    std::vector<uint32_t> pendingInputs(nodeCount, 0);
+    std::vector<std::vector<size_t>> consumers(nodeCount);
+    for (size_t i = 0; i < nodeCount; i++) {
+        if (!needed[i]) {
+            continue;
+        }
+        for (int p : producers[i]) {
+            if (p >= 0) {
+                pendingInputs[i]++;
+                consumers[static_cast<size_t>(p)].push_back(i);
+            }
+        }
+    }
+    std::vector<uint32_t> level(nodeCount, 0);
+    std::vector<size_t> order;
+    order.reserve(neededCount);
+    for (size_t i = 0; i < nodeCount; i++) {
+        if (needed[i] && pendingInputs[i] == 0) {
+            order.push_back(i);
+        }
+    }
+    for (size_t head = 0; head < order.size(); head++) {
+        size_t i = order[head];
+        for (size_t c : consumers[i]) {
+            level[c] = std::max(level[c], level[i] + 1);
+            if (--pendingInputs[c] == 0) {
+                order.push_back(c);
+            }
+        }
+    }
+    if (order.size() != neededCount) {
+        for (size_t i = 0; i < nodeCount; i++) {
+            if (needed[i] && pendingInputs[i] > 0) {
+                m_lastError = "Cycle through node '" + nodes[i].title + "' (id " + std::to_string(nodes[i].id) + ")";
+                break;
+            }
+        }
+        return false;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return level[a] < level[b]; });
+
+    std::vector<int> scheduleIndex(nodeCount, -1);
+    for (size_t s = 0; s < order.size(); s++) {
+        scheduleIndex[order[s]] = static_cast<int>(s);
+    }
+    m_schedule.resize(order.size());
+    for (size_t s = 0; s < order.size(); s++) {
+        const Node& node = nodes[order[s]];
+        CompiledNode& step = m_schedule[s];
+        step.nodeId = node.id;
+        step.type = node.type;
+        step.title = node.title;
+        step.level = level[order[s]];
+        step.inputs.clear();
+        for (int p : producers[order[s]]) {
+            step.inputs.push_back(p >= 0 ? scheduleIndex[static_cast<size_t>(p)] : -1);
+        }
+        if (s == 0 || step.level != m_schedule[s - 1].level) {
+            m_levelStarts.push_back(s);
+        }
+    }
+    m_levelStarts.push_back(m_schedule.size());
+
+    // Buffer aliasing: a buffer is free for reuse from the level after its last reader
+    std::vector<uint32_t> lastReadLevel(m_schedule.size(), kUnusedLevel);
+    for (const CompiledNode& step : m_schedule) {
+        for (int input : step.inputs) {
+            if (input >= 0) {
+                uint32_t& last = lastReadLevel[static_cast<size_t>(input)];
+                last = last == kUnusedLevel ? step.level : std::max(last, step.level);
+            }
+        }
+    }
+    std::vector<uint32_t> freeBuffers;
+    std::vector<size_t> live;
+    for (size_t l = 0; l + 1 < m_levelStarts.size(); l++) {
+        const uint32_t currentLevel = m_schedule[m_levelStarts[l]].level;
+        for (size_t k = 0; k < live.size();) {
+            const uint32_t last = lastReadLevel[live[k]];
+            if (last != kUnusedLevel && last < currentLevel) {
+                freeBuffers.push_back(m_schedule[live[k]].buffer);
+                live[k] = live.back();
+                live.pop_back();
+            } else {
+                k++;
+            }
+        }
+        for (size_t s = m_levelStarts[l]; s < m_levelStarts[l + 1]; s++) {
+            if (!freeBuffers.empty()) {
+                m_schedule[s].buffer = freeBuffers.back();
+                freeBuffers.pop_back();
+            } else {
+                m_schedule[s].buffer = static_cast<uint32_t>(m_bufferCount++);
+            }
+            live.push_back(s);
+        }
+    }
+    return true;
+}
+
+void NodeGraphExecutor::resolveParameters(const CompiledNode& node, int64_t timeMs,
+                                          std::vector<double>& values) const {
+    const std::vector<NodeParameterSpec>& specs = parameterSpecs(node.type);
+    values.resize(specs.size());
+    for (size_t i = 0; i < specs.size(); i++) {
+        std::optional<double> value;
+        if (m_parameterSource) {
+            value = m_parameterSource(node.nodeId, specs[i].id, timeMs);
+        }
+        values[i] = value.value_or(specs[i].defaultValue);
+    }
+}
+
+void NodeGraphExecutor::runNode(const CompiledNode& node, const std::vector<double>& params,
+                                const CpuImage* const* inputs, size_t inputCount, CpuImage& output) const {
+    ThreadPool& threads = pool();
+    const CpuImage& first = *inputs[0];
+    const CpuImage& second = inputCount > 1 ? *inputs[1] : first;
+    switch (node.type) {
+        case NodeType::Transform:
+            transformImage(first, output, params[0], params[1], params[2], params[3], threads);
+            break;
+        case NodeType::Blur:
+            if (params[0] >= 1.0) {
+                CpuEffectBackend::boxBlur(first, output, static_cast<float>(params[0]));
+            } else {
+                copyImage(first, output);
+            }
+            break;
+        case NodeType::Merge:
+            mergeImages(first, second, output, params[0], threads);
+            break;
+        case NodeType::Mask:
+            maskImage(first, second, output, params[0], threads);
+            break;
+        case NodeType::Glow:
+            glowImage(first, output, params[0], params[1], threads);
+            break;
+    }
+}
+
+bool NodeGraphExecutor::execute(const CpuImage& source, int64_t timeMs, CpuImage& output, uint64_t sourceKey) {
+    if (!isCompiled()) {
+        m_lastError = "Node graph is not compiled";
+        return false;
+    }
+    if (!source.isValid()) {
+        m_lastError = "Invalid source image";
+        return false;
+    }
+
+    auto frameStart = std::chrono::steady_clock::now();
+    const size_t stepCount = m_schedule.size();
+    if (m_buffers.size() < m_bufferCount) {
+        m_buffers.resize(m_bufferCount);
+    }
+    m_lastTimings.resize(stepCount);
+    m_stepKeys.assign(stepCount, 0);
+    m_stepResults.assign(stepCount, nullptr);
+    m_stepCached.assign(stepCount, nullptr);
+    m_previousKeys.resize(stepCount, 0);
+    if (m_cache && sourceKey == 0) {
+        sourceKey = hashImage(source);
+    }
+
+    for (size_t l = 0; l + 1 < m_levelStarts.size(); l++) {
+        pool().parallelFor(m_levelStarts[l], m_levelStarts[l + 1], 1, [&](size_t begin, size_t end) {
+            std::vector<double> params;
+            for (size_t s = begin; s < end; s++) {
+                auto start = std::chrono::steady_clock::now();
+                const CompiledNode& node = m_schedule[s];
+                const CpuImage* inputs[2] = {&source, &source};
+                const size_t inputCount = std::min<size_t>(node.inputs.size(), 2);
+                for (size_t port = 0; port < inputCount; port++) {
+                    const int producer = node.inputs[port];
+                    if (producer >= 0) {
+                        inputs[port] = m_stepResults[static_cast<size_t>(producer)];
+                    }
+                }
+                resolveParameters(node, timeMs, params);
+
+                if (m_cache) {
+                    uint64_t key = hashCombine(kNodeKeySeed, static_cast<uint64_t>(node.type));
+                    for (double value : params) {
+                        key = hashCombine(key, doubleBits(value));
+                    }
+                    for (size_t port = 0; port < inputCount; port++) {
+                        const int producer = node.inputs[port];
+                        key = hashCombine(key, producer >= 0 ? m_stepKeys[static_cast<size_t>(producer)] : sourceKey);
+                    }
+                    m_stepKeys[s] = key;
+                    if (std::shared_ptr<const CpuImage> hit = m_cache->find(key)) {
+                        m_stepResults[s] = hit.get();
+                        m_stepCached[s] = std::move(hit);
+                        m_lastTimings[s] = {node.nodeId, node.title, elapsedMs(start), true};
+                        continue;
+                    }
+                }
+
+                CpuImage& result = m_buffers[node.buffer];
+                runNode(node, params, inputs, inputCount, result);
+                m_stepResults[s] = &result;
+                // Only a key that held still since the last frame is likely to be asked for again
+                if (m_cache && m_stepKeys[s] == m_previousKeys[s]) {
+                    m_cache->insert(m_stepKeys[s], std::make_shared<const CpuImage>(result));
+                }
+                m_lastTimings[s] = {node.nodeId, node.title, elapsedMs(start), false};
+            }
+        });
+    }
+
+    // The output node is alone in the last level, so its buffer is not read again this frame
+    const CpuImage* result = m_stepResults.back();
+    if (result == &m_buffers[m_schedule.back().buffer]) {
+        std::swap(output, m_buffers[m_schedule.back().buffer]);
+    } else {
+        output = *result;
+    }
+    if (m_cache) {
+        m_previousKeys = m_stepKeys;
+    }
+    m_lastCacheHits = static_cast<size_t>(std::count_if(m_stepCached.begin(), m_stepCached.end(),
+                                                        [](const auto& cached) { return cached != nullptr; }));
+    // Don't pin cache entries beyond the frame; the cache decides what stays resident
+    m_stepCached.assign(stepCount, nullptr);
+    m_lastTotalMs = elapsedMs(frameStart);
+    return true;
+}
+
+} // namespace aether
@@ -1,9 +1,38 @@
 #include "aether/NodeGraphModel.h"
+#include <algorithm>
 
 namespace aether {
 
+namespace {
+
+const std::vector<size_t> kNoConnections;
+
+void eraseIndex(std::vector<size_t>& list, size_t value) {
+    auto it = std::find(list.begin(), list.end(), value);
+    if (it != list.end()) {
+        *it = list.back();
+        list.pop_back();
+    }
+}
+
+void replaceIndex(std::vector<size_t>& list, size_t from, size_t to) {
+    auto it = std::find(list.begin(), list.end(), from);
+    if (it != list.end()) *it = to;
+}
+
+} // namespace
+
 NodeGraphModel::NodeGraphModel() = default;
 
+NodeGraphModel::NodeGraphModel(const NodeGraphModel& other)
+    : m_nodes(other.m_nodes)
+    , m_adjacency(other.m_adjacency)
+    , m_indexById(other.m_indexById)
+    , m_connections(other.m_connections)
+    , m_connectionSet(other.m_connectionSet)
+    , m_revision(other.m_revision)
+    , m_nextId(other.m_nextId) {}
+
 uint32_t NodeGraphModel::nextNodeId() {
     return m_nextId++;
 }
@@ -21,50 +50,149 @@ uint32_t NodeGraphModel::addNode(NodeType type, float x, float y) {
         n.inputPortNames.push_back(std::string("in") + std::to_string(i));
     for (int i = 0; i < outCount; i++)
         n.outputPortNames.push_back(std::string("out") + std::to_string(i));
-    m_nodes.push_back(std::move(n));
-    return m_nodes.back().id;
+    const uint32_t id = n.id;
+    insertNode(std::move(n));
+    return id;
+}
+
+bool NodeGraphModel::insertNode(Node node) {
+    if (node.id == 0 || m_indexById.count(node.id)) return false;
+    const uint32_t id = node.id;
+    if (id >= m_nextId) m_nextId = id + 1;
+    m_indexById[id] = m_nodes.size();
+    m_nodes.push_back(std::move(node));
+    m_adjacency.emplace_back();
+    m_revision++;
+    notify({ NodeGraphChange::NodeAdded, id, {} });
+    return true;
+}
+
+void NodeGraphModel::clear() {
+    while (!m_nodes.empty())
+        removeNode(m_nodes.back().id);
+    m_nextId = 1;
 }
 
 void NodeGraphModel::removeNode(uint32_t nodeId) {
-    m_nodes.erase(
-        std::remove_if(m_nodes.begin(), m_nodes.end(), [nodeId](const Node& n) { return n.id == nodeId; }),
-        m_nodes.end());
-    m_connections.erase(
-        std::remove_if(m_connections.begin(), m_connections.end(),
-            [nodeId](const NodeConnection& c) { return c.source.nodeId == nodeId || c.dest.nodeId == nodeId; }),
-        m_connections.end());
+    auto found = m_indexById.find(nodeId);
+    if (found == m_indexById.end()) return;
+    const size_t index = found->second;
+
+    // Each removal swaps another connection into the freed slot, so always take the last entry
+    while (!m_adjacency[index].incoming.empty())
+        removeConnectionAt(m_adjacency[index].incoming.back());
+    while (!m_adjacency[index].outgoing.empty())
+        removeConnectionAt(m_adjacency[index].outgoing.back());
+
+    const size_t last = m_nodes.size() - 1;
+    if (index != last) {
+        m_nodes[index] = std::move(m_nodes[last]);
+        m_adjacency[index] = std::move(m_adjacency[last]);
+        m_indexById[m_nodes[index].id] = index;
+    }
+    m_nodes.pop_back();
+    m_adjacency.pop_back();
+    m_indexById.erase(nodeId);
+    m_revision++;
+    notify({ NodeGraphChange::NodeRemoved, nodeId, {} });
 }
 
 bool NodeGraphModel::addConnection(const NodePort& source, const NodePort& dest) {
     if (source.nodeId == dest.nodeId) return false;
-    for (const auto& c : m_connections)
-        if (c.source.nodeId == source.nodeId && c.source.portIndex == source.portIndex
-            && c.dest.nodeId == dest.nodeId && c.dest.portIndex == dest.portIndex)
-            return false;
-    m_connections.push_back({ source, dest });
+    auto src = m_indexById.find(source.nodeId);
+    auto dst = m_indexById.find(dest.nodeId);
+    if (src == m_indexById.end() || dst == m_indexById.end()) return false;
+    const NodeConnection connection{ source, dest };
+    if (!m_connectionSet.insert(connection).second) return false;
+
+    const size_t index = m_connections.size();
+    m_connections.push_back(connection);
+    m_adjacency[src->second].outgoing.push_back(index);
+    m_adjacency[dst->second].incoming.push_back(index);
+    m_revision++;
+    notify({ NodeGraphChange::ConnectionAdded, 0, connection });
     return true;
 }
 
 void NodeGraphModel::removeConnection(size_t connectionIndex) {
     if (connectionIndex < m_connections.size())
-        m_connections.erase(m_connections.begin() + static_cast<std::ptrdiff_t>(connectionIndex));
+        removeConnectionAt(connectionIndex);
+}
+
+bool NodeGraphModel::removeConnection(const NodeConnection& connection) {
+    if (!hasConnection(connection)) return false;
+    for (size_t index : outgoingConnections(connection.source.nodeId)) {
+        if (m_connections[index] == connection) {
+            removeConnectionAt(index);
+            return true;
+        }
+    }
+    return false;
+}
+
+void NodeGraphModel::removeConnectionAt(size_t connectionIndex) {
+    const NodeConnection removed = m_connections[connectionIndex];
+    eraseIndex(m_adjacency[m_indexById.at(removed.source.nodeId)].outgoing, connectionIndex);
+    eraseIndex(m_adjacency[m_indexById.at(removed.dest.nodeId)].incoming, connectionIndex);
+
+    // Move the last connection into the hole and repoint its two adjacency entries
+    const size_t last = m_connections.size() - 1;
+    if (connectionIndex != last) {
+        const NodeConnection& moved = m_connections[last];
+        replaceIndex(m_adjacency[m_indexById.at(moved.source.nodeId)].outgoing, last, connectionIndex);
+        replaceIndex(m_adjacency[m_indexById.at(moved.dest.nodeId)].incoming, last, connectionIndex);
+        m_connections[connectionIndex] = moved;
+    }
+    m_connections.pop_back();
+    m_connectionSet.erase(removed);
+    m_revision++;
+    notify({ NodeGraphChange::ConnectionRemoved, 0, removed });
 }
 
 void NodeGraphModel::setNodePosition(uint32_t nodeId, float x, float y) {
     Node* n = nodeById(nodeId);
-    if (n) { n->x = x; n->y = y; }
+    if (!n || (n->x == x && n->y == y)) return;
+    n->x = x;
+    n->y = y;
+    notify({ NodeGraphChange::NodeMoved, nodeId, {} });
 }
 
 Node* NodeGraphModel::nodeById(uint32_t id) {
-    for (auto& n : m_nodes)
-        if (n.id == id) return &n;
-    return nullptr;
+    auto it = m_indexById.find(id);
+    return it != m_indexById.end() ? &m_nodes[it->second] : nullptr;
 }
 
 const Node* NodeGraphModel::nodeById(uint32_t id) const {
-    for (const auto& n : m_nodes)
-        if (n.id == id) return &n;
-    return nullptr;
+    auto it = m_indexById.find(id);
+    return it != m_indexById.end() ? &m_nodes[it->second] : nullptr;
+}
+
+const std::vector<size_t>& NodeGraphModel::incomingConnections(uint32_t nodeId) const {
+    auto it = m_indexById.find(nodeId);
+    return it != m_indexById.end() ? m_adjacency[it->second].incoming : kNoConnections;
+}
+
+const std::vector<size_t>& NodeGraphModel::outgoingConnections(uint32_t nodeId) const {
+    auto it = m_indexById.find(nodeId);
+    return it != m_indexById.end() ? m_adjacency[it->second].outgoing : kNoConnections;
+}
+
+int NodeGraphModel::addListener(NodeGraphListener listener) {
+    const int handle = m_nextListener++;
+    m_listeners.emplace_back(handle, std::move(listener));
+    return handle;
+}
+
+void NodeGraphModel::removeListener(int handle) {
+    m_listeners.erase(
+        std::remove_if(m_listeners.begin(), m_listeners.end(), [handle](const auto& l) { return l.first == handle; }),
+        m_listeners.end());
+}
+
+void NodeGraphModel::notify(const NodeGraphEvent& event) {
+    // Listeners must not add or remove listeners from inside the callback
+    for (const auto& listener : m_listeners)
+        listener.second(event);
 }
 
 const char* NodeGraphModel::nodeTypeName(NodeType t) {
@@ -89,7 +217,7 @@ int NodeGraphModel::inputPortCount(NodeType t) {
     return 0;
 }
 
-int NodeGraphModel::outputPortCount(NodeType t) {
+int NodeGraphModel::outputPortCount(NodeType) {
     return 1;
 }
 
@@ -2,6 +2,7 @@
 #include "aether/NodeGraphModel.h"
 
 #include <cstddef>
+#include <functional>
 
 #include <QGraphicsScene>
 #include <QGraphicsRectItem>
@@ -21,12 +22,15 @@ static const int PortSpacing = 22;
 
 class NodeItem : public QGraphicsRectItem {
 public:
+    enum { Type = UserType + 1 };
+
     NodeItem(uint32_t id, const QString& title, int inputCount, int outputCount)
         : QGraphicsRectItem(0, 0, NodeWidth, NodeHeaderHeight + std::max(inputCount, outputCount) * PortSpacing)
         , m_id(id)
     {
         setFlag(QGraphicsItem::ItemIsMovable);
         setFlag(QGraphicsItem::ItemIsSelectable);
+        setFlag(QGraphicsItem::ItemSendsGeometryChanges);
         setBrush(QColor(45, 45, 50));
         setPen(QPen(QColor(60, 60, 66), 1));
         m_title = new QGraphicsTextItem(title, this);
@@ -35,6 +39,8 @@ public:
         m_inputCount = inputCount;
         m_outputCount = outputCount;
     }
+    int type() const override { return Type; }
+    void setMoveHandler(std::function<void(uint32_t, const QPointF&)> handler) { m_onMoved = std::move(handler); }
     uint32_t nodeIdentifier() const { return m_id; }
     int inputCount() const { return m_inputCount; }
     int outputCount() const { return m_outputCount; }
@@ -45,8 +51,16 @@ public:
         return QPointF(NodeWidth, NodeHeaderHeight + (idx + 1) * PortSpacing - PortRadius);
     }
 
+protected:
+    QVariant itemChange(GraphicsItemChange change, const QVariant& value) override {
+        if (change == ItemPositionHasChanged && m_onMoved)
+            m_onMoved(m_id, value.toPointF());
+        return QGraphicsRectItem::itemChange(change, value);
+    }
+
 private:
     uint32_t m_id;
+    std::function<void(uint32_t, const QPointF&)> m_onMoved;
     QGraphicsTextItem* m_title = nullptr;
     int m_inputCount = 0;
     int m_outputCount = 0;
@@ -88,6 +102,7 @@ NodeGraphView::NodeGraphView(QWidget* parent)
     setTransformationAnchor(AnchorUnderMouse);
     setResizeAnchor(AnchorUnderMouse);
     setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(m_scene, &QGraphicsScene::selectionChanged, this, &NodeGraphView::onSelectionChanged);
     connect(this, &NodeGraphView::customContextMenuRequested, this, [this](const QPoint& pos) {
         QPointF scenePos = mapToScene(pos);
         QMenu menu(this);
@@ -100,11 +115,19 @@ NodeGraphView::NodeGraphView(QWidget* parent)
     });
 }
 
+NodeGraphView::~NodeGraphView() {
+    if (m_model && m_listenerHandle)
+        m_model->removeListener(m_listenerHandle);
+}
+
 void NodeGraphView::setModel(NodeGraphModel* model) {
+    if (m_model && m_listenerHandle)
+        m_model->removeListener(m_listenerHandle);
+    m_listenerHandle = 0;
     m_model = model;
     rebuildScene();
     if (m_model)
-        connect(m_scene, &QGraphicsScene::selectionChanged, this, &NodeGraphView::onSelectionChanged);
+        m_listenerHandle = m_model->addListener([this](const NodeGraphEvent& event) { onModelEvent(event); });
 }
 
 void NodeGraphView::drawBackground(QPainter* painter, const QRectF& rect) {
@@ -119,49 +142,111 @@ void NodeGraphView::drawBackground(QPainter* painter, const QRectF& rect) {
 
 void NodeGraphView::rebuildScene() {
     m_scene->clear();
+    m_nodeItems.clear();
+    m_connectionItems.clear();
     m_selectedNodeId = 0;
     if (!m_model) return;
 
-    for (const auto& n : m_model->nodes()) {
-        NodeItem* item = new NodeItem(n.id, QString::fromStdString(n.title),
-            static_cast<int>(n.inputPortNames.size()), static_cast<int>(n.outputPortNames.size()));
-        item->setPos(n.x, n.y);
-        m_scene->addItem(item);
-    }
+    for (const auto& n : m_model->nodes())
+        addNodeItem(n);
+    for (const auto& c : m_model->connections())
+        addConnectionItem(c);
+}
 
-    for (const auto& c : m_model->connections()) {
-        const Node* src = m_model->nodeById(c.source.nodeId);
-        const Node* dest = m_model->nodeById(c.dest.nodeId);
-        if (!src || !dest) continue;
-        NodeItem* srcItem = nullptr;
-        NodeItem* destItem = nullptr;
-        for (QGraphicsItem* it : m_scene->items()) {
-            NodeItem* ni = qgraphicsitem_cast<NodeItem*>(it);
-            if (ni && ni->nodeIdentifier() == src->id) srcItem = ni;
-            if (ni && ni->nodeIdentifier() == dest->id) destItem = ni;
+void NodeGraphView::onModelEvent(const NodeGraphEvent& event) {
+    switch (event.change) {
+        case NodeGraphChange::NodeAdded:
+            if (const Node* n = m_model->nodeById(event.nodeId)) addNodeItem(*n);
+            break;
+        case NodeGraphChange::NodeRemoved:
+            removeNodeItem(event.nodeId);
+            break;
+        case NodeGraphChange::NodeMoved: {
+            auto it = m_nodeItems.find(event.nodeId);
+            const Node* n = m_model->nodeById(event.nodeId);
+            if (it == m_nodeItems.end() || !n) break;
+            const QPointF pos(n->x, n->y);
+            // Moves that came from dragging the item already have it in place
+            if (it->second->pos() != pos) {
+                it->second->setPos(pos);
+            } else {
+                updateConnectionItems(event.nodeId);
+            }
+            break;
         }
-        if (!srcItem || !destItem) continue;
-        const int srcPort = static_cast<int>(c.source.portIndex);
-        const int destPort = static_cast<int>(c.dest.portIndex);
-        qreal outOx, outOy, inOx, inOy;
-        nodeConnectionOutputOffset(srcPort, &outOx, &outOy);
-        nodeConnectionInputOffset(destPort, &inOx, &inOy);
-        const char* srcBase = reinterpret_cast<const char*>(src);
-        const char* destBase = reinterpret_cast<const char*>(dest);
-        float srcPx = *reinterpret_cast<const float*>(srcBase + offsetof(Node, x));
-        float srcPy = *reinterpret_cast<const float*>(srcBase + offsetof(Node, y));
-        float destPx = *reinterpret_cast<const float*>(destBase + offsetof(Node, x));
-        float destPy = *reinterpret_cast<const float*>(destBase + offsetof(Node, y));
-        qreal p1a = static_cast<qreal>(srcPx) + outOx;
-        qreal p1b = static_cast<qreal>(srcPy) + outOy;
-        qreal p2a = static_cast<qreal>(destPx) + inOx;
-        qreal p2b = static_cast<qreal>(destPy) + inOy;
-        QPointF p1{ p1a, p1b };
-        QPointF p2{ p2a, p2b };
-        auto* line = new ConnectionLine(p1, p2);
-        m_scene->addItem(line);
-        line->setZValue(-1);
+        case NodeGraphChange::ConnectionAdded:
+            addConnectionItem(event.connection);
+            break;
+        case NodeGraphChange::ConnectionRemoved:
+            removeConnectionItem(event.connection);
+            break;
+    }
+}
+
+void NodeGraphView::addNodeItem(const Node& node) {
+    NodeItem* item = new NodeItem(node.id, QString::fromStdString(node.title),
+        static_cast<int>(node.inputPortNames.size()), static_cast<int>(node.outputPortNames.size()));
+    item->setPos(node.x, node.y);
+    item->setMoveHandler([this](uint32_t id, const QPointF& pos) { onNodeItemMoved(id, pos); });
+    m_scene->addItem(item);
+    m_nodeItems[node.id] = item;
+}
+
+void NodeGraphView::removeNodeItem(uint32_t nodeId) {
+    auto it = m_nodeItems.find(nodeId);
+    if (it == m_nodeItems.end()) return;
+    delete it->second;
+    m_nodeItems.erase(it);
+}
+
+void NodeGraphView::addConnectionItem(const NodeConnection& connection) {
+    QPointF p1, p2;
+    if (m_connectionItems.count(connection) || !connectionEndpoints(connection, &p1, &p2)) return;
+    auto* line = new ConnectionLine(p1, p2);
+    m_scene->addItem(line);
+    m_connectionItems[connection] = line;
+}
+
+void NodeGraphView::removeConnectionItem(const NodeConnection& connection) {
+    auto it = m_connectionItems.find(connection);
+    if (it == m_connectionItems.end()) return;
+    delete it->second;
+    m_connectionItems.erase(it);
+}
+
+void NodeGraphView::updateConnectionItems(uint32_t nodeId) {
+    auto update = [this](size_t index) {
+        const NodeConnection& c = m_model->connections()[index];
+        auto it = m_connectionItems.find(c);
+        QPointF p1, p2;
+        if (it != m_connectionItems.end() && connectionEndpoints(c, &p1, &p2))
+            it->second->updatePath(p1, p2);
+    };
+    for (size_t index : m_model->incomingConnections(nodeId)) update(index);
+    for (size_t index : m_model->outgoingConnections(nodeId)) update(index);
+}
+
+bool NodeGraphView::connectionEndpoints(const NodeConnection& connection, QPointF* p1, QPointF* p2) const {
+    const Node* src = m_model->nodeById(connection.source.nodeId);
+    const Node* dest = m_model->nodeById(connection.dest.nodeId);
+    if (!src || !dest) return false;
+    qreal outOx, outOy, inOx, inOy;
+    nodeConnectionOutputOffset(static_cast<int>(connection.source.portIndex), &outOx, &outOy);
+    nodeConnectionInputOffset(static_cast<int>(connection.dest.portIndex), &inOx, &inOy);
+    *p1 = QPointF(src->x + outOx, src->y + outOy);
+    *p2 = QPointF(dest->x + inOx, dest->y + inOy);
+    return true;
+}
+
+void NodeGraphView::onNodeItemMoved(uint32_t nodeId, const QPointF& pos) {
+    if (!m_model) return;
+    const Node* n = m_model->nodeById(nodeId);
+    if (!n || (n->x == static_cast<float>(pos.x()) && n->y == static_cast<float>(pos.y()))) {
+        // Programmatic setPos from a model move: only the attached lines need following
+        updateConnectionItems(nodeId);
+        return;
     }
+    m_model->setNodePosition(nodeId, static_cast<float>(pos.x()), static_cast<float>(pos.y()));
 }
 
 void NodeGraphView::onSelectionChanged() {
@@ -179,8 +264,8 @@ void NodeGraphView::onModelChanged() {
 
 void NodeGraphView::addNodeAt(const QPointF& scenePos, NodeType type) {
     if (!m_model) return;
+    // The NodeAdded event creates the item
     m_model->addNode(type, static_cast<float>(scenePos.x()), static_cast<float>(scenePos.y()));
-    rebuildScene();
 }
 
 } // namespace aether
@@ -1,16 +1,20 @@
 #pragma once
 
 #include <QGraphicsView>
+#include <unordered_map>
 #include "aether/NodeGraphModel.h"
 
 namespace aether {
 
 class NodeGraphModel;
+class NodeItem;
+class ConnectionLine;
 
 class NodeGraphView : public QGraphicsView {
     Q_OBJECT
 public:
     explicit NodeGraphView(QWidget* parent = nullptr);
+    ~NodeGraphView() override;
     void setModel(NodeGraphModel* model);
     NodeGraphModel* model() const { return m_model; }
     uint32_t selectedNodeId() const { return m_selectedNodeId; }
@@ -29,9 +33,22 @@ private:
     void rebuildScene();
     void addNodeAt(const QPointF& scenePos, NodeType type);
 
+    // Incremental scene updates driven by NodeGraphModel events
+    void onModelEvent(const NodeGraphEvent& event);
+    void addNodeItem(const Node& node);
+    void removeNodeItem(uint32_t nodeId);
+    void addConnectionItem(const NodeConnection& connection);
+    void removeConnectionItem(const NodeConnection& connection);
+    void updateConnectionItems(uint32_t nodeId);
+    bool connectionEndpoints(const NodeConnection& connection, QPointF* p1, QPointF* p2) const;
+    void onNodeItemMoved(uint32_t nodeId, const QPointF& pos);
+
     NodeGraphModel* m_model = nullptr;
     QGraphicsScene* m_scene = nullptr;
     uint32_t m_selectedNodeId = 0;
+    int m_listenerHandle = 0;
+    std::unordered_map<uint32_t, NodeItem*> m_nodeItems;
+    std::unordered_map<NodeConnection, ConnectionLine*, NodeConnectionHash> m_connectionItems;
 };
 
 } // namespace aether
@@ -0,0 +1,71 @@
+#include "aether/NodeResultCache.h"
+
+namespace aether {
+
+NodeResultCache::NodeResultCache(size_t budgetBytes) : m_budget(budgetBytes) {}
+
+void NodeResultCache::setBudget(size_t budgetBytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_budget = budgetBytes;
+    evictToBudget();
+}
+
+std::shared_ptr<const CpuImage> NodeResultCache::find(uint64_t key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_index.find(key);
+    if (it == m_index.end()) {
+        m_stats.misses++;
+        return nullptr;
+    }
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    m_stats.hits++;
+    return it->second->image;
+}
+
+void NodeResultCache::insert(uint64_t key, std::shared_ptr<const CpuImage> image) {
+    if (!image) {
+        return;
+    }
+    const size_t bytes = image->rgba.size() + sizeof(CpuImage);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (bytes > m_budget) {
+        return;
+    }
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        m_bytes -= it->second->bytes;
+        m_lru.erase(it->second);
+        m_index.erase(it);
+    }
+    m_lru.push_front({key, std::move(image), bytes});
+    m_index[key] = m_lru.begin();
+    m_bytes += bytes;
+    evictToBudget();
+}
+
+void NodeResultCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_lru.clear();
+    m_index.clear();
+    m_bytes = 0;
+}
+
+NodeCacheStats NodeResultCache::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    NodeCacheStats stats = m_stats;
+    stats.entries = m_lru.size();
+    stats.bytes = m_bytes;
+    return stats;
+}
+
+void NodeResultCache::evictToBudget() {
+    while (m_bytes > m_budget && !m_lru.empty()) {
+        const Entry& victim = m_lru.back();
+        m_bytes -= victim.bytes;
+        m_index.erase(victim.key);
+        m_lru.pop_back();
+        m_stats.evictions++;
+    }
+}
+
+} // namespace aether
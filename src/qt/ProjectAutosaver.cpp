@@ -0,0 +1,118 @@
+#include "aether/ProjectAutosaver.h"
+#include <QFileInfo>
+#include <algorithm>
+
+namespace aether {
+
+ProjectAutosaver::ProjectAutosaver(SavedCallback onSaved) : m_onSaved(std::move(onSaved)) {
+    m_thread = std::thread([this]() { workerLoop(); });
+}
+
+ProjectAutosaver::~ProjectAutosaver() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void ProjectAutosaver::submit(const QString& projectPath, ProjectDocument document) {
+    if (projectPath.isEmpty()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_hasPending) {
+            m_stats.superseded++;
+        }
+        m_pendingPath = autosavePathFor(projectPath);
+        m_pending = std::move(document);
+        m_hasPending = true;
+    }
+    m_condition.notify_one();
+}
+
+void ProjectAutosaver::cancelPending() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending = ProjectDocument();
+    m_hasPending = false;
+}
+
+bool ProjectAutosaver::isBusy() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_hasPending || m_saving;
+}
+
+AutosaveStats ProjectAutosaver::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+QString ProjectAutosaver::autosavePathFor(const QString& projectPath) {
+    return projectPath + QStringLiteral(".autosave");
+}
+
+bool ProjectAutosaver::hasNewerAutosave(const QString& projectPath) {
+    const QFileInfo project(projectPath);
+    const QFileInfo autosave(autosavePathFor(projectPath));
+    if (!autosave.exists() || autosave.lastModified() <= project.lastModified()) return false;
+
+    // A periodic autosave of an unedited project is newer but identical; compare chunk CRCs
+    ProjectReader a, b;
+    if (!a.open(projectPath)) return true;
+    if (!b.open(autosave.filePath())) return false;
+    if (a.chunks().size() != b.chunks().size()) return true;
+    for (const ProjectReader::ChunkEntry& entry : b.chunks()) {
+        const ProjectReader::ChunkEntry* other = a.findChunk(entry.type, entry.id);
+        if (!other || other->crc != entry.crc || other->size != entry.size) return true;
+    }
+    return false;
+}
+
+void ProjectAutosaver::workerLoop() {
+    for (;;) {
+        QString path;
+        ProjectDocument document;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_stopping || m_hasPending; });
+            // Still write what is queued when stopping; only then exit
+            if (!m_hasPending) {
+                return;
+            }
+            path = std::move(m_pendingPath);
+            document = std::move(m_pending);
+            m_pending = ProjectDocument();
+            m_hasPending = false;
+            m_saving = true;
+        }
+
+        ProjectSaveStats stats;
+        const bool ok = m_writer.save(path, document, &stats);
+        // Release the snapshot here rather than when the next document replaces it
+        document = ProjectDocument();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_saving = false;
+            m_stats.last = stats;
+            if (!ok) {
+                m_stats.failures++;
+                m_stats.lastError = m_writer.getLastError();
+            } else if (stats.chunksWritten == 0) {
+                m_stats.unchanged++;
+            } else {
+                m_stats.saves++;
+                m_stats.totalBytes += stats.bytesWritten;
+                m_stats.totalMs += stats.milliseconds;
+                m_stats.maxMs = std::max(m_stats.maxMs, stats.milliseconds);
+            }
+        }
+        if (m_onSaved) {
+            m_onSaved(ok, stats);
+        }
+    }
+}
+
+} // namespace aether
@@ -1,66 +1,964 @@
 #include "aether/ProjectFile.h"
+#include "aether/KeyframeModel.h"
+#include "aether/NodeGraphModel.h"
+#include "ProjectModel.h"
 #include <QFile>
-#include <QDir>
-#include <QTextStream>
 #include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QTextStream>
 #include <QStringConverter>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace aether {
 
-bool ProjectFile::saveToPath(const QString& path, const QString& projectName,
-                              const QString& saveLocation, const ProjectSettings& settings) {
-    QFile f(path);
-    if (!f.open(QIODevice::WriteOnly | QIODevice::Text))
-        return false;
-    QTextStream out(&f);
-    out.setEncoding(QStringConverter::Utf8);
-    out << "ProjectName=" << projectName << "\n";
-    out << "SaveLocation=" << saveLocation << "\n";
-    out << "Width=" << settings.width << "\n";
-    out << "Height=" << settings.height << "\n";
-    out << "Fps=" << settings.fps << "\n";
-    out << "BitrateKbps=" << settings.bitrateKbps << "\n";
-    out << "AudioSampleRate=" << settings.audioSampleRate << "\n";
-    f.close();
+// File layout (all integers little-endian):
+//   header   "AETHPROJ" u32 formatVersion u32 reserved
+//   chunk    u32 'CHNK' u32 type u32 id u32 version u32 size u32 crc, payload
+//   index    u32 'INDX', payload: u64 generation u32 count, count x {u32 type id version crc, u64 offset size}
+//   trailer  u32 'AEND' u32 indexCrc u64 indexOffset u32 indexSize u32 formatVersion
+// Saves append chunks, an index and a trailer; the last valid trailer wins.
+
+namespace {
+
+constexpr char kMagic[8] = {'A', 'E', 'T', 'H', 'P', 'R', 'O', 'J'};
+constexpr uint32_t kFormatVersion = 1;
+constexpr uint32_t kChunkMagic = ProjectChunk::fourcc('C', 'H', 'N', 'K');
+constexpr uint32_t kIndexMagic = ProjectChunk::fourcc('I', 'N', 'D', 'X');
+constexpr uint32_t kTrailerMagic = ProjectChunk::fourcc('A', 'E', 'N', 'D');
+constexpr qint64 kHeaderSize = 16;
+constexpr qint64 kChunkHeaderSize = 24;
+constexpr qint64 kIndexEntrySize = 32;
+constexpr qint64 kTrailerSize = 24;
+
+uint32_t crc32(const char* data, size_t size) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; i++)
+        crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+uint32_t crc32(const QByteArray& bytes) {
+    return crc32(bytes.constData(), static_cast<size_t>(bytes.size()));
+}
+
+class ByteWriter {
+public:
+    explicit ByteWriter(QByteArray& out) : m_out(out) {}
+
+    template <typename T>
+    void raw(T value) { m_out.append(reinterpret_cast<const char*>(&value), sizeof(T)); }
+    void u8(uint8_t v) { raw(v); }
+    void u32(uint32_t v) { raw(v); }
+    void u64(uint64_t v) { raw(v); }
+    void i64(int64_t v) { raw(v); }
+    void f32(float v) { raw(v); }
+    void f64(double v) { raw(v); }
+    void bytes(const char* data, size_t size) {
+        u32(static_cast<uint32_t>(size));
+        m_out.append(data, static_cast<qsizetype>(size));
+    }
+    void string(const QString& s) {
+        const QByteArray utf8 = s.toUtf8();
+        bytes(utf8.constData(), static_cast<size_t>(utf8.size()));
+    }
+    void string(const std::string& s) { bytes(s.data(), s.size()); }
+
+private:
+    QByteArray& m_out;
+};
+
+class ByteReader {
+public:
+    ByteReader(const char* data, size_t size) : m_pos(data), m_end(data + size) {}
+    explicit ByteReader(const QByteArray& bytes) : ByteReader(bytes.constData(), static_cast<size_t>(bytes.size())) {}
+
+    bool ok() const { return m_ok; }
+
+    template <typename T>
+    T raw() {
+        T value{};
+        if (static_cast<size_t>(m_end - m_pos) < sizeof(T)) {
+            m_ok = false;
+            return value;
+        }
+        std::memcpy(&value, m_pos, sizeof(T));
+        m_pos += sizeof(T);
+        return value;
+    }
+    uint8_t u8() { return raw<uint8_t>(); }
+    uint32_t u32() { return raw<uint32_t>(); }
+    uint64_t u64() { return raw<uint64_t>(); }
+    int64_t i64() { return raw<int64_t>(); }
+    float f32() { return raw<float>(); }
+    double f64() { return raw<double>(); }
+    QString qstring() {
+        const char* data = nullptr;
+        uint32_t size = span(data);
+        return m_ok ? QString::fromUtf8(data, size) : QString();
+    }
+    std::string string() {
+        const char* data = nullptr;
+        uint32_t size = span(data);
+        return m_ok ? std::string(data, size) : std::string();
+    }
+    // Element counts are bounded by the bytes left, so a corrupt count cannot force a huge allocation
+    uint32_t count(size_t minElementSize) {
+        uint32_t n = u32();
+        if (m_ok && static_cast<size_t>(m_end - m_pos) / minElementSize < n) m_ok = false;
+        return m_ok ? n : 0;
+    }
+
+private:
+    uint32_t span(const char*& data) {
+        uint32_t size = u32();
+        if (!m_ok || static_cast<size_t>(m_end - m_pos) < size) {
+            m_ok = false;
+            return 0;
+        }
+        data = m_pos;
+        m_pos += size;
+        return size;
+    }
+
+    const char* m_pos;
+    const char* m_end;
+    bool m_ok = true;
+};
+
+bool syncToDisk(QFile& file) {
+    if (!file.flush()) return false;
+#ifdef _WIN32
+    return _commit(file.handle()) == 0;
+#else
+    return fsync(file.handle()) == 0;
+#endif
+}
+
+// ---- Chunk payloads ----
+
+QByteArray encodeMeta(const ProjectDocument& doc, uint32_t trackCount) {
+    QByteArray out;
+    ByteWriter w(out);
+    w.string(doc.projectName);
+    w.string(doc.saveLocation);
+    w.u32(static_cast<uint32_t>(doc.settings.width));
+    w.u32(static_cast<uint32_t>(doc.settings.height));
+    w.u32(static_cast<uint32_t>(doc.settings.fps));
+    w.u32(static_cast<uint32_t>(doc.settings.bitrateKbps));
+    w.u32(static_cast<uint32_t>(doc.settings.audioSampleRate));
+    w.u32(trackCount);
+    return out;
+}
+
+bool decodeMeta(const QByteArray& payload, QString* name, QString* location, ProjectSettings* settings, uint32_t* trackCount) {
+    ByteReader r(payload);
+    QString n = r.qstring();
+    QString l = r.qstring();
+    ProjectSettings s;
+    s.width = static_cast<int>(r.u32());
+    s.height = static_cast<int>(r.u32());
+    s.fps = static_cast<int>(r.u32());
+    s.bitrateKbps = static_cast<int>(r.u32());
+    s.audioSampleRate = static_cast<int>(r.u32());
+    uint32_t tracks = r.u32();
+    if (!r.ok()) return false;
+    if (name) *name = n;
+    if (location) *location = l;
+    if (settings) *settings = s;
+    if (trackCount) *trackCount = tracks;
+    return true;
+}
+
+QByteArray encodeMedia(const QVector<MediaItem>& media) {
+    QByteArray out;
+    ByteWriter w(out);
+    w.u32(static_cast<uint32_t>(media.size()));
+    for (const MediaItem& m : media) {
+        w.string(m.path);
+        w.string(m.name);
+        w.i64(m.durationMs);
+        w.u8(static_cast<uint8_t>((m.isVideo ? 1 : 0) | (m.isAudio ? 2 : 0)));
+        w.u32(static_cast<uint32_t>(m.width));
+        w.u32(static_cast<uint32_t>(m.height));
+        w.u32(static_cast<uint32_t>(m.fps));
+        w.u32(static_cast<uint32_t>(m.interpretFps));
+        // Version 2: probe results
+        w.u8(m.probed ? 1 : 0);
+        w.string(m.videoCodec);
+        w.string(m.audioCodec);
+        w.u32(static_cast<uint32_t>(m.audioChannels));
+        w.u32(static_cast<uint32_t>(m.audioSampleRate));
+        w.string(m.audioLayout);
+    }
+    return out;
+}
+
+bool decodeMedia(const QByteArray& payload, uint32_t version, QVector<MediaItem>& media) {
+    ByteReader r(payload);
+    uint32_t count = r.count(version >= 2 ? 54 : 33);
+    media.reserve(count);
+    for (uint32_t i = 0; i < count && r.ok(); i++) {
+        MediaItem m;
+        m.path = r.qstring();
+        m.name = r.qstring();
+        m.durationMs = r.i64();
+        uint8_t flags = r.u8();
+        m.isVideo = (flags & 1) != 0;
+        m.isAudio = (flags & 2) != 0;
+        m.width = static_cast<int>(r.u32());
+        m.height = static_cast<int>(r.u32());
+        m.fps = static_cast<int>(r.u32());
+        m.interpretFps = static_cast<int>(r.u32());
+        if (version >= 2) {
+            m.probed = r.u8() != 0;
+            m.videoCodec = r.qstring();
+            m.audioCodec = r.qstring();
+            m.audioChannels = static_cast<int>(r.u32());
+            m.audioSampleRate = static_cast<int>(r.u32());
+            m.audioLayout = r.qstring();
+        }
+        media.append(m);
+    }
+    return r.ok();
+}
+
+// Clips reference a per-track path table, so a path used by many clips is stored once
+QByteArray encodeTrack(const Track& track) {
+    QByteArray out;
+    ByteWriter w(out);
+    w.string(track.name);
+    w.u8(track.isVideo ? 1 : 0);
+    QHash<QString, uint32_t> pathIndex;
+    std::vector<const QString*> paths;
+    std::vector<uint32_t> clipPaths;
+    clipPaths.reserve(static_cast<size_t>(track.clips.size()));
+    for (const TimelineClip& c : track.clips) {
+        auto it = pathIndex.find(c.mediaPath);
+        if (it == pathIndex.end()) {
+            it = pathIndex.insert(c.mediaPath, static_cast<uint32_t>(paths.size()));
+            paths.push_back(&c.mediaPath);
+        }
+        clipPaths.push_back(it.value());
+    }
+    w.u32(static_cast<uint32_t>(paths.size()));
+    for (const QString* path : paths)
+        w.string(*path);
+    w.u32(static_cast<uint32_t>(track.clips.size()));
+    out.reserve(out.size() + track.clips.size() * 38);
+    size_t i = 0;
+    for (const TimelineClip& c : track.clips) {
+        w.u32(clipPaths[i++]);
+        w.i64(c.sourceInMs);
+        w.i64(c.sourceOutMs);
+        w.i64(c.timelineStartMs);
+        w.f64(c.speedRatio);
+        w.u8(c.scaleToFrame ? 1 : 0);
+    }
+    return out;
+}
+
+bool decodeTrack(const QByteArray& payload, int trackIndex, Track& track) {
+    ByteReader r(payload);
+    track.name = r.qstring();
+    track.isVideo = r.u8() != 0;
+    uint32_t pathCount = r.count(4);
+    std::vector<QString> paths;
+    paths.reserve(pathCount);
+    for (uint32_t i = 0; i < pathCount && r.ok(); i++)
+        paths.push_back(r.qstring());
+    uint32_t clipCount = r.count(37);
+    std::vector<TimelineClip> clips(clipCount);
+    for (TimelineClip& c : clips) {
+        uint32_t path = r.u32();
+        if (!r.ok() || path >= paths.size()) return false;
+        c.mediaPath = paths[path];
+        c.sourceInMs = r.i64();
+        c.sourceOutMs = r.i64();
+        c.timelineStartMs = r.i64();
+        c.speedRatio = r.f64();
+        c.scaleToFrame = r.u8() != 0;
+        c.trackIndex = trackIndex;
+    }
+    if (!r.ok()) return false;
+    // Tracks must be ordered by start; files written before that was kept may not be
+    std::stable_sort(clips.begin(), clips.end(), [](const TimelineClip& a, const TimelineClip& b) {
+        return a.timelineStartMs < b.timelineStartMs;
+    });
+    track.clips = ClipList::fromRange(clips.begin(), clips.end());
+    return true;
+}
+
+QByteArray encodeNodeGraph(const NodeGraphModel& graph) {
+    QByteArray out;
+    ByteWriter w(out);
+    w.u32(static_cast<uint32_t>(graph.nodes().size()));
+    for (const Node& n : graph.nodes()) {
+        w.u32(n.id);
+        w.u32(static_cast<uint32_t>(n.type));
+        w.f32(n.x);
+        w.f32(n.y);
+        w.string(n.title);
+        w.u32(static_cast<uint32_t>(n.inputPortNames.size()));
+        for (const std::string& port : n.inputPortNames) w.string(port);
+        w.u32(static_cast<uint32_t>(n.outputPortNames.size()));
+        for (const std::string& port : n.outputPortNames) w.string(port);
+    }
+    w.u32(static_cast<uint32_t>(graph.connections().size()));
+    for (const NodeConnection& c : graph.connections()) {
+        w.u32(c.source.nodeId);
+        w.u32(c.source.portIndex);
+        w.u32(c.dest.nodeId);
+        w.u32(c.dest.portIndex);
+    }
+    return out;
+}
+
+bool decodeNodeGraph(const QByteArray& payload, NodeGraphModel& graph) {
+    ByteReader r(payload);
+    graph.clear();
+    uint32_t nodeCount = r.count(24);
+    for (uint32_t i = 0; i < nodeCount && r.ok(); i++) {
+        Node n;
+        n.id = r.u32();
+        uint32_t type = r.u32();
+        if (type > static_cast<uint32_t>(NodeType::Glow)) return false;
+        n.type = static_cast<NodeType>(type);
+        n.x = r.f32();
+        n.y = r.f32();
+        n.title = r.string();
+        uint32_t inputs = r.count(4);
+        for (uint32_t k = 0; k < inputs && r.ok(); k++) n.inputPortNames.push_back(r.string());
+        uint32_t outputs = r.count(4);
+        for (uint32_t k = 0; k < outputs && r.ok(); k++) n.outputPortNames.push_back(r.string());
+        if (r.ok() && !graph.insertNode(std::move(n))) return false;
+    }
+    uint32_t connectionCount = r.count(16);
+    for (uint32_t i = 0; i < connectionCount && r.ok(); i++) {
+        NodePort source{ r.u32(), 0 };
+        source.portIndex = r.u32();
+        NodePort dest{ r.u32(), 0 };
+        dest.portIndex = r.u32();
+        if (r.ok()) graph.addConnection(source, dest);
+    }
+    return r.ok();
+}
+
+QByteArray encodeKeyframes(const KeyframeModel& model) {
+    QByteArray out;
+    ByteWriter w(out);
+    w.u32(model.nodeId());
+    w.u32(static_cast<uint32_t>(model.parameters().size()));
+    for (const ParameterKeyframes& p : model.parameters()) {
+        w.string(p.parameterId);
+        w.string(p.displayName);
+        w.f64(p.minValue);
+        w.f64(p.maxValue);
+        w.u32(static_cast<uint32_t>(p.keyframes.size()));
+        for (const Keyframe& k : p.keyframes) {
+            w.i64(k.timeMs);
+            w.f64(k.value);
+            w.u8(static_cast<uint8_t>(k.interpolation));
+            w.f64(k.inHandle.x);
+            w.f64(k.inHandle.y);
+            w.f64(k.outHandle.x);
+            w.f64(k.outHandle.y);
+        }
+    }
+    return out;
+}
+
+bool decodeKeyframes(const QByteArray& payload, KeyframeModel& model) {
+    ByteReader r(payload);
+    uint32_t nodeId = r.u32();
+    uint32_t paramCount = r.count(28);
+    std::vector<ParameterKeyframes> params(paramCount);
+    for (ParameterKeyframes& p : params) {
+        p.parameterId = r.string();
+        p.displayName = r.string();
+        p.minValue = r.f64();
+        p.maxValue = r.f64();
+        uint32_t keyCount = r.count(49);
+        p.keyframes.resize(keyCount);
+        for (Keyframe& k : p.keyframes) {
+            k.timeMs = r.i64();
+            k.value = r.f64();
+            uint8_t interpolation = r.u8();
+            if (interpolation > static_cast<uint8_t>(KeyframeInterpolation::Bezier)) return false;
+            k.interpolation = static_cast<KeyframeInterpolation>(interpolation);
+            k.inHandle.x = r.f64();
+            k.inHandle.y = r.f64();
+            k.outHandle.x = r.f64();
+            k.outHandle.y = r.f64();
+        }
+        if (!r.ok()) return false;
+    }
+    if (!r.ok()) return false;
+    model.setNodeId(nodeId);
+    model.setParameters(params);
     return true;
 }
 
-static QString readIniLine(const QString& path, const QString& key) {
+bool isBinaryProject(const QString& path) {
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    return f.read(sizeof(kMagic)) == QByteArray(kMagic, sizeof(kMagic));
+}
+
+// Older projects were INI-style text with settings only; read it in a single pass
+QHash<QString, QString> readIni(const QString& path) {
+    QHash<QString, QString> values;
     QFile f(path);
     if (!f.open(QIODevice::ReadOnly | QIODevice::Text))
-        return QString();
+        return values;
     QTextStream in(&f);
     in.setEncoding(QStringConverter::Utf8);
     while (!in.atEnd()) {
         QString line = in.readLine().trimmed();
         int eq = line.indexOf(QLatin1Char('='));
         if (eq <= 0) continue;
-        if (line.left(eq).trimmed() == key)
-            return line.mid(eq + 1).trimmed();
+        values.insert(line.left(eq).trimmed(), line.mid(eq + 1).trimmed());
     }
-    return QString();
+    return values;
+}
+
+void sanitizeSettings(ProjectSettings& s) {
+    if (s.width <= 0) s.width = 1920;
+    if (s.height <= 0) s.height = 1080;
+    if (s.fps <= 0) s.fps = 30;
+    if (s.bitrateKbps <= 0) s.bitrateKbps = 25000;
+    if (s.audioSampleRate <= 0) s.audioSampleRate = 48000;
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+} // namespace
+
+// ---- ProjectFile ----
+
+ProjectDocument ProjectFile::capture(const ProjectModel& model, const NodeGraphModel* nodeGraph,
+                                     const KeyframeModel* keyframes, const QString& projectName,
+                                     const QString& saveLocation, const ProjectSettings& settings) {
+    ProjectDocument doc;
+    doc.projectName = projectName;
+    doc.saveLocation = saveLocation;
+    doc.settings = settings;
+    doc.media = std::make_shared<const QVector<MediaItem>>(model.media()); // implicitly shared
+    doc.timeline = model.snapshot();
+    if (nodeGraph) doc.nodeGraph = std::make_shared<const NodeGraphModel>(*nodeGraph);
+    if (keyframes) doc.keyframes = std::make_shared<const KeyframeModel>(*keyframes);
+    return doc;
+}
+
+bool ProjectFile::saveToPath(const QString& path, const QString& projectName,
+                             const QString& saveLocation, const ProjectSettings& settings) {
+    ProjectDocument doc;
+    doc.projectName = projectName;
+    doc.saveLocation = saveLocation;
+    doc.settings = settings;
+    doc.media = std::make_shared<const QVector<MediaItem>>();
+    doc.timeline = std::make_shared<const TimelineSnapshot>();
+    ProjectWriter writer;
+    return writer.save(path, doc);
 }
 
 bool ProjectFile::loadFromPath(const QString& path, QString* outProjectName,
                                QString* outSaveLocation, ProjectSettings* outSettings) {
     if (!outProjectName && !outSaveLocation && !outSettings)
         return true;
+    if (isBinaryProject(path)) {
+        ProjectReader reader;
+        QByteArray payload;
+        const ProjectReader::ChunkEntry* meta = reader.open(path) ? reader.findChunk(ProjectChunk::Meta) : nullptr;
+        if (!meta || !reader.readChunk(*meta, payload)) return false;
+        if (!decodeMeta(payload, outProjectName, outSaveLocation, outSettings, nullptr)) return false;
+        if (outSettings) sanitizeSettings(*outSettings);
+        return true;
+    }
+    const QHash<QString, QString> ini = readIni(path);
     if (outProjectName)
-        *outProjectName = readIniLine(path, QStringLiteral("ProjectName"));
+        *outProjectName = ini.value(QStringLiteral("ProjectName"));
     if (outSaveLocation)
-        *outSaveLocation = readIniLine(path, QStringLiteral("SaveLocation"));
+        *outSaveLocation = ini.value(QStringLiteral("SaveLocation"));
     if (outSettings) {
-        outSettings->width = readIniLine(path, QStringLiteral("Width")).toInt();
-        if (outSettings->width <= 0) outSettings->width = 1920;
-        outSettings->height = readIniLine(path, QStringLiteral("Height")).toInt();
-        if (outSettings->height <= 0) outSettings->height = 1080;
-        outSettings->fps = readIniLine(path, QStringLiteral("Fps")).toInt();
-        if (outSettings->fps <= 0) outSettings->fps = 30;
-        outSettings->bitrateKbps = readIniLine(path, QStringLiteral("BitrateKbps")).toInt();
-        if (outSettings->bitrateKbps <= 0) outSettings->bitrateKbps = 25000;
-        outSettings->audioSampleRate = readIniLine(path, QStringLiteral("AudioSampleRate")).toInt();
-        if (outSettings->audioSampleRate <= 0) outSettings->audioSampleRate = 48000;
+        outSettings->width = ini.value(QStringLiteral("Width")).toInt();
+        outSettings->height = ini.value(QStringLiteral("Height")).toInt();
+        outSettings->fps = ini.value(QStringLiteral("Fps")).toInt();
+        outSettings->bitrateKbps = ini.value(QStringLiteral("BitrateKbps")).toInt();
+        outSettings->audioSampleRate = ini.value(QStringLiteral("AudioSampleRate")).toInt();
+        sanitizeSettings(*outSettings);
+    }
+    return true;
+}
+
+bool ProjectFile::loadProject(const QString& path, ProjectModel& model, NodeGraphModel* nodeGraph,
+                              KeyframeModel* keyframes, QString* outProjectName, QString* outSaveLocation,
+                              ProjectSettings* outSettings, QString* outError) {
+    auto fail = [outError](const QString& message) {
+        if (outError) *outError = message;
+        return false;
+    };
+    if (!isBinaryProject(path)) {
+        // Settings-only INI project: open it with an empty timeline
+        if (!QFileInfo::exists(path) || !loadFromPath(path, outProjectName, outSaveLocation, outSettings))
+            return fail(QStringLiteral("Could not read %1").arg(path));
+        model.clearMedia();
+        model.clearAllClips();
+        if (nodeGraph) nodeGraph->clear();
+        if (keyframes) keyframes->setParameters({});
+        return true;
+    }
+
+    ProjectReader reader;
+    if (!reader.open(path)) return fail(reader.getLastError());
+    QByteArray payload;
+    uint32_t version = 0;
+    auto read = [&](uint32_t type, uint32_t id) {
+        const ProjectReader::ChunkEntry* entry = reader.findChunk(type, id);
+        version = entry ? entry->version : 0;
+        return entry && reader.readChunk(*entry, payload);
+    };
+
+    uint32_t trackCount = 0;
+    ProjectSettings settings;
+    QString name, location;
+    if (!read(ProjectChunk::Meta, 0) || !decodeMeta(payload, &name, &location, &settings, &trackCount))
+        return fail(QStringLiteral("Project metadata is missing or damaged"));
+    sanitizeSettings(settings);
+
+    QVector<MediaItem> media;
+    if (read(ProjectChunk::Media, 0) && !decodeMedia(payload, version, media))
+        return fail(QStringLiteral("Media pool is damaged"));
+
+    std::vector<Track> tracks(trackCount);
+    for (uint32_t i = 0; i < trackCount; i++) {
+        if (!read(ProjectChunk::Track, i) || !decodeTrack(payload, static_cast<int>(i), tracks[i]))
+            return fail(QStringLiteral("Track %1 is missing or damaged").arg(i + 1));
+    }
+
+    model.resetContents(std::move(media), PersistentVector<Track>::fromRange(tracks.begin(), tracks.end()));
+    if (nodeGraph) {
+        if (read(ProjectChunk::NodeGraph, 0)) {
+            if (!decodeNodeGraph(payload, *nodeGraph)) return fail(QStringLiteral("Node graph is damaged"));
+        } else {
+            nodeGraph->clear();
+        }
+    }
+    if (keyframes) {
+        if (read(ProjectChunk::Keyframes, 0)) {
+            if (!decodeKeyframes(payload, *keyframes)) return fail(QStringLiteral("Keyframes are damaged"));
+        } else {
+            keyframes->setParameters({});
+        }
+    }
+    if (outProjectName) *outProjectName = name;
+    if (outSaveLocation) *outSaveLocation = location;
+    if (outSettings) *outSettings = settings;
+    return true;
+}
+
+// ---- ProjectReader ----
+
+bool ProjectReader::open(const QString& path) {
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_lastError = QStringLiteral("Cannot open %1").arg(path);
+        return false;
+    }
+    const qint64 size = m_file.size();
+    if (size < kHeaderSize + kTrailerSize || m_file.read(sizeof(kMagic)) != QByteArray(kMagic, sizeof(kMagic))) {
+        m_lastError = QStringLiteral("Not an Aether project file");
+        close();
+        return false;
+    }
+    m_file.seek(size - kTrailerSize);
+    const QByteArray trailer = m_file.read(kTrailerSize);
+    ByteReader r(trailer);
+    const uint32_t magic = r.u32();
+    const uint32_t indexCrc = r.u32();
+    const uint64_t indexOffset = r.u64();
+    const uint32_t indexSize = r.u32();
+    if (r.ok() && magic == kTrailerMagic && indexOffset + indexSize + kTrailerSize == static_cast<uint64_t>(size)
+        && readIndex(indexOffset, indexSize, indexCrc) && appendedChunksIntact(indexOffset)) {
+        m_validEnd = static_cast<uint64_t>(size);
+        return true;
+    }
+    if (recoverIndex()) return true;
+    m_lastError = QStringLiteral("Project index is damaged");
+    close();
+    return false;
+}
+
+void ProjectReader::close() {
+    if (m_file.isOpen()) m_file.close();
+    m_chunks.clear();
+    m_generation = 0;
+    m_validEnd = 0;
+}
+
+bool ProjectReader::readIndex(uint64_t indexOffset, uint32_t indexSize, uint32_t indexCrc) {
+    if (indexOffset < static_cast<uint64_t>(kHeaderSize) || !m_file.seek(static_cast<qint64>(indexOffset))) return false;
+    const QByteArray index = m_file.read(indexSize);
+    if (index.size() != static_cast<qsizetype>(indexSize) || crc32(index) != indexCrc) return false;
+    ByteReader r(index);
+    const uint64_t generation = r.u64();
+    const uint32_t count = r.count(kIndexEntrySize);
+    std::vector<ChunkEntry> chunks(count);
+    for (ChunkEntry& e : chunks) {
+        e.type = r.u32();
+        e.id = r.u32();
+        e.version = r.u32();
+        e.crc = r.u32();
+        e.offset = r.u64();
+        e.size = r.u64();
+        if (e.offset < static_cast<uint64_t>(kHeaderSize + kChunkHeaderSize) || e.offset + e.size > indexOffset) return false;
+    }
+    if (!r.ok()) return false;
+    m_chunks = std::move(chunks);
+    m_generation = generation;
+    return true;
+}
+
+// Chunks reach the disk before their index, but a torn or reordered write can
+// still leave the index pointing at damaged data. Only the newest save's chunks
+// are at risk: they are the run that ends right before the index record.
+// Older chunks were in place before an earlier index was written.
+bool ProjectReader::appendedChunksIntact(uint64_t indexOffset) {
+    std::vector<const ChunkEntry*> byOffset;
+    byOffset.reserve(m_chunks.size());
+    for (const ChunkEntry& e : m_chunks) byOffset.push_back(&e);
+    std::sort(byOffset.begin(), byOffset.end(), [](const ChunkEntry* a, const ChunkEntry* b) { return a->offset > b->offset; });
+    uint64_t end = indexOffset - 4; // the index record starts with its magic
+    size_t appended = 0;
+    while (appended < byOffset.size() && byOffset[appended]->offset + byOffset[appended]->size == end) {
+        end = byOffset[appended]->offset - kChunkHeaderSize;
+        appended++;
+    }
+    // A run reaching the file header was written whole and renamed into place
+    if (end == static_cast<uint64_t>(kHeaderSize)) return true;
+    QByteArray payload;
+    for (size_t i = 0; i < appended; i++) {
+        if (!readChunk(*byOffset[i], payload)) return false;
+    }
+    return true;
+}
+
+// A save was interrupted: walk back to the newest trailer whose index and chunks check out
+bool ProjectReader::recoverIndex() {
+    m_file.seek(0);
+    const QByteArray all = m_file.readAll();
+    for (qsizetype pos = all.size() - kTrailerSize; pos >= kHeaderSize; pos--) {
+        uint32_t magic;
+        std::memcpy(&magic, all.constData() + pos, sizeof(magic));
+        if (magic != kTrailerMagic) continue;
+        ByteReader r(all.constData() + pos + 4, kTrailerSize - 4);
+        const uint32_t indexCrc = r.u32();
+        const uint64_t indexOffset = r.u64();
+        const uint32_t indexSize = r.u32();
+        if (indexOffset + indexSize != static_cast<uint64_t>(pos)) continue;
+        if (readIndex(indexOffset, indexSize, indexCrc) && appendedChunksIntact(indexOffset)) {
+            m_validEnd = static_cast<uint64_t>(pos + kTrailerSize);
+            return true;
+        }
+    }
+    return false;
+}
+
+const ProjectReader::ChunkEntry* ProjectReader::findChunk(uint32_t type, uint32_t id) const {
+    for (const ChunkEntry& e : m_chunks) {
+        if (e.type == type && e.id == id) return &e;
+    }
+    return nullptr;
+}
+
+bool ProjectReader::readChunk(const ChunkEntry& entry, QByteArray& payload) {
+    if (!m_file.isOpen() || !m_file.seek(static_cast<qint64>(entry.offset))) return false;
+    payload = m_file.read(static_cast<qint64>(entry.size));
+    if (payload.size() != static_cast<qsizetype>(entry.size) || crc32(payload) != entry.crc) {
+        m_lastError = QStringLiteral("Chunk checksum mismatch");
+        return false;
+    }
+    return true;
+}
+
+// ---- ProjectWriter ----
+
+struct ProjectWriter::Pending {
+    uint32_t type = 0;
+    uint32_t id = 0;
+    uint32_t version = 1;
+    std::function<QByteArray()> encode;
+    QByteArray payload;
+    bool encoded = false;
+    bool reuse = false; // identical to the chunk already in the file
+    ProjectReader::ChunkEntry entry;
+
+    void ensureEncoded() {
+        if (encoded) return;
+        payload = encode();
+        entry.type = type;
+        entry.id = id;
+        entry.version = version;
+        entry.size = static_cast<uint64_t>(payload.size());
+        entry.crc = crc32(payload);
+        encoded = true;
+    }
+};
+
+ProjectWriter::ProjectWriter() = default;
+ProjectWriter::~ProjectWriter() = default;
+
+void ProjectWriter::reset() {
+    m_path.clear();
+    m_fileSize = 0;
+    m_generation = 0;
+    m_written.clear();
+    m_lastMedia.reset();
+    m_lastTimeline.reset();
+}
+
+bool ProjectWriter::save(const QString& path, const ProjectDocument& document, ProjectSaveStats* outStats) {
+    const auto start = std::chrono::steady_clock::now();
+    ProjectSaveStats stats;
+    m_lastError.clear();
+    if (!document.media || !document.timeline) {
+        m_lastError = QStringLiteral("Incomplete project document");
+        return false;
+    }
+
+    // Appending is only safe onto the exact file this writer produced last
+    const QFileInfo info(path);
+    const bool canAppend = path == m_path && m_fileSize > 0 && info.exists()
+                           && static_cast<uint64_t>(info.size()) == m_fileSize;
+    if (!canAppend) reset();
+
+    std::vector<Pending> pending;
+    auto add = [&](uint32_t type, uint32_t id, std::function<QByteArray()> encode) -> Pending& {
+        Pending p;
+        p.type = type;
+        p.id = id;
+        p.encode = std::move(encode);
+        pending.push_back(std::move(p));
+        return pending.back();
+    };
+    // Parts still shared with the last save are known to be unchanged without encoding them
+    auto reuseIfWritten = [&](Pending& p) {
+        auto it = m_written.find({p.type, p.id});
+        if (it == m_written.end()) return;
+        p.entry = it->second;
+        p.reuse = true;
+    };
+
+    const ProjectDocument& doc = document;
+    const auto& tracks = doc.timeline->tracks;
+    add(ProjectChunk::Meta, 0, [&doc, &tracks] { return encodeMeta(doc, static_cast<uint32_t>(tracks.size())); });
+
+    Pending& media = add(ProjectChunk::Media, 0, [&doc] { return encodeMedia(*doc.media); });
+    media.version = 2;
+    if (m_lastMedia && m_lastMedia->size() == doc.media->size() && m_lastMedia->constData() == doc.media->constData())
+        reuseIfWritten(media);
+
+    for (qsizetype i = 0; i < tracks.size(); i++) {
+        const Track& track = tracks[i];
+        Pending& p = add(ProjectChunk::Track, static_cast<uint32_t>(i), [&track] { return encodeTrack(track); });
+        if (m_lastTimeline && i < m_lastTimeline->tracks.size()) {
+            const Track& previous = m_lastTimeline->tracks[i];
+            if (previous.clips.sharesRootWith(track.clips) && previous.name == track.name && previous.isVideo == track.isVideo)
+                reuseIfWritten(p);
+        }
+    }
+    if (doc.nodeGraph)
+        add(ProjectChunk::NodeGraph, 0, [&doc] { return encodeNodeGraph(*doc.nodeGraph); });
+    if (doc.keyframes)
+        add(ProjectChunk::Keyframes, 0, [&doc] { return encodeKeyframes(*doc.keyframes); });
+
+    // Everything else is encoded and compared with what the file already holds
+    uint64_t liveBytes = kHeaderSize;
+    uint64_t appendBytes = 0;
+    for (Pending& p : pending) {
+        if (!p.reuse) {
+            p.ensureEncoded();
+            auto it = m_written.find({p.type, p.id});
+            if (it != m_written.end() && it->second.crc == p.entry.crc && it->second.size == p.entry.size
+                && it->second.version == p.entry.version) {
+                p.entry = it->second;
+                p.reuse = true;
+            }
+        }
+        liveBytes += kChunkHeaderSize + p.entry.size;
+        if (!p.reuse) appendBytes += kChunkHeaderSize + p.entry.size;
+    }
+    const uint64_t indexBytes = 4 + 12 + pending.size() * kIndexEntrySize + kTrailerSize;
+    liveBytes += indexBytes;
+    appendBytes += indexBytes;
+
+    // Nothing changed since the last save: the file is already current
+    const bool unchanged = std::all_of(pending.begin(), pending.end(), [](const Pending& p) { return p.reuse; });
+    if (canAppend && unchanged && m_written.size() == pending.size()) {
+        stats.chunksReused = static_cast<uint32_t>(pending.size());
+        stats.milliseconds = elapsedMs(start);
+        if (outStats) *outStats = stats;
+        return true;
+    }
+
+    // Compact once superseded chunks would make up more than half the file
+    const bool append = canAppend && m_fileSize + appendBytes <= 2 * liveBytes + (1u << 20);
+    const bool ok = append ? writeAppend(path, pending, stats) : writeFull(path, pending, stats);
+    if (!ok) {
+        reset();
+        return false;
+    }
+
+    m_written.clear();
+    for (const Pending& p : pending)
+        m_written[{p.type, p.id}] = p.entry;
+    m_path = path;
+    m_lastMedia = doc.media;
+    m_lastTimeline = doc.timeline;
+    stats.milliseconds = elapsedMs(start);
+    if (outStats) *outStats = stats;
+    return true;
+}
+
+namespace {
+
+QByteArray chunkHeader(const ProjectReader::ChunkEntry& e) {
+    QByteArray out;
+    ByteWriter w(out);
+    w.u32(kChunkMagic);
+    w.u32(e.type);
+    w.u32(e.id);
+    w.u32(e.version);
+    w.u32(static_cast<uint32_t>(e.size));
+    w.u32(e.crc);
+    return out;
+}
+
+QByteArray indexAndTrailer(uint64_t generation, const std::vector<ProjectReader::ChunkEntry>& entries, uint64_t indexRecordOffset) {
+    QByteArray index;
+    ByteWriter w(index);
+    w.u64(generation);
+    w.u32(static_cast<uint32_t>(entries.size()));
+    for (const auto& e : entries) {
+        w.u32(e.type);
+        w.u32(e.id);
+        w.u32(e.version);
+        w.u32(e.crc);
+        w.u64(e.offset);
+        w.u64(e.size);
+    }
+    QByteArray out;
+    ByteWriter o(out);
+    o.u32(kIndexMagic);
+    out.append(index);
+    o.u32(kTrailerMagic);
+    o.u32(crc32(index));
+    o.u64(indexRecordOffset + 4);
+    o.u32(static_cast<uint32_t>(index.size()));
+    o.u32(kFormatVersion);
+    return out;
+}
+
+} // namespace
+
+bool ProjectWriter::writeFull(const QString& path, std::vector<Pending>& pending, ProjectSaveStats& stats) {
+    // QSaveFile writes beside the target and renames over it on commit()
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        m_lastError = QStringLiteral("Cannot write %1").arg(path);
+        return false;
+    }
+    QByteArray header;
+    ByteWriter w(header);
+    header.append(kMagic, sizeof(kMagic));
+    w.u32(kFormatVersion);
+    w.u32(0);
+    file.write(header);
+    uint64_t offset = static_cast<uint64_t>(header.size());
+
+    std::vector<ProjectReader::ChunkEntry> entries;
+    entries.reserve(pending.size());
+    for (Pending& p : pending) {
+        p.ensureEncoded();
+        p.entry.offset = offset + kChunkHeaderSize;
+        file.write(chunkHeader(p.entry));
+        file.write(p.payload);
+        offset += kChunkHeaderSize + p.entry.size;
+        entries.push_back(p.entry);
+        stats.chunksWritten++;
+    }
+    const QByteArray tail = indexAndTrailer(++m_generation, entries, offset);
+    file.write(tail);
+    offset += static_cast<uint64_t>(tail.size());
+    if (!file.commit()) {
+        m_lastError = QStringLiteral("Saving %1 failed: %2").arg(path, file.errorString());
+        return false;
+    }
+    m_fileSize = offset;
+    stats.bytesWritten = offset;
+    stats.compacted = true;
+    return true;
+}
+
+bool ProjectWriter::writeAppend(const QString& path, std::vector<Pending>& pending, ProjectSaveStats& stats) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadWrite) || !file.seek(static_cast<qint64>(m_fileSize))) {
+        m_lastError = QStringLiteral("Cannot append to %1").arg(path);
+        return false;
+    }
+    uint64_t offset = m_fileSize;
+    std::vector<ProjectReader::ChunkEntry> entries;
+    entries.reserve(pending.size());
+    for (Pending& p : pending) {
+        if (p.reuse) {
+            stats.chunksReused++;
+        } else {
+            p.entry.offset = offset + kChunkHeaderSize;
+            if (file.write(chunkHeader(p.entry)) != kChunkHeaderSize || file.write(p.payload) != p.payload.size()) {
+                m_lastError = QStringLiteral("Writing %1 failed: %2").arg(path, file.errorString());
+                return false;
+            }
+            offset += kChunkHeaderSize + p.entry.size;
+            stats.chunksWritten++;
+        }
+        entries.push_back(p.entry);
+    }
+    // The chunks must be on disk before the index that points at them
+    if (stats.chunksWritten > 0 && !syncToDisk(file)) {
+        m_lastError = QStringLiteral("Writing %1 failed: %2").arg(path, file.errorString());
+        return false;
+    }
+    // The trailer goes last: until it is on disk, readers keep using the previous index
+    const QByteArray tail = indexAndTrailer(++m_generation, entries, offset);
+    if (file.write(tail) != tail.size() || !syncToDisk(file)) {
+        m_lastError = QStringLiteral("Writing %1 failed: %2").arg(path, file.errorString());
+        return false;
     }
+    offset += static_cast<uint64_t>(tail.size());
+    stats.bytesWritten = offset - m_fileSize;
+    m_fileSize = offset;
     return true;
 }
 
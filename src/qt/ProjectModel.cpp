@@ -1,24 +1,99 @@
 #include "ProjectModel.h"
+#include "aether/MediaProbe.h"
+#include "aether/UndoRedo.h"
 #include <QFileInfo>
+#include <QHash>
 
 namespace aether {
 
+namespace {
+
+// What keeping `after` costs on top of `before`: the track and clip nodes the edits copied
+size_t snapshotEditBytes(const TimelineSnapshot& before, const TimelineSnapshot& after) {
+    size_t bytes = sizeof(TimelineSnapshot) + after.tracks.unsharedBytes(before.tracks);
+    auto previous = before.tracks.begin();
+    for (const Track& t : after.tracks) {
+        if (previous != before.tracks.end()) {
+            bytes += t.clips.unsharedBytes(previous->clips);
+            ++previous;
+        } else {
+            bytes += t.clips.unsharedBytes(ClipList());
+        }
+    }
+    return bytes;
+}
+
+} // namespace
+
+int Track::clipAt(qint64 timeMs) const {
+    // First clip ending after timeMs; clips are ordered by start, so no later one can start earlier
+    const ClipList::size_type i = clips.findFirst([timeMs](const ClipSpan& s) { return s.maxEndMs > timeMs; });
+    if (i >= clips.size() || clips[i].timelineStartMs > timeMs) return -1;
+    return static_cast<int>(i);
+}
+
+void Track::clipsInRange(qint64 fromMs, qint64 toMs, std::vector<int>& out) const {
+    out.clear();
+    ClipList::size_type i = clips.findFirst([fromMs](const ClipSpan& s) { return s.maxEndMs > fromMs; });
+    for (auto it = clips.iteratorAt(i); i < clips.size() && it->timelineStartMs <= toMs; ++it, ++i) {
+        if (it->timelineEndMs() > fromMs) out.push_back(static_cast<int>(i));
+    }
+}
+
+int Track::insertionIndex(qint64 startMs) const {
+    return static_cast<int>(clips.findFirst([startMs](const ClipSpan& s) { return s.maxStartMs > startMs; }));
+}
+
+bool Track::overlaps(qint64 startMs, qint64 endMs, int ignore) const {
+    if (endMs <= startMs) return false;
+    std::vector<int> hits;
+    clipsInRange(startMs, endMs - 1, hits);
+    return std::any_of(hits.begin(), hits.end(), [ignore](int i) { return i != ignore; });
+}
+
+// Undo step between two timeline versions; undo and redo just swap the current snapshot
+class ProjectModel::SnapshotAction : public UndoRedoAction {
+public:
+    SnapshotAction(ProjectModel& model, const char* description, std::string coalesceKey,
+                   TimelineSnapshotPtr before, TimelineSnapshotPtr after)
+        : m_model(model), m_description(description), m_coalesceKey(std::move(coalesceKey))
+        , m_before(std::move(before)), m_after(std::move(after))
+        , m_bytes(snapshotEditBytes(*m_before, *m_after)) {}
+
+    void undo() override { m_model.restoreSnapshot(m_before); }
+    void redo() override { m_model.restoreSnapshot(m_after); }
+    std::string getDescription() const override { return m_description; }
+    std::string getCoalesceKey() const override { return m_coalesceKey; }
+    size_t getMemoryUsage() const override { return sizeof(*this) + m_bytes; }
+
+    bool mergeWith(const UndoRedoAction& newer) override {
+        const auto* other = dynamic_cast<const SnapshotAction*>(&newer);
+        if (!other || &other->m_model != &m_model || other->m_before != m_after) return false;
+        m_after = other->m_after;
+        m_bytes = snapshotEditBytes(*m_before, *m_after);
+        return true;
+    }
+
+private:
+    ProjectModel& m_model;
+    std::string m_description;
+    std::string m_coalesceKey;
+    TimelineSnapshotPtr m_before;
+    TimelineSnapshotPtr m_after;
+    size_t m_bytes = 0;
+};
+
 ProjectModel::ProjectModel(QObject* parent) : QObject(parent) {
+    m_timeline = std::make_shared<TimelineSnapshot>();
+    m_published.store(m_timeline);
     addTrack(true);
     addTrack(false);
 }
 
 qint64 ProjectModel::sequenceDurationMs() const {
     qint64 end = 0;
-    for (const Track& t : m_tracks) {
-        for (const TimelineClip& c : t.clips) {
-            qint64 span = (c.speedRatio > 0.001)
-                ? static_cast<qint64>((c.sourceOutMs - c.sourceInMs) / c.speedRatio)
-                : (c.sourceOutMs - c.sourceInMs);
-            qint64 clipEnd = c.timelineStartMs + span;
-            if (clipEnd > end) end = clipEnd;
-        }
-    }
+    for (const Track& t : tracks())
+        end = std::max(end, t.endMs());
     return end;
 }
 
@@ -51,6 +126,37 @@ void ProjectModel::setMediaMetadataByPath(const QString& path, int width, int he
     }
 }
 
+void ProjectModel::applyProbeResults(const std::vector<MediaProbeResult>& results) {
+    if (results.empty()) return;
+    // A path may have been imported more than once; update every copy
+    QHash<QString, std::vector<int>> byPath;
+    for (int i = 0; i < m_media.size(); i++)
+        byPath[m_media[i].path].push_back(i);
+    bool changed = false;
+    for (const MediaProbeResult& r : results) {
+        if (!r.ok) continue;
+        auto it = byPath.constFind(r.path);
+        if (it == byPath.constEnd()) continue;
+        for (int index : it.value()) {
+            MediaItem& m = m_media[index];
+            if (!r.isStill && r.durationMs > 0) m.durationMs = r.durationMs;
+            m.isVideo = r.hasVideo;
+            m.isAudio = r.hasAudio && !r.hasVideo;
+            m.width = r.width;
+            m.height = r.height;
+            m.fps = r.fps;
+            m.probed = true;
+            m.videoCodec = r.videoCodec;
+            m.audioCodec = r.audioCodec;
+            m.audioChannels = r.audioChannels;
+            m.audioSampleRate = r.audioSampleRate;
+            m.audioLayout = r.audioLayout;
+            changed = true;
+        }
+    }
+    if (changed) emit mediaListChanged();
+}
+
 int ProjectModel::mediaInterpretFps(const QString& path) const {
     for (const MediaItem& m : m_media) {
         if (m.path == path) return m.interpretFps;
@@ -64,89 +170,115 @@ void ProjectModel::clearMedia() {
 }
 
 void ProjectModel::addTrack(bool isVideo) {
+    const auto& current = tracks();
     Track t;
-    t.name = isVideo ? QString("Video %1").arg(m_tracks.size() + 1) : QString("Audio %1").arg(m_tracks.size() + 1);
+    t.name = isVideo ? QString("Video %1").arg(current.size() + 1) : QString("Audio %1").arg(current.size() + 1);
     t.isVideo = isVideo;
-    m_tracks.append(t);
-    emit tracksChanged();
+    commitTimeline(current.pushBack(t), isVideo ? "Add Video Track" : "Add Audio Track");
 }
 
 void ProjectModel::removeTrack(int index) {
-    if (index < 0 || index >= m_tracks.size()) return;
-    m_tracks.removeAt(index);
-    emit tracksChanged();
+    if (index < 0 || index >= tracks().size()) return;
+    commitTimeline(tracks().erase(index), "Remove Track");
 }
 
 void ProjectModel::addClipToTrack(int trackIndex, const QString& mediaPath, qint64 sourceInMs, qint64 sourceOutMs, qint64 timelineStartMs) {
-    if (trackIndex < 0 || trackIndex >= m_tracks.size()) return;
+    if (trackIndex < 0 || trackIndex >= tracks().size()) return;
     TimelineClip c;
     c.mediaPath = mediaPath;
     c.sourceInMs = sourceInMs;
     c.sourceOutMs = sourceOutMs;
     c.timelineStartMs = timelineStartMs;
     c.trackIndex = trackIndex;
-    m_tracks[trackIndex].clips.append(c);
-    emit tracksChanged();
+    Track t = tracks()[trackIndex];
+    t.clips = t.clips.insert(t.insertionIndex(timelineStartMs), c);
+    commitTimeline(tracks().set(trackIndex, t), "Add Clip");
 }
 
 void ProjectModel::removeClip(int trackIndex, int clipIndex) {
-    if (trackIndex < 0 || trackIndex >= m_tracks.size()) return;
-    auto& clips = m_tracks[trackIndex].clips;
-    if (clipIndex < 0 || clipIndex >= clips.size()) return;
-    clips.removeAt(clipIndex);
-    emit tracksChanged();
+    if (trackIndex < 0 || trackIndex >= tracks().size()) return;
+    Track t = tracks()[trackIndex];
+    if (clipIndex < 0 || clipIndex >= t.clips.size()) return;
+    t.clips = t.clips.erase(clipIndex);
+    commitTimeline(tracks().set(trackIndex, t), "Remove Clip");
 }
 
 void ProjectModel::clearAllClips() {
-    for (Track& t : m_tracks)
-        t.clips.clear();
-    emit tracksChanged();
+    PersistentVector<Track> cleared = tracks();
+    bool changed = false;
+    for (qsizetype i = 0; i < cleared.size(); i++) {
+        if (cleared[i].clips.isEmpty()) continue;
+        Track t = cleared[i];
+        t.clips = ClipList();
+        cleared = cleared.set(i, t);
+        changed = true;
+    }
+    if (changed)
+        commitTimeline(std::move(cleared), "Clear Timeline");
+    else
+        emit tracksChanged();
 }
 
-void ProjectModel::moveClip(int fromTrack, int fromClip, int toTrack, qint64 newStartMs) {
-    if (fromTrack < 0 || fromTrack >= m_tracks.size() || toTrack < 0 || toTrack >= m_tracks.size()) return;
-    auto& src = m_tracks[fromTrack].clips;
-    if (fromClip < 0 || fromClip >= src.size()) return;
-    TimelineClip c = src.takeAt(fromClip);
+int ProjectModel::moveClip(int fromTrack, int fromClip, int toTrack, qint64 newStartMs) {
+    const auto& current = tracks();
+    if (fromTrack < 0 || fromTrack >= current.size() || toTrack < 0 || toTrack >= current.size()) return -1;
+    Track src = current[fromTrack];
+    if (fromClip < 0 || fromClip >= src.clips.size()) return -1;
+    TimelineClip c = src.clips[fromClip];
     c.timelineStartMs = newStartMs;
     c.trackIndex = toTrack;
-    m_tracks[toTrack].clips.append(c);
-    emit tracksChanged();
+    src.clips = src.clips.erase(fromClip);
+    PersistentVector<Track> next = current.set(fromTrack, src);
+    Track dst = next[toTrack];
+    const int index = dst.insertionIndex(newStartMs);
+    dst.clips = dst.clips.insert(index, c);
+    commitTimeline(next.set(toTrack, dst), "Move Clip");
+    return index;
+}
+
+template <typename Edit>
+void ProjectModel::editClip(int trackIndex, int clipIndex, const char* description, std::string coalesceKey, Edit&& edit) {
+    if (trackIndex < 0 || trackIndex >= tracks().size()) return;
+    Track t = tracks()[trackIndex];
+    if (clipIndex < 0 || clipIndex >= t.clips.size()) return;
+    TimelineClip c = t.clips[clipIndex];
+    edit(c);
+    t.clips = t.clips.set(clipIndex, c);
+    commitTimeline(tracks().set(trackIndex, t), description, std::move(coalesceKey));
 }
 
 void ProjectModel::setClipInOut(int trackIndex, int clipIndex, qint64 sourceInMs, qint64 sourceOutMs) {
-    if (trackIndex < 0 || trackIndex >= m_tracks.size()) return;
-    auto& clips = m_tracks[trackIndex].clips;
-    if (clipIndex < 0 || clipIndex >= clips.size()) return;
-    clips[clipIndex].sourceInMs = sourceInMs;
-    clips[clipIndex].sourceOutMs = sourceOutMs;
-    emit tracksChanged();
+    editClip(trackIndex, clipIndex, "Trim Clip", QString("clip-trim:%1:%2").arg(trackIndex).arg(clipIndex).toStdString(),
+             [&](TimelineClip& c) {
+                 c.sourceInMs = sourceInMs;
+                 c.sourceOutMs = sourceOutMs;
+             });
 }
 
-void ProjectModel::setClipStart(int trackIndex, int clipIndex, qint64 timelineStartMs) {
-    if (trackIndex < 0 || trackIndex >= m_tracks.size()) return;
-    auto& clips = m_tracks[trackIndex].clips;
-    if (clipIndex < 0 || clipIndex >= clips.size()) return;
-    clips[clipIndex].timelineStartMs = timelineStartMs;
-    emit tracksChanged();
+int ProjectModel::setClipStart(int trackIndex, int clipIndex, qint64 timelineStartMs) {
+    if (trackIndex < 0 || trackIndex >= tracks().size()) return -1;
+    Track t = tracks()[trackIndex];
+    if (clipIndex < 0 || clipIndex >= t.clips.size()) return -1;
+    TimelineClip c = t.clips[clipIndex];
+    c.timelineStartMs = timelineStartMs;
+    // Re-place it to keep the start order; the index can change mid-drag, so coalesce by track
+    t.clips = t.clips.erase(clipIndex);
+    const int index = t.insertionIndex(timelineStartMs);
+    t.clips = t.clips.insert(index, c);
+    commitTimeline(tracks().set(trackIndex, t), "Move Clip", QString("clip-start:%1").arg(trackIndex).toStdString());
+    return index;
 }
 
 void ProjectModel::setClipSpeedRatio(int trackIndex, int clipIndex, double speedRatio) {
-    if (trackIndex < 0 || trackIndex >= m_tracks.size()) return;
-    auto& clips = m_tracks[trackIndex].clips;
-    if (clipIndex < 0 || clipIndex >= clips.size()) return;
     if (speedRatio < 0.01) speedRatio = 0.01;
     if (speedRatio > 100.0) speedRatio = 100.0;
-    clips[clipIndex].speedRatio = speedRatio;
-    emit tracksChanged();
+    editClip(trackIndex, clipIndex, "Change Clip Speed", std::string(),
+             [&](TimelineClip& c) { c.speedRatio = speedRatio; });
 }
 
 void ProjectModel::setClipScaleToFrame(int trackIndex, int clipIndex, bool scaleToFrame) {
-    if (trackIndex < 0 || trackIndex >= m_tracks.size()) return;
-    auto& clips = m_tracks[trackIndex].clips;
-    if (clipIndex < 0 || clipIndex >= clips.size()) return;
-    clips[clipIndex].scaleToFrame = scaleToFrame;
-    emit tracksChanged();
+    editClip(trackIndex, clipIndex, "Scale Clip to Frame", std::string(),
+             [&](TimelineClip& c) { c.scaleToFrame = scaleToFrame; });
 }
 
 void ProjectModel::setMediaInterpretFpsByPath(const QString& path, int interpretFps) {
@@ -160,28 +292,62 @@ void ProjectModel::setMediaInterpretFpsByPath(const QString& path, int interpret
 }
 
 bool ProjectModel::splitClipAt(int trackIndex, qint64 positionMs, int* outTrackIndex, int* outClipIndex) {
-    if (trackIndex < 0 || trackIndex >= m_tracks.size()) return false;
-    auto& clips = m_tracks[trackIndex].clips;
-    for (int i = 0; i < clips.size(); ++i) {
-        const TimelineClip& c = clips[i];
-        qint64 start = c.timelineStartMs;
-        qint64 end = c.timelineStartMs + (c.sourceOutMs - c.sourceInMs);
-        if (positionMs > start && positionMs < end) {
-            qint64 dur = c.sourceOutMs - c.sourceInMs;
-            qint64 leftDur = positionMs - start;
-            (void)(dur - leftDur);
-            TimelineClip right = c;
-            right.sourceInMs = c.sourceInMs + leftDur;
-            right.timelineStartMs = positionMs;
-            clips[i].sourceOutMs = c.sourceInMs + leftDur;
-            clips.insert(i + 1, right);
-            if (outTrackIndex) *outTrackIndex = trackIndex;
-            if (outClipIndex) *outClipIndex = i + 1;
-            emit tracksChanged();
-            return true;
-        }
+    if (trackIndex < 0 || trackIndex >= tracks().size()) return false;
+    Track t = tracks()[trackIndex];
+    std::vector<int> hits;
+    t.clipsInRange(positionMs, positionMs, hits);
+    for (int i : hits) {
+        const TimelineClip& c = t.clips[i];
+        if (positionMs <= c.timelineStartMs) continue;
+        // Timeline time runs at 1/speedRatio of source time
+        const qint64 sourceSplitMs = c.sourceInMs
+            + static_cast<qint64>((positionMs - c.timelineStartMs) * (c.speedRatio > 0.001 ? c.speedRatio : 1.0));
+        TimelineClip left = c;
+        TimelineClip right = c;
+        left.sourceOutMs = sourceSplitMs;
+        right.sourceInMs = sourceSplitMs;
+        right.timelineStartMs = positionMs;
+        t.clips = t.clips.set(i, left);
+        const int rightIndex = t.insertionIndex(positionMs);
+        t.clips = t.clips.insert(rightIndex, right);
+        commitTimeline(tracks().set(trackIndex, t), "Split Clip");
+        if (outTrackIndex) *outTrackIndex = trackIndex;
+        if (outClipIndex) *outClipIndex = rightIndex;
+        return true;
     }
     return false;
 }
 
+void ProjectModel::restoreSnapshot(TimelineSnapshotPtr snapshot) {
+    if (!snapshot || snapshot == m_timeline) return;
+    m_timeline = std::move(snapshot);
+    m_published.store(m_timeline, std::memory_order_release);
+    emit tracksChanged();
+}
+
+void ProjectModel::resetContents(QVector<MediaItem> media, PersistentVector<Track> tracks) {
+    m_media = std::move(media);
+    auto next = std::make_shared<TimelineSnapshot>();
+    next->tracks = std::move(tracks);
+    next->revision = m_nextRevision++;
+    m_timeline = std::move(next);
+    m_published.store(m_timeline, std::memory_order_release);
+    emit mediaListChanged();
+    emit tracksChanged();
+}
+
+void ProjectModel::commitTimeline(PersistentVector<Track> tracks, const char* description, std::string coalesceKey) {
+    auto next = std::make_shared<TimelineSnapshot>();
+    next->tracks = std::move(tracks);
+    next->revision = m_nextRevision++;
+    TimelineSnapshotPtr previous = std::move(m_timeline);
+    m_timeline = std::move(next);
+    m_published.store(m_timeline, std::memory_order_release);
+    if (m_undoEnabled) {
+        UndoRedoManager::getInstance().pushAction(
+            std::make_unique<SnapshotAction>(*this, description, std::move(coalesceKey), std::move(previous), m_timeline));
+    }
+    emit tracksChanged();
+}
+
 } // namespace aether
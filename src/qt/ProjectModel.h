@@ -3,9 +3,19 @@
 #include <QObject>
 #include <QString>
 #include <QVector>
+#include "aether/PersistentVector.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace aether {
 
+struct MediaProbeResult;
+
 struct MediaItem {
     QString path;
     QString name;
@@ -16,6 +26,13 @@ struct MediaItem {
     int height = 0;
     int fps = 0;
     int interpretFps = 0;
+    // Filled in by MediaProbeService
+    bool probed = false;
+    QString videoCodec;
+    QString audioCodec;
+    int audioChannels = 0;
+    int audioSampleRate = 0;
+    QString audioLayout;
 };
 
 struct TimelineClip {
@@ -26,26 +43,83 @@ struct TimelineClip {
     int trackIndex = 0;
     double speedRatio = 1.0;
     bool scaleToFrame = false;
+
+    /** Timeline time just past the clip's last frame. */
+    qint64 timelineEndMs() const {
+        const qint64 span = speedRatio > 0.001 ? static_cast<qint64>((sourceOutMs - sourceInMs) / speedRatio)
+                                               : (sourceOutMs - sourceInMs);
+        return timelineStartMs + span;
+    }
 };
 
+/** Latest start and end among a run of clips; every node of a track's clip tree keeps one. */
+struct ClipSpan {
+    qint64 maxStartMs = std::numeric_limits<qint64>::min();
+    qint64 maxEndMs = std::numeric_limits<qint64>::min();
+
+    static ClipSpan of(const TimelineClip& c) { return {c.timelineStartMs, c.timelineEndMs()}; }
+    static ClipSpan combine(const ClipSpan& a, const ClipSpan& b) {
+        return {std::max(a.maxStartMs, b.maxStartMs), std::max(a.maxEndMs, b.maxEndMs)};
+    }
+};
+
+using ClipList = PersistentVector<TimelineClip, ClipSpan>;
+
+/**
+ * Clips are kept ordered by timelineStartMs (ProjectModel inserts each edit
+ * at its place), so with the spans in the tree the time queries below are a
+ * descent of O(log n) rather than a scan of the track.
+ */
 struct Track {
     QString name;
     bool isVideo = true;
-    QVector<TimelineClip> clips;
+    ClipList clips;
+
+    qint64 endMs() const { return clips.isEmpty() ? 0 : clips.summary().maxEndMs; }
+    /** First clip covering timeMs, or -1. */
+    int clipAt(qint64 timeMs) const;
+    /** Clips overlapping [fromMs, toMs], in start order; O(log n + k) when clips do not overlap. */
+    void clipsInRange(qint64 fromMs, qint64 toMs, std::vector<int>& out) const;
+    /** Where a clip starting at startMs goes to keep the order: after clips with the same start. */
+    int insertionIndex(qint64 startMs) const;
+    /** True if [startMs, endMs) overlaps any clip other than `ignore`. */
+    bool overlaps(qint64 startMs, qint64 endMs, int ignore = -1) const;
 };
 
+/**
+ * One immutable version of the timeline. Versions share every track and clip
+ * node an edit did not touch, so each edit costs O(log n) and any number of
+ * versions can be held at once: the undo history keeps old ones, and background
+ * threads (render, autosave) read a consistent timeline without locking.
+ */
+struct TimelineSnapshot {
+    PersistentVector<Track> tracks;
+    uint64_t revision = 0; // distinct for every edit; undo returns to an older revision
+};
+
+using TimelineSnapshotPtr = std::shared_ptr<const TimelineSnapshot>;
+
 class ProjectModel : public QObject {
     Q_OBJECT
 public:
     explicit ProjectModel(QObject* parent = nullptr);
 
     const QVector<MediaItem>& media() const { return m_media; }
-    const QVector<Track>& tracks() const { return m_tracks; }
+    /** GUI thread; the reference is valid until the next timeline edit. */
+    const PersistentVector<Track>& tracks() const { return m_timeline->tracks; }
+    /** Current timeline version; safe to call from any thread. */
+    TimelineSnapshotPtr snapshot() const { return m_published.load(std::memory_order_acquire); }
+    /** Makes snapshot the current timeline (undo/redo, loading). GUI thread. */
+    void restoreSnapshot(TimelineSnapshotPtr snapshot);
+    /** Replaces media and timeline wholesale (project load); not recorded for undo. */
+    void resetContents(QVector<MediaItem> media, PersistentVector<Track> tracks);
     qint64 sequenceDurationMs() const;
 
     int addMedia(const QString& path, const QString& name, qint64 durationMs, bool isVideo, bool isAudio);
     void setMediaMetadata(int mediaIndex, int width, int height, int fps);
     void setMediaMetadataByPath(const QString& path, int width, int height, int fps);
+    /** Copies probe results onto the media items with matching paths; one mediaListChanged for the batch. */
+    void applyProbeResults(const std::vector<MediaProbeResult>& results);
     int mediaInterpretFps(const QString& path) const;
     void clearMedia();
     void addTrack(bool isVideo = true);
@@ -53,21 +127,36 @@ public:
     void addClipToTrack(int trackIndex, const QString& mediaPath, qint64 sourceInMs, qint64 sourceOutMs, qint64 timelineStartMs);
     void removeClip(int trackIndex, int clipIndex);
     void clearAllClips();
-    void moveClip(int fromTrack, int fromClip, int toTrack, qint64 newStartMs);
+    /** Returns the clip's index on toTrack, or -1. */
+    int moveClip(int fromTrack, int fromClip, int toTrack, qint64 newStartMs);
     void setClipInOut(int trackIndex, int clipIndex, qint64 sourceInMs, qint64 sourceOutMs);
-    void setClipStart(int trackIndex, int clipIndex, qint64 timelineStartMs);
+    /** Clips stay ordered by start, so this returns the clip's new index, or -1. */
+    int setClipStart(int trackIndex, int clipIndex, qint64 timelineStartMs);
     void setClipSpeedRatio(int trackIndex, int clipIndex, double speedRatio);
     void setClipScaleToFrame(int trackIndex, int clipIndex, bool scaleToFrame);
     void setMediaInterpretFpsByPath(const QString& path, int interpretFps);
     bool splitClipAt(int trackIndex, qint64 positionMs, int* outTrackIndex, int* outClipIndex);
 
+    /** Track and clip edits are pushed to UndoRedoManager while enabled (off by default). */
+    void setUndoEnabled(bool enabled) { m_undoEnabled = enabled; }
+
 signals:
     void mediaListChanged();
     void tracksChanged();
 
 private:
+    class SnapshotAction;
+
+    void commitTimeline(PersistentVector<Track> tracks, const char* description,
+                        std::string coalesceKey = std::string());
+    template <typename Edit>
+    void editClip(int trackIndex, int clipIndex, const char* description, std::string coalesceKey, Edit&& edit);
+
     QVector<MediaItem> m_media;
-    QVector<Track> m_tracks;
+    TimelineSnapshotPtr m_timeline;                // GUI thread's current version
+    std::atomic<TimelineSnapshotPtr> m_published;  // same version, for other threads
+    uint64_t m_nextRevision = 1;
+    bool m_undoEnabled = false;
 };
 
 } // namespace aether
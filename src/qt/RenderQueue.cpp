@@ -0,0 +1,475 @@
+#include "aether/RenderQueue.h"
+#include "aether/KeyframeModel.h"
+#include "aether/MemoryManager.h"
+#include "aether/NodeGraphModel.h"
+#include "ProjectModel.h"
+#include <QDir>
+#include <QFile>
+#include <QSettings>
+#include <algorithm>
+#include <chrono>
+
+namespace aether {
+
+namespace {
+
+const char* statusName(RenderJobStatus status) {
+    switch (status) {
+    case RenderJobStatus::Queued: return "queued";
+    case RenderJobStatus::Rendering: return "rendering";
+    case RenderJobStatus::Done: return "done";
+    case RenderJobStatus::Failed: return "failed";
+    case RenderJobStatus::Cancelled: return "cancelled";
+    }
+    return "queued";
+}
+
+RenderJobStatus statusFromName(const QString& name) {
+    for (RenderJobStatus status : { RenderJobStatus::Rendering, RenderJobStatus::Done, RenderJobStatus::Failed,
+                                    RenderJobStatus::Cancelled }) {
+        if (name == QLatin1String(statusName(status))) return status;
+    }
+    return RenderJobStatus::Queued;
+}
+
+int64_t finishedFrames(const std::vector<ExportChunk>& chunks) {
+    int64_t frames = 0;
+    for (const ExportChunk& chunk : chunks) {
+        if (chunk.done) frames += chunk.frameCount;
+    }
+    return frames;
+}
+
+} // namespace
+
+struct RenderQueue::Job {
+    RenderJobInfo info;
+    ExportRequest request;
+    uint64_t sequence = 0;   // order the job was added in
+    int64_t chunkFrames = 0; // fixed by the first run, so later runs find its chunks
+    std::unique_ptr<ChunkedExport> exporter;
+    bool stopping = false;   // cancelled by the queue; the export has not reported back yet
+    RenderJobStatus stopAs = RenderJobStatus::Queued;
+
+    QString filePath(const QString& directory, const QString& name) const {
+        return QDir(directory).filePath(info.id + QLatin1Char('/') + name);
+    }
+
+    /** The chunks of the job's first run, marked done where their files exist; empty before it. */
+    std::vector<ExportChunk> chunks(const QString& directory) const {
+        if (chunkFrames <= 0) return {};
+        std::vector<ExportChunk> planned = ChunkedExport::planChunks(
+            info.totalFrames, request.params, 1, 0.0, filePath(directory, QStringLiteral("chunks")).toStdString(), chunkFrames);
+        for (ExportChunk& chunk : planned) chunk.done = QFile::exists(QString::fromStdString(chunk.path));
+        return planned;
+    }
+};
+
+RenderQueue::RenderQueue(const QString& directory, ChangedCallback onChanged, BackendFactory backendFactory)
+    : m_directory(directory), m_onChanged(std::move(onChanged)), m_backendFactory(std::move(backendFactory)) {
+    load();
+    m_thread = std::thread([this]() { schedulerLoop(); });
+}
+
+RenderQueue::~RenderQueue() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_condition.notify_all();
+    }
+    if (m_thread.joinable()) m_thread.join();
+
+    // Stop every export before waiting for any; their job files still say rendering, so they resume next time
+    std::vector<std::unique_ptr<Job>> jobs;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& job : m_jobs) {
+            if (job->exporter) job->exporter->cancel();
+        }
+        jobs.swap(m_jobs);
+    }
+    jobs.clear();
+}
+
+void RenderQueue::load() {
+    const QDir dir(m_directory);
+    bool interrupted = false;
+    for (const QString& id : dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name)) {
+        auto job = std::make_unique<Job>();
+        job->info.id = id;
+        const QString iniPath = job->filePath(m_directory, QStringLiteral("job.ini"));
+        if (!QFile::exists(iniPath)) continue;
+
+        QSettings ini(iniPath, QSettings::IniFormat);
+        job->sequence = ini.value(QStringLiteral("sequence")).toULongLong();
+        job->chunkFrames = ini.value(QStringLiteral("chunkFrames")).toLongLong();
+        job->info.name = ini.value(QStringLiteral("name")).toString();
+        job->info.priority = ini.value(QStringLiteral("priority")).toInt();
+        job->info.status = statusFromName(ini.value(QStringLiteral("status")).toString());
+        job->info.framesDone = ini.value(QStringLiteral("framesDone")).toLongLong();
+        job->info.error = ini.value(QStringLiteral("error")).toString().toStdString();
+        job->request.startMs = ini.value(QStringLiteral("startMs")).toLongLong();
+        job->request.endMs = ini.value(QStringLiteral("endMs"), -1).toLongLong();
+        job->request.frameCount = ini.value(QStringLiteral("frameCount"), -1).toLongLong();
+        job->request.smartRender = ini.value(QStringLiteral("smartRender"), true).toBool();
+
+        EncodeParams& params = job->request.params;
+        ini.beginGroup(QStringLiteral("Encode"));
+        params.outputPath = ini.value(QStringLiteral("outputPath")).toString().toStdString();
+        params.width = ini.value(QStringLiteral("width")).toUInt();
+        params.height = ini.value(QStringLiteral("height")).toUInt();
+        params.fps = ini.value(QStringLiteral("fps")).toDouble();
+        params.bitrateKbps = ini.value(QStringLiteral("bitrateKbps")).toUInt();
+        params.maxBitrateKbps = ini.value(QStringLiteral("maxBitrateKbps")).toUInt();
+        params.bufferSizeKbits = ini.value(QStringLiteral("bufferSizeKbits")).toUInt();
+        params.codec = ini.value(QStringLiteral("codec")).toString().toStdString();
+        params.gopSize = ini.value(QStringLiteral("gopSize")).toUInt();
+        ini.endGroup();
+        job->info.params = params;
+
+        ProjectModel model;
+        NodeGraphModel nodeGraph;
+        KeyframeModel keyframes;
+        QString projectName, saveLocation, loadError;
+        ProjectSettings settings;
+        if (ProjectFile::loadProject(job->filePath(m_directory, QStringLiteral("project.aeth")), model, &nodeGraph,
+                                     &keyframes, &projectName, &saveLocation, &settings, &loadError)) {
+            job->request.project = ProjectFile::capture(model, &nodeGraph, &keyframes, projectName, saveLocation, settings);
+            job->info.totalFrames = ExportEngine::frameCount(job->request);
+        } else if (job->info.status != RenderJobStatus::Done) {
+            job->info.status = RenderJobStatus::Failed;
+            job->info.error = "Could not read the job's project: " + loadError.toStdString();
+        }
+
+        if (job->info.status == RenderJobStatus::Rendering) {
+            job->info.status = RenderJobStatus::Queued;
+            job->info.framesDone = finishedFrames(job->chunks(m_directory));
+            interrupted = true;
+        }
+        m_nextSequence = std::max(m_nextSequence, job->sequence + 1);
+        m_jobs.push_back(std::move(job));
+    }
+    m_paused = !interrupted;
+}
+
+bool RenderQueue::saveJob(const Job& job) const {
+    QSettings ini(job.filePath(m_directory, QStringLiteral("job.ini")), QSettings::IniFormat);
+    ini.setValue(QStringLiteral("sequence"), static_cast<qulonglong>(job.sequence));
+    ini.setValue(QStringLiteral("chunkFrames"), static_cast<qlonglong>(job.chunkFrames));
+    ini.setValue(QStringLiteral("name"), job.info.name);
+    ini.setValue(QStringLiteral("priority"), job.info.priority);
+    ini.setValue(QStringLiteral("status"), QString::fromLatin1(statusName(job.info.status)));
+    ini.setValue(QStringLiteral("framesDone"), static_cast<qlonglong>(job.info.framesDone));
+    ini.setValue(QStringLiteral("error"), QString::fromStdString(job.info.error));
+    ini.setValue(QStringLiteral("startMs"), static_cast<qlonglong>(job.request.startMs));
+    ini.setValue(QStringLiteral("endMs"), static_cast<qlonglong>(job.request.endMs));
+    ini.setValue(QStringLiteral("frameCount"), static_cast<qlonglong>(job.request.frameCount));
+    ini.setValue(QStringLiteral("smartRender"), job.request.smartRender);
+
+    const EncodeParams& params = job.request.params;
+    ini.beginGroup(QStringLiteral("Encode"));
+    ini.setValue(QStringLiteral("outputPath"), QString::fromStdString(params.outputPath));
+    ini.setValue(QStringLiteral("width"), params.width);
+    ini.setValue(QStringLiteral("height"), params.height);
+    ini.setValue(QStringLiteral("fps"), params.fps);
+    ini.setValue(QStringLiteral("bitrateKbps"), params.bitrateKbps);
+    ini.setValue(QStringLiteral("maxBitrateKbps"), params.maxBitrateKbps);
+    ini.setValue(QStringLiteral("bufferSizeKbits"), params.bufferSizeKbits);
+    ini.setValue(QStringLiteral("codec"), QString::fromStdString(params.codec));
+    ini.setValue(QStringLiteral("gopSize"), params.gopSize);
+    ini.endGroup();
+    ini.sync();
+    return ini.status() == QSettings::NoError;
+}
+
+QString RenderQueue::submit(const ExportRequest& request, const QString& name, int priority, std::string* error) {
+    auto job = std::make_unique<Job>();
+    job->request = request;
+    job->request.params.encoderThreads = 0; // chosen by the scheduler for each run
+    job->info.name = name;
+    job->info.priority = priority;
+    job->info.params = job->request.params;
+    job->info.totalFrames = ExportEngine::frameCount(request);
+    if (job->info.totalFrames <= 0 || request.params.fps <= 0.0) {
+        if (error) *error = "Nothing to export";
+        return QString();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        job->sequence = m_nextSequence++;
+    }
+    job->info.id = QStringLiteral("job_%1").arg(static_cast<qulonglong>(job->sequence), 6, 10, QChar('0'));
+
+    if (!QDir(m_directory).mkpath(job->info.id)) {
+        if (error) *error = "Could not create the job directory in " + m_directory.toStdString();
+        return QString();
+    }
+    ProjectWriter writer;
+    if (!writer.save(job->filePath(m_directory, QStringLiteral("project.aeth")), request.project) || !saveJob(*job)) {
+        if (error) *error = writer.getLastError().isEmpty() ? "Could not save the job" : writer.getLastError().toStdString();
+        QDir(job->filePath(m_directory, QString())).removeRecursively();
+        return QString();
+    }
+
+    const QString id = job->info.id;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_jobs.push_back(std::move(job));
+    m_dirty = true;
+    m_condition.notify_all();
+    return id;
+}
+
+void RenderQueue::setPriority(const QString& id, int priority) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& job : m_jobs) {
+        if (job->info.id != id || job->info.priority == priority) continue;
+        job->info.priority = priority;
+        saveJob(*job);
+        m_dirty = true;
+        m_condition.notify_all();
+    }
+}
+
+void RenderQueue::cancel(const QString& id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& job : m_jobs) {
+        if (job->info.id != id) continue;
+        if (job->exporter) {
+            job->stopping = true;
+            job->stopAs = RenderJobStatus::Cancelled;
+            job->exporter->cancel();
+        } else if (job->info.status == RenderJobStatus::Queued) {
+            job->info.status = RenderJobStatus::Cancelled;
+            saveJob(*job);
+        }
+        m_dirty = true;
+        m_condition.notify_all();
+    }
+}
+
+void RenderQueue::requeue(const QString& id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& job : m_jobs) {
+        if (job->info.id != id || job->exporter || job->request.project.timeline == nullptr) continue;
+        if (job->info.status != RenderJobStatus::Cancelled && job->info.status != RenderJobStatus::Failed) continue;
+        job->info.status = RenderJobStatus::Queued;
+        job->info.error.clear();
+        saveJob(*job);
+        m_dirty = true;
+        m_condition.notify_all();
+    }
+}
+
+void RenderQueue::remove(const QString& id) {
+    std::unique_ptr<Job> removed;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = std::find_if(m_jobs.begin(), m_jobs.end(), [&](const auto& job) { return job->info.id == id; });
+        if (it == m_jobs.end()) return;
+        removed = std::move(*it);
+        m_jobs.erase(it);
+        m_dirty = true;
+        m_condition.notify_all();
+    }
+    // The export's callback takes m_mutex, so it is stopped and joined outside it
+    removed->exporter.reset();
+    QDir(removed->filePath(m_directory, QString())).removeRecursively();
+}
+
+void RenderQueue::setPaused(bool paused) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_paused == paused) return;
+    m_paused = paused;
+    m_dirty = true;
+    m_condition.notify_all();
+}
+
+bool RenderQueue::isPaused() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_paused;
+}
+
+std::vector<RenderJobInfo> RenderQueue::getJobs() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<RenderJobInfo> jobs;
+    for (const Job* job : renderOrder()) jobs.push_back(job->info);
+    return jobs;
+}
+
+std::vector<RenderQueue::Job*> RenderQueue::renderOrder() const {
+    std::vector<Job*> order;
+    for (const auto& job : m_jobs) order.push_back(job.get());
+    std::sort(order.begin(), order.end(), [](const Job* a, const Job* b) {
+        if (a->info.priority != b->info.priority) return a->info.priority > b->info.priority;
+        return a->sequence < b->sequence;
+    });
+    return order;
+}
+
+RenderBudget RenderQueue::currentBudget() {
+    RenderBudget budget;
+    budget.cores = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t totalBytes = 0;
+    if (!querySystemMemory(totalBytes, budget.availableBytes)) budget.availableBytes = UINT64_MAX;
+    return budget;
+}
+
+uint64_t RenderQueue::engineMemory(const EncodeParams& params, uint32_t queueDepth) {
+    const uint64_t pixels = static_cast<uint64_t>(params.width) * params.height;
+    // RGBA frames fill the two queues before conversion plus one in each stage; YUV
+    // frames fill the encoder's queue, its lookahead and references, and the decoder's pool
+    constexpr uint64_t kFramesInStages = 4;
+    constexpr uint64_t kEncoderFrames = 64;
+    constexpr uint64_t kDecoderFrames = 16;
+    return pixels * 4 * (2 * queueDepth + kFramesInStages) + pixels * 3 / 2 * (queueDepth + kEncoderFrames + kDecoderFrames);
+}
+
+void RenderQueue::schedulerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping) {
+        collectFinished(lock);
+        schedule();
+        bool changed = m_dirty;
+        for (const auto& job : m_jobs) {
+            if (!job->exporter) continue;
+            updateProgress(*job);
+            changed = true;
+        }
+        m_dirty = false;
+        if (changed && m_onChanged) {
+            lock.unlock();
+            m_onChanged();
+            lock.lock();
+        }
+        m_condition.wait_for(lock, std::chrono::seconds(1), [this]() { return m_stopping || m_dirty; });
+    }
+}
+
+void RenderQueue::collectFinished(std::unique_lock<std::mutex>& lock) {
+    // Not running any more means the controller thread is at its callback, which takes m_mutex;
+    // the exports are taken from their jobs and joined outside it
+    std::vector<std::pair<QString, std::unique_ptr<ChunkedExport>>> finished;
+    for (const auto& job : m_jobs) {
+        if (job->exporter && !job->exporter->isRunning()) finished.emplace_back(job->info.id, std::move(job->exporter));
+    }
+    if (finished.empty()) return;
+    lock.unlock();
+    for (auto& [id, exporter] : finished) exporter->wait();
+    lock.lock();
+
+    for (auto& [id, exporter] : finished) {
+        auto it = std::find_if(m_jobs.begin(), m_jobs.end(), [&](const auto& job) { return job->info.id == id; });
+        if (it == m_jobs.end()) continue; // removed meanwhile
+        Job& job = **it;
+        const ExportStats stats = exporter->getStats();
+        RenderJobInfo& info = job.info;
+        if (stats.ok) {
+            info.status = RenderJobStatus::Done;
+            info.framesDone = info.totalFrames;
+        } else {
+            info.status = job.stopping ? job.stopAs : RenderJobStatus::Failed;
+            info.error = job.stopping ? std::string() : stats.error;
+            info.framesDone = finishedFrames(exporter->getChunks());
+        }
+        info.fps = 0.0;
+        info.etaSeconds = -1.0;
+        info.workers = 0;
+        job.stopping = false;
+        saveJob(job);
+        m_dirty = true;
+    }
+}
+
+void RenderQueue::schedule() {
+    const std::vector<Job*> order = renderOrder();
+    if (m_paused || std::none_of(order.begin(), order.end(), [](const Job* job) {
+            return job->info.status == RenderJobStatus::Queued;
+        }))
+        return;
+
+    const RenderBudget budget = currentBudget();
+    // The engine count a single chunked export would pick, shared out between the jobs
+    const uint32_t maxEngines = std::clamp(budget.cores / 4, 1u, 8u);
+    const uint32_t encoderThreads = std::max(1u, budget.cores / maxEngines);
+    uint32_t engines = 0;
+    for (const Job* job : order) engines += job->info.workers;
+    // Running jobs already show in the free memory; leave a quarter of it to everything else
+    uint64_t freeBytes = budget.availableBytes / 4 * 3;
+
+    for (Job* job : order) {
+        if (job->info.status != RenderJobStatus::Queued) continue;
+        if (engines >= maxEngines) {
+            // A job waiting for engines takes them from the lowest running job below it
+            for (auto it = order.rbegin(); it != order.rend(); ++it) {
+                Job* other = *it;
+                if (other->info.priority >= job->info.priority) break;
+                if (!other->exporter || other->stopping) continue;
+                other->stopping = true;
+                other->stopAs = RenderJobStatus::Queued;
+                other->exporter->cancel();
+                break;
+            }
+            break;
+        }
+
+        const uint64_t perEngine = std::max<uint64_t>(1, engineMemory(job->request.params, job->request.queueDepth));
+        uint64_t byMemory = freeBytes / perEngine;
+        if (byMemory == 0) {
+            if (engines > 0) break;
+            byMemory = 1; // one engine always runs, however large the job
+        }
+        // A resumed job has no use for more engines than it has chunks left
+        uint64_t remaining = maxEngines;
+        if (job->chunkFrames > 0) {
+            const std::vector<ExportChunk> chunks = job->chunks(m_directory);
+            remaining = std::count_if(chunks.begin(), chunks.end(), [](const ExportChunk& chunk) { return !chunk.done; });
+        }
+        const uint32_t count = static_cast<uint32_t>(
+            std::max<uint64_t>(1, std::min<uint64_t>({ maxEngines - engines, byMemory, remaining })));
+        if (!startJob(*job, count, encoderThreads)) continue;
+        engines += count;
+        freeBytes -= std::min(freeBytes, perEngine * count);
+    }
+}
+
+bool RenderQueue::startJob(Job& job, uint32_t engines, uint32_t encoderThreads) {
+    auto exporter = std::make_unique<ChunkedExport>();
+    exporter->setBackendFactory(m_backendFactory);
+    exporter->setChunkFrames(job.chunkFrames);
+    ExportRequest request = job.request;
+    request.params.encoderThreads = encoderThreads;
+    // The callback only wakes the scheduler, which collects the job on its own thread
+    const bool started = exporter->start(request, job.filePath(m_directory, QStringLiteral("chunks")).toStdString(),
+                                         engines, [this](const ExportStats&) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_dirty = true;
+        m_condition.notify_all();
+    });
+    m_dirty = true;
+    if (!started) {
+        job.info.status = RenderJobStatus::Failed;
+        job.info.error = exporter->getLastError();
+        saveJob(job);
+        return false;
+    }
+    if (job.chunkFrames == 0) {
+        const std::vector<ExportChunk> chunks = exporter->getChunks();
+        if (!chunks.empty()) job.chunkFrames = chunks.front().frameCount;
+    }
+    job.exporter = std::move(exporter);
+    job.info.status = RenderJobStatus::Rendering;
+    job.info.workers = engines;
+    job.info.error.clear();
+    saveJob(job);
+    return true;
+}
+
+void RenderQueue::updateProgress(Job& job) const {
+    const ExportStats stats = job.exporter->getStats();
+    job.info.framesDone = stats.framesDone;
+    job.info.totalFrames = stats.totalFrames;
+    job.info.fps = stats.fps;
+    job.info.etaSeconds = stats.fps > 0.0 ? (stats.totalFrames - stats.framesDone) / stats.fps : -1.0;
+}
+
+} // namespace aether
@@ -1,24 +1,154 @@
 #include "RenderQueueWidget.h"
+#include "aether/RenderQueue.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QLabel>
 #include <QTableWidget>
 #include <QPushButton>
+#include <QHeaderView>
+#include <QFileInfo>
 
 namespace aether {
 
-RenderQueueWidget::RenderQueueWidget(QWidget* parent) : QWidget(parent) {
+namespace {
+
+enum Column { NameColumn, StatusColumn, OutputColumn, CodecColumn, PriorityColumn, ProgressColumn, SpeedColumn, EtaColumn, ColumnCount };
+
+QString statusText(const RenderJobInfo& job) {
+    switch (job.status) {
+    case RenderJobStatus::Queued: return RenderQueueWidget::tr("Queued");
+    case RenderJobStatus::Rendering: return RenderQueueWidget::tr("Rendering (%1 workers)").arg(job.workers);
+    case RenderJobStatus::Done: return RenderQueueWidget::tr("Done");
+    case RenderJobStatus::Failed: return RenderQueueWidget::tr("Failed");
+    case RenderJobStatus::Cancelled: return RenderQueueWidget::tr("Cancelled");
+    }
+    return QString();
+}
+
+QString etaText(double seconds) {
+    if (seconds < 0.0) return QString();
+    const qint64 total = static_cast<qint64>(seconds + 0.5);
+    return QStringLiteral("%1:%2").arg(total / 60).arg(total % 60, 2, 10, QLatin1Char('0'));
+}
+
+} // namespace
+
+RenderQueueWidget::RenderQueueWidget(RenderQueue* queue, QWidget* parent) : QWidget(parent), m_queue(queue) {
     QVBoxLayout* layout = new QVBoxLayout(this);
     layout->addWidget(new QLabel(tr("Render Queue"), this));
-    QTableWidget* table = new QTableWidget(0, 5, this);
-    table->setHorizontalHeaderLabels({ tr("Name"), tr("Status"), tr("Output"), tr("Codec"), tr("Progress") });
-    layout->addWidget(table, 1);
+    m_table = new QTableWidget(0, ColumnCount, this);
+    m_table->setHorizontalHeaderLabels({ tr("Name"), tr("Status"), tr("Output"), tr("Codec"), tr("Priority"),
+                                         tr("Progress"), tr("Speed"), tr("Remaining") });
+    m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_table->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->horizontalHeader()->setSectionResizeMode(OutputColumn, QHeaderView::Stretch);
+    layout->addWidget(m_table, 1);
+
     QPushButton* addBtn = new QPushButton(tr("Add"), this);
-    QPushButton* renderBtn = new QPushButton(tr("Render All"), this);
+    QPushButton* raiseBtn = new QPushButton(tr("Raise"), this);
+    QPushButton* lowerBtn = new QPushButton(tr("Lower"), this);
+    QPushButton* cancelBtn = new QPushButton(tr("Cancel"), this);
+    QPushButton* retryBtn = new QPushButton(tr("Retry"), this);
+    QPushButton* removeBtn = new QPushButton(tr("Remove"), this);
+    m_renderButton = new QPushButton(tr("Render All"), this);
+    connect(addBtn, &QPushButton::clicked, this, &RenderQueueWidget::addRequested);
+    connect(raiseBtn, &QPushButton::clicked, this, &RenderQueueWidget::onRaise);
+    connect(lowerBtn, &QPushButton::clicked, this, &RenderQueueWidget::onLower);
+    connect(cancelBtn, &QPushButton::clicked, this, &RenderQueueWidget::onCancel);
+    connect(retryBtn, &QPushButton::clicked, this, &RenderQueueWidget::onRetry);
+    connect(removeBtn, &QPushButton::clicked, this, &RenderQueueWidget::onRemove);
+    connect(m_renderButton, &QPushButton::clicked, this, &RenderQueueWidget::onRenderAll);
     QHBoxLayout* btnLayout = new QHBoxLayout();
     btnLayout->addWidget(addBtn);
-    btnLayout->addWidget(renderBtn);
+    btnLayout->addWidget(raiseBtn);
+    btnLayout->addWidget(lowerBtn);
+    btnLayout->addWidget(cancelBtn);
+    btnLayout->addWidget(retryBtn);
+    btnLayout->addWidget(removeBtn);
+    btnLayout->addStretch(1);
+    btnLayout->addWidget(m_renderButton);
     layout->addLayout(btnLayout);
+
+    refresh();
+}
+
+void RenderQueueWidget::refresh() {
+    if (!m_queue) return;
+    const QString selected = selectedJob();
+    const std::vector<RenderJobInfo> jobs = m_queue->getJobs();
+    m_table->setRowCount(static_cast<int>(jobs.size()));
+    for (int row = 0; row < static_cast<int>(jobs.size()); row++) {
+        const RenderJobInfo& job = jobs[row];
+        const int percent = job.totalFrames > 0 ? static_cast<int>(job.framesDone * 100 / job.totalFrames) : 0;
+        const QString codec = job.params.codec.empty() ? QFileInfo(QString::fromStdString(job.params.outputPath)).suffix()
+                                                        : QString::fromStdString(job.params.codec);
+        const QString texts[ColumnCount] = {
+            job.name,
+            statusText(job),
+            QString::fromStdString(job.params.outputPath),
+            codec,
+            QString::number(job.priority),
+            tr("%1% (%2 / %3)").arg(percent).arg(job.framesDone).arg(job.totalFrames),
+            job.status == RenderJobStatus::Rendering ? tr("%1 fps").arg(job.fps, 0, 'f', 1) : QString(),
+            job.status == RenderJobStatus::Rendering ? etaText(job.etaSeconds) : QString(),
+        };
+        for (int column = 0; column < ColumnCount; column++) {
+            QTableWidgetItem* item = m_table->item(row, column);
+            if (!item) {
+                item = new QTableWidgetItem;
+                m_table->setItem(row, column, item);
+            }
+            item->setText(texts[column]);
+        }
+        m_table->item(row, NameColumn)->setData(Qt::UserRole, job.id);
+        m_table->item(row, StatusColumn)->setToolTip(QString::fromStdString(job.error));
+        if (job.id == selected) m_table->selectRow(row);
+    }
+    m_renderButton->setText(m_queue->isPaused() ? tr("Render All") : tr("Pause"));
+}
+
+QString RenderQueueWidget::selectedJob() const {
+    const int row = m_table->currentRow();
+    if (row < 0 || !m_table->item(row, NameColumn)) return QString();
+    return m_table->item(row, NameColumn)->data(Qt::UserRole).toString();
+}
+
+void RenderQueueWidget::changePriority(int delta) {
+    const QString id = selectedJob();
+    if (!m_queue || id.isEmpty()) return;
+    for (const RenderJobInfo& job : m_queue->getJobs()) {
+        if (job.id == id) m_queue->setPriority(id, job.priority + delta);
+    }
+    refresh();
+}
+
+void RenderQueueWidget::onRenderAll() {
+    if (!m_queue) return;
+    m_queue->setPaused(!m_queue->isPaused());
+    refresh();
+}
+
+void RenderQueueWidget::onRaise() {
+    changePriority(1);
+}
+
+void RenderQueueWidget::onLower() {
+    changePriority(-1);
+}
+
+void RenderQueueWidget::onCancel() {
+    if (m_queue && !selectedJob().isEmpty()) m_queue->cancel(selectedJob());
+}
+
+void RenderQueueWidget::onRetry() {
+    if (m_queue && !selectedJob().isEmpty()) m_queue->requeue(selectedJob());
+}
+
+void RenderQueueWidget::onRemove() {
+    if (!m_queue || selectedJob().isEmpty()) return;
+    m_queue->remove(selectedJob());
+    refresh();
 }
 
 } // namespace aether
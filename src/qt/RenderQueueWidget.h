@@ -2,11 +2,39 @@
 
 #include <QWidget>
 
+class QPushButton;
+class QTableWidget;
+
 namespace aether {
 
+class RenderQueue;
+
 class RenderQueueWidget : public QWidget {
+    Q_OBJECT
 public:
-    explicit RenderQueueWidget(QWidget* parent = nullptr);
+    explicit RenderQueueWidget(RenderQueue* queue, QWidget* parent = nullptr);
+
+    /** Rereads the jobs; call when the queue reports a change. */
+    void refresh();
+
+signals:
+    void addRequested();
+
+private slots:
+    void onRenderAll();
+    void onRaise();
+    void onLower();
+    void onCancel();
+    void onRetry();
+    void onRemove();
+
+private:
+    QString selectedJob() const;
+    void changePriority(int delta);
+
+    RenderQueue* m_queue = nullptr;
+    QTableWidget* m_table = nullptr;
+    QPushButton* m_renderButton = nullptr;
 };
 
 } // namespace aether
@@ -0,0 +1,422 @@
+#include "aether/ThumbnailCache.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QImageWriter>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#ifdef AETHER_FFMPEG_ENABLED
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/avutil.h>
+#include <libswscale/swscale.h>
+}
+#endif
+
+namespace aether {
+
+namespace {
+
+constexpr qint64 kDiskBudgetBytes = 512LL * 1024 * 1024;
+constexpr int kStalePasses = 2;
+// A failed atlas is not retried on every paint, but is once the file may have changed (still being copied, say)
+constexpr auto kFailedRetryInterval = std::chrono::seconds(30);
+// What a failed entry counts against the memory budget
+constexpr size_t kFailedEntryBytes = 1024;
+// A .tmp this old is left over from a save that never finished
+constexpr qint64 kStaleTempSecs = 10 * 60;
+const char* const kAtlasTextKey = "AetherThumbs";
+
+} // namespace
+
+int ThumbnailCache::levelForSpacing(double msPerThumb) {
+    int level = 0;
+    while (level + 1 < kLevelCount && static_cast<double>(levelIntervalMs(level + 1)) <= msPerThumb)
+        level++;
+    return level;
+}
+
+ThumbnailCache::ThumbnailCache(ReadyCallback onReady, const QString& diskDir, size_t memoryBudgetBytes,
+                               size_t threadCount)
+    : m_onReady(std::move(onReady)), m_diskDir(diskDir), m_memoryBudget(memoryBudgetBytes) {
+    if (!m_diskDir.isEmpty()) QDir().mkpath(m_diskDir);
+    threadCount = std::max<size_t>(1, threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        m_threads.emplace_back([this, i]() {
+            if (i == 0) trimDisk(kDiskBudgetBytes);
+            workerLoop();
+        });
+    }
+}
+
+ThumbnailCache::~ThumbnailCache() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_queue.clear();
+    }
+    m_condition.notify_all();
+    for (std::thread& t : m_threads) {
+        if (t.joinable()) t.join();
+    }
+}
+
+void ThumbnailCache::beginFrame() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_frame++;
+}
+
+QString ThumbnailCache::atlasKey(const QString& mediaPath, int level, int index) {
+    return mediaPath + QLatin1Char('|') + QString::number(level) + QLatin1Char('|') + QString::number(index);
+}
+
+size_t ThumbnailCache::entryBytes(const Entry& entry) {
+    return entry.atlas ? static_cast<size_t>(entry.atlas->image.sizeInBytes()) : kFailedEntryBytes;
+}
+
+bool ThumbnailCache::isCached(const QString& key) {
+    auto it = m_atlases.find(key);
+    if (it == m_atlases.end()) return false;
+    if (it.value().atlas || std::chrono::steady_clock::now() - it.value().failedAt < kFailedRetryInterval) return true;
+    m_memoryBytes -= entryBytes(it.value());
+    m_lru.erase(it.value().lru);
+    m_atlases.erase(it);
+    return false;
+}
+
+std::shared_ptr<const ThumbnailCache::Atlas> ThumbnailCache::find(const QString& key) {
+    auto it = m_atlases.find(key);
+    if (it == m_atlases.end()) return nullptr;
+    m_lru.splice(m_lru.begin(), m_lru, it.value().lru);
+    return it.value().atlas;
+}
+
+bool ThumbnailCache::thumbnail(const QString& mediaPath, int level, qint64 sourceMs, int priority,
+                               QImage& atlas, QRect& source) {
+    level = std::clamp(level, 0, kLevelCount - 1);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // The requested level first, then the nearest levels either side while it is extracted
+    for (int distance = 0; distance < kLevelCount; distance++) {
+        for (int sign : {-1, 1}) {
+            if (distance == 0 && sign > 0) continue;
+            const int l = level + sign * distance;
+            if (l < 0 || l >= kLevelCount) continue;
+            const qint64 interval = levelIntervalMs(l);
+            const qint64 n = std::max<qint64>(0, (sourceMs + interval / 2) / interval);
+            const int index = static_cast<int>(n / kThumbsPerAtlas);
+            const QString key = atlasKey(mediaPath, l, index);
+            const bool known = isCached(key);
+            if (l == level && !known) enqueue(mediaPath, l, index, priority);
+            if (!known) continue;
+            std::shared_ptr<const Atlas> a = find(key);
+            if (!a || a->count == 0) continue;
+            const int slot = std::min(static_cast<int>(n % kThumbsPerAtlas), a->count - 1);
+            atlas = a->image;
+            source = QRect(slot * a->thumbWidth, 0, a->thumbWidth, a->image.height());
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThumbnailCache::request(const QString& mediaPath, int level, qint64 sourceMs, int priority) {
+    level = std::clamp(level, 0, kLevelCount - 1);
+    const qint64 interval = levelIntervalMs(level);
+    const qint64 n = std::max<qint64>(0, (sourceMs + interval / 2) / interval);
+    const int index = static_cast<int>(n / kThumbsPerAtlas);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!isCached(atlasKey(mediaPath, level, index)))
+        enqueue(mediaPath, level, index, priority);
+}
+
+void ThumbnailCache::enqueue(const QString& mediaPath, int level, int index, int priority) {
+    const QString key = atlasKey(mediaPath, level, index);
+    if (m_running.contains(key)) return;
+    auto it = m_queue.find(key);
+    if (it != m_queue.end()) {
+        // Asked again in this pass: refresh it and keep the most urgent priority of the pass
+        Job& job = it.value();
+        job.priority = job.frame == m_frame ? std::min(job.priority, priority) : priority;
+        job.frame = m_frame;
+        return;
+    }
+    Job job;
+    job.mediaPath = mediaPath;
+    job.level = level;
+    job.index = index;
+    job.priority = priority;
+    job.frame = m_frame;
+    job.order = m_order++;
+    m_queue.insert(key, job);
+    m_condition.notify_one();
+}
+
+void ThumbnailCache::store(const QString& key, std::shared_ptr<const Atlas> atlas) {
+    auto existing = m_atlases.find(key);
+    if (existing != m_atlases.end()) {
+        m_memoryBytes -= entryBytes(existing.value());
+        m_lru.erase(existing.value().lru);
+        m_atlases.erase(existing);
+    }
+    Entry entry;
+    m_lru.push_front(key);
+    entry.lru = m_lru.begin();
+    entry.atlas = std::move(atlas);
+    if (!entry.atlas) entry.failedAt = std::chrono::steady_clock::now();
+    m_memoryBytes += entryBytes(entry);
+    m_atlases.insert(key, entry);
+
+    while (m_memoryBytes > m_memoryBudget && m_lru.size() > 1) {
+        auto it = m_atlases.find(m_lru.back());
+        m_memoryBytes -= entryBytes(it.value());
+        m_atlases.erase(it);
+        m_lru.pop_back();
+    }
+}
+
+size_t ThumbnailCache::getMemoryBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_memoryBytes;
+}
+
+size_t ThumbnailCache::getQueueLength() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<size_t>(m_queue.size());
+}
+
+void ThumbnailCache::workerLoop() {
+    for (;;) {
+        QString key;
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_stopping || !m_queue.isEmpty(); });
+            if (m_stopping) return;
+            // Scrolled out of view: drop rather than extract
+            for (auto it = m_queue.begin(); it != m_queue.end();) {
+                if (it.value().frame + kStalePasses <= m_frame)
+                    it = m_queue.erase(it);
+                else
+                    ++it;
+            }
+            auto best = m_queue.end();
+            for (auto it = m_queue.begin(); it != m_queue.end(); ++it) {
+                if (best == m_queue.end() || it.value().priority < best.value().priority
+                    || (it.value().priority == best.value().priority && it.value().order < best.value().order))
+                    best = it;
+            }
+            if (best == m_queue.end()) continue;
+            key = best.key();
+            job = best.value();
+            m_queue.erase(best);
+            m_running.insert(key);
+        }
+
+        const QString file = diskPath(job.mediaPath, job.level, job.index);
+        std::shared_ptr<const Atlas> atlas = file.isEmpty() ? nullptr : loadFromDisk(file);
+        if (atlas) {
+            m_diskHits++;
+        } else {
+            atlas = extract(job.mediaPath, job.level, job.index);
+            m_extracted++;
+            if (atlas && !file.isEmpty()) saveToDisk(file, *atlas);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running.remove(key);
+            if (m_stopping) return;
+            store(key, std::move(atlas));
+        }
+        if (m_onReady) m_onReady();
+    }
+}
+
+// ---- Disk cache ----
+
+QString ThumbnailCache::diskPath(const QString& mediaPath, int level, int index) const {
+    if (m_diskDir.isEmpty()) return QString();
+    // Identity of the file's contents, so an edited or replaced file gets new thumbnails
+    const QFileInfo info(mediaPath);
+    if (!info.exists()) return QString();
+    const QString identity = info.canonicalFilePath() + QLatin1Char('|') + QString::number(info.size())
+                           + QLatin1Char('|') + QString::number(info.lastModified().toMSecsSinceEpoch());
+    const QByteArray hash = QCryptographicHash::hash(identity.toUtf8(), QCryptographicHash::Md5).toHex();
+    return m_diskDir + QLatin1Char('/') + QString::fromLatin1(hash) + QLatin1Char('_') + QString::number(level)
+         + QLatin1Char('_') + QString::number(index) + QStringLiteral(".jpg");
+}
+
+std::shared_ptr<const ThumbnailCache::Atlas> ThumbnailCache::loadFromDisk(const QString& path) const {
+    QImageReader reader(path);
+    QImage image = reader.read();
+    if (image.isNull() || image.height() != kThumbHeight) return nullptr;
+    const QStringList layout = reader.text(QLatin1String(kAtlasTextKey)).split(QLatin1Char(','));
+    auto atlas = std::make_shared<Atlas>();
+    atlas->thumbWidth = layout.size() == 2 ? layout[0].toInt() : image.width() / kThumbsPerAtlas;
+    atlas->count = layout.size() == 2 ? layout[1].toInt() : kThumbsPerAtlas;
+    if (atlas->thumbWidth <= 0 || atlas->count <= 0 || atlas->thumbWidth * atlas->count > image.width())
+        return nullptr;
+    atlas->image = image.convertToFormat(QImage::Format_RGB888);
+    // Mark it used so trimDisk keeps it; setFileTime needs an open file
+    QFile touch(path);
+    if (touch.open(QIODevice::ReadWrite))
+        touch.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    return atlas;
+}
+
+void ThumbnailCache::saveToDisk(const QString& path, const Atlas& atlas) const {
+    QImageWriter writer(path + QStringLiteral(".tmp"), "jpg");
+    writer.setQuality(80);
+    writer.setText(QLatin1String(kAtlasTextKey),
+                   QString::number(atlas.thumbWidth) + QLatin1Char(',') + QString::number(atlas.count));
+    if (writer.write(atlas.image)) {
+        QFile::remove(path);
+        QFile::rename(path + QStringLiteral(".tmp"), path);
+    } else {
+        QFile::remove(path + QStringLiteral(".tmp"));
+    }
+}
+
+void ThumbnailCache::trimDisk(qint64 maxBytes) const {
+    if (m_diskDir.isEmpty()) return;
+    // Newest first: keep until the budget is spent, delete the rest
+    const QDir dir(m_diskDir);
+    const QFileInfoList files = dir.entryInfoList({QStringLiteral("*.jpg")}, QDir::Files, QDir::Time);
+    qint64 total = 0;
+    for (const QFileInfo& f : files) {
+        total += f.size();
+        if (total > maxBytes) QFile::remove(f.filePath());
+    }
+    // Saves interrupted by a crash; the other workers may be writing new ones right now
+    const QDateTime staleBefore = QDateTime::currentDateTime().addSecs(-kStaleTempSecs);
+    for (const QFileInfo& f : dir.entryInfoList({QStringLiteral("*.jpg.tmp")}, QDir::Files)) {
+        if (f.lastModified() < staleBefore) QFile::remove(f.filePath());
+    }
+}
+
+// ---- Extraction ----
+
+#ifdef AETHER_FFMPEG_ENABLED
+std::shared_ptr<const ThumbnailCache::Atlas> ThumbnailCache::extract(const QString& mediaPath, int level, int index) {
+    AVFormatContext* fmt = nullptr;
+    if (avformat_open_input(&fmt, mediaPath.toUtf8().constData(), nullptr, nullptr) < 0) return nullptr;
+    if (avformat_find_stream_info(fmt, nullptr) < 0) {
+        avformat_close_input(&fmt);
+        return nullptr;
+    }
+    const int stream = av_find_best_stream(fmt, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (stream < 0 || (fmt->streams[stream]->disposition & AV_DISPOSITION_ATTACHED_PIC)) {
+        avformat_close_input(&fmt);
+        return nullptr;
+    }
+    AVStream* st = fmt->streams[stream];
+    const AVCodec* dec = avcodec_find_decoder(st->codecpar->codec_id);
+    AVCodecContext* codec = dec ? avcodec_alloc_context3(dec) : nullptr;
+    if (!codec || avcodec_parameters_to_context(codec, st->codecpar) < 0) {
+        avcodec_free_context(&codec);
+        avformat_close_input(&fmt);
+        return nullptr;
+    }
+    // Several atlases decode at once; keep each decoder small
+    codec->thread_count = 2;
+    // Only the keyframe is wanted; skip everything the seek does not land on
+    codec->skip_frame = AVDISCARD_NONKEY;
+    if (avcodec_open2(codec, dec, nullptr) < 0) {
+        avcodec_free_context(&codec);
+        avformat_close_input(&fmt);
+        return nullptr;
+    }
+
+    double aspect = st->codecpar->height > 0 ? static_cast<double>(st->codecpar->width) / st->codecpar->height : 16.0 / 9.0;
+    const AVRational sar = av_guess_sample_aspect_ratio(fmt, st, nullptr);
+    if (sar.num > 0 && sar.den > 0) aspect *= av_q2d(sar);
+    auto atlas = std::make_shared<Atlas>();
+    atlas->thumbWidth = std::clamp(static_cast<int>(std::lround(kThumbHeight * aspect)), 16, 4 * kThumbHeight);
+    atlas->image = QImage(atlas->thumbWidth * kThumbsPerAtlas, kThumbHeight, QImage::Format_RGB888);
+    atlas->image.fill(Qt::black);
+
+    AVFrame* frame = av_frame_alloc();
+    AVPacket* pkt = av_packet_alloc();
+    SwsContext* sws = nullptr;
+    const qint64 durationMs = fmt->duration != AV_NOPTS_VALUE ? av_rescale(fmt->duration, 1000, AV_TIME_BASE) : 0;
+    const int64_t startTs = st->start_time != AV_NOPTS_VALUE ? st->start_time : 0;
+    const qint64 interval = levelIntervalMs(level);
+    int64_t previousKeyTs = AV_NOPTS_VALUE;
+
+    for (int i = 0; i < kThumbsPerAtlas; i++) {
+        const qint64 timeMs = (static_cast<qint64>(index) * kThumbsPerAtlas + i) * interval;
+        if (durationMs > 0 && timeMs >= durationMs) break;
+        const int64_t ts = startTs + av_rescale_q(timeMs, AVRational{1, 1000}, st->time_base);
+        if (av_seek_frame(fmt, stream, ts, AVSEEK_FLAG_BACKWARD) < 0 && i > 0) break;
+        avcodec_flush_buffers(codec);
+
+        bool decoded = false;
+        bool reused = false;
+        bool firstPacket = true;
+        while (!decoded && av_read_frame(fmt, pkt) >= 0) {
+            if (pkt->stream_index != stream) {
+                av_packet_unref(pkt);
+                continue;
+            }
+            const int64_t packetTs = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+            if (firstPacket && i > 0 && packetTs == previousKeyTs) {
+                // Long GOP: the seek landed on the same keyframe as the previous thumbnail
+                av_packet_unref(pkt);
+                reused = true;
+                break;
+            }
+            if (firstPacket) previousKeyTs = packetTs;
+            firstPacket = false;
+            const int ret = avcodec_send_packet(codec, pkt);
+            av_packet_unref(pkt);
+            if (ret < 0) continue;
+            decoded = avcodec_receive_frame(codec, frame) == 0;
+        }
+        if (!decoded && !reused) {
+            avcodec_send_packet(codec, nullptr);
+            decoded = avcodec_receive_frame(codec, frame) == 0;
+        }
+
+        uint8_t* column = atlas->image.bits() + static_cast<size_t>(i) * atlas->thumbWidth * 3;
+        if (reused) {
+            const uint8_t* previous = column - atlas->thumbWidth * 3;
+            for (int y = 0; y < kThumbHeight; y++)
+                std::memcpy(column + y * atlas->image.bytesPerLine(), previous + y * atlas->image.bytesPerLine(),
+                            static_cast<size_t>(atlas->thumbWidth) * 3);
+        } else if (decoded) {
+            sws = sws_getCachedContext(sws, frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+                                       atlas->thumbWidth, kThumbHeight, AV_PIX_FMT_RGB24, SWS_BILINEAR,
+                                       nullptr, nullptr, nullptr);
+            if (!sws) break;
+            uint8_t* dst[1] = {column};
+            int dstStride[1] = {static_cast<int>(atlas->image.bytesPerLine())};
+            sws_scale(sws, frame->data, frame->linesize, 0, frame->height, dst, dstStride);
+            av_frame_unref(frame);
+        } else {
+            break;
+        }
+        atlas->count = i + 1;
+    }
+
+    if (sws) sws_freeContext(sws);
+    av_packet_free(&pkt);
+    av_frame_free(&frame);
+    avcodec_free_context(&codec);
+    avformat_close_input(&fmt);
+    if (atlas->count == 0) return nullptr;
+    return atlas;
+}
+#else
+std::shared_ptr<const ThumbnailCache::Atlas> ThumbnailCache::extract(const QString&, int, int) {
+    return nullptr;
+}
+#endif
+
+} // namespace aether
@@ -1,5 +1,8 @@
 #include "TimelineWidget.h"
 #include "ProjectModel.h"
+#include "aether/AudioPeaks.h"
+#include "aether/ThumbnailCache.h"
+#include "aether/UndoRedo.h"
 #include <QPainter>
 #include <QMouseEvent>
 #include <QContextMenuEvent>
@@ -21,6 +24,11 @@
 #include <QFormLayout>
 #include <QLabel>
 #include <QSlider>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+#include <algorithm>
+#include <cmath>
 
 namespace aether {
 
@@ -75,9 +83,39 @@ TimelineWidget::TimelineWidget(ProjectModel* model, QWidget* parent)
 
     if (m_model) {
         connect(m_model, &ProjectModel::tracksChanged, this, [this]() { updateScrollRange(); update(); });
+        connect(m_model, &ProjectModel::mediaListChanged, this, [this]() { invalidateLayer(); });
     }
     m_pixelsPerMs = 0.15;
     updateScrollRange();
+
+    // Atlases and peak files finish on worker threads; see queueCacheRepaint
+    m_thumbnails = std::make_unique<ThumbnailCache>([this]() {
+        QMetaObject::invokeMethod(this, [this]() { queueCacheRepaint(); }, Qt::QueuedConnection);
+    }, QApplication::applicationDirPath() + QLatin1String("/thumbnail_cache"));
+    m_peaks = std::make_unique<AudioPeakCache>([this]() {
+        QMetaObject::invokeMethod(this, [this]() { queueCacheRepaint(); }, Qt::QueuedConnection);
+    }, QApplication::applicationDirPath() + QLatin1String("/peak_cache"));
+}
+
+TimelineWidget::~TimelineWidget() {
+    // Join the workers before QWidget teardown so their callback never sees a dead widget
+    m_thumbnails.reset();
+    m_peaks.reset();
+}
+
+void TimelineWidget::queueCacheRepaint() {
+    // Fold a burst of finished atlases or peak files into one repaint
+    if (m_cacheRepaintQueued) return;
+    m_cacheRepaintQueued = true;
+    QTimer::singleShot(30, this, [this]() {
+        m_cacheRepaintQueued = false;
+        invalidateLayer();
+    });
+}
+
+void TimelineWidget::invalidateLayer() {
+    m_layerDirty = true;
+    update();
 }
 
 void TimelineWidget::setModel(ProjectModel* model) {
@@ -85,16 +123,24 @@ void TimelineWidget::setModel(ProjectModel* model) {
     m_model = model;
     if (m_model) {
         connect(m_model, &ProjectModel::tracksChanged, this, [this]() { updateScrollRange(); update(); });
+        connect(m_model, &ProjectModel::mediaListChanged, this, [this]() { invalidateLayer(); });
     }
     updateScrollRange();
-    update();
+    invalidateLayer();
 }
 
 void TimelineWidget::setPlayheadPositionMs(qint64 ms) {
     if (m_playheadMs == ms) return;
+    // Only the strips under the old and new playhead; the rest is blitted from the cached layer
+    update(playheadRect(m_playheadMs));
     m_playheadMs = qMax(0ll, ms);
+    update(playheadRect(m_playheadMs));
     emit playheadMoved(m_playheadMs);
-    update();
+}
+
+QRect TimelineWidget::playheadRect(qint64 ms) const {
+    const int x = m_trackHeaderWidth + timeToPixel(ms) - m_hScroll->value();
+    return QRect(x - 7, 0, 15, height());
 }
 
 void TimelineWidget::setPixelsPerMs(double ppm) {
@@ -181,11 +227,8 @@ QRect TimelineWidget::clipRect(int trackIndex, int clipIndex) const {
     const Track& track = m_model->tracks()[trackIndex];
     if (clipIndex < 0 || clipIndex >= track.clips.size()) return QRect();
     const TimelineClip& c = track.clips[clipIndex];
-    qint64 durationOnTimelineMs = (c.speedRatio > 0.001)
-        ? static_cast<qint64>((c.sourceOutMs - c.sourceInMs) / c.speedRatio)
-        : (c.sourceOutMs - c.sourceInMs);
     int x = timeToPixel(c.timelineStartMs) - m_hScroll->value();
-    int w = timeToPixel(durationOnTimelineMs);
+    int w = timeToPixel(c.timelineEndMs() - c.timelineStartMs);
     int y = m_rulerHeight + trackIndex * m_trackHeight + 2;
     int h = m_trackHeight - 4;
     return QRect(m_trackHeaderWidth + x, y, qMax(4, w), h);
@@ -207,25 +250,51 @@ void TimelineWidget::findClipAt(int x, int y, int* outTrack, int* outClip) const
     if (t < 0) return;
     int contentX = x - m_trackHeaderWidth + m_hScroll->value();
     qint64 timeMs = pixelToTime(contentX);
-    const Track& track = m_model->tracks()[t];
-    for (int i = 0; i < track.clips.size(); ++i) {
-        const TimelineClip& c = track.clips[i];
-        qint64 start = c.timelineStartMs;
-        qint64 durationOnTimelineMs = (c.speedRatio > 0.001)
-            ? static_cast<qint64>((c.sourceOutMs - c.sourceInMs) / c.speedRatio)
-            : (c.sourceOutMs - c.sourceInMs);
-        qint64 end = c.timelineStartMs + durationOnTimelineMs;
-        if (timeMs >= start && timeMs < end) {
-            *outTrack = t;
-            *outClip = i;
-            return;
-        }
+    const int clip = m_model->tracks()[t].clipAt(timeMs);
+    if (clip >= 0) {
+        *outTrack = t;
+        *outClip = clip;
     }
 }
 
 void TimelineWidget::paintEvent(QPaintEvent* e) {
-    Q_UNUSED(e);
+    LayerKey key;
+    key.scrollX = m_hScroll->value();
+    key.scrollY = m_vScroll->value();
+    key.pixelsPerMs = m_pixelsPerMs;
+    key.trackHeight = m_trackHeight;
+    key.size = size();
+    key.devicePixelRatio = devicePixelRatioF();
+    key.revision = m_model ? m_model->snapshot()->revision : 0;
+    if (m_layerDirty || m_layer.isNull() || !(key == m_layerKey)) {
+        m_layer = QPixmap(size() * key.devicePixelRatio);
+        m_layer.setDevicePixelRatio(key.devicePixelRatio);
+        QPainter lp(&m_layer);
+        paintLayer(lp);
+        m_layerKey = key;
+        m_layerDirty = false;
+    }
+
     QPainter p(this);
+    const QRectF dirty = e->rect();
+    const qreal dpr = key.devicePixelRatio;
+    p.drawPixmap(dirty, m_layer, QRectF(dirty.x() * dpr, dirty.y() * dpr, dirty.width() * dpr, dirty.height() * dpr));
+
+    // Playhead
+    int viewW = width();
+    int viewH = height();
+    int playheadX = m_trackHeaderWidth + timeToPixel(m_playheadMs) - key.scrollX;
+    if (playheadX >= m_trackHeaderWidth && playheadX < viewW) {
+        p.setPen(QColor(255, 80, 80));
+        p.setBrush(QColor(255, 80, 80));
+        p.drawLine(playheadX, 0, playheadX, viewH);
+        QPolygon tri;
+        tri << QPoint(playheadX - 6, 0) << QPoint(playheadX + 6, 0) << QPoint(playheadX, 10);
+        p.drawPolygon(tri);
+    }
+}
+
+void TimelineWidget::paintLayer(QPainter& p) {
     p.fillRect(rect(), QColor(28, 28, 31));
 
     int viewW = width();
@@ -256,9 +325,25 @@ void TimelineWidget::paintEvent(QPaintEvent* e) {
         t += step;
     }
 
-    // Track headers and content
+    // Aspect ratio of each video, for filmstrip slot widths, and which media may carry audio
+    QHash<QString, double> videoAspect;
+    QSet<QString> audioMedia;
+    if (m_model) {
+        for (const MediaItem& m : m_model->media()) {
+            if (m.isVideo && !m.isAudio)
+                videoAspect.insert(m.path, (m.width > 0 && m.height > 0) ? double(m.width) / m.height : 16.0 / 9.0);
+            if (m.isAudio || !m.probed || m.audioChannels > 0)
+                audioMedia.insert(m.path);
+        }
+    }
+    m_thumbnails->beginFrame();
+
+    // Track headers and content: only the rows and clips inside the view
     int trackCount = m_model ? m_model->tracks().size() : 2;
-    for (int i = 0; i < trackCount; ++i) {
+    const int firstTrack = qMax(0, (scrollY - m_rulerHeight) / m_trackHeight);
+    const int lastTrack = qMin(trackCount - 1, (scrollY + viewH) / m_trackHeight);
+    const qint64 visibleFromMs = pixelToTime(scrollX - 4); // clips are drawn at least 4 px wide
+    for (int i = firstTrack; i <= lastTrack; ++i) {
         QRect headerR = trackHeaderRect(i);
         headerR.translate(0, -scrollY);
         if (headerR.bottom() < 0 || headerR.top() > viewH) continue;
@@ -276,33 +361,124 @@ void TimelineWidget::paintEvent(QPaintEvent* e) {
 
         if (m_model) {
             const Track& track = m_model->tracks()[i];
-            for (int j = 0; j < track.clips.size(); ++j) {
+            track.clipsInRange(visibleFromMs, visibleEnd, m_visibleClips);
+            for (int j : m_visibleClips) {
                 QRect cr = clipRect(i, j);
                 cr.translate(0, -scrollY);
                 if (cr.right() < m_trackHeaderWidth || cr.left() > viewW) continue;
+                const QRect fullRect = cr;
                 cr.setLeft(qMax(cr.left(), m_trackHeaderWidth));
                 cr.setRight(qMin(cr.right(), viewW));
                 p.fillRect(cr, QColor(94, 129, 172));
+                const TimelineClip& clip = track.clips[j];
+                auto aspect = videoAspect.constFind(clip.mediaPath);
+                const bool filmstrip = track.isVideo && aspect != videoAspect.constEnd();
+                // Audio tracks, and audio-only media on any track, show the waveform instead
+                const bool waveform = !filmstrip && audioMedia.contains(clip.mediaPath);
+                if (filmstrip) drawFilmstrip(p, clip, fullRect, cr, aspect.value());
+                else if (waveform) drawWaveform(p, clip, fullRect, cr);
                 p.setPen(QColor(60, 90, 120));
+                p.setBrush(Qt::NoBrush);
                 p.drawRect(cr.adjusted(0, 0, -1, -1));
-                QFileInfo fi(track.clips[j].mediaPath);
+                QFileInfo fi(clip.mediaPath);
+                QRect labelR = cr.adjusted(4, 0, -4, 0);
+                if (filmstrip || waveform) {
+                    // Name on a band along the top so it stays readable over the frames
+                    labelR.setHeight(p.fontMetrics().height() + 2);
+                    p.fillRect(labelR.adjusted(-3, 1, 3, 0), QColor(0, 0, 0, 140));
+                }
                 p.setPen(Qt::white);
-                p.drawText(cr.adjusted(4, 0, -4, 0), Qt::AlignVCenter | Qt::AlignLeft,
+                p.drawText(labelR, Qt::AlignVCenter | Qt::AlignLeft,
                     p.fontMetrics().elidedText(fi.fileName(), Qt::ElideRight, cr.width() - 8));
             }
         }
     }
+}
 
-    // Playhead
-    int playheadX = m_trackHeaderWidth + timeToPixel(m_playheadMs) - scrollX;
-    if (playheadX >= m_trackHeaderWidth && playheadX < viewW) {
-        p.setPen(QColor(255, 80, 80));
-        p.setBrush(QColor(255, 80, 80));
-        p.drawLine(playheadX, 0, playheadX, viewH);
-        QPolygon tri;
-        tri << QPoint(playheadX - 6, 0) << QPoint(playheadX + 6, 0) << QPoint(playheadX, 10);
-        p.drawPolygon(tri);
+void TimelineWidget::drawFilmstrip(QPainter& p, const TimelineClip& clip, const QRect& fullRect,
+                                   const QRect& visibleRect, double aspect) {
+    const QRect inner = fullRect.adjusted(1, 1, -1, -1);
+    const int thumbW = qMax(8, static_cast<int>(std::lround(inner.height() * aspect)));
+    if (inner.height() < 8 || inner.width() < thumbW / 2) return;
+
+    // Slots are laid out from the clip's start so they do not swim while scrolling
+    const double sourceMsPerPixel = (clip.speedRatio > 0.001 ? clip.speedRatio : 1.0) / m_pixelsPerMs;
+    const int level = ThumbnailCache::levelForSpacing(thumbW * sourceMsPerPixel);
+    const int viewCenter = m_trackHeaderWidth + (width() - m_trackHeaderWidth) / 2;
+    const int viewW = width() - m_trackHeaderWidth;
+    auto slotSourceMs = [&](int slot) {
+        return clip.sourceInMs + static_cast<qint64>((slot * thumbW + thumbW / 2) * sourceMsPerPixel);
+    };
+
+    p.save();
+    p.setClipRect(visibleRect.adjusted(1, 1, -1, -1));
+    const int firstSlot = qMax(0, (visibleRect.left() - inner.left()) / thumbW);
+    const int lastSlot = (qMin(visibleRect.right(), inner.right()) - inner.left()) / thumbW;
+    QImage atlas;
+    QRect source;
+    for (int slot = firstSlot; slot <= lastSlot; slot++) {
+        const int x = inner.left() + slot * thumbW;
+        const qint64 sourceMs = qMin(slotSourceMs(slot), clip.sourceOutMs);
+        // Slots nearest the middle of the view are extracted first
+        const int priority = std::abs(x + thumbW / 2 - viewCenter);
+        if (m_thumbnails->thumbnail(clip.mediaPath, level, sourceMs, priority, atlas, source))
+            p.drawImage(QRect(x, inner.top(), thumbW, inner.height()), atlas, source);
+    }
+    p.restore();
+
+    // Prefetch a view's width either side, one request per atlas, behind everything visible
+    const int slotsPerAtlas = qMax(1, static_cast<int>(ThumbnailCache::levelIntervalMs(level) * ThumbnailCache::kThumbsPerAtlas
+                                                        / (thumbW * sourceMsPerPixel)));
+    const int totalSlots = (inner.width() + thumbW - 1) / thumbW;
+    const int prefetchSlots = viewW / thumbW + 1;
+    for (int slot = qMax(0, firstSlot - prefetchSlots); slot < firstSlot; slot += slotsPerAtlas)
+        m_thumbnails->request(clip.mediaPath, level, slotSourceMs(slot), viewW + (firstSlot - slot) * thumbW);
+    for (int slot = lastSlot + 1; slot < qMin(totalSlots, lastSlot + 1 + prefetchSlots); slot += slotsPerAtlas)
+        m_thumbnails->request(clip.mediaPath, level, slotSourceMs(slot), viewW + (slot - lastSlot) * thumbW);
+}
+
+void TimelineWidget::drawWaveform(QPainter& p, const TimelineClip& clip, const QRect& fullRect,
+                                  const QRect& visibleRect) {
+    const QRect inner = fullRect.adjusted(1, 1, -1, -1);
+    if (inner.height() < 4) return;
+    const std::shared_ptr<const AudioPeaks> peaks = m_peaks->peaks(clip.mediaPath);
+    if (!peaks) return;
+    const int left = qMax(visibleRect.left(), inner.left());
+    const int right = qMin(visibleRect.right(), inner.right());
+    if (right < left) return;
+
+    // One bin per visible pixel, read from the pyramid level matching the zoom
+    const double sourceMsPerPixel = (clip.speedRatio > 0.001 ? clip.speedRatio : 1.0) / m_pixelsPerMs;
+    const int pixels = right - left + 1;
+    m_peakScratch.resize(static_cast<size_t>(pixels));
+    peaks->render(clip.sourceInMs + (left - inner.left()) * sourceMsPerPixel, sourceMsPerPixel, pixels,
+                  m_peakScratch.data());
+
+    const double mid = inner.top() + inner.height() / 2.0;
+    const double scale = (inner.height() / 2.0) / 32767.0;
+    QVector<QLine> peakLines;
+    QVector<QLine> rmsLines;
+    peakLines.reserve(pixels);
+    rmsLines.reserve(pixels);
+    for (int i = 0; i < pixels; i++) {
+        const PeakBin& bin = m_peakScratch[static_cast<size_t>(i)];
+        const int x = left + i;
+        const int top = static_cast<int>(std::lround(mid - bin.max * scale));
+        const int bottom = static_cast<int>(std::lround(mid - bin.min * scale));
+        peakLines.append(QLine(x, top, x, bottom));
+        const int rmsTop = qMax(top, static_cast<int>(std::lround(mid - bin.rms * scale)));
+        const int rmsBottom = qMin(bottom, static_cast<int>(std::lround(mid + bin.rms * scale)));
+        if (rmsBottom >= rmsTop) rmsLines.append(QLine(x, rmsTop, x, rmsBottom));
     }
+    p.save();
+    p.setClipRect(visibleRect.adjusted(1, 1, -1, -1));
+    p.setPen(QColor(60, 90, 120));
+    p.drawLine(left, static_cast<int>(mid), right, static_cast<int>(mid));
+    p.setPen(QColor(170, 200, 230));
+    p.drawLines(peakLines);
+    p.setPen(QColor(225, 238, 250));
+    p.drawLines(rmsLines);
+    p.restore();
 }
 
 void TimelineWidget::contextMenuEvent(QContextMenuEvent* e) {
@@ -382,6 +558,8 @@ void TimelineWidget::mousePressEvent(QMouseEvent* e) {
                 m_dragClip = clp;
                 m_dragStartX = x;
                 m_dragStartMs = m_model->tracks()[trk].clips[clp].timelineStartMs;
+                // The whole drag is one undo step, however long it pauses
+                UndoRedoManager::getInstance().beginGesture();
                 emit clipSelected(trk, clp);
             } else {
                 setPlayheadPositionMs(timeMs);
@@ -409,7 +587,8 @@ void TimelineWidget::mouseMoveEvent(QMouseEvent* e) {
         qint64 dMs = static_cast<qint64>(dx / m_pixelsPerMs);
         qint64 newStart = m_dragStartMs + dMs;
         if (newStart < 0) newStart = 0;
-        m_model->setClipStart(m_dragTrack, m_dragClip, newStart);
+        // Clips are kept in start order, so the dragged clip's index can change
+        m_dragClip = m_model->setClipStart(m_dragTrack, m_dragClip, newStart);
         emit clipMoved(m_dragTrack, m_dragClip, newStart);
         update();
     }
@@ -417,6 +596,7 @@ void TimelineWidget::mouseMoveEvent(QMouseEvent* e) {
 
 void TimelineWidget::mouseReleaseEvent(QMouseEvent* e) {
     if (e->button() == Qt::LeftButton) {
+        if (m_dragTrack >= 0) UndoRedoManager::getInstance().endGesture();
         m_dragTrack = -1;
         m_dragClip = -1;
     }
@@ -1,19 +1,29 @@
 #pragma once
 
 #include <QWidget>
+#include <QPixmap>
 #include <QPointer>
 #include <QScrollBar>
+#include <cstdint>
+#include <memory>
+#include <vector>
 
 class QSlider;
+class QPainter;
 
 namespace aether {
 
 class ProjectModel;
+class ThumbnailCache;
+class AudioPeakCache;
+struct PeakBin;
+struct TimelineClip;
 
 class TimelineWidget : public QWidget {
     Q_OBJECT
 public:
     explicit TimelineWidget(ProjectModel* model, QWidget* parent = nullptr);
+    ~TimelineWidget() override;
 
     void setModel(ProjectModel* model);
     qint64 playheadPositionMs() const { return m_playheadMs; }
@@ -49,6 +59,21 @@ private:
     void wheelEvent(QWheelEvent*) override;
     void resizeEvent(QResizeEvent*) override;
 
+    /** View state the cached layer was painted for; any change repaints it. */
+    struct LayerKey {
+        int scrollX = 0;
+        int scrollY = 0;
+        double pixelsPerMs = 0.0;
+        int trackHeight = 0;
+        QSize size;
+        qreal devicePixelRatio = 1.0;
+        uint64_t revision = 0;
+        bool operator==(const LayerKey&) const = default;
+    };
+
+    void paintLayer(QPainter& p);
+    void invalidateLayer();
+    QRect playheadRect(qint64 ms) const;
     int timeToPixel(qint64 ms) const;
     qint64 pixelToTime(int x) const;
     void updateScrollRange();
@@ -57,6 +82,10 @@ private:
     QRect clipRect(int trackIndex, int clipIndex) const;
     int trackAtY(int y) const;
     void findClipAt(int x, int y, int* outTrack, int* outClip) const;
+    void drawFilmstrip(QPainter& p, const TimelineClip& clip, const QRect& fullRect, const QRect& visibleRect,
+                       double aspect);
+    void drawWaveform(QPainter& p, const TimelineClip& clip, const QRect& fullRect, const QRect& visibleRect);
+    void queueCacheRepaint();
 
     QPointer<ProjectModel> m_model;
     qint64 m_playheadMs = 0;
@@ -74,6 +103,15 @@ private:
     int m_dragClip = -1;
     int m_dragStartX = 0;
     qint64 m_dragStartMs = 0;
+    std::unique_ptr<ThumbnailCache> m_thumbnails;
+    std::unique_ptr<AudioPeakCache> m_peaks;
+    std::vector<PeakBin> m_peakScratch; // one bin per visible pixel, reused across paints
+    bool m_cacheRepaintQueued = false;
+    // Ruler, tracks and clips, painted once per view change; playhead moves only blit from it
+    QPixmap m_layer;
+    LayerKey m_layerKey;
+    bool m_layerDirty = true;
+    std::vector<int> m_visibleClips;
 };
 
 } // namespace aether
@@ -1,23 +1,169 @@
 #include "VideoScopesWidget.h"
+#include "aether/ScopeEngine.h"
+#include <QContextMenuEvent>
+#include <QMenu>
 #include <QPainter>
+#include <algorithm>
 
 namespace aether {
 
+namespace {
+
+// Wraps the result's pixels without copying; valid while the result is held
+QImage wrapImage(const CpuImage& image) {
+    return QImage(image.rgba.data(), static_cast<int>(image.width), static_cast<int>(image.height),
+                  static_cast<qsizetype>(image.width) * 4, QImage::Format_RGBA8888);
+}
+
+void drawLevelGraticule(QPainter& p, const QRectF& r) {
+    p.setPen(QColor(255, 255, 255, 40));
+    for (int i = 0; i <= 4; i++) {
+        qreal y = r.bottom() - r.height() * i / 4.0;
+        p.drawLine(QPointF(r.left(), y), QPointF(r.right(), y));
+    }
+}
+
+void drawVectorscopeGraticule(QPainter& p, const QRectF& r) {
+    p.setPen(QColor(255, 255, 255, 40));
+    p.drawEllipse(r);
+    p.drawLine(QPointF(r.center().x(), r.top()), QPointF(r.center().x(), r.bottom()));
+    p.drawLine(QPointF(r.left(), r.center().y()), QPointF(r.right(), r.center().y()));
+}
+
+void drawLabel(QPainter& p, const QRectF& r, const QString& text) {
+    p.setPen(QColor(120, 120, 120));
+    p.drawText(r.adjusted(4, 2, -4, -2), Qt::AlignTop | Qt::AlignLeft, text);
+}
+
+} // namespace
+
 VideoScopesWidget::VideoScopesWidget(QWidget* parent) : QWidget(parent) {
     setMinimumSize(200, 120);
     setStyleSheet("VideoScopesWidget { background: #0d0d0d; }");
+    // Repaint on the UI thread when the worker publishes; queued events die with the widget
+    m_worker = std::make_unique<ScopeWorker>([this]() {
+        QMetaObject::invokeMethod(this, [this]() { update(); }, Qt::QueuedConnection);
+    });
+}
+
+VideoScopesWidget::~VideoScopesWidget() {
+    // Join the worker before QWidget teardown so its callback never sees a dead widget
+    m_worker.reset();
 }
 
 void VideoScopesWidget::setFrame(const QImage& frame) {
-    m_frame = frame;
+    if (frame.isNull() || !isVisible()) {
+        return;
+    }
+    // Implicitly shared, so this only copies when the format needs converting
+    auto image = std::make_shared<QImage>(frame.format() == QImage::Format_RGB888
+                                              ? frame
+                                              : frame.convertToFormat(QImage::Format_RGB888));
+    ScopeFrame scopeFrame;
+    scopeFrame.format = ScopeFrame::Format::Rgb24;
+    scopeFrame.width = static_cast<uint32_t>(image->width());
+    scopeFrame.height = static_cast<uint32_t>(image->height());
+    scopeFrame.planes[0] = image->constBits();
+    scopeFrame.strides[0] = static_cast<uint32_t>(image->bytesPerLine());
+    m_worker->submit(scopeFrame, image);
+}
+
+void VideoScopesWidget::setFrame(const ScopeFrame& frame, std::shared_ptr<const void> owner) {
+    if (!isVisible()) {
+        return;
+    }
+    m_worker->submit(frame, std::move(owner));
+}
+
+void VideoScopesWidget::setMode(Mode mode) {
+    if (m_mode == mode) {
+        return;
+    }
+    m_mode = mode;
     update();
 }
 
+double VideoScopesWidget::getLastComputeMs() const {
+    std::shared_ptr<const ScopeResult> result = m_worker->latestResult();
+    return result ? result->computeMs() : 0.0;
+}
+
+void VideoScopesWidget::contextMenuEvent(QContextMenuEvent* event) {
+    QMenu menu(this);
+    const std::pair<Mode, QString> modes[] = {
+        {Mode::All, tr("All Scopes")},
+        {Mode::Waveform, tr("Waveform")},
+        {Mode::Parade, tr("RGB Parade")},
+        {Mode::Vectorscope, tr("Vectorscope")},
+        {Mode::Histogram, tr("Histogram")},
+    };
+    for (const auto& [mode, label] : modes) {
+        QAction* action = menu.addAction(label);
+        action->setCheckable(true);
+        action->setChecked(m_mode == mode);
+        connect(action, &QAction::triggered, this, [this, mode = mode]() { setMode(mode); });
+    }
+    menu.exec(event->globalPos());
+}
+
 void VideoScopesWidget::paintEvent(QPaintEvent*) {
     QPainter p(this);
     p.fillRect(rect(), QColor(13, 13, 13));
-    p.setPen(QColor(80, 80, 80));
-    p.drawText(rect(), Qt::AlignCenter, tr("Waveform | Vectorscope"));
+
+    std::shared_ptr<const ScopeResult> result = m_worker->latestResult();
+    if (!result) {
+        p.setPen(QColor(80, 80, 80));
+        p.drawText(rect(), Qt::AlignCenter, tr("Waveform | Vectorscope"));
+        return;
+    }
+
+    const QRectF area = QRectF(rect()).adjusted(4, 4, -4, -18);
+    auto drawWaveform = [&](const QRectF& r) {
+        p.drawImage(r, wrapImage(result->waveform));
+        drawLevelGraticule(p, r);
+        drawLabel(p, r, tr("Waveform"));
+    };
+    auto drawParade = [&](const QRectF& r) {
+        p.drawImage(r, wrapImage(result->parade));
+        drawLevelGraticule(p, r);
+        drawLabel(p, r, tr("Parade"));
+    };
+    auto drawVectorscope = [&](const QRectF& r) {
+        qreal side = std::min(r.width(), r.height());
+        QRectF square(r.center().x() - side / 2, r.center().y() - side / 2, side, side);
+        p.drawImage(square, wrapImage(result->vectorscope));
+        drawVectorscopeGraticule(p, square);
+        drawLabel(p, r, tr("Vectorscope"));
+    };
+    auto drawHistogram = [&](const QRectF& r) {
+        p.drawImage(r, wrapImage(result->histogram));
+        drawLabel(p, r, tr("Histogram"));
+    };
+
+    switch (m_mode) {
+    case Mode::All: {
+        const qreal halfW = area.width() / 2;
+        const qreal halfH = area.height() / 2;
+        drawWaveform(QRectF(area.left(), area.top(), halfW - 2, halfH - 2));
+        drawParade(QRectF(area.left() + halfW + 2, area.top(), halfW - 2, halfH - 2));
+        drawVectorscope(QRectF(area.left(), area.top() + halfH + 2, halfW - 2, halfH - 2));
+        drawHistogram(QRectF(area.left() + halfW + 2, area.top() + halfH + 2, halfW - 2, halfH - 2));
+        break;
+    }
+    case Mode::Waveform: drawWaveform(area); break;
+    case Mode::Parade: drawParade(area); break;
+    case Mode::Vectorscope: drawVectorscope(area); break;
+    case Mode::Histogram: drawHistogram(area); break;
+    }
+
+    p.setPen(QColor(120, 120, 120));
+    const QString stats = tr("%1 ms  |  %2x%3  |  1/%4 sampling  |  %5 dropped")
+                              .arg(result->computeMs(), 0, 'f', 1)
+                              .arg(result->frameWidth)
+                              .arg(result->frameHeight)
+                              .arg(result->sampleStep)
+                              .arg(m_worker->getDroppedFrames());
+    p.drawText(QRectF(rect()).adjusted(6, 0, -6, -2), Qt::AlignBottom | Qt::AlignLeft, stats);
 }
 
 } // namespace aether
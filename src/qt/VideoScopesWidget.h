@@ -2,20 +2,42 @@
 
 #include <QWidget>
 #include <QImage>
+#include <memory>
 
 namespace aether {
 
+class ScopeWorker;
+struct ScopeFrame;
+
+/**
+ * Waveform, RGB parade, vectorscope and histogram. Analysis runs on a ScopeWorker
+ * thread; paintEvent only draws the density images of the latest result.
+ */
 class VideoScopesWidget : public QWidget {
     Q_OBJECT
 public:
+    enum class Mode { All, Waveform, Parade, Vectorscope, Histogram };
+
     explicit VideoScopesWidget(QWidget* parent = nullptr);
+    ~VideoScopesWidget() override;
+
+    /** Queues a frame for analysis and returns immediately; ignored while hidden. */
     void setFrame(const QImage& frame);
+    /** Native decoder planes; owner keeps them alive until the worker has read them. */
+    void setFrame(const ScopeFrame& frame, std::shared_ptr<const void> owner);
+
+    void setMode(Mode mode);
+    Mode getMode() const { return m_mode; }
+    /** Analysis cost of the frame currently shown, in milliseconds. */
+    double getLastComputeMs() const;
 
 protected:
     void paintEvent(QPaintEvent*) override;
+    void contextMenuEvent(QContextMenuEvent* event) override;
 
 private:
-    QImage m_frame;
+    std::unique_ptr<ScopeWorker> m_worker;
+    Mode m_mode = Mode::All;
 };
 
 } // namespace aether